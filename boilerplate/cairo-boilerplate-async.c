@@ -0,0 +1,100 @@
+/* -*- Mode: c; c-basic-offset: 4; indent-tabs-mode: t; tab-width: 8; -*- */
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "cairo-boilerplate-private.h"
+
+#include <cairo-async.h>
+
+static cairo_surface_t *
+_cairo_boilerplate_async_create_surface (const char		   *name,
+					 cairo_content_t	    content,
+					 double			    width,
+					 double			    height,
+					 double			    max_width,
+					 double			    max_height,
+					 cairo_boilerplate_mode_t   mode,
+					 void			  **closure)
+{
+    cairo_format_t format;
+    cairo_surface_t *image, *surface;
+
+    if (content == CAIRO_CONTENT_COLOR_ALPHA)
+	format = CAIRO_FORMAT_ARGB32;
+    else
+	format = CAIRO_FORMAT_RGB24;
+
+    image = cairo_image_surface_create (format, ceil (width), ceil (height));
+    surface = cairo_async_surface_create (image);
+    cairo_surface_destroy (image);
+
+    /* for synchronize, not referenced */
+    *closure = surface;
+    return surface;
+}
+
+static cairo_status_t
+_cairo_boilerplate_async_finish_surface (cairo_surface_t *surface)
+{
+    cairo_surface_flush (surface);
+    return cairo_surface_status (surface);
+}
+
+static void
+_cairo_boilerplate_async_synchronize (void *closure)
+{
+    cairo_surface_flush (closure);
+}
+
+static const cairo_boilerplate_target_t targets[] = {
+    {
+	"async", "image", NULL, NULL,
+	CAIRO_SURFACE_TYPE_ASYNC, CAIRO_CONTENT_COLOR_ALPHA, 0,
+	"cairo_async_surface_create",
+	_cairo_boilerplate_async_create_surface,
+	cairo_surface_create_similar,
+	NULL,
+	_cairo_boilerplate_async_finish_surface,
+	_cairo_boilerplate_get_image_surface,
+	cairo_surface_write_to_png,
+	NULL,
+	_cairo_boilerplate_async_synchronize,
+	NULL,
+	TRUE, FALSE, FALSE
+    },
+    {
+	"async", "image", NULL, NULL,
+	CAIRO_SURFACE_TYPE_ASYNC, CAIRO_CONTENT_COLOR, 0,
+	"cairo_async_surface_create",
+	_cairo_boilerplate_async_create_surface,
+	cairo_surface_create_similar,
+	NULL,
+	_cairo_boilerplate_async_finish_surface,
+	_cairo_boilerplate_get_image_surface,
+	cairo_surface_write_to_png,
+	NULL,
+	_cairo_boilerplate_async_synchronize,
+	NULL,
+	FALSE, FALSE, FALSE
+    },
+};
+CAIRO_BOILERPLATE (async, targets)
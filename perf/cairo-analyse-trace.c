@@ -97,10 +97,33 @@ basename_no_ext (char *path)
 #include <fontconfig/fontconfig.h>
 #endif
 
+/* The hot-spot profile aggregates the time spent in each operation by
+ * its signature, as described by the observer, and the line of the
+ * trace which issued it.
+ */
+struct profile_entry {
+    unsigned int signature;
+    unsigned int line;
+    unsigned int count;
+    double elapsed;
+};
+
+struct profile {
+    char **signatures;
+    unsigned int num_signatures;
+    unsigned int last_signature;
+
+    struct profile_entry *entries;
+    unsigned int num_entries;
+    unsigned int size;
+};
+
 struct trace {
     const cairo_boilerplate_target_t *target;
     void            *closure;
     cairo_surface_t *surface;
+    cairo_script_interpreter_t *csi;
+    struct profile *profile;
 };
 
 cairo_bool_t
@@ -235,9 +258,11 @@ execute (cairo_perf_t	 *perf,
 	csi = cairo_script_interpreter_create ();
 	cairo_script_interpreter_install_hooks (csi, &hooks);
 
+	args->csi = csi;
 	cairo_script_interpreter_run (csi, trace);
 
 	cairo_script_interpreter_finish (csi);
+	args->csi = NULL;
 
 	line_no = cairo_script_interpreter_get_line_number (csi);
 	status = cairo_script_interpreter_destroy (csi);
@@ -256,13 +281,16 @@ static void
 usage (const char *argv0)
 {
     fprintf (stderr,
-"Usage: %s [-l] [-i iterations] [-x exclude-file] [test-names ... | traces ...]\n"
+"Usage: %s [-lp] [-i iterations] [-x exclude-file] [test-names ... | traces ...]\n"
 "\n"
 "Run the cairo trace analysis suite over the given tests (all by default)\n"
 "The command-line arguments are interpreted as follows:\n"
 "\n"
 "  -i	iterations; specify the number of iterations per test case\n"
 "  -l	list only; just list selected test case names without executing\n"
+"  -p	profile; instead of the summary, print the time spent in each\n"
+"	operation, by signature and line of the trace, as folded stacks\n"
+"	suitable for flamegraph.pl, the most expensive first\n"
 "  -x	exclude; specify a file to read a list of traces to exclude\n"
 "\n"
 "If test names are given they are used as sub-string matches so a command\n"
@@ -323,13 +351,14 @@ parse_options (cairo_perf_t *perf,
     int c;
 
     perf->list_only = FALSE;
+    perf->profile = FALSE;
     perf->names = NULL;
     perf->num_names = 0;
     perf->exclude_names = NULL;
     perf->num_exclude_names = 0;
 
     while (1) {
-	c = _cairo_getopt (argc, argv, "i:lx:");
+	c = _cairo_getopt (argc, argv, "i:lpx:");
 	if (c == -1)
 	    break;
 
@@ -346,6 +375,9 @@ parse_options (cairo_perf_t *perf,
 	case 'l':
 	    perf->list_only = TRUE;
 	    break;
+	case 'p':
+	    perf->profile = TRUE;
+	    break;
 	case 'x':
 	    if (! read_excludes (perf, optarg)) {
 		fprintf (stderr, "Invalid argument for -x (not readable file): %s\n",
@@ -404,15 +436,149 @@ print (void *closure, const unsigned char *data, unsigned int length)
     return CAIRO_STATUS_SUCCESS;
 }
 
+static void
+profile_operation (cairo_device_t *observer,
+		   const char	  *operation,
+		   double	   elapsed,
+		   void		  *closure)
+{
+    struct trace *args = closure;
+    struct profile *profile = args->profile;
+    struct profile_entry *e;
+    unsigned int line, sig;
+
+    /* There are only a handful of distinct signatures in any trace,
+     * and consecutive operations tend to share one. */
+    sig = profile->last_signature;
+    if (sig >= profile->num_signatures ||
+	strcmp (profile->signatures[sig], operation))
+    {
+	for (sig = 0; sig < profile->num_signatures; sig++)
+	    if (strcmp (profile->signatures[sig], operation) == 0)
+		break;
+
+	if (sig == profile->num_signatures) {
+	    profile->signatures = xrealloc (profile->signatures,
+					    sizeof (char *) * (sig + 1));
+	    profile->signatures[sig] = xstrdup (operation);
+	    profile->num_signatures++;
+	}
+	profile->last_signature = sig;
+    }
+
+    line = args->csi ? cairo_script_interpreter_get_line_number (args->csi) : 0;
+
+    if (profile->num_entries) {
+	e = &profile->entries[profile->num_entries - 1];
+	if (e->signature == sig && e->line == line) {
+	    e->count++;
+	    e->elapsed += elapsed;
+	    return;
+	}
+    }
+
+    if (profile->num_entries == profile->size) {
+	profile->size = profile->size ? 2 * profile->size : 1024;
+	profile->entries = xrealloc (profile->entries,
+				     sizeof (struct profile_entry) * profile->size);
+    }
+
+    e = &profile->entries[profile->num_entries++];
+    e->signature = sig;
+    e->line = line;
+    e->count = 1;
+    e->elapsed = elapsed;
+}
+
+static int
+profile_entry_cmp_site (const void *a, const void *b)
+{
+    const struct profile_entry *ea = a, *eb = b;
+
+    if (ea->signature != eb->signature)
+	return ea->signature < eb->signature ? -1 : 1;
+    if (ea->line != eb->line)
+	return ea->line < eb->line ? -1 : 1;
+    return 0;
+}
+
+static int
+profile_entry_cmp_elapsed (const void *a, const void *b)
+{
+    const struct profile_entry *ea = a, *eb = b;
+
+    /* most expensive first */
+    if (ea->elapsed != eb->elapsed)
+	return ea->elapsed > eb->elapsed ? -1 : 1;
+    return profile_entry_cmp_site (a, b);
+}
+
+/* Print the profile as folded stacks, "trace;op;field...;line N ns",
+ * so that the flame graph groups by the operation signature first
+ * and then by the calls in the trace responsible.
+ */
+static void
+profile_print (struct profile *profile,
+	       const char     *name)
+{
+    struct profile_entry *e, *last;
+    unsigned int n;
+    char *s;
+
+    if (profile->num_entries == 0)
+	return;
+
+    qsort (profile->entries, profile->num_entries,
+	   sizeof (struct profile_entry), profile_entry_cmp_site);
+
+    last = profile->entries;
+    for (n = 1; n < profile->num_entries; n++) {
+	e = &profile->entries[n];
+	if (profile_entry_cmp_site (e, last) == 0) {
+	    last->count += e->count;
+	    last->elapsed += e->elapsed;
+	} else {
+	    *++last = *e;
+	}
+    }
+    profile->num_entries = last - profile->entries + 1;
+
+    qsort (profile->entries, profile->num_entries,
+	   sizeof (struct profile_entry), profile_entry_cmp_elapsed);
+
+    for (n = 0; n < profile->num_entries; n++) {
+	e = &profile->entries[n];
+
+	printf ("%s;", name);
+	for (s = profile->signatures[e->signature]; *s; s++)
+	    putchar (*s == ' ' ? ';' : *s);
+	printf (";line %u %.0f\n", e->line, e->elapsed);
+    }
+}
+
+static void
+profile_fini (struct profile *profile)
+{
+    unsigned int n;
+
+    for (n = 0; n < profile->num_signatures; n++)
+	free (profile->signatures[n]);
+    free (profile->signatures);
+    free (profile->entries);
+}
+
 static void
 cairo_perf_trace (cairo_perf_t			   *perf,
 		  const cairo_boilerplate_target_t *target,
 		  const char			   *trace)
 {
     struct trace args;
+    struct profile profile;
     cairo_surface_t *real;
 
     args.target = target;
+    args.csi = NULL;
+    args.profile = NULL;
     real = target->create_surface (NULL,
 				   CAIRO_CONTENT_COLOR_ALPHA,
 				   1, 1,
@@ -430,14 +596,30 @@ cairo_perf_trace (cairo_perf_t			   *perf,
 	return;
     }
 
-    printf ("Observing '%s'...", trace);
-    fflush (stdout);
+    if (perf->profile) {
+	char *trace_cpy = xstrdup (trace);
 
-    execute (perf, &args, trace);
+	memset (&profile, 0, sizeof (profile));
+	args.profile = &profile;
+	cairo_device_observer_add_operation_callback (cairo_surface_get_device (args.surface),
+						      profile_operation,
+						      &args);
 
-    printf ("\n");
-    cairo_device_observer_print (cairo_surface_get_device (args.surface),
-				 print, stdout);
+	execute (perf, &args, trace);
+
+	profile_print (&profile, basename_no_ext (trace_cpy));
+	profile_fini (&profile);
+	free (trace_cpy);
+    } else {
+	printf ("Observing '%s'...", trace);
+	fflush (stdout);
+
+	execute (perf, &args, trace);
+
+	printf ("\n");
+	cairo_device_observer_print (cairo_surface_get_device (args.surface),
+				     print, stdout);
+    }
     fflush (stdout);
 
     cairo_surface_destroy (args.surface);
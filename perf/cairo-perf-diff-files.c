@@ -40,6 +40,7 @@ typedef struct _cairo_perf_report_options {
     int use_utf;
     int print_change_bars;
     int use_ticks;
+    int print_counters;
 } cairo_perf_report_options_t;
 
 typedef struct _cairo_perf_diff_files_args {
@@ -149,6 +150,43 @@ print_change_bar (double change,
     printf ("\n");
 }
 
+/* Hardware counters are only present when both reports sampled them,
+ * and are shown as a percentage change as for a counter "lower is
+ * better" is all we can say. */
+static void
+test_diff_print_counters_binary (test_diff_t *diff)
+{
+    const cairo_perf_counters_t *old = &diff->tests[0]->counters_median;
+    const cairo_perf_counters_t *new = &diff->tests[1]->counters_median;
+    int n;
+
+    for (n = 0; n < CAIRO_PERF_NUM_COUNTERS; n++) {
+	if (isnan (old->value[n]) || isnan (new->value[n]))
+	    continue;
+
+	printf ("%28s %-14s %10.4g -> %10.4g: %+6.1f%%\n", "",
+		cairo_perf_counter_name (n),
+		old->value[n], new->value[n],
+		old->value[n] ?
+		100. * (new->value[n] - old->value[n]) / old->value[n] : 0.);
+    }
+}
+
+static void
+test_report_print_counters (const test_report_t *test)
+{
+    int n;
+
+    for (n = 0; n < CAIRO_PERF_NUM_COUNTERS; n++) {
+	if (isnan (test->counters_median.value[n]))
+	    continue;
+
+	printf (" %s: %.4g",
+		cairo_perf_counter_name (n),
+		test->counters_median.value[n]);
+    }
+}
+
 static void
 test_diff_print_binary (test_diff_t		    *diff,
 			double			     max_change,
@@ -178,6 +216,9 @@ test_diff_print_binary (test_diff_t		    *diff,
     if (options->print_change_bars)
 	print_change_bar (fabs (diff->change), max_change,
 			  options->use_utf);
+
+    if (options->print_counters)
+	test_diff_print_counters_binary (diff);
 }
 
 static void
@@ -215,6 +256,14 @@ test_diff_print_multi (test_diff_t		   *diff,
 	    print_change_bar (change, max_change, options->use_utf);
 	else
 	    printf("\n");
+
+	if (options->print_counters &&
+	    diff->tests[i]->counters_count)
+	{
+	    printf ("   ");
+	    test_report_print_counters (diff->tests[i]);
+	    printf ("\n");
+	}
     }
 
     printf("\n");
@@ -403,6 +452,10 @@ usage (const char *argv0)
 	     "\n"
 	     "--no-bars   Don't display change bars at all.\n\n"
 	     "\n"
+	     "--no-counters\n"
+	     "            Don't display hardware performance counters, even\n"
+	     "            if they were recorded (cairo-perf -p).\n"
+	     "\n"
 	     "--use-ms    Use milliseconds to calculate differences.\n"
 	     "            (instead of ticks which are hardware dependent)\n"
 	     "\n"
@@ -429,6 +482,9 @@ parse_args (int 			   argc,
 	else if (strcmp (argv[i], "--no-bars") == 0) {
 	    args->options.print_change_bars = 0;
 	}
+	else if (strcmp (argv[i], "--no-counters") == 0) {
+	    args->options.print_counters = 0;
+	}
 	else if (strcmp (argv[i], "--use-ms") == 0) {
 	    /* default */
 	}
@@ -469,6 +525,8 @@ main (int	  argc,
 	    0.05,		/* min change */
 	    1,			/* use UTF-8? */
 	    1,			/* display change bars? */
+	    0,			/* use ticks? */
+	    1,			/* display counters? */
 	}
     };
     cairo_perf_report_t *reports;
@@ -495,6 +553,7 @@ main (int	  argc,
     for (i = 0; i < args.num_filenames; i++) {
 	for (t = reports[i].tests; t->name; t++) {
 	    free (t->samples);
+	    free (t->counters);
 	    free (t->backend);
 	    free (t->name);
 	}
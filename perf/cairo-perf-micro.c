@@ -183,6 +183,15 @@ cairo_perf_run (cairo_perf_t	   *perf,
 	if (perf->raw) {
 	    printf ("[ # ] %s.%-s %s %s %s ...\n",
 		    "backend", "content", "test-size", "ticks-per-ms", "time(ticks)");
+	    if (perf->counters) {
+		printf ("[ # ] %s.%-s %s %s,%s,%s,%s,%s ...\n",
+			"backend", "content", "test-size",
+			cairo_perf_counter_name (CAIRO_PERF_COUNTER_CYCLES),
+			cairo_perf_counter_name (CAIRO_PERF_COUNTER_INSTRUCTIONS),
+			cairo_perf_counter_name (CAIRO_PERF_COUNTER_L1D_MISSES),
+			cairo_perf_counter_name (CAIRO_PERF_COUNTER_LLC_MISSES),
+			cairo_perf_counter_name (CAIRO_PERF_COUNTER_BRANCH_MISSES));
+	    }
 	}
 
 	if (perf->summary) {
@@ -261,6 +270,14 @@ cairo_perf_run (cairo_perf_t	   *perf,
 		cairo_pattern_destroy (cairo_pop_group (perf->cr));
 	    else
 		cairo_restore (perf->cr);
+	    if (perf->counters) {
+		cairo_perf_counters_t *counters = &perf->counters_samples[i];
+		int n;
+
+		cairo_perf_timer_counters (counters);
+		for (n = 0; n < CAIRO_PERF_NUM_COUNTERS; n++)
+		    counters->value[n] /= loops;
+	    }
 	    if (perf->raw) {
 		if (i == 0)
 		    printf ("[*] %s.%s %s.%d %g",
@@ -284,8 +301,17 @@ cairo_perf_run (cairo_perf_t	   *perf,
 	    }
 	}
 
-	if (perf->raw)
+	if (perf->raw) {
 	    printf ("\n");
+	    if (perf->counters) {
+		printf ("[@] %s.%s %s.%d",
+			perf->target->name,
+			_content_to_string (perf->target->content, similar),
+			name, perf->size);
+		cairo_perf_counters_print_raw (stdout, perf->counters_samples, i);
+		printf ("\n");
+	    }
+	}
 
 	if (perf->summary) {
 	    _cairo_stats_compute (&stats, times, i);
@@ -308,6 +334,9 @@ cairo_perf_run (cairo_perf_t	   *perf,
 			 _cairo_time_to_s (stats.median_ticks) * 1000.0 / loops,
 			 stats.std_dev * 100.0, stats.iterations);
 	    }
+	    if (perf->counters)
+		cairo_perf_counters_print_summary (perf->summary,
+						   perf->counters_samples, i);
 	    fflush (perf->summary);
 	}
 
@@ -319,7 +348,7 @@ static void
 usage (const char *argv0)
 {
     fprintf (stderr,
-"Usage: %s [-flrv] [-i iterations] [test-names ...]\n"
+"Usage: %s [-flprv] [-i iterations] [test-names ...]\n"
 "\n"
 "Run the cairo performance test suite over the given tests (all by default)\n"
 "The command-line arguments are interpreted as follows:\n"
@@ -327,6 +356,7 @@ usage (const char *argv0)
 "  -f	fast; faster, less accurate\n"
 "  -i	iterations; specify the number of iterations per test case\n"
 "  -l	list only; just list selected test case names without executing\n"
+"  -p	perf counters; also sample hardware performance counters (Linux)\n"
 "  -r	raw; display each time measurement instead of summary statistics\n"
 "  -v	verbose; in raw mode also show the summaries\n"
 "\n"
@@ -359,13 +389,14 @@ parse_options (cairo_perf_t *perf,
     }
 
     perf->raw = FALSE;
+    perf->counters = FALSE;
     perf->list_only = FALSE;
     perf->names = NULL;
     perf->num_names = 0;
     perf->summary = stdout;
 
     while (1) {
-	c = _cairo_getopt (argc, argv, "fi:lrv");
+	c = _cairo_getopt (argc, argv, "fi:lprv");
 	if (c == -1)
 	    break;
 
@@ -387,6 +418,9 @@ parse_options (cairo_perf_t *perf,
 	case 'l':
 	    perf->list_only = TRUE;
 	    break;
+	case 'p':
+	    perf->counters = TRUE;
+	    break;
 	case 'r':
 	    perf->raw = TRUE;
 	    perf->summary = NULL;
@@ -453,6 +487,8 @@ cairo_perf_fini (cairo_perf_t *perf)
     cairo_boilerplate_fini ();
 
     free (perf->times);
+    free (perf->counters_samples);
+    cairo_perf_counters_fini ();
     cairo_debug_reset_static_data ();
 #if HAVE_FCFINI
     FcFini ();
@@ -486,6 +522,18 @@ main (int   argc,
     perf.targets = cairo_boilerplate_get_targets (&perf.num_targets, NULL);
     perf.times = xmalloc (perf.iterations * sizeof (cairo_time_t));
 
+    perf.counters_samples = NULL;
+    if (perf.counters) {
+	if (cairo_perf_counters_init ()) {
+	    perf.counters_samples =
+		xmalloc (perf.iterations * sizeof (cairo_perf_counters_t));
+	} else {
+	    fputs ("WARNING: hardware performance counters are unavailable.\n",
+		   stderr);
+	    perf.counters = FALSE;
+	}
+    }
+
     for (i = 0; i < perf.num_targets; i++) {
 	const cairo_boilerplate_target_t *target = perf.targets[i];
 
@@ -564,6 +612,7 @@ const cairo_perf_case_t perf_cases[] = {
     { FUNC(hatching),   64, 512},
     { FUNC(tessellate), 100, 100},
     { FUNC(subimage_copy), 16, 512},
+    { FUNC(pixel_transfer), 64, 512},
     { FUNC(hash_table), 16, 16},
     { FUNC(pattern_create_radial), 16, 16},
     { FUNC(zrusin), 415, 415},
@@ -117,7 +117,9 @@ test_report_parse (test_report_t *report,
     char *end;
     char *s = line;
     cairo_bool_t is_raw = FALSE;
+    cairo_bool_t is_counters = FALSE;
     double min_time, median_time;
+    int n;
 
     /* The code here looks funny unless you understand that these are
      * all macro calls, (and then the code just looks sick). */
@@ -131,6 +133,9 @@ test_report_parse (test_report_t *report,
     if (*s == '*') {
 	s++;
 	is_raw = TRUE;
+    } else if (*s == '@') {
+	s++;
+	is_counters = TRUE;
     } else {
 	parse_int (report->id);
     }
@@ -160,7 +165,36 @@ test_report_parse (test_report_t *report,
     report->samples_size = 0;
     report->samples_count = 0;
 
-    if (is_raw) {
+    report->counters = NULL;
+    report->counters_size = 0;
+    report->counters_count = 0;
+    for (n = 0; n < CAIRO_PERF_NUM_COUNTERS; n++)
+	report->counters_median.value[n] = NAN;
+
+    if (is_counters) {
+	/* One comma-separated set of counters per sample, in the
+	 * order of cairo_perf_counter_t. */
+	report->stats.ticks_per_ms = 0;
+	report->stats.iterations = 0;
+
+	report->counters_size = 5;
+	report->counters = xmalloc (report->counters_size * sizeof (cairo_perf_counters_t));
+	do {
+	    if (report->counters_count == report->counters_size) {
+		report->counters_size *= 2;
+		report->counters = xrealloc (report->counters,
+					     report->counters_size * sizeof (cairo_perf_counters_t));
+	    }
+	    for (n = 0; n < CAIRO_PERF_NUM_COUNTERS; n++) {
+		if (n)
+		    skip_char (',');
+		parse_double (report->counters[report->counters_count].value[n]);
+	    }
+	    report->counters_count++;
+	    skip_space ();
+	} while (*s && *s != '\n');
+	skip_char ('\n');
+    } else if (is_raw) {
 	parse_double (report->stats.ticks_per_ms);
 	skip_space ();
 
@@ -361,10 +395,30 @@ cairo_perf_report_sort_and_compute_stats (cairo_perf_report_t *report,
 			    t->samples_count * sizeof (cairo_time_t));
 		    base->samples_count += t->samples_count;
 		}
+
+		new_samples_count = base->counters_count;
+		for (t = base + 1; t < next; t++)
+		    new_samples_count += t->counters_count;
+		if (new_samples_count > base->counters_size) {
+		    base->counters_size = new_samples_count;
+		    base->counters = xrealloc (base->counters,
+					       base->counters_size * sizeof (cairo_perf_counters_t));
+		}
+		for (t = base + 1; t < next; t++) {
+		    memcpy (&base->counters[base->counters_count], t->counters,
+			    t->counters_count * sizeof (cairo_perf_counters_t));
+		    base->counters_count += t->counters_count;
+		    /* the counters may have sorted before the times */
+		    if (base->stats.ticks_per_ms == 0)
+			base->stats.ticks_per_ms = t->stats.ticks_per_ms;
+		}
 	    }
 	}
-	if (base->samples)
+	if (base->samples_count)
 	    _cairo_stats_compute (&base->stats, base->samples, base->samples_count);
+	if (base->counters_count)
+	    _cairo_stats_compute_counters (&base->counters_median,
+					   base->counters, base->counters_count);
 	base = next;
     }
 }
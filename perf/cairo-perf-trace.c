@@ -369,7 +369,7 @@ static void
 usage (const char *argv0)
 {
     fprintf (stderr,
-"Usage: %s [-clrsv] [-i iterations] [-t tile-size] [-x exclude-file] [test-names ... | traces ...]\n"
+"Usage: %s [-clprsv] [-i iterations] [-t tile-size] [-x exclude-file] [test-names ... | traces ...]\n"
 "\n"
 "Run the cairo performance test suite over the given tests (all by default)\n"
 "The command-line arguments are interpreted as follows:\n"
@@ -377,6 +377,7 @@ usage (const char *argv0)
 "  -c	use surface cache; keep a cache of surfaces to be reused\n"
 "  -i	iterations; specify the number of iterations per test case\n"
 "  -l	list only; just list selected test case names without executing\n"
+"  -p	perf counters; also sample hardware performance counters (Linux)\n"
 "  -r	raw; display each time measurement instead of summary statistics\n"
 "  -s	sync; only sum the elapsed time of the indiviual operations\n"
 "  -t	tile size; draw to tiled surfaces\n"
@@ -450,6 +451,7 @@ parse_options (cairo_perf_t *perf,
     perf->exact_iterations = 0;
 
     perf->raw = FALSE;
+    perf->counters = FALSE;
     perf->observe = FALSE;
     perf->list_only = FALSE;
     perf->tile_size = 0;
@@ -461,7 +463,7 @@ parse_options (cairo_perf_t *perf,
     perf->num_exclude_names = 0;
 
     while (1) {
-	c = _cairo_getopt (argc, argv, "ci:lrst:vx:");
+	c = _cairo_getopt (argc, argv, "ci:lprst:vx:");
 	if (c == -1)
 	    break;
 
@@ -481,6 +483,9 @@ parse_options (cairo_perf_t *perf,
 	case 'l':
 	    perf->list_only = TRUE;
 	    break;
+	case 'p':
+	    perf->counters = TRUE;
+	    break;
 	case 'r':
 	    perf->raw = TRUE;
 	    perf->summary = NULL;
@@ -520,6 +525,11 @@ parse_options (cairo_perf_t *perf,
 	exit (1);
     }
 
+    if (perf->observe && perf->counters) {
+	fprintf (stderr, "Can't mix observer and hardware counters. Sorry.\n");
+	exit (1);
+    }
+
     if (verbose && perf->summary == NULL)
 	perf->summary = stderr;
 #if HAVE_UNISTD_H
@@ -543,6 +553,8 @@ cairo_perf_fini (cairo_perf_t *perf)
     cairo_boilerplate_fini ();
 
     free (perf->times);
+    free (perf->counters_samples);
+    cairo_perf_counters_fini ();
     cairo_debug_reset_static_data ();
 #if HAVE_FCFINI
     FcFini ();
@@ -678,6 +690,15 @@ cairo_perf_trace (cairo_perf_t			   *perf,
 	if (perf->raw) {
 	    printf ("[ # ] %s.%-s %s %s %s ...\n",
 		    "backend", "content", "test-size", "ticks-per-ms", "time(ticks)");
+	    if (perf->counters) {
+		printf ("[ # ] %s.%-s %s %s,%s,%s,%s,%s ...\n",
+			"backend", "content", "test-size",
+			cairo_perf_counter_name (CAIRO_PERF_COUNTER_CYCLES),
+			cairo_perf_counter_name (CAIRO_PERF_COUNTER_INSTRUCTIONS),
+			cairo_perf_counter_name (CAIRO_PERF_COUNTER_L1D_MISSES),
+			cairo_perf_counter_name (CAIRO_PERF_COUNTER_LLC_MISSES),
+			cairo_perf_counter_name (CAIRO_PERF_COUNTER_BRANCH_MISSES));
+	    }
 	}
 
 	if (perf->summary) {
@@ -775,6 +796,8 @@ cairo_perf_trace (cairo_perf_t			   *perf,
 	    fill_surface (args.surface); /* queue a write to the sync'ed surface */
 	    cairo_perf_timer_stop ();
 	    times[i] = cairo_perf_timer_elapsed ();
+	    if (perf->counters)
+		cairo_perf_timer_counters (&perf->counters_samples[i]);
 	}
 
 	scache_clear ();
@@ -907,12 +930,24 @@ cairo_perf_trace (cairo_perf_t			   *perf,
 		     stats.std_dev * 100.0,
 		     stats.iterations, i);
 	}
+	if (perf->counters)
+	    cairo_perf_counters_print_summary (perf->summary,
+					       perf->counters_samples, i);
 	fflush (perf->summary);
     }
 
 out:
     if (perf->raw) {
 	printf ("\n");
+	if (perf->counters && i) {
+	    printf ("[@] %s.%s %s.%d",
+		    perf->target->name,
+		    "rgba",
+		    name,
+		    0);
+	    cairo_perf_counters_print_raw (stdout, perf->counters_samples, i);
+	    printf ("\n");
+	}
 	fflush (stdout);
     }
 
@@ -1008,6 +1043,18 @@ main (int   argc,
     perf.targets = cairo_boilerplate_get_targets (&perf.num_targets, NULL);
     perf.times = xmalloc (6 * perf.iterations * sizeof (cairo_time_t));
 
+    perf.counters_samples = NULL;
+    if (perf.counters) {
+	if (cairo_perf_counters_init ()) {
+	    perf.counters_samples =
+		xmalloc (perf.iterations * sizeof (cairo_perf_counters_t));
+	} else {
+	    fputs ("WARNING: hardware performance counters are unavailable.\n",
+		   stderr);
+	    perf.counters = FALSE;
+	}
+    }
+
     /* do we have a list of filenames? */
     perf.exact_names = have_trace_filenames (&perf);
 
@@ -30,6 +30,7 @@
  */
 
 #include "cairo-perf.h"
+#include "cairo-stats.h"
 #include "../src/cairo-time-private.h"
 
 #if HAVE_UNISTD_H
@@ -46,6 +47,216 @@
 #include <sched.h>
 #endif
 
+#if HAVE_LINUX_PERF_EVENT_H
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <stdint.h>
+#endif
+
+
+/* hardware counters */
+static const char *counter_names[CAIRO_PERF_NUM_COUNTERS] = {
+    "cycles",
+    "instructions",
+    "l1d-misses",
+    "llc-misses",
+    "branch-misses",
+};
+
+#if HAVE_LINUX_PERF_EVENT_H
+/* All counters are opened as a single group so that they are read
+ * together with one syscall and, should the PMU be shared with other
+ * users, are scheduled together. Only user-space events are counted
+ * which is all an unprivileged process is usually allowed to see.
+ */
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} counter_events[CAIRO_PERF_NUM_COUNTERS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+			  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+			  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL |
+			  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+			  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+static int counter_fd[CAIRO_PERF_NUM_COUNTERS];
+static int counter_slot[CAIRO_PERF_NUM_COUNTERS];
+static int counter_group = -1;
+static int num_counter_slots;
+
+/* nr, time_enabled, time_running, value[nr] */
+static uint64_t counter_start[3 + CAIRO_PERF_NUM_COUNTERS];
+#endif
+
+static cairo_perf_counters_t counters;
+
+static cairo_bool_t
+_cairo_perf_counters_read (void *values)
+{
+#if HAVE_LINUX_PERF_EVENT_H
+    ssize_t len = (3 + num_counter_slots) * sizeof (uint64_t);
+
+    return counter_group != -1 && read (counter_group, values, len) == len;
+#else
+    return FALSE;
+#endif
+}
+
+cairo_bool_t
+cairo_perf_counters_init (void)
+{
+#if HAVE_LINUX_PERF_EVENT_H
+    struct perf_event_attr attr;
+    int n, fd;
+
+    for (n = 0; n < CAIRO_PERF_NUM_COUNTERS; n++) {
+	memset (&attr, 0, sizeof (attr));
+	attr.size = sizeof (attr);
+	attr.type = counter_events[n].type;
+	attr.config = counter_events[n].config;
+	attr.read_format = PERF_FORMAT_GROUP |
+			   PERF_FORMAT_TOTAL_TIME_ENABLED |
+			   PERF_FORMAT_TOTAL_TIME_RUNNING;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	counter_fd[n] = counter_slot[n] = -1;
+
+	/* Not every PMU (or hypervisor) provides every event, so we
+	 * simply report those that are missing as unavailable. */
+	fd = syscall (__NR_perf_event_open, &attr, 0, -1, counter_group, 0);
+	if (fd < 0)
+	    continue;
+
+	if (counter_group == -1)
+	    counter_group = fd;
+	counter_fd[n] = fd;
+	counter_slot[n] = num_counter_slots++;
+    }
+
+    return counter_group != -1;
+#else
+    return FALSE;
+#endif
+}
+
+void
+cairo_perf_counters_fini (void)
+{
+#if HAVE_LINUX_PERF_EVENT_H
+    int n;
+
+    if (counter_group == -1)
+	return;
+
+    /* Close the group leader last. */
+    for (n = CAIRO_PERF_NUM_COUNTERS; n--; ) {
+	if (counter_fd[n] != -1 && counter_fd[n] != counter_group)
+	    close (counter_fd[n]);
+	counter_fd[n] = -1;
+    }
+    close (counter_group);
+    counter_group = -1;
+    num_counter_slots = 0;
+#endif
+}
+
+const char *
+cairo_perf_counter_name (cairo_perf_counter_t counter)
+{
+    return counter_names[counter];
+}
+
+static void
+_cairo_perf_counters_start (void)
+{
+#if HAVE_LINUX_PERF_EVENT_H
+    if (! _cairo_perf_counters_read (counter_start))
+	counter_start[0] = 0;
+#endif
+}
+
+static void
+_cairo_perf_counters_stop (void)
+{
+#if HAVE_LINUX_PERF_EVENT_H
+    uint64_t end[3 + CAIRO_PERF_NUM_COUNTERS];
+    double scale = 0.;
+    int n;
+
+    /* If the group was not on the PMU for the whole interval, scale
+     * up the counts in proportion. */
+    if (counter_start[0] && _cairo_perf_counters_read (end)) {
+	uint64_t enabled = end[1] - counter_start[1];
+	uint64_t running = end[2] - counter_start[2];
+	if (running)
+	    scale = enabled / (double) running;
+    }
+
+    for (n = 0; n < CAIRO_PERF_NUM_COUNTERS; n++) {
+	int slot = counter_slot[n];
+
+	if (scale && slot != -1)
+	    counters.value[n] = (end[3 + slot] - counter_start[3 + slot]) * scale;
+	else
+	    counters.value[n] = NAN;
+    }
+#else
+    int n;
+
+    for (n = 0; n < CAIRO_PERF_NUM_COUNTERS; n++)
+	counters.value[n] = NAN;
+#endif
+}
+
+void
+cairo_perf_timer_counters (cairo_perf_counters_t *out)
+{
+    *out = counters;
+}
+
+/* The raw format, as read back by cairo_perf_report_load(), is one
+ * comma-separated set of counters per sample. */
+void
+cairo_perf_counters_print_raw (FILE			   *file,
+			       const cairo_perf_counters_t *samples,
+			       int			    num_samples)
+{
+    int i, n;
+
+    for (i = 0; i < num_samples; i++) {
+	for (n = 0; n < CAIRO_PERF_NUM_COUNTERS; n++)
+	    fprintf (file, "%c%g", n ? ',' : ' ', samples[i].value[n]);
+    }
+}
+
+void
+cairo_perf_counters_print_summary (FILE			       *file,
+				   const cairo_perf_counters_t *samples,
+				   int				num_samples)
+{
+    cairo_perf_counters_t median;
+    int n;
+
+    if (num_samples == 0)
+	return;
+
+    _cairo_stats_compute_counters (&median, samples, num_samples);
+
+    fprintf (file, "[ # ] %8s", "");
+    for (n = 0; n < CAIRO_PERF_NUM_COUNTERS; n++) {
+	if (isnan (median.value[n]))
+	    fprintf (file, " %s: n/a", counter_names[n]);
+	else
+	    fprintf (file, " %s: %.4g", counter_names[n], median.value[n]);
+    }
+    fprintf (file, "\n");
+}
 
 /* timers */
 static cairo_time_t timer;
@@ -63,6 +274,7 @@ cairo_perf_timer_set_synchronize (cairo_perf_timer_synchronize_t  synchronize,
 void
 cairo_perf_timer_start (void)
 {
+    _cairo_perf_counters_start ();
     timer = _cairo_time_get ();
 }
 
@@ -73,6 +285,7 @@ cairo_perf_timer_stop (void)
 	cairo_perf_timer_synchronize (cairo_perf_timer_synchronize_closure);
 
     timer = _cairo_time_get_delta (timer);
+    _cairo_perf_counters_stop ();
 }
 
 cairo_time_t
@@ -58,6 +58,44 @@ cairo_perf_timer_set_synchronize (cairo_perf_timer_synchronize_t  synchronize,
 cairo_time_t
 cairo_perf_timer_elapsed (void);
 
+/* hardware performance counters, sampled along with the timer */
+
+typedef enum _cairo_perf_counter {
+    CAIRO_PERF_COUNTER_CYCLES,
+    CAIRO_PERF_COUNTER_INSTRUCTIONS,
+    CAIRO_PERF_COUNTER_L1D_MISSES,
+    CAIRO_PERF_COUNTER_LLC_MISSES,
+    CAIRO_PERF_COUNTER_BRANCH_MISSES,
+    CAIRO_PERF_NUM_COUNTERS
+} cairo_perf_counter_t;
+
+/* A counter which could not be read is NAN. */
+typedef struct _cairo_perf_counters {
+    double value[CAIRO_PERF_NUM_COUNTERS];
+} cairo_perf_counters_t;
+
+cairo_bool_t
+cairo_perf_counters_init (void);
+
+void
+cairo_perf_counters_fini (void);
+
+const char *
+cairo_perf_counter_name (cairo_perf_counter_t counter);
+
+void
+cairo_perf_timer_counters (cairo_perf_counters_t *counters);
+
+void
+cairo_perf_counters_print_raw (FILE			   *file,
+			       const cairo_perf_counters_t *samples,
+			       int			    num_samples);
+
+void
+cairo_perf_counters_print_summary (FILE			       *file,
+				   const cairo_perf_counters_t *samples,
+				   int				num_samples);
+
 /* yield */
 
 void
@@ -74,6 +112,8 @@ typedef struct _cairo_perf {
     cairo_bool_t raw;
     cairo_bool_t list_only;
     cairo_bool_t observe;
+    cairo_bool_t profile;
+    cairo_bool_t counters;
     char **names;
     unsigned int num_names;
     char **exclude_names;
@@ -87,6 +127,7 @@ typedef struct _cairo_perf {
 
     /* Stuff used internally */
     cairo_time_t *times;
+    cairo_perf_counters_t *counters_samples;
     const cairo_boilerplate_target_t **targets;
     int num_targets;
     const cairo_boilerplate_target_t *target;
@@ -135,10 +176,17 @@ typedef struct _test_report {
     unsigned int samples_size;
     unsigned int samples_count;
 
+    /* The counters, one set per sample, are only present in raw
+     * reports recorded with hardware counters enabled. */
+    cairo_perf_counters_t *counters;
+    unsigned int counters_size;
+    unsigned int counters_count;
+
     /* The stats are either read directly or computed from samples.
      * If the stats have not yet been computed from samples, then
      * iterations will be 0. */
     cairo_stats_t stats;
+    cairo_perf_counters_t counters_median;
 } test_report_t;
 
 typedef struct _test_diff {
@@ -192,6 +240,7 @@ CAIRO_PERF_DECL (paint_with_alpha);
 CAIRO_PERF_DECL (mask);
 CAIRO_PERF_DECL (stroke);
 CAIRO_PERF_DECL (subimage_copy);
+CAIRO_PERF_DECL (pixel_transfer);
 CAIRO_PERF_DECL (disjoint);
 CAIRO_PERF_DECL (hatching);
 CAIRO_PERF_DECL (tessellate);
@@ -97,3 +97,43 @@ _cairo_stats_compute (cairo_stats_t *stats,
     }
     stats->std_dev = sqrt(s / num_valid);
 }
+
+static int
+_double_cmp (const void *a,
+	     const void *b)
+{
+    double da = *(const double *) a;
+    double db = *(const double *) b;
+
+    return da < db ? -1 : da > db ? 1 : 0;
+}
+
+/* Counters are summarised by their median, which unlike the minimum
+ * is not biased by the odd sample that lost events to multiplexing.
+ */
+void
+_cairo_stats_compute_counters (cairo_perf_counters_t	   *median,
+			       const cairo_perf_counters_t *samples,
+			       int			    num_samples)
+{
+    double *values;
+    int i, n, num_valid;
+
+    values = xmalloc (num_samples * sizeof (double));
+    for (n = 0; n < CAIRO_PERF_NUM_COUNTERS; n++) {
+	num_valid = 0;
+	for (i = 0; i < num_samples; i++) {
+	    if (! isnan (samples[i].value[n]))
+		values[num_valid++] = samples[i].value[n];
+	}
+
+	if (num_valid == 0) {
+	    median->value[n] = NAN;
+	    continue;
+	}
+
+	qsort (values, num_valid, sizeof (double), _double_cmp);
+	median->value[n] = values[num_valid / 2];
+    }
+    free (values);
+}
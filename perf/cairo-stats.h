@@ -33,4 +33,9 @@ _cairo_stats_compute (cairo_stats_t *stats,
 		      cairo_time_t  *values,
 		      int	     num_values);
 
+void
+_cairo_stats_compute_counters (cairo_perf_counters_t	   *median,
+			       const cairo_perf_counters_t *samples,
+			       int			    num_samples);
+
 #endif /* _CAIRO_STATS_H_ */
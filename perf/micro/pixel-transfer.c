@@ -0,0 +1,102 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Measures the cost of moving pixels between client memory and the
+ * target: uploading an image that changes every frame, and mapping a
+ * region of the target to an image and back again.
+ */
+
+#include "cairo-perf.h"
+
+static cairo_surface_t *image;
+
+static cairo_time_t
+do_upload (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_surface (cr, image, 0, 0);
+
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	/* as if the application had drawn a new frame into the image */
+	cairo_surface_mark_dirty (image);
+	cairo_paint (cr);
+    }
+
+    cairo_perf_timer_stop ();
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static cairo_time_t
+do_map (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_surface_t *target = cairo_get_target (cr);
+    cairo_rectangle_int_t extents;
+    cairo_surface_t *map;
+
+    extents.x = extents.y = 0;
+    extents.width = width;
+    extents.height = height;
+
+    cairo_set_source_rgb (cr, 0, 0, 1);
+    cairo_paint (cr);
+
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	map = cairo_surface_map_to_image (target, &extents);
+	cairo_surface_unmap_image (target, map);
+    }
+
+    cairo_perf_timer_stop ();
+
+    return cairo_perf_timer_elapsed ();
+}
+
+cairo_bool_t
+pixel_transfer_enabled (cairo_perf_t *perf)
+{
+    return cairo_perf_can_run (perf, "pixel-transfer", NULL);
+}
+
+void
+pixel_transfer (cairo_perf_t *perf, cairo_t *cr, int width, int height)
+{
+    cairo_t *cr2;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+    cr2 = cairo_create (image);
+    cairo_set_source_rgb (cr2, 1, 0, 0);
+    cairo_paint (cr2);
+    cairo_set_source_rgb (cr2, 0, 1, 0);
+    cairo_rectangle (cr2, width / 4, height / 4, width / 2, height / 2);
+    cairo_fill (cr2);
+    cairo_destroy (cr2);
+
+    cairo_perf_run (perf, "pixel-transfer-upload", do_upload, NULL);
+    cairo_perf_run (perf, "pixel-transfer-map", do_map, NULL);
+
+    cairo_surface_destroy (image);
+    image = NULL;
+}
@@ -0,0 +1,724 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is Red Hat, Inc.
+ */
+
+/* This surface records all drawing into a queue which a dedicated
+ * thread replays onto an image surface, so that the drawing thread
+ * only pays for recording the operations.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-async.h"
+
+#include "cairo-default-context-private.h"
+#include "cairo-error-private.h"
+#include "cairo-image-surface-inline.h"
+#include "cairo-pattern-private.h"
+#include "cairo-recording-surface-inline.h"
+#include "cairo-recording-surface-private.h"
+#include "cairo-surface-backend-private.h"
+#include "cairo-surface-snapshot-inline.h"
+
+#include <pthread.h>
+
+/* The number of operations that may be queued before the drawing
+ * thread waits for the render thread to catch up. */
+#define ASYNC_MAX_PENDING 1024
+
+typedef struct _cairo_async_surface {
+    cairo_surface_t base;
+
+    cairo_surface_t *target;
+    cairo_rectangle_int_t extents;
+    cairo_font_options_t font_options;
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t wakeup;	/* a batch was queued, or shutdown */
+    pthread_cond_t progress;	/* a batch was taken, or completed */
+
+    /* Protected by the mutex */
+    cairo_surface_t *pending;	/* the recording of the queued operations */
+    int num_pending;
+    cairo_bool_t busy;
+    cairo_bool_t shutdown;
+    cairo_status_t error;
+} cairo_async_surface_t;
+
+static const cairo_surface_backend_t cairo_async_surface_backend;
+
+static void *
+_cairo_async_surface_worker (void *closure)
+{
+    cairo_async_surface_t *surface = closure;
+
+    pthread_mutex_lock (&surface->mutex);
+    for (;;) {
+	cairo_surface_t *batch;
+	cairo_status_t status;
+
+	while (surface->pending == NULL && ! surface->shutdown)
+	    pthread_cond_wait (&surface->wakeup, &surface->mutex);
+	if (surface->pending == NULL)
+	    break;
+
+	batch = surface->pending;
+	surface->pending = NULL;
+	surface->num_pending = 0;
+	surface->busy = TRUE;
+	pthread_cond_broadcast (&surface->progress);
+	pthread_mutex_unlock (&surface->mutex);
+
+	status = _cairo_recording_surface_replay (batch, surface->target);
+	cairo_surface_destroy (batch);
+
+	pthread_mutex_lock (&surface->mutex);
+	if (unlikely (status) && surface->error == CAIRO_STATUS_SUCCESS)
+	    surface->error = status;
+	surface->busy = FALSE;
+	pthread_cond_broadcast (&surface->progress);
+    }
+    pthread_mutex_unlock (&surface->mutex);
+
+    return NULL;
+}
+
+/* Wait until everything recorded so far has reached the target. */
+static cairo_status_t
+_cairo_async_surface_sync (cairo_async_surface_t *surface)
+{
+    cairo_status_t status;
+
+    pthread_mutex_lock (&surface->mutex);
+    while (surface->pending != NULL || surface->busy)
+	pthread_cond_wait (&surface->progress, &surface->mutex);
+    status = surface->error;
+    pthread_mutex_unlock (&surface->mutex);
+
+    return status;
+}
+
+/* Lock the queue for recording another operation. On success the
+ * mutex is held until _cairo_async_surface_end_record(). */
+static cairo_status_t
+_cairo_async_surface_begin_record (cairo_async_surface_t *surface)
+{
+    cairo_status_t status;
+
+    pthread_mutex_lock (&surface->mutex);
+    while (surface->num_pending >= ASYNC_MAX_PENDING)
+	pthread_cond_wait (&surface->progress, &surface->mutex);
+
+    status = surface->error;
+    if (unlikely (status))
+	goto unlock;
+
+    if (surface->pending == NULL) {
+	cairo_rectangle_t r;
+	cairo_surface_t *batch;
+
+	r.x = surface->extents.x;
+	r.y = surface->extents.y;
+	r.width = surface->extents.width;
+	r.height = surface->extents.height;
+
+	batch = cairo_recording_surface_create (surface->target->content, &r);
+	status = batch->status;
+	if (unlikely (status)) {
+	    cairo_surface_destroy (batch);
+	    goto unlock;
+	}
+
+	/* The target is not clear, so clears must reach it. */
+	((cairo_recording_surface_t *) batch)->optimize_clears = FALSE;
+	surface->pending = batch;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+
+unlock:
+    pthread_mutex_unlock (&surface->mutex);
+    return status;
+}
+
+static void
+_cairo_async_surface_end_record (cairo_async_surface_t *surface)
+{
+    surface->num_pending++;
+    if (! surface->busy)
+	pthread_cond_signal (&surface->wakeup);
+    pthread_mutex_unlock (&surface->mutex);
+}
+
+/* The render thread reads the sources long after the drawing call has
+ * returned, by which time the caller may have drawn onto them again.
+ * So rather than the usual copy-on-write snapshot, which shares the
+ * pixels until the next modification, we take an immutable copy now
+ * and keep it attached to the source until that is next modified.
+ */
+static cairo_surface_t *
+_cairo_async_surface_copy_source (cairo_surface_t *source)
+{
+    const cairo_surface_backend_t *backend;
+    cairo_surface_t *clone;
+
+    if (source->snapshot_of != NULL && ! _cairo_surface_is_snapshot (source))
+	return cairo_surface_reference (source);
+
+    if (_cairo_surface_is_recording (source))
+	backend = source->backend;
+    else
+	backend = &_cairo_image_surface_backend;
+
+    clone = _cairo_surface_has_snapshot (source, backend);
+    if (clone != NULL)
+	return cairo_surface_reference (clone);
+
+    if (_cairo_surface_is_recording (source)) {
+	clone = source->backend->snapshot (source);
+    } else {
+	cairo_image_surface_t *image;
+	void *image_extra;
+	cairo_status_t status;
+
+	status = _cairo_surface_acquire_source_image (source,
+						      &image, &image_extra);
+	if (unlikely (status))
+	    return _cairo_surface_create_in_error (status);
+
+	clone = image->base.backend->snapshot (&image->base);
+	_cairo_surface_release_source_image (source, image, image_extra);
+    }
+    if (unlikely (clone->status))
+	return clone;
+
+    clone->device_transform = source->device_transform;
+    clone->device_transform_inverse = source->device_transform_inverse;
+
+    if (! _cairo_surface_is_snapshot (source))
+	_cairo_surface_attach_snapshot (source, clone, NULL);
+
+    return clone;
+}
+
+static cairo_status_t
+_cairo_async_surface_copy_pattern (cairo_pattern_union_t  *copy,
+				   const cairo_pattern_t **pattern)
+{
+    cairo_surface_t *clone;
+    cairo_status_t status;
+
+    if ((*pattern)->type != CAIRO_PATTERN_TYPE_SURFACE)
+	return CAIRO_STATUS_SUCCESS;
+
+    clone = _cairo_async_surface_copy_source (((cairo_surface_pattern_t *) *pattern)->surface);
+    status = clone->status;
+    if (unlikely (status)) {
+	cairo_surface_destroy (clone);
+	return status;
+    }
+
+    _cairo_pattern_init_static_copy (&copy->base, *pattern);
+    copy->surface.surface = clone;
+    *pattern = &copy->base;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+_cairo_async_surface_fini_pattern (cairo_pattern_union_t *copy,
+				   const cairo_pattern_t *pattern)
+{
+    if (pattern == &copy->base)
+	cairo_surface_destroy (copy->surface.surface);
+}
+
+static cairo_status_t
+_cairo_async_surface_finish (void *abstract_surface)
+{
+    cairo_async_surface_t *surface = abstract_surface;
+    cairo_status_t status;
+
+    pthread_mutex_lock (&surface->mutex);
+    surface->shutdown = TRUE;
+    pthread_cond_signal (&surface->wakeup);
+    pthread_mutex_unlock (&surface->mutex);
+
+    /* The render thread drains the queue before exiting. */
+    pthread_join (surface->thread, NULL);
+    status = surface->error;
+
+    pthread_cond_destroy (&surface->progress);
+    pthread_cond_destroy (&surface->wakeup);
+    pthread_mutex_destroy (&surface->mutex);
+
+    cairo_surface_destroy (surface->target);
+
+    return status;
+}
+
+static cairo_surface_t *
+_cairo_async_surface_create_similar (void		*abstract_surface,
+				     cairo_content_t	 content,
+				     int		 width,
+				     int		 height)
+{
+    cairo_rectangle_t rect;
+
+    /* Record groups as well, so that they are only rasterised when
+     * the render thread replays them onto the target. */
+    rect.x = rect.y = 0.;
+    rect.width = width;
+    rect.height = height;
+    return cairo_recording_surface_create (content, &rect);
+}
+
+static cairo_surface_t *
+_cairo_async_surface_create_similar_image (void			*abstract_surface,
+					   cairo_format_t	 format,
+					   int			 width,
+					   int			 height)
+{
+    cairo_async_surface_t *surface = abstract_surface;
+
+    return cairo_surface_create_similar_image (surface->target,
+					       format, width, height);
+}
+
+static cairo_image_surface_t *
+_cairo_async_surface_map_to_image (void				*abstract_surface,
+				   const cairo_rectangle_int_t	*extents)
+{
+    cairo_async_surface_t *surface = abstract_surface;
+    cairo_status_t status;
+
+    status = _cairo_async_surface_sync (surface);
+    if (unlikely (status))
+	return (cairo_image_surface_t *) _cairo_surface_create_in_error (status);
+
+    return _cairo_surface_map_to_image (surface->target, extents);
+}
+
+static cairo_int_status_t
+_cairo_async_surface_unmap_image (void			*abstract_surface,
+				  cairo_image_surface_t	*image)
+{
+    cairo_async_surface_t *surface = abstract_surface;
+
+    return _cairo_surface_unmap_image (surface->target, image);
+}
+
+static cairo_status_t
+_cairo_async_surface_acquire_source_image (void			 *abstract_surface,
+					   cairo_image_surface_t **image_out,
+					   void			**image_extra)
+{
+    cairo_async_surface_t *surface = abstract_surface;
+    cairo_status_t status;
+
+    status = _cairo_async_surface_sync (surface);
+    if (unlikely (status))
+	return status;
+
+    return _cairo_surface_acquire_source_image (surface->target,
+						image_out, image_extra);
+}
+
+static void
+_cairo_async_surface_release_source_image (void			*abstract_surface,
+					   cairo_image_surface_t	*image,
+					   void			*image_extra)
+{
+    cairo_async_surface_t *surface = abstract_surface;
+
+    _cairo_surface_release_source_image (surface->target, image, image_extra);
+}
+
+static cairo_surface_t *
+_cairo_async_surface_snapshot (void *abstract_surface)
+{
+    cairo_async_surface_t *surface = abstract_surface;
+    cairo_status_t status;
+
+    status = _cairo_async_surface_sync (surface);
+    if (unlikely (status))
+	return _cairo_surface_create_in_error (status);
+
+    return surface->target->backend->snapshot (surface->target);
+}
+
+static cairo_bool_t
+_cairo_async_surface_get_extents (void			*abstract_surface,
+				  cairo_rectangle_int_t	*rectangle)
+{
+    cairo_async_surface_t *surface = abstract_surface;
+
+    *rectangle = surface->extents;
+    return TRUE;
+}
+
+static void
+_cairo_async_surface_get_font_options (void			*abstract_surface,
+				       cairo_font_options_t	*options)
+{
+    cairo_async_surface_t *surface = abstract_surface;
+
+    _cairo_font_options_init_copy (options, &surface->font_options);
+}
+
+static cairo_status_t
+_cairo_async_surface_flush (void	*abstract_surface,
+			    unsigned	 flags)
+{
+    cairo_async_surface_t *surface = abstract_surface;
+    cairo_status_t status;
+
+    /* Only an explicit flush waits for the render thread. */
+    if (flags)
+	return CAIRO_STATUS_SUCCESS;
+
+    status = _cairo_async_surface_sync (surface);
+    if (unlikely (status))
+	return status;
+
+    return _cairo_surface_flush (surface->target, 0);
+}
+
+static cairo_status_t
+_cairo_async_surface_mark_dirty_rectangle (void	*abstract_surface,
+					   int	 x,
+					   int	 y,
+					   int	 width,
+					   int	 height)
+{
+    cairo_async_surface_t *surface = abstract_surface;
+
+    cairo_surface_mark_dirty_rectangle (surface->target, x, y, width, height);
+    return surface->target->status;
+}
+
+static cairo_int_status_t
+_cairo_async_surface_paint (void		*abstract_surface,
+			    cairo_operator_t	 op,
+			    const cairo_pattern_t	*source,
+			    const cairo_clip_t	*clip)
+{
+    cairo_async_surface_t *surface = abstract_surface;
+    cairo_pattern_union_t source_copy;
+    cairo_status_t status;
+
+    status = _cairo_async_surface_copy_pattern (&source_copy, &source);
+    if (unlikely (status))
+	return status;
+
+    status = _cairo_async_surface_begin_record (surface);
+    if (likely (status == CAIRO_STATUS_SUCCESS)) {
+	status = _cairo_surface_paint (surface->pending, op, source, clip);
+	_cairo_async_surface_end_record (surface);
+    }
+
+    _cairo_async_surface_fini_pattern (&source_copy, source);
+    return status;
+}
+
+static cairo_int_status_t
+_cairo_async_surface_mask (void			*abstract_surface,
+			   cairo_operator_t	 op,
+			   const cairo_pattern_t	*source,
+			   const cairo_pattern_t	*mask,
+			   const cairo_clip_t	*clip)
+{
+    cairo_async_surface_t *surface = abstract_surface;
+    cairo_pattern_union_t source_copy, mask_copy;
+    cairo_status_t status;
+
+    status = _cairo_async_surface_copy_pattern (&source_copy, &source);
+    if (unlikely (status))
+	return status;
+
+    status = _cairo_async_surface_copy_pattern (&mask_copy, &mask);
+    if (unlikely (status))
+	goto CLEANUP_SOURCE;
+
+    status = _cairo_async_surface_begin_record (surface);
+    if (likely (status == CAIRO_STATUS_SUCCESS)) {
+	status = _cairo_surface_mask (surface->pending, op, source, mask, clip);
+	_cairo_async_surface_end_record (surface);
+    }
+
+    _cairo_async_surface_fini_pattern (&mask_copy, mask);
+CLEANUP_SOURCE:
+    _cairo_async_surface_fini_pattern (&source_copy, source);
+    return status;
+}
+
+static cairo_int_status_t
+_cairo_async_surface_stroke (void			*abstract_surface,
+			     cairo_operator_t		 op,
+			     const cairo_pattern_t	*source,
+			     const cairo_path_fixed_t	*path,
+			     const cairo_stroke_style_t	*style,
+			     const cairo_matrix_t	*ctm,
+			     const cairo_matrix_t	*ctm_inverse,
+			     double			 tolerance,
+			     cairo_antialias_t		 antialias,
+			     const cairo_clip_t		*clip)
+{
+    cairo_async_surface_t *surface = abstract_surface;
+    cairo_pattern_union_t source_copy;
+    cairo_status_t status;
+
+    status = _cairo_async_surface_copy_pattern (&source_copy, &source);
+    if (unlikely (status))
+	return status;
+
+    status = _cairo_async_surface_begin_record (surface);
+    if (likely (status == CAIRO_STATUS_SUCCESS)) {
+	status = _cairo_surface_stroke (surface->pending, op, source,
+					path, style,
+					ctm, ctm_inverse,
+					tolerance, antialias,
+					clip);
+	_cairo_async_surface_end_record (surface);
+    }
+
+    _cairo_async_surface_fini_pattern (&source_copy, source);
+    return status;
+}
+
+static cairo_int_status_t
+_cairo_async_surface_fill (void				*abstract_surface,
+			   cairo_operator_t		 op,
+			   const cairo_pattern_t	*source,
+			   const cairo_path_fixed_t	*path,
+			   cairo_fill_rule_t		 fill_rule,
+			   double			 tolerance,
+			   cairo_antialias_t		 antialias,
+			   const cairo_clip_t		*clip)
+{
+    cairo_async_surface_t *surface = abstract_surface;
+    cairo_pattern_union_t source_copy;
+    cairo_status_t status;
+
+    status = _cairo_async_surface_copy_pattern (&source_copy, &source);
+    if (unlikely (status))
+	return status;
+
+    status = _cairo_async_surface_begin_record (surface);
+    if (likely (status == CAIRO_STATUS_SUCCESS)) {
+	status = _cairo_surface_fill (surface->pending, op, source,
+				      path, fill_rule,
+				      tolerance, antialias,
+				      clip);
+	_cairo_async_surface_end_record (surface);
+    }
+
+    _cairo_async_surface_fini_pattern (&source_copy, source);
+    return status;
+}
+
+static cairo_int_status_t
+_cairo_async_surface_glyphs (void			*abstract_surface,
+			     cairo_operator_t		 op,
+			     const cairo_pattern_t	*source,
+			     cairo_glyph_t		*glyphs,
+			     int			 num_glyphs,
+			     cairo_scaled_font_t	*scaled_font,
+			     const cairo_clip_t		*clip)
+{
+    cairo_async_surface_t *surface = abstract_surface;
+    cairo_pattern_union_t source_copy;
+    cairo_status_t status;
+
+    status = _cairo_async_surface_copy_pattern (&source_copy, &source);
+    if (unlikely (status))
+	return status;
+
+    status = _cairo_async_surface_begin_record (surface);
+    if (likely (status == CAIRO_STATUS_SUCCESS)) {
+	status = _cairo_surface_show_text_glyphs (surface->pending, op, source,
+						  NULL, 0,
+						  glyphs, num_glyphs,
+						  NULL, 0, 0,
+						  scaled_font,
+						  clip);
+	_cairo_async_surface_end_record (surface);
+    }
+
+    _cairo_async_surface_fini_pattern (&source_copy, source);
+    return status;
+}
+
+static const cairo_surface_backend_t cairo_async_surface_backend = {
+    CAIRO_SURFACE_TYPE_ASYNC,
+    _cairo_async_surface_finish,
+
+    _cairo_default_context_create,
+
+    _cairo_async_surface_create_similar,
+    _cairo_async_surface_create_similar_image,
+    _cairo_async_surface_map_to_image,
+    _cairo_async_surface_unmap_image,
+
+    _cairo_surface_default_source,
+    _cairo_async_surface_acquire_source_image,
+    _cairo_async_surface_release_source_image,
+    _cairo_async_surface_snapshot,
+
+    NULL, /* copy_page */
+    NULL, /* show_page */
+
+    _cairo_async_surface_get_extents,
+    _cairo_async_surface_get_font_options,
+
+    _cairo_async_surface_flush,
+    _cairo_async_surface_mark_dirty_rectangle,
+
+    _cairo_async_surface_paint,
+    _cairo_async_surface_mask,
+    _cairo_async_surface_stroke,
+    _cairo_async_surface_fill,
+    NULL, /* fill_stroke */
+    _cairo_async_surface_glyphs,
+};
+
+/**
+ * cairo_async_surface_create:
+ * @target: the image surface to draw onto
+ *
+ * Creates a surface that renders onto @target from a separate thread.
+ * Drawing operations on the returned surface are only recorded, with
+ * their patterns, paths and clips copied as by a recording surface,
+ * and a render thread owned by the surface replays them onto @target
+ * in order.
+ *
+ * The drawing thread waits for the render thread only when the
+ * result is needed: on cairo_surface_flush(), when the surface is
+ * mapped with cairo_surface_map_to_image(), when it is used as a
+ * source and when it is finished. In particular @target must not be
+ * read, for example with cairo_image_surface_get_data(), nor drawn
+ * to directly without first calling cairo_surface_flush() on the
+ * returned surface.
+ *
+ * Surfaces used as sources are copied when the operation is recorded
+ * unless they are already unchanged since the last copy, so that the
+ * caller may keep drawing onto them while the render thread works.
+ *
+ * Return value: the newly created surface. The caller owns the
+ * surface and should call cairo_surface_destroy() when done with it.
+ *
+ * This function always returns a valid pointer, but it will return a
+ * pointer to a "nil" surface if @target is not an image surface or if
+ * the render thread cannot be started.
+ *
+ * Since: 1.14
+ **/
+cairo_surface_t *
+cairo_async_surface_create (cairo_surface_t *target)
+{
+    cairo_async_surface_t *surface;
+
+    if (unlikely (target->status))
+	return _cairo_surface_create_in_error (target->status);
+    if (unlikely (target->finished))
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_SURFACE_FINISHED));
+
+    if (! _cairo_surface_is_image (target))
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_SURFACE_TYPE_MISMATCH));
+
+    surface = malloc (sizeof (cairo_async_surface_t));
+    if (unlikely (surface == NULL))
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_NO_MEMORY));
+
+    _cairo_surface_init (&surface->base,
+			 &cairo_async_surface_backend,
+			 NULL, /* device */
+			 target->content);
+
+    /* The target belongs to the render thread from now on, so
+     * anything we need to know about it is read here. */
+    surface->target = cairo_surface_reference (target);
+    _cairo_surface_get_extents (target, &surface->extents);
+    _cairo_font_options_init_default (&surface->font_options);
+    cairo_surface_get_font_options (target, &surface->font_options);
+
+    surface->pending = NULL;
+    surface->num_pending = 0;
+    surface->busy = FALSE;
+    surface->shutdown = FALSE;
+    surface->error = CAIRO_STATUS_SUCCESS;
+
+    pthread_mutex_init (&surface->mutex, NULL);
+    pthread_cond_init (&surface->wakeup, NULL);
+    pthread_cond_init (&surface->progress, NULL);
+
+    if (pthread_create (&surface->thread, NULL,
+			_cairo_async_surface_worker, surface) != 0)
+    {
+	pthread_cond_destroy (&surface->progress);
+	pthread_cond_destroy (&surface->wakeup);
+	pthread_mutex_destroy (&surface->mutex);
+	cairo_surface_destroy (target);
+	free (surface);
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_NO_MEMORY));
+    }
+
+    return &surface->base;
+}
+
+/**
+ * cairo_async_surface_get_target:
+ * @surface: an async surface
+ *
+ * Returns the image surface that @surface renders onto. Call
+ * cairo_surface_flush() on @surface before accessing it.
+ *
+ * Return value: the target surface, owned by @surface, or a "nil"
+ * surface if @surface is not an async surface.
+ *
+ * Since: 1.14
+ **/
+cairo_surface_t *
+cairo_async_surface_get_target (cairo_surface_t *abstract_surface)
+{
+    cairo_async_surface_t *surface;
+
+    if (unlikely (abstract_surface->status))
+	return _cairo_surface_create_in_error (abstract_surface->status);
+    if (unlikely (abstract_surface->finished))
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_SURFACE_FINISHED));
+
+    if (abstract_surface->backend != &cairo_async_surface_backend)
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_SURFACE_TYPE_MISMATCH));
+
+    surface = (cairo_async_surface_t *) abstract_surface;
+    return surface->target;
+}
@@ -142,12 +142,15 @@ struct _cairo_backend {
     cairo_status_t (*stroke_preserve) (void *cr);
     cairo_status_t (*in_stroke) (void *cr, double x, double y, cairo_bool_t *inside);
     cairo_status_t (*stroke_extents) (void *cr, double *x1, double *y1, double *x2, double *y2);
+    void (*approximate_stroke_extents) (void *cr, double *x1, double *y1, double *x2, double *y2);
 
     cairo_status_t (*fill) (void *cr);
     cairo_status_t (*fill_preserve) (void *cr);
     cairo_status_t (*in_fill) (void *cr, double x, double y, cairo_bool_t *inside);
     cairo_status_t (*fill_extents) (void *cr, double *x1, double *y1, double *x2, double *y2);
 
+    cairo_hit_test_t *(*create_hit_test) (void *cr, cairo_bool_t stroke);
+
     cairo_status_t (*set_font_face) (void *cr, cairo_font_face_t *font_face);
     cairo_font_face_t *(*get_font_face) (void *cr);
     cairo_status_t (*set_font_size) (void *cr, double size);
@@ -403,6 +403,32 @@ _cairo_clip_equal (const cairo_clip_t *clip_a,
     return cp_a == NULL && cp_b == NULL;
 }
 
+unsigned long
+_cairo_clip_hash (const cairo_clip_t *clip)
+{
+    const cairo_clip_path_t *clip_path;
+    unsigned long hash = _CAIRO_HASH_INIT_VALUE;
+
+    if (clip == NULL)
+	return hash;
+
+    if (_cairo_clip_is_all_clipped (clip))
+	return hash + 1;
+
+    hash = _cairo_hash_bytes (hash, &clip->num_boxes, sizeof (clip->num_boxes));
+    hash = _cairo_hash_bytes (hash, clip->boxes,
+			      clip->num_boxes * sizeof (cairo_box_t));
+
+    for (clip_path = clip->path; clip_path; clip_path = clip_path->prev) {
+	hash = _cairo_hash_bytes (hash,
+				  &clip_path->fill_rule,
+				  sizeof (clip_path->fill_rule));
+	hash ^= _cairo_path_fixed_hash (&clip_path->path);
+    }
+
+    return hash;
+}
+
 static cairo_clip_t *
 _cairo_clip_path_copy_with_translation (cairo_clip_t      *clip,
 					cairo_clip_path_t *other_path,
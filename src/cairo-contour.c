@@ -250,9 +250,9 @@ _cairo_contour_simplify_chain (cairo_contour_t *contour, const double tolerance,
 			       const cairo_contour_iter_t *last)
 {
     cairo_contour_iter_t iter, furthest;
-    uint64_t max_error;
-    int x0, y0;
-    int nx, ny;
+    double max_error;
+    double dx, dy, length_sq;
+    int x0, y0, x1, y1;
     int count;
 
     iter = *first;
@@ -262,17 +262,44 @@ _cairo_contour_simplify_chain (cairo_contour_t *contour, const double tolerance,
 
     x0 = first->point->x;
     y0 = first->point->y;
-    nx = last->point->y - y0;
-    ny = x0 - last->point->x;
-
+    x1 = last->point->x;
+    y1 = last->point->y;
+    dx = (double) x1 - x0;
+    dy = (double) y1 - y0;
+    length_sq = dx * dx + dy * dy;
+    if (length_sq == 0)
+	length_sq = 1;
+
+    /* The error is the distance to the chord as a segment, not as a
+     * line, as a point may lie beyond either end of the chord. It is
+     * kept squared and scaled by the squared length of the chord to
+     * avoid the division. The cross product overflows 64-bits for
+     * chords longer than a few hundred pixels, so measure the error in
+     * doubles.
+     */
     count = 0;
     max_error = 0;
     do {
 	cairo_point_t *p = iter.point;
 	if (! DELETED(p)) {
-	    uint64_t d = (uint64_t)nx * (x0 - p->x) + (uint64_t)ny * (y0 - p->y);
-	    if (d * d > max_error) {
-		max_error = d * d;
+	    double px = (double) p->x - x0;
+	    double py = (double) p->y - y0;
+	    double t = px * dx + py * dy;
+	    double d;
+
+	    if (t <= 0) {
+		d = (px * px + py * py) * length_sq;
+	    } else if (t >= length_sq) {
+		px = (double) p->x - x1;
+		py = (double) p->y - y1;
+		d = (px * px + py * py) * length_sq;
+	    } else {
+		d = px * dy - py * dx;
+		d *= d;
+	    }
+
+	    if (d > max_error) {
+		max_error = d;
 		furthest = iter;
 	    }
 	    count++;
@@ -282,7 +309,7 @@ _cairo_contour_simplify_chain (cairo_contour_t *contour, const double tolerance,
     if (count == 0)
 	return FALSE;
 
-    if (max_error > tolerance * ((uint64_t)nx * nx + (uint64_t)ny * ny)) {
+    if (max_error > tolerance * length_sq) {
 	cairo_bool_t simplified;
 
 	simplified = FALSE;
@@ -303,13 +330,47 @@ _cairo_contour_simplify_chain (cairo_contour_t *contour, const double tolerance,
     }
 }
 
+/* Squeeze out the deleted points, keeping the survivors in order. */
+static void
+_cairo_contour_compact (cairo_contour_t *contour)
+{
+    cairo_contour_chain_t *chain, *tail, *next;
+    int i, j;
+
+    tail = &contour->chain;
+    j = 0;
+    for (chain = &contour->chain; chain; chain = chain->next) {
+	int num_points = chain->num_points;
+
+	chain->num_points = 0;
+	for (i = 0; i < num_points; i++) {
+	    if (DELETED (&chain->points[i]))
+		continue;
+
+	    if (j == tail->size_points) {
+		tail = tail->next;
+		j = 0;
+	    }
+	    tail->points[j++] = chain->points[i];
+	    tail->num_points = j;
+	}
+    }
+
+    for (chain = tail->next; chain; chain = next) {
+	next = chain->next;
+	free (chain);
+    }
+
+    tail->next = NULL;
+    contour->tail = tail;
+}
+
 void
 _cairo_contour_simplify (cairo_contour_t *contour, double tolerance)
 {
     cairo_contour_chain_t *chain;
     cairo_point_t *last = NULL;
     cairo_contour_iter_t iter, furthest;
-    cairo_bool_t simplified;
     uint64_t max = 0;
     int i;
 
@@ -319,10 +380,11 @@ _cairo_contour_simplify (cairo_contour_t *contour, double tolerance)
     tolerance = tolerance * CAIRO_FIXED_ONE;
     tolerance *= tolerance;
 
-    /* stage 1: vertex reduction */
+    /* stage 1: vertex reduction, keeping both end points as the anchors */
     for (chain = &contour->chain; chain; chain = chain->next) {
 	for (i = 0; i < chain->num_points; i++) {
 	    if (last == NULL ||
+		(chain->next == NULL && i == chain->num_points - 1) ||
 		point_distance_sq (last, &chain->points[i]) > tolerance) {
 		last = &chain->points[i];
 	    } else {
@@ -330,66 +392,37 @@ _cairo_contour_simplify (cairo_contour_t *contour, double tolerance)
 	    }
 	}
     }
-
-    /* stage2: polygon simplification using Douglas-Peucker */
-    simplified = FALSE;
-    do {
-	last = &contour->chain.points[0];
-	iter_init (&furthest, contour);
-	max = 0;
-	for (chain = &contour->chain; chain; chain = chain->next) {
-	    for (i = 0; i < chain->num_points; i++) {
-		uint64_t d;
-
-		if (DELETED (&chain->points[i]))
-		    continue;
-
-		d = point_distance_sq (last, &chain->points[i]);
-		if (d > max) {
-		    furthest.chain = chain;
-		    furthest.point = &chain->points[i];
-		    max = d;
-		}
-	    }
-	}
-	assert (max);
-
-	simplified = FALSE;
-	iter_init (&iter, contour);
-	simplified |= _cairo_contour_simplify_chain (contour, tolerance,
-						     &iter, &furthest);
-
-	iter_init_last (&iter, contour);
-	if (! iter_equal (&furthest, &iter))
-	    simplified |= _cairo_contour_simplify_chain (contour, tolerance,
-							 &furthest, &iter);
-    } while (simplified);
-
-    iter_init (&iter, contour);
+    _cairo_contour_compact (contour);
+
+    /* stage2: polygon simplification using Douglas-Peucker.
+     * The split points are never deleted, so a second pass would retrace
+     * the same recursion without removing anything.
+     */
+    last = &contour->chain.points[0];
+    iter_init (&furthest, contour);
     for (chain = &contour->chain; chain; chain = chain->next) {
-	int num_points = chain->num_points;
-	chain->num_points = 0;
-	for (i = 0; i < num_points; i++) {
-	    if (! DELETED(&chain->points[i])) {
-		if (iter.point != &chain->points[i])
-		    *iter.point = chain->points[i];
-		iter.chain->num_points++;
-		iter_next (&iter);
+	for (i = 0; i < chain->num_points; i++) {
+	    uint64_t d;
+
+	    d = point_distance_sq (last, &chain->points[i]);
+	    if (d > max) {
+		furthest.chain = chain;
+		furthest.point = &chain->points[i];
+		max = d;
 	    }
 	}
     }
+    if (max == 0)
+	return;
 
-    if (iter.chain) {
-	cairo_contour_chain_t *next;
+    iter_init (&iter, contour);
+    _cairo_contour_simplify_chain (contour, tolerance, &iter, &furthest);
 
-	for (chain = iter.chain->next; chain; chain = next) {
-	    next = chain->next;
-	    free (chain);
-	}
+    iter_init_last (&iter, contour);
+    if (! iter_equal (&furthest, &iter))
+	_cairo_contour_simplify_chain (contour, tolerance, &furthest, &iter);
 
-	iter.chain->next = NULL;
-	contour->tail = iter.chain;
-    }
+    _cairo_contour_compact (contour);
 }
 
 void
@@ -52,6 +52,13 @@ struct _cairo_default_context {
     cairo_gstate_t *gstate_freelist;
 
     cairo_path_fixed_t path[1];
+
+    /* Recently popped group surfaces, kept for reuse by push_group */
+    struct _cairo_default_context_group {
+	cairo_surface_t *surface;
+	const cairo_surface_backend_t *parent;
+	cairo_content_t content;
+    } group_cache[2];
 };
 
 cairo_private cairo_t *
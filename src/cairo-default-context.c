@@ -44,9 +44,11 @@
 #include "cairo-arc-private.h"
 #include "cairo-backend-private.h"
 #include "cairo-clip-inline.h"
+#include "cairo-damage-private.h"
 #include "cairo-default-context-private.h"
 #include "cairo-error-private.h"
 #include "cairo-freed-pool-private.h"
+#include "cairo-image-surface-inline.h"
 #include "cairo-path-private.h"
 #include "cairo-pattern-private.h"
 
@@ -67,6 +69,8 @@ _cairo_default_context_reset_static_data (void)
 void
 _cairo_default_context_fini (cairo_default_context_t *cr)
 {
+    unsigned int i;
+
     while (cr->gstate != &cr->gstate_tail[0]) {
 	if (_cairo_gstate_restore (&cr->gstate, &cr->gstate_freelist))
 	    break;
@@ -82,6 +86,9 @@ _cairo_default_context_fini (cairo_default_context_t *cr)
 
     _cairo_path_fixed_fini (cr->path);
 
+    for (i = 0; i < ARRAY_LENGTH (cr->group_cache); i++)
+	cairo_surface_destroy (cr->group_cache[i].surface);
+
     _cairo_fini (&cr->base);
 }
 
@@ -132,6 +139,123 @@ _cairo_default_context_restore (void *abstract_cr)
     return _cairo_gstate_restore (&cr->gstate, &cr->gstate_freelist);
 }
 
+/* Only the area drawn upon needs to be cleared before a group surface
+ * is reused, which for image surfaces is tracked by the damage.
+ */
+static cairo_status_t
+_cairo_default_context_clear_group (cairo_surface_t *surface)
+{
+    cairo_clip_t *clip = NULL;
+    cairo_status_t status;
+
+    if (surface->is_clear)
+	return CAIRO_STATUS_SUCCESS;
+
+    if (surface->damage_is_ink) {
+	cairo_rectangle_int_t ink;
+
+	surface->damage = _cairo_damage_reduce (surface->damage);
+	if (surface->damage->status == CAIRO_STATUS_SUCCESS &&
+	    surface->damage->region != NULL)
+	{
+	    cairo_region_get_extents (surface->damage->region, &ink);
+	    clip = _cairo_clip_intersect_rectangle (NULL, &ink);
+	}
+    }
+
+    status = _cairo_surface_paint (surface,
+				   CAIRO_OPERATOR_CLEAR,
+				   &_cairo_pattern_clear.base,
+				   clip);
+    _cairo_clip_destroy (clip);
+    if (unlikely (status))
+	return status;
+
+    if (surface->damage_is_ink) {
+	_cairo_damage_destroy (surface->damage);
+	surface->damage = _cairo_damage_create ();
+	surface->is_clear = TRUE;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_surface_t *
+_cairo_default_context_create_group (cairo_default_context_t *cr,
+				     cairo_surface_t *parent,
+				     cairo_content_t content,
+				     int width, int height)
+{
+    cairo_surface_t *surface;
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_LENGTH (cr->group_cache); i++) {
+	struct _cairo_default_context_group *group = &cr->group_cache[i];
+	cairo_rectangle_int_t extents;
+
+	surface = group->surface;
+	if (surface == NULL ||
+	    group->parent != parent->backend ||
+	    group->content != content ||
+	    surface->device != parent->device)
+	    continue;
+
+	/* still in use as a source? */
+	if (CAIRO_REFERENCE_COUNT_GET_VALUE (&surface->ref_count) != 1)
+	    continue;
+
+	if (! _cairo_surface_get_extents (surface, &extents) ||
+	    extents.width != width || extents.height != height)
+	    continue;
+
+	group->surface = NULL;
+	if (_cairo_default_context_clear_group (surface) == CAIRO_STATUS_SUCCESS)
+	    return surface;
+
+	cairo_surface_destroy (surface);
+    }
+
+    surface = _cairo_surface_create_similar_solid (parent,
+						   content,
+						   width, height,
+						   CAIRO_COLOR_TRANSPARENT);
+    if (surface->status == CAIRO_STATUS_SUCCESS &&
+	_cairo_surface_is_image (surface) &&
+	surface->damage == NULL)
+    {
+	/* Everything drawn onto an image passes through a compositor,
+	 * which records the damage, so that the group can later be
+	 * composited and cleared using just the area drawn upon.
+	 */
+	surface->damage = _cairo_damage_create ();
+	surface->damage_is_ink = TRUE;
+    }
+
+    return surface;
+}
+
+static void
+_cairo_default_context_cache_group (cairo_default_context_t *cr,
+				    cairo_surface_t *parent,
+				    cairo_surface_t *surface)
+{
+    struct _cairo_default_context_group *group;
+    unsigned int i;
+
+    group = &cr->group_cache[0];
+    for (i = 0; i < ARRAY_LENGTH (cr->group_cache); i++) {
+	if (cr->group_cache[i].surface == NULL) {
+	    group = &cr->group_cache[i];
+	    break;
+	}
+    }
+
+    cairo_surface_destroy (group->surface);
+    group->surface = cairo_surface_reference (surface);
+    group->parent = parent->backend;
+    group->content = cairo_surface_get_content (surface);
+}
+
 static cairo_status_t
 _cairo_default_context_push_group (void *abstract_cr, cairo_content_t content)
 {
@@ -165,11 +289,11 @@ _cairo_default_context_push_group (void *abstract_cr, cairo_content_t content)
 	    group_surface = cairo_recording_surface_create (content, NULL);
 	    extents.x = extents.y = 0;
 	} else {
-	    group_surface = _cairo_surface_create_similar_solid (parent_surface,
+	    group_surface = _cairo_default_context_create_group (cr,
+								 parent_surface,
 								 content,
 								 extents.width,
-								 extents.height,
-								 CAIRO_COLOR_TRANSPARENT);
+								 extents.height);
 	}
 	status = group_surface->status;
 	if (unlikely (status))
@@ -210,6 +334,7 @@ _cairo_default_context_pop_group (void *abstract_cr)
     cairo_surface_t *group_surface;
     cairo_pattern_t *group_pattern;
     cairo_matrix_t group_matrix, device_transform_matrix;
+    cairo_rectangle_int_t extents;
     cairo_status_t status;
 
     /* Verify that we are at the right nesting level */
@@ -247,6 +372,14 @@ _cairo_default_context_pop_group (void *abstract_cr)
 			   &group_surface->device_transform_inverse);
     _cairo_path_fixed_transform (cr->path, &device_transform_matrix);
 
+    if (_cairo_surface_get_extents (group_surface, &extents) &&
+	extents.width > 0 && extents.height > 0)
+    {
+	_cairo_default_context_cache_group (cr,
+					    _cairo_gstate_get_target (cr->gstate),
+					    group_surface);
+    }
+
 done:
     cairo_surface_destroy (group_surface);
 
@@ -1036,6 +1169,17 @@ _cairo_default_context_stroke_extents (void *abstract_cr,
 					 x1, y1, x2, y2);
 }
 
+static void
+_cairo_default_context_approximate_stroke_extents (void *abstract_cr,
+						   double *x1, double *y1, double *x2, double *y2)
+{
+    cairo_default_context_t *cr = abstract_cr;
+
+    _cairo_gstate_approximate_stroke_extents (cr->gstate,
+					      cr->path,
+					      x1, y1, x2, y2);
+}
+
 static cairo_status_t
 _cairo_default_context_fill_preserve (void *abstract_cr)
 {
@@ -1070,6 +1214,15 @@ _cairo_default_context_in_fill (void *abstract_cr,
     return CAIRO_STATUS_SUCCESS;
 }
 
+static cairo_hit_test_t *
+_cairo_default_context_create_hit_test (void *abstract_cr,
+					cairo_bool_t stroke)
+{
+    cairo_default_context_t *cr = abstract_cr;
+
+    return _cairo_gstate_create_hit_test (cr->gstate, cr->path, stroke);
+}
+
 static cairo_status_t
 _cairo_default_context_fill_extents (void *abstract_cr,
 				     double *x1, double *y1, double *x2, double *y2)
@@ -1412,12 +1565,15 @@ static const cairo_backend_t _cairo_default_context_backend = {
     _cairo_default_context_stroke_preserve,
     _cairo_default_context_in_stroke,
     _cairo_default_context_stroke_extents,
+    _cairo_default_context_approximate_stroke_extents,
 
     _cairo_default_context_fill,
     _cairo_default_context_fill_preserve,
     _cairo_default_context_in_fill,
     _cairo_default_context_fill_extents,
 
+    _cairo_default_context_create_hit_test,
+
     _cairo_default_context_set_font_face,
     _cairo_default_context_get_font_face,
     _cairo_default_context_set_font_size,
@@ -1447,6 +1603,8 @@ _cairo_default_context_init (cairo_default_context_t *cr, void *target)
     cr->gstate_freelist = &cr->gstate_tail[1];
     cr->gstate_tail[1].next = NULL;
 
+    memset (cr->group_cache, 0, sizeof (cr->group_cache));
+
     return _cairo_gstate_init (cr->gstate, target);
 }
 
@@ -41,10 +41,12 @@
 #define _BSD_SOURCE /* for strdup() */
 #include "cairoint.h"
 
+#include "cairo-cache-private.h"
 #include "cairo-error-private.h"
 #include "cairo-image-surface-private.h"
 #include "cairo-ft-private.h"
 #include "cairo-pattern-private.h"
+#include "cairo-time-private.h"
 
 #include <float.h>
 
@@ -195,7 +197,7 @@ struct _cairo_ft_font_face {
 #if CAIRO_HAS_FC_FONT
     FcPattern *pattern; /* if pattern is set, the above fields will be NULL */
     cairo_font_face_t *resolved_font_face;
-    FcConfig *resolved_config;
+    unsigned int resolved_generation;
 #endif
 };
 
@@ -353,6 +355,218 @@ _cairo_ft_unscaled_font_map_unlock (void)
     CAIRO_MUTEX_UNLOCK (_cairo_ft_unscaled_font_map_mutex);
 }
 
+#if CAIRO_HAS_FC_FONT
+/*
+ * Resolving a pattern means running FcConfigSubstitute and FcFontMatch,
+ * which is far too slow to repeat for every equivalent font face that
+ * an application creates. So we keep a process-wide cache mapping
+ * (pattern, font options, pixel size) => resolved font face. It is
+ * flushed whenever the current FcConfig changes, and the font
+ * directories are only checked for changes once every
+ * FC_RESCAN_INTERVAL seconds.
+ */
+
+#define MAX_RESOLVED_PATTERNS 64
+#define FC_RESCAN_INTERVAL 1.
+
+typedef struct _cairo_ft_resolved_pattern {
+    cairo_cache_entry_t base;
+
+    FcPattern *pattern;
+    cairo_font_options_t options;
+    double pixel_size;
+
+    cairo_font_face_t *font_face;
+} cairo_ft_resolved_pattern_t;
+
+/* All protected by _cairo_ft_resolve_cache_mutex */
+static cairo_cache_t *cairo_ft_resolve_cache;
+static FcConfig *cairo_ft_resolve_config;
+static unsigned int cairo_ft_resolve_generation;
+static cairo_time_t cairo_ft_resolve_rescan;
+
+static void
+_cairo_ft_resolved_pattern_init_key (cairo_ft_resolved_pattern_t *key,
+				     FcPattern *pattern,
+				     const cairo_font_options_t *options,
+				     double pixel_size)
+{
+    unsigned long hash;
+
+    key->pattern = pattern;
+    _cairo_font_options_init_copy (&key->options, options);
+    key->pixel_size = pixel_size;
+
+    hash = FcPatternHash (pattern);
+    hash ^= cairo_font_options_hash (options);
+    hash = _cairo_hash_bytes (hash, &pixel_size, sizeof (pixel_size));
+
+    key->base.hash = hash;
+    key->base.size = 1;
+}
+
+static cairo_bool_t
+_cairo_ft_resolved_pattern_equal (const void *key_a, const void *key_b)
+{
+    const cairo_ft_resolved_pattern_t *a = key_a;
+    const cairo_ft_resolved_pattern_t *b = key_b;
+
+    return a->pixel_size == b->pixel_size &&
+	   cairo_font_options_equal (&a->options, &b->options) &&
+	   FcPatternEqual (a->pattern, b->pattern);
+}
+
+static void
+_cairo_ft_resolved_pattern_destroy (void *abstract_entry)
+{
+    cairo_ft_resolved_pattern_t *entry = abstract_entry;
+
+    FcPatternDestroy (entry->pattern);
+    cairo_font_face_destroy (entry->font_face);
+    free (entry);
+}
+
+static void
+_cairo_ft_resolve_cache_flush (void)
+{
+    if (cairo_ft_resolve_cache == NULL)
+	return;
+
+    _cairo_cache_fini (cairo_ft_resolve_cache);
+    free (cairo_ft_resolve_cache);
+    cairo_ft_resolve_cache = NULL;
+}
+
+/* Returns the generation of the fontconfig configuration, which
+ * changes whenever previously resolved patterns become stale.
+ */
+static cairo_status_t
+_cairo_ft_resolve_cache_validate (unsigned int *generation)
+{
+    cairo_status_t status = CAIRO_STATUS_SUCCESS;
+    cairo_time_t now;
+
+    CAIRO_MUTEX_LOCK (_cairo_ft_resolve_cache_mutex);
+
+    now = _cairo_time_get ();
+    if (cairo_ft_resolve_config == NULL ||
+	_cairo_time_to_s (_cairo_time_sub (now, cairo_ft_resolve_rescan)) >= FC_RESCAN_INTERVAL)
+    {
+	if (! FcInitBringUptoDate ())
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	cairo_ft_resolve_rescan = now;
+    }
+
+    if (cairo_ft_resolve_config != FcConfigGetCurrent ()) {
+	_cairo_ft_resolve_cache_flush ();
+	cairo_ft_resolve_config = FcConfigGetCurrent ();
+	cairo_ft_resolve_generation++;
+    }
+
+    *generation = cairo_ft_resolve_generation;
+
+    CAIRO_MUTEX_UNLOCK (_cairo_ft_resolve_cache_mutex);
+
+    return status;
+}
+
+static cairo_font_face_t *
+_cairo_ft_resolve_cache_lookup (FcPattern *pattern,
+				const cairo_font_options_t *options,
+				double pixel_size)
+{
+    cairo_ft_resolved_pattern_t key, *entry;
+    cairo_font_face_t *font_face = NULL;
+
+    _cairo_ft_resolved_pattern_init_key (&key, pattern, options, pixel_size);
+
+    CAIRO_MUTEX_LOCK (_cairo_ft_resolve_cache_mutex);
+    if (cairo_ft_resolve_cache != NULL) {
+	entry = _cairo_cache_lookup (cairo_ft_resolve_cache, &key.base);
+	if (entry != NULL)
+	    font_face = cairo_font_face_reference (entry->font_face);
+    }
+    CAIRO_MUTEX_UNLOCK (_cairo_ft_resolve_cache_mutex);
+
+    return font_face;
+}
+
+/* Returns the cached face if another thread resolved the same pattern
+ * in the meantime, otherwise @font_face.
+ */
+static cairo_font_face_t *
+_cairo_ft_resolve_cache_insert (FcPattern *pattern,
+				const cairo_font_options_t *options,
+				double pixel_size,
+				cairo_font_face_t *font_face)
+{
+    cairo_ft_resolved_pattern_t *entry, *existing;
+    cairo_status_t status;
+
+    entry = malloc (sizeof (cairo_ft_resolved_pattern_t));
+    if (unlikely (entry == NULL))
+	return font_face;
+
+    pattern = FcPatternDuplicate (pattern);
+    if (unlikely (pattern == NULL)) {
+	free (entry);
+	return font_face;
+    }
+
+    _cairo_ft_resolved_pattern_init_key (entry, pattern, options, pixel_size);
+    entry->font_face = cairo_font_face_reference (font_face);
+
+    CAIRO_MUTEX_LOCK (_cairo_ft_resolve_cache_mutex);
+
+    if (cairo_ft_resolve_cache == NULL) {
+	cairo_ft_resolve_cache = malloc (sizeof (cairo_cache_t));
+	if (unlikely (cairo_ft_resolve_cache == NULL))
+	    goto FAIL;
+
+	status = _cairo_cache_init (cairo_ft_resolve_cache,
+				    _cairo_ft_resolved_pattern_equal,
+				    NULL,
+				    _cairo_ft_resolved_pattern_destroy,
+				    MAX_RESOLVED_PATTERNS);
+	if (unlikely (status)) {
+	    free (cairo_ft_resolve_cache);
+	    cairo_ft_resolve_cache = NULL;
+	    goto FAIL;
+	}
+    }
+
+    existing = _cairo_cache_lookup (cairo_ft_resolve_cache, &entry->base);
+    if (existing != NULL) {
+	cairo_font_face_destroy (font_face);
+	font_face = cairo_font_face_reference (existing->font_face);
+	goto FAIL;
+    }
+
+    status = _cairo_cache_insert (cairo_ft_resolve_cache, &entry->base);
+    if (unlikely (status))
+	goto FAIL;
+
+    CAIRO_MUTEX_UNLOCK (_cairo_ft_resolve_cache_mutex);
+
+    return font_face;
+
+FAIL:
+    CAIRO_MUTEX_UNLOCK (_cairo_ft_resolve_cache_mutex);
+    _cairo_ft_resolved_pattern_destroy (entry);
+
+    return font_face;
+}
+
+static void
+_cairo_ft_resolve_cache_destroy (void)
+{
+    CAIRO_MUTEX_LOCK (_cairo_ft_resolve_cache_mutex);
+    _cairo_ft_resolve_cache_flush ();
+    cairo_ft_resolve_config = NULL;
+    CAIRO_MUTEX_UNLOCK (_cairo_ft_resolve_cache_mutex);
+}
+#endif
+
 static void
 _cairo_ft_unscaled_font_init_key (cairo_ft_unscaled_font_t *key,
 				  cairo_bool_t              from_face,
@@ -2778,15 +2992,15 @@ _cairo_ft_font_face_get_implementation (void                     *abstract_face,
     if (font_face->pattern) {
 	cairo_font_face_t *resolved;
 
+	unsigned int generation;
+
+	if (unlikely (_cairo_ft_resolve_cache_validate (&generation)))
+	    return (cairo_font_face_t *) &_cairo_font_face_nil;
+
 	/* Cache the resolved font whilst the FcConfig remains consistent. */
 	resolved = font_face->resolved_font_face;
 	if (resolved != NULL) {
-	    if (! FcInitBringUptoDate ()) {
-		_cairo_error_throw (CAIRO_STATUS_NO_MEMORY);
-		return (cairo_font_face_t *) &_cairo_font_face_nil;
-	    }
-
-	    if (font_face->resolved_config == FcConfigGetCurrent ())
+	    if (font_face->resolved_generation == generation)
 		return cairo_font_face_reference (resolved);
 
 	    cairo_font_face_destroy (resolved);
@@ -2801,7 +3015,7 @@ _cairo_ft_font_face_get_implementation (void                     *abstract_face,
 	    return resolved;
 
 	font_face->resolved_font_face = cairo_font_face_reference (resolved);
-	font_face->resolved_config = FcConfigGetCurrent ();
+	font_face->resolved_generation = generation;
 
 	return resolved;
     }
@@ -2845,7 +3059,7 @@ _cairo_ft_font_face_create_for_pattern (FcPattern *pattern)
     }
 
     font_face->resolved_font_face = NULL;
-    font_face->resolved_config = NULL;
+    font_face->resolved_generation = 0;
 
     _cairo_font_face_init (&font_face->base, &_cairo_ft_font_face_backend);
 
@@ -3077,7 +3291,7 @@ _cairo_ft_resolve_pattern (FcPattern		      *pattern,
     cairo_status_t status;
 
     cairo_matrix_t scale;
-    FcPattern *resolved;
+    FcPattern *key, *resolved;
     cairo_ft_font_transform_t sf;
     FcResult result;
     cairo_ft_unscaled_font_t *unscaled;
@@ -3094,6 +3308,13 @@ _cairo_ft_resolve_pattern (FcPattern		      *pattern,
     if (unlikely (status))
 	return (cairo_font_face_t *)&_cairo_font_face_nil;
 
+    font_face = _cairo_ft_resolve_cache_lookup (pattern,
+						font_options,
+						sf.y_scale);
+    if (font_face != NULL)
+	return font_face;
+
+    key = pattern;
     pattern = FcPatternDuplicate (pattern);
     if (pattern == NULL)
 	return (cairo_font_face_t *)&_cairo_font_face_nil;
@@ -3145,6 +3366,13 @@ _cairo_ft_resolve_pattern (FcPattern		      *pattern,
     font_face = _cairo_ft_font_face_create (unscaled, &ft_options);
     _cairo_unscaled_font_destroy (&unscaled->base);
 
+    if (font_face->status == CAIRO_STATUS_SUCCESS) {
+	font_face = _cairo_ft_resolve_cache_insert (key,
+						    font_options,
+						    sf.y_scale,
+						    font_face);
+    }
+
 FREE_RESOLVED:
     if (resolved != pattern)
 	FcPatternDestroy (resolved);
@@ -3492,5 +3720,8 @@ _cairo_ft_scaled_font_get_load_flags (cairo_scaled_font_t *scaled_font)
 void
 _cairo_ft_font_reset_static_data (void)
 {
+#if CAIRO_HAS_FC_FONT
+    _cairo_ft_resolve_cache_destroy ();
+#endif
     _cairo_ft_unscaled_font_map_destroy ();
 }
@@ -243,6 +243,7 @@ _cairo_gl_context_setup_operand (cairo_gl_context_t *ctx,
     case CAIRO_GL_OPERAND_CONSTANT:
         break;
     case CAIRO_GL_OPERAND_TEXTURE:
+    case CAIRO_GL_OPERAND_DISTANCE_FIELD:
         glActiveTexture (GL_TEXTURE0 + tex_unit);
         glBindTexture (ctx->tex_target, operand->texture.tex);
         _cairo_gl_texture_set_extend (ctx, ctx->tex_target,
@@ -316,6 +317,7 @@ _cairo_gl_context_destroy_operand (cairo_gl_context_t *ctx,
     case CAIRO_GL_OPERAND_CONSTANT:
         break;
     case CAIRO_GL_OPERAND_TEXTURE:
+    case CAIRO_GL_OPERAND_DISTANCE_FIELD:
         dispatch->DisableVertexAttribArray (CAIRO_GL_TEXCOORD0_ATTRIB_INDEX + tex_unit);
         break;
     case CAIRO_GL_OPERAND_LINEAR_GRADIENT:
@@ -1022,6 +1024,7 @@ _cairo_gl_context_choose_emit_span (cairo_gl_context_t *ctx)
 		    break;
 
 	    case CAIRO_GL_OPERAND_TEXTURE:
+	    case CAIRO_GL_OPERAND_DISTANCE_FIELD:
 		    if (!ctx->operands[CAIRO_GL_TEX_MASK].texture.texgen)
 			    return _cairo_gl_composite_emit_span;
 		    break;
@@ -1045,6 +1048,7 @@ _cairo_gl_context_choose_emit_span (cairo_gl_context_t *ctx)
 	break;
 
     case CAIRO_GL_OPERAND_TEXTURE:
+    case CAIRO_GL_OPERAND_DISTANCE_FIELD:
 	if (!ctx->operands[CAIRO_GL_TEX_SOURCE].texture.texgen)
 		return _cairo_gl_composite_emit_span;
     }
@@ -1133,6 +1137,7 @@ _cairo_gl_context_choose_emit_glyph (cairo_gl_context_t *ctx)
     case CAIRO_GL_OPERAND_RADIAL_GRADIENT_NONE:
     case CAIRO_GL_OPERAND_RADIAL_GRADIENT_EXT:
     case CAIRO_GL_OPERAND_TEXTURE:
+    case CAIRO_GL_OPERAND_DISTANCE_FIELD:
 	return _cairo_gl_composite_emit_glyph;
     }
 }
@@ -1256,3 +1261,29 @@ _cairo_gl_composite_emit_triangle_as_tristrip (cairo_gl_context_t	*ctx,
     _cairo_gl_composite_emit_point (ctx, &triangle[2]);
     return _cairo_gl_composite_append_vertex_indices (ctx, 3);
 }
+
+/* Draw triangles held in a buffer object instead of the streamed vertex
+ * buffer. Only positions are stored, so the operands must use texgen. */
+void
+_cairo_gl_composite_draw_buffer (cairo_gl_context_t *ctx,
+				 GLuint vbo,
+				 unsigned int num_vertices)
+{
+    cairo_gl_dispatch_t *dispatch = &ctx->dispatch;
+
+    assert (ctx->vertex_size == 2 * sizeof (GLfloat));
+
+    _cairo_gl_composite_flush (ctx);
+
+    dispatch->BindBuffer (GL_ARRAY_BUFFER, vbo);
+    dispatch->VertexAttribPointer (CAIRO_GL_VERTEX_ATTRIB_INDEX, 2,
+				   GL_FLOAT, GL_FALSE, ctx->vertex_size,
+				   NULL);
+
+    _cairo_gl_composite_draw_triangles_with_clip_region (ctx, num_vertices);
+
+    dispatch->BindBuffer (GL_ARRAY_BUFFER, 0);
+    dispatch->VertexAttribPointer (CAIRO_GL_VERTEX_ATTRIB_INDEX, 2,
+				   GL_FLOAT, GL_FALSE, ctx->vertex_size,
+				   ctx->vb);
+}
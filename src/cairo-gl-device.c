@@ -106,11 +106,18 @@ _gl_finish (void *device)
     _gl_lock (device);
 
     _cairo_cache_fini (&ctx->gradients);
+    _cairo_cache_fini (&ctx->geometry);
 
     _cairo_gl_context_fini_shaders (ctx);
 
     for (n = 0; n < ARRAY_LENGTH (ctx->glyph_cache); n++)
 	_cairo_gl_glyph_cache_fini (ctx, &ctx->glyph_cache[n]);
+    _cairo_gl_distance_field_cache_fini (ctx, &ctx->distance_field_cache);
+
+    if (ctx->coverage != NULL) {
+	cairo_surface_destroy (&ctx->coverage->base);
+	ctx->coverage = NULL;
+    }
 
     _gl_unlock (device);
 }
@@ -207,6 +214,8 @@ _cairo_gl_context_init (cairo_gl_context_t *ctx)
     ctx->thread_aware = TRUE;
 
     memset (ctx->glyph_cache, 0, sizeof (ctx->glyph_cache));
+    memset (&ctx->distance_field_cache, 0, sizeof (ctx->distance_field_cache));
+    ctx->distance_field_threshold = 0;
     cairo_list_init (&ctx->fonts);
 
     /* Support only GL version >= 1.3 */
@@ -297,9 +306,20 @@ _cairo_gl_context_init (cairo_gl_context_t *ctx)
     if (unlikely (status))
         return status;
 
+    status = _cairo_cache_init (&ctx->geometry,
+                                _cairo_gl_geometry_equal,
+                                NULL,
+                                _cairo_gl_geometry_destroy,
+                                CAIRO_GL_GEOMETRY_CACHE_SIZE);
+    if (unlikely (status)) {
+	    _cairo_cache_fini (&ctx->gradients);
+	    return status;
+    }
+
     ctx->vb = malloc (CAIRO_GL_VBO_SIZE);
     if (unlikely (ctx->vb == NULL)) {
 	    _cairo_cache_fini (&ctx->gradients);
+	    _cairo_cache_fini (&ctx->geometry);
 	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
     }
 
@@ -318,6 +338,11 @@ _cairo_gl_context_init (cairo_gl_context_t *ctx)
 
     for (n = 0; n < ARRAY_LENGTH (ctx->glyph_cache); n++)
 	_cairo_gl_glyph_cache_init (&ctx->glyph_cache[n]);
+    status = _cairo_gl_distance_field_cache_init (&ctx->distance_field_cache);
+    if (unlikely (status))
+	return status;
+
+    ctx->coverage = NULL;
 
     return CAIRO_STATUS_SUCCESS;
 }
@@ -747,3 +772,32 @@ cairo_gl_device_set_thread_aware (cairo_device_t	*device,
     }
     ((cairo_gl_context_t *) device)->thread_aware = thread_aware;
 }
+
+/**
+ * cairo_gl_device_set_glyph_distance_field_threshold:
+ * @device: a #cairo_device_t for the GL backend
+ * @pixel_size: the smallest glyph size, in device pixels, to draw from
+ * distance fields, or 0 to never use them
+ *
+ * Glyphs at or above @pixel_size that are only scaled (not rotated or
+ * sheared) are drawn from a single signed distance field per glyph of
+ * the font face, shared by all sizes, instead of being rasterized and
+ * uploaded for every size. This keeps the glyph cache small and
+ * avoids uploads while text is continuously zoomed. Such glyphs are
+ * always unhinted and are antialiased in grayscale.
+ *
+ * Distance fields are disabled by default.
+ *
+ * Since: 1.14
+ **/
+void
+cairo_gl_device_set_glyph_distance_field_threshold (cairo_device_t *device,
+						    double	    pixel_size)
+{
+    if (device->backend->type != CAIRO_DEVICE_TYPE_GL) {
+	_cairo_error_throw (CAIRO_STATUS_DEVICE_TYPE_MISMATCH);
+	return;
+    }
+    ((cairo_gl_context_t *) device)->distance_field_threshold =
+	MAX (pixel_size, 0);
+}
@@ -65,6 +65,7 @@ cairo_private cairo_gl_dispatch_entry_t dispatch_buffers_entries[] = {
     DISPATCH_ENTRY_ARB     (BufferData),
     DISPATCH_ENTRY_ARB_OES (MapBuffer),
     DISPATCH_ENTRY_ARB_OES (UnmapBuffer),
+    DISPATCH_ENTRY_ARB     (DeleteBuffers),
     DISPATCH_ENTRY_LAST
 };
 
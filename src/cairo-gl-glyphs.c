@@ -51,6 +51,14 @@
 #define GLYPH_CACHE_MIN_SIZE 4
 #define GLYPH_CACHE_MAX_SIZE 128
 
+/* Outlines are sampled into distance fields at this many texels to the
+ * em, recording distances of up to DISTANCE_FIELD_SPREAD texels either
+ * side of the outline.
+ */
+#define DISTANCE_FIELD_EM 48
+#define DISTANCE_FIELD_SPREAD 4
+#define DISTANCE_FIELD_TOLERANCE 0.05
+
 typedef struct _cairo_gl_glyph {
     cairo_rtree_node_t node;
     cairo_scaled_glyph_private_t base;
@@ -219,7 +227,671 @@ cairo_gl_context_get_glyph_cache (cairo_gl_context_t *ctx,
     return CAIRO_STATUS_SUCCESS;
 }
 
+typedef struct _cairo_gl_distance_field {
+    cairo_rtree_node_t node;
+    cairo_hash_entry_t hash_entry;
+    cairo_gl_distance_field_cache_t *cache;
+    cairo_font_face_t *font_face;
+    unsigned long index;
+    cairo_bool_t is_empty;
+    /* the centres of the outermost texels, relative to the glyph
+     * origin and in texels, followed by their texture coordinates */
+    float x1, y1, x2, y2;
+    struct { float x, y; } p1, p2;
+} cairo_gl_distance_field_t;
+
+static unsigned long
+_cairo_gl_distance_field_hash (cairo_font_face_t *font_face,
+			       unsigned long index)
+{
+    return _cairo_hash_bytes (index, &font_face, sizeof (font_face));
+}
+
+static cairo_bool_t
+_cairo_gl_distance_field_equal (const void *key_a, const void *key_b)
+{
+    const cairo_gl_distance_field_t *a =
+	cairo_container_of (key_a, cairo_gl_distance_field_t, hash_entry);
+    const cairo_gl_distance_field_t *b =
+	cairo_container_of (key_b, cairo_gl_distance_field_t, hash_entry);
+
+    return a->font_face == b->font_face && a->index == b->index;
+}
+
+static void
+_cairo_gl_distance_field_node_destroy (cairo_rtree_node_t *node)
+{
+    cairo_gl_distance_field_t *field = (cairo_gl_distance_field_t *) node;
+
+    if (field->font_face == NULL)
+	return;
+
+    _cairo_hash_table_remove (field->cache->fields, &field->hash_entry);
+    cairo_font_face_destroy (field->font_face);
+    field->font_face = NULL;
+}
+
+static cairo_gl_distance_field_t *
+_cairo_gl_distance_field_lookup (cairo_gl_distance_field_cache_t *cache,
+				 cairo_font_face_t *font_face,
+				 unsigned long index)
+{
+    cairo_gl_distance_field_t key;
+    cairo_hash_entry_t *entry;
+
+    key.font_face = font_face;
+    key.index = index;
+    key.hash_entry.hash = _cairo_gl_distance_field_hash (font_face, index);
+
+    entry = _cairo_hash_table_lookup (cache->fields, &key.hash_entry);
+    if (entry == NULL)
+	return NULL;
+
+    return cairo_container_of (entry, cairo_gl_distance_field_t, hash_entry);
+}
+
+typedef struct _cairo_gl_segment {
+    double x1, y1, x2, y2;
+} cairo_gl_segment_t;
+
+typedef struct _cairo_gl_outline {
+    cairo_array_t segments;
+    cairo_point_t first, current;
+} cairo_gl_outline_t;
+
+static cairo_status_t
+_cairo_gl_outline_line_to (void *closure, const cairo_point_t *point)
+{
+    cairo_gl_outline_t *outline = closure;
+    cairo_gl_segment_t segment;
+
+    if (point->x == outline->current.x && point->y == outline->current.y)
+	return CAIRO_STATUS_SUCCESS;
+
+    segment.x1 = _cairo_fixed_to_double (outline->current.x);
+    segment.y1 = _cairo_fixed_to_double (outline->current.y);
+    segment.x2 = _cairo_fixed_to_double (point->x);
+    segment.y2 = _cairo_fixed_to_double (point->y);
+    outline->current = *point;
+
+    return _cairo_array_append (&outline->segments, &segment);
+}
+
+static cairo_status_t
+_cairo_gl_outline_close_path (void *closure)
+{
+    cairo_gl_outline_t *outline = closure;
+
+    return _cairo_gl_outline_line_to (outline, &outline->first);
+}
+
+static cairo_status_t
+_cairo_gl_outline_move_to (void *closure, const cairo_point_t *point)
+{
+    cairo_gl_outline_t *outline = closure;
+    cairo_status_t status;
+
+    status = _cairo_gl_outline_close_path (outline);
+    if (unlikely (status))
+	return status;
+
+    outline->first = outline->current = *point;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Samples the signed distance to a glyph outline, positive inside, at
+ * the centre of every texel within DISTANCE_FIELD_SPREAD of its
+ * extents. The distance is exact, being measured to every segment of
+ * the flattened outline, and a ray cast along each row supplies the
+ * winding number. Returns a NULL image for an empty outline.
+ */
+static cairo_status_t
+_cairo_gl_distance_field_render (const cairo_path_fixed_t *path,
+				 cairo_image_surface_t **image_out,
+				 int *x_out, int *y_out)
+{
+    cairo_gl_outline_t outline;
+    const cairo_gl_segment_t *segments;
+    cairo_image_surface_t *image;
+    double x1, y1, x2, y2;
+    int num_segments, x0, y0, width, height;
+    int i, j, n;
+    cairo_status_t status;
+
+    *image_out = NULL;
+
+    _cairo_array_init (&outline.segments, sizeof (cairo_gl_segment_t));
+    outline.first.x = outline.first.y = 0;
+    outline.current = outline.first;
+    status = _cairo_path_fixed_interpret_flat (path,
+					       _cairo_gl_outline_move_to,
+					       _cairo_gl_outline_line_to,
+					       _cairo_gl_outline_close_path,
+					       &outline,
+					       DISTANCE_FIELD_TOLERANCE);
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = _cairo_gl_outline_close_path (&outline);
+    if (unlikely (status))
+	goto FINISH;
+
+    num_segments = _cairo_array_num_elements (&outline.segments);
+    if (num_segments == 0)
+	goto FINISH;
+
+    segments = _cairo_array_index_const (&outline.segments, 0);
+    x1 = x2 = segments[0].x1;
+    y1 = y2 = segments[0].y1;
+    for (n = 0; n < num_segments; n++) {
+	x1 = MIN (x1, segments[n].x2);
+	x2 = MAX (x2, segments[n].x2);
+	y1 = MIN (y1, segments[n].y2);
+	y2 = MAX (y2, segments[n].y2);
+    }
+
+    x0 = floor (x1) - DISTANCE_FIELD_SPREAD;
+    y0 = floor (y1) - DISTANCE_FIELD_SPREAD;
+    width = ceil (x2) + DISTANCE_FIELD_SPREAD - x0;
+    height = ceil (y2) + DISTANCE_FIELD_SPREAD - y0;
+
+    image = (cairo_image_surface_t *)
+	cairo_image_surface_create (CAIRO_FORMAT_A8, width, height);
+    status = image->base.status;
+    if (unlikely (status))
+	goto FINISH;
+
+    for (j = 0; j < height; j++) {
+	uint8_t *row = image->data + j * image->stride;
+	double py = y0 + j + .5;
+
+	for (i = 0; i < width; i++) {
+	    double px = x0 + i + .5;
+	    double d2 = HUGE_VAL, d;
+	    int winding = 0;
+
+	    for (n = 0; n < num_segments; n++) {
+		const cairo_gl_segment_t *s = &segments[n];
+		double dx = s->x2 - s->x1, dy = s->y2 - s->y1;
+		double ex, ey, t;
+
+		t = ((px - s->x1) * dx + (py - s->y1) * dy) / (dx * dx + dy * dy);
+		t = MAX (0., MIN (t, 1.));
+		ex = s->x1 + t * dx - px;
+		ey = s->y1 + t * dy - py;
+		d2 = MIN (d2, ex * ex + ey * ey);
+
+		if ((s->y1 <= py) != (s->y2 <= py) &&
+		    s->x1 + (py - s->y1) * dx / dy > px)
+		{
+		    winding += dy > 0 ? 1 : -1;
+		}
+	    }
+
+	    d = sqrt (d2);
+	    if (winding == 0)
+		d = -d;
+	    d = .5 + d / (2 * DISTANCE_FIELD_SPREAD);
+	    row[i] = MAX (0., MIN (d, 1.)) * 255 + .5;
+	}
+    }
+
+    *image_out = image;
+    *x_out = x0;
+    *y_out = y0;
+
+FINISH:
+    _cairo_array_fini (&outline.segments);
+    return status;
+}
+
+static cairo_int_status_t
+_cairo_gl_distance_field_cache_add (cairo_gl_context_t *ctx,
+				    cairo_gl_distance_field_cache_t *cache,
+				    cairo_font_face_t *font_face,
+				    unsigned long index,
+				    cairo_image_surface_t *image,
+				    int x, int y,
+				    cairo_gl_distance_field_t **out)
+{
+    cairo_gl_distance_field_t *field;
+    cairo_rtree_node_t *node = NULL;
+    cairo_int_status_t status;
+    int width, height;
+
+    width = height = GLYPH_CACHE_MIN_SIZE;
+    if (image != NULL) {
+	width = MAX (width, image->width);
+	height = MAX (height, image->height);
+    }
+
+    status = _cairo_rtree_insert (&cache->base.rtree, width, height, &node);
+    if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
+	status = _cairo_rtree_evict_random (&cache->base.rtree,
+					    width, height, &node);
+	if (status == CAIRO_INT_STATUS_SUCCESS) {
+	    status = _cairo_rtree_node_insert (&cache->base.rtree,
+					       node, width, height, &node);
+	}
+    }
+    if (status)
+	return status;
+
+    field = (cairo_gl_distance_field_t *) node;
+    field->font_face = NULL;
+
+    if (image != NULL) {
+	glActiveTexture (GL_TEXTURE1);
+	status = _cairo_gl_surface_draw_image (cache->base.surface, image,
+					       0, 0,
+					       image->width, image->height,
+					       node->x, node->y, FALSE);
+	if (unlikely (status)) {
+	    _cairo_rtree_node_remove (&cache->base.rtree, node);
+	    return status;
+	}
+
+	/* Uploading resets the filter, which may already have been set
+	 * up for the glyphs being drawn. */
+	_cairo_gl_context_activate (ctx, CAIRO_GL_TEX_TEMP);
+	glBindTexture (ctx->tex_target, cache->base.surface->tex);
+	glTexParameteri (ctx->tex_target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri (ctx->tex_target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    field->cache = cache;
+    field->index = index;
+    field->font_face = font_face;
+    field->hash_entry.hash = _cairo_gl_distance_field_hash (font_face, index);
+    status = _cairo_hash_table_insert (cache->fields, &field->hash_entry);
+    if (unlikely (status)) {
+	field->font_face = NULL;
+	_cairo_rtree_node_remove (&cache->base.rtree, node);
+	return status;
+    }
+    cairo_font_face_reference (font_face);
+
+    field->is_empty = image == NULL;
+    if (! field->is_empty) {
+	/* Only sample between the outermost texel centres, so that
+	 * bilinear filtering never reaches into a neighbouring entry. */
+	field->x1 = x + .5;
+	field->y1 = y + .5;
+	field->x2 = x + image->width - .5;
+	field->y2 = y + image->height - .5;
+
+	field->p1.x = node->x + .5;
+	field->p1.y = node->y + .5;
+	field->p2.x = node->x + image->width - .5;
+	field->p2.y = node->y + image->height - .5;
+	if (! _cairo_gl_device_requires_power_of_two_textures (&ctx->base)) {
+	    field->p1.x /= GLYPH_CACHE_WIDTH;
+	    field->p2.x /= GLYPH_CACHE_WIDTH;
+	    field->p1.y /= GLYPH_CACHE_HEIGHT;
+	    field->p2.y /= GLYPH_CACHE_HEIGHT;
+	}
+    }
+
+    *out = field;
+    return CAIRO_STATUS_SUCCESS;
+}
+
 static cairo_status_t
+cairo_gl_context_get_distance_field_cache (cairo_gl_context_t *ctx,
+					   cairo_gl_distance_field_cache_t **cache_out)
+{
+    cairo_gl_distance_field_cache_t *cache = &ctx->distance_field_cache;
+
+    if (unlikely (cache->base.surface == NULL)) {
+	cairo_surface_t *surface;
+
+	surface = _cairo_gl_surface_create_scratch_for_caching (ctx,
+								CAIRO_CONTENT_ALPHA,
+								GLYPH_CACHE_WIDTH,
+								GLYPH_CACHE_HEIGHT);
+	if (unlikely (surface->status))
+	    return surface->status;
+
+	_cairo_surface_release_device_reference (surface);
+
+	cache->base.surface = (cairo_gl_surface_t *) surface;
+    }
+
+    *cache_out = cache;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* A glyph whose distance field was not cached when the glyphs were
+ * checked, together with the field rendered for it.
+ */
+typedef struct _cairo_gl_distance_field_glyph {
+    unsigned long index;
+    cairo_image_surface_t *image;
+    int x, y;
+} cairo_gl_distance_field_glyph_t;
+
+static void
+_cairo_gl_distance_field_glyphs_reset (cairo_array_t *glyphs)
+{
+    cairo_gl_distance_field_glyph_t *glyph;
+    unsigned int i;
+
+    glyph = _cairo_array_index (glyphs, 0);
+    for (i = 0; i < _cairo_array_num_elements (glyphs); i++) {
+	if (glyph[i].image != NULL)
+	    cairo_surface_destroy (&glyph[i].image->base);
+    }
+    _cairo_array_truncate (glyphs, 0);
+}
+
+static cairo_gl_distance_field_glyph_t *
+_cairo_gl_distance_field_glyphs_find (cairo_array_t *glyphs,
+				      unsigned long index)
+{
+    cairo_gl_distance_field_glyph_t *glyph;
+    unsigned int i;
+
+    glyph = _cairo_array_index (glyphs, 0);
+    for (i = 0; i < _cairo_array_num_elements (glyphs); i++) {
+	if (glyph[i].index == index)
+	    return &glyph[i];
+    }
+
+    return NULL;
+}
+
+/* Collects the glyphs from start onwards that have no distance field. */
+static cairo_int_status_t
+_cairo_gl_distance_field_find_missing (cairo_gl_surface_t *dst,
+				       cairo_composite_glyphs_info_t *info,
+				       int start,
+				       cairo_array_t *missing)
+{
+    cairo_font_face_t *font_face = info->font->font_face;
+    cairo_gl_distance_field_cache_t *cache;
+    cairo_gl_context_t *ctx;
+    cairo_int_status_t status;
+    int i;
+
+    status = _cairo_gl_context_acquire (dst->base.device, &ctx);
+    if (unlikely (status))
+	return status;
+
+    status = cairo_gl_context_get_distance_field_cache (ctx, &cache);
+    for (i = start; status == CAIRO_INT_STATUS_SUCCESS && i < info->num_glyphs; i++) {
+	cairo_gl_distance_field_glyph_t glyph;
+
+	glyph.index = info->glyphs[i].index;
+	if (_cairo_gl_distance_field_lookup (cache, font_face, glyph.index) ||
+	    _cairo_gl_distance_field_glyphs_find (missing, glyph.index))
+	    continue;
+
+	glyph.image = NULL;
+	status = _cairo_array_append (missing, &glyph);
+    }
+
+    return _cairo_gl_context_release (ctx, status);
+}
+
+/* Renders the distance fields of the missing glyphs from their outlines
+ * at the size the fields are sampled at. This freezes the cache of that
+ * reference font, so it must be done without the device: another thread
+ * may be drawing with the reference font, holding it frozen while it
+ * waits for the device. Only the font being drawn may be frozen as well,
+ * and that by our caller.
+ */
+static cairo_int_status_t
+_cairo_gl_distance_field_prepare (cairo_scaled_font_t *scaled_font,
+				  cairo_array_t *missing)
+{
+    cairo_gl_distance_field_glyph_t *glyph;
+    cairo_font_options_t options;
+    cairo_matrix_t font_matrix, ctm;
+    cairo_scaled_font_t *reference;
+    cairo_int_status_t status;
+    unsigned int i;
+
+    if (_cairo_array_num_elements (missing) == 0)
+	return CAIRO_INT_STATUS_SUCCESS;
+
+    _cairo_font_options_init_copy (&options, &scaled_font->options);
+    options.antialias = CAIRO_ANTIALIAS_GRAY;
+    options.hint_style = CAIRO_HINT_STYLE_NONE;
+    options.hint_metrics = CAIRO_HINT_METRICS_OFF;
+
+    cairo_matrix_init_scale (&font_matrix,
+			     DISTANCE_FIELD_EM, DISTANCE_FIELD_EM);
+    cairo_matrix_init_identity (&ctm);
+
+    reference = cairo_scaled_font_create (scaled_font->font_face,
+					  &font_matrix, &ctm, &options);
+    status = reference->status;
+    if (unlikely (status)) {
+	cairo_scaled_font_destroy (reference);
+	return status;
+    }
+
+    if (reference != scaled_font)
+	_cairo_scaled_font_freeze_cache (reference);
+
+    glyph = _cairo_array_index (missing, 0);
+    for (i = 0; i < _cairo_array_num_elements (missing); i++) {
+	cairo_scaled_glyph_t *scaled_glyph;
+
+	status = _cairo_scaled_glyph_lookup (reference, glyph[i].index,
+					     CAIRO_SCALED_GLYPH_INFO_PATH,
+					     &scaled_glyph);
+	if (unlikely (status))
+	    break;
+
+	status = _cairo_gl_distance_field_render (scaled_glyph->path,
+						  &glyph[i].image,
+						  &glyph[i].x, &glyph[i].y);
+	if (unlikely (status))
+	    break;
+    }
+
+    if (reference != scaled_font)
+	_cairo_scaled_font_thaw_cache (reference);
+    cairo_scaled_font_destroy (reference);
+
+    return status;
+}
+
+/* Whether glyphs of the font are drawn from distance fields, which
+ * depends only upon the size as the fields are sampled in a shader
+ * that expects a uniform scale.
+ */
+static cairo_bool_t
+_cairo_gl_font_use_distance_fields (cairo_gl_context_t *ctx,
+				    cairo_scaled_font_t *scaled_font)
+{
+    const cairo_matrix_t *scale = &scaled_font->scale;
+
+    if (ctx->distance_field_threshold <= 0 || ! ctx->has_shader_support)
+	return FALSE;
+
+    if (scale->xy != 0 || scale->yx != 0 || scale->xx != scale->yy)
+	return FALSE;
+
+    if (scale->xx < ctx->distance_field_threshold)
+	return FALSE;
+
+    switch (scaled_font->options.antialias) {
+    case CAIRO_ANTIALIAS_NONE:
+    case CAIRO_ANTIALIAS_SUBPIXEL:
+    case CAIRO_ANTIALIAS_BEST:
+	return FALSE;
+    case CAIRO_ANTIALIAS_DEFAULT:
+    case CAIRO_ANTIALIAS_GRAY:
+    case CAIRO_ANTIALIAS_FAST:
+    case CAIRO_ANTIALIAS_GOOD:
+	break;
+    }
+
+    return TRUE;
+}
+
+/* Draws the glyphs from start onwards, adding the prepared fields to
+ * the cache as they are needed. Making room in the cache may evict a
+ * field that a later glyph needs; if that has not been prepared, stop
+ * there and return the glyph to continue from in *start.
+ */
+static cairo_int_status_t
+_cairo_gl_distance_field_draw (cairo_gl_surface_t *dst,
+			       int dst_x, int dst_y,
+			       cairo_operator_t op,
+			       cairo_surface_t *source,
+			       cairo_composite_glyphs_info_t *info,
+			       cairo_clip_t *clip,
+			       cairo_array_t *prepared,
+			       int *start)
+{
+    cairo_font_face_t *font_face = info->font->font_face;
+    cairo_gl_distance_field_cache_t *cache;
+    cairo_gl_context_t *ctx;
+    cairo_gl_emit_glyph_t emit;
+    cairo_gl_composite_t setup;
+    cairo_gl_operand_t mask;
+    cairo_int_status_t status;
+    double scale;
+    int i;
+
+    status = _cairo_gl_context_acquire (dst->base.device, &ctx);
+    if (unlikely (status))
+	return status;
+
+    status = cairo_gl_context_get_distance_field_cache (ctx, &cache);
+    if (unlikely (status))
+	goto RELEASE;
+
+    status = _cairo_gl_composite_init (&setup, op, dst, TRUE);
+    if (unlikely (status))
+	goto RELEASE;
+
+    if (source == NULL) {
+	_cairo_gl_composite_set_solid_source (&setup, CAIRO_COLOR_WHITE);
+    } else {
+	_cairo_gl_composite_set_source_operand (&setup,
+						source_to_operand (source));
+    }
+
+    _cairo_gl_composite_set_clip (&setup, clip);
+
+    scale = info->font->scale.xx / DISTANCE_FIELD_EM;
+
+    mask = cache->base.surface->operand;
+    mask.type = CAIRO_GL_OPERAND_DISTANCE_FIELD;
+    mask.texture.attributes.filter = CAIRO_FILTER_BILINEAR;
+    mask.texture.distance_scale = 2 * DISTANCE_FIELD_SPREAD * scale;
+    _cairo_gl_composite_set_mask_operand (&setup, &mask);
+
+    status = _cairo_gl_composite_begin (&setup, &ctx);
+    status = _cairo_gl_context_release (ctx, status);
+    if (unlikely (status))
+	goto FINISH;
+
+    emit = _cairo_gl_context_choose_emit_glyph (ctx);
+
+    for (i = *start; i < info->num_glyphs; i++) {
+	unsigned long index = info->glyphs[i].index;
+	cairo_gl_distance_field_t *field;
+	double x, y;
+
+	field = _cairo_gl_distance_field_lookup (cache, font_face, index);
+	if (field == NULL) {
+	    cairo_gl_distance_field_glyph_t *glyph;
+
+	    glyph = _cairo_gl_distance_field_glyphs_find (prepared, index);
+	    if (glyph == NULL)
+		break;
+
+	    status = _cairo_gl_distance_field_cache_add (ctx, cache,
+							 font_face, index,
+							 glyph->image,
+							 glyph->x, glyph->y,
+							 &field);
+	    if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
+		/* Cache is full, so flush existing prims and try again. */
+		_cairo_gl_composite_flush (ctx);
+		_cairo_gl_glyph_cache_unlock (&cache->base);
+		status = _cairo_gl_distance_field_cache_add (ctx, cache,
+							     font_face, index,
+							     glyph->image,
+							     glyph->x, glyph->y,
+							     &field);
+	    }
+
+	    if (unlikely (status))
+		goto FINISH;
+	}
+
+	_cairo_rtree_pin (&cache->base.rtree, &field->node);
+	if (field->is_empty)
+	    continue;
+
+	/* Unlike bitmaps, fields need not be aligned to the pixel grid */
+	x = info->glyphs[i].x - dst_x;
+	y = info->glyphs[i].y - dst_y;
+	emit (ctx,
+	      x + scale * field->x1, y + scale * field->y1,
+	      x + scale * field->x2, y + scale * field->y2,
+	      field->p1.x, field->p1.y,
+	      field->p2.x, field->p2.y);
+    }
+
+    *start = i;
+    status = CAIRO_STATUS_SUCCESS;
+  FINISH:
+    _cairo_gl_composite_fini (&setup);
+  RELEASE:
+    return _cairo_gl_context_release (ctx, status);
+}
+
+static cairo_int_status_t
+render_glyphs_with_distance_fields (cairo_gl_surface_t *dst,
+				    int dst_x, int dst_y,
+				    cairo_operator_t op,
+				    cairo_surface_t *source,
+				    cairo_composite_glyphs_info_t *info,
+				    cairo_clip_t *clip)
+{
+    cairo_array_t missing;
+    cairo_int_status_t status;
+    int start;
+
+    TRACE ((stderr, "%s (%d, %d)x(%d, %d)\n", __FUNCTION__,
+	    info->extents.x, info->extents.y,
+	    info->extents.width, info->extents.height));
+
+    _cairo_array_init (&missing, sizeof (cairo_gl_distance_field_glyph_t));
+
+    /* Every glyph is checked to have an outline before any is drawn,
+     * so that the bitmaps can be used instead if one does not. Later
+     * passes only pick up fields evicted in the meantime, whose
+     * outlines are known to exist. */
+    start = 0;
+    do {
+	status = _cairo_gl_distance_field_find_missing (dst, info, start,
+							&missing);
+	if (unlikely (status))
+	    break;
+
+	status = _cairo_gl_distance_field_prepare (info->font, &missing);
+	if (unlikely (status))
+	    break;
+
+	status = _cairo_gl_distance_field_draw (dst, dst_x, dst_y,
+						op, source, info, clip,
+						&missing, &start);
+	_cairo_gl_distance_field_glyphs_reset (&missing);
+    } while (status == CAIRO_INT_STATUS_SUCCESS && start < info->num_glyphs);
+
+    _cairo_gl_distance_field_glyphs_reset (&missing);
+    _cairo_array_fini (&missing);
+
+    return status;
+}
+
+static cairo_int_status_t
 render_glyphs (cairo_gl_surface_t *dst,
 	       int dst_x, int dst_y,
 	       cairo_operator_t op,
@@ -242,6 +914,21 @@ render_glyphs (cairo_gl_surface_t *dst,
 
     *has_component_alpha = FALSE;
 
+    if (_cairo_gl_font_use_distance_fields ((cairo_gl_context_t *) dst->base.device,
+					    info->font))
+    {
+	status = render_glyphs_with_distance_fields (dst, dst_x, dst_y,
+						     op, source, info, clip);
+	if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+	    return status;
+
+	/* Without outlines, glyphs too large for the bitmap cache can
+	 * only be drawn by the fallback compositor; nothing has been
+	 * drawn yet, so hand them over. */
+	if (ceil (info->font->max_scale) >= GLYPH_CACHE_MAX_SIZE)
+	    return UNSUPPORTED ("glyphs too large");
+    }
+
     status = _cairo_gl_context_acquire (dst->base.device, &ctx);
     if (unlikely (status))
 	return status;
@@ -355,7 +1042,7 @@ render_glyphs_via_mask (cairo_gl_surface_t *dst,
 			cairo_clip_t *clip)
 {
     cairo_surface_t *mask;
-    cairo_status_t status;
+    cairo_int_status_t status;
     cairo_bool_t has_component_alpha;
 
     TRACE ((stderr, "%s\n", __FUNCTION__));
@@ -423,8 +1110,12 @@ _cairo_gl_check_composite_glyphs (const cairo_composite_rectangles_t *extents,
 	return UNSUPPORTED ("unsupported operator");
 
     /* XXX use individual masks for large glyphs? */
-    if (ceil (scaled_font->max_scale) >= GLYPH_CACHE_MAX_SIZE)
+    if (ceil (scaled_font->max_scale) >= GLYPH_CACHE_MAX_SIZE &&
+	! _cairo_gl_font_use_distance_fields ((cairo_gl_context_t *) extents->surface->device,
+					      scaled_font))
+    {
 	return UNSUPPORTED ("glyphs too large");
+    }
 
     return CAIRO_STATUS_SUCCESS;
 }
@@ -500,3 +1191,35 @@ _cairo_gl_glyph_cache_fini (cairo_gl_context_t *ctx,
     _cairo_rtree_fini (&cache->rtree);
     cairo_surface_destroy (&cache->surface->base);
 }
+
+cairo_status_t
+_cairo_gl_distance_field_cache_init (cairo_gl_distance_field_cache_t *cache)
+{
+    _cairo_rtree_init (&cache->base.rtree,
+		       GLYPH_CACHE_WIDTH,
+		       GLYPH_CACHE_HEIGHT,
+		       GLYPH_CACHE_MIN_SIZE,
+		       sizeof (cairo_gl_distance_field_t),
+		       _cairo_gl_distance_field_node_destroy);
+
+    cache->fields = _cairo_hash_table_create (_cairo_gl_distance_field_equal);
+    if (unlikely (cache->fields == NULL)) {
+	_cairo_rtree_fini (&cache->base.rtree);
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+void
+_cairo_gl_distance_field_cache_fini (cairo_gl_context_t *ctx,
+				     cairo_gl_distance_field_cache_t *cache)
+{
+    if (cache->fields == NULL)
+	return;
+
+    /* Evicting the entries releases their font faces */
+    _cairo_gl_glyph_cache_fini (ctx, &cache->base);
+    _cairo_hash_table_destroy (cache->fields);
+    cache->fields = NULL;
+}
@@ -60,13 +60,10 @@ struct _tristrip_composite_info {
     cairo_gl_context_t		*ctx;
 };
 
-static cairo_int_status_t
-_draw_trap (cairo_gl_context_t		*ctx,
-	    cairo_gl_composite_t	*setup,
-	    cairo_trapezoid_t		*trap)
+static void
+_quad_from_trap (const cairo_trapezoid_t	*trap,
+		 cairo_point_t			 quad[4])
 {
-    cairo_point_t quad[4];
-
     quad[0].x = _cairo_edge_compute_intersection_x_for_y (&trap->left.p1,
 							  &trap->left.p2,
 							  trap->top);
@@ -86,6 +83,16 @@ _draw_trap (cairo_gl_context_t		*ctx,
 						      &trap->right.p2,
 						      trap->top);
     quad[3].y = trap->top;
+}
+
+static cairo_int_status_t
+_draw_trap (cairo_gl_context_t		*ctx,
+	    cairo_gl_composite_t	*setup,
+	    cairo_trapezoid_t		*trap)
+{
+    cairo_point_t quad[4];
+
+    _quad_from_trap (trap, quad);
     return _cairo_gl_composite_emit_quad_as_tristrip (ctx, setup, quad);
 }
 
@@ -635,6 +642,393 @@ query_surface_capabilities (cairo_gl_surface_t *surface)
     status = _cairo_gl_context_release (ctx, status);
 }
 
+/* Applications tend to redraw the same paths frame after frame, and for
+ * anything but the simplest of paths the tessellation dominates the cost
+ * of drawing them. The first time we see a path we only remember it; the
+ * second time we tessellate it into a buffer object, and from then on the
+ * path is drawn with a single draw call, sampling the source with texgen
+ * as the cached vertices carry nothing but their position.
+ */
+
+static cairo_bool_t
+_stroke_style_equal (const cairo_stroke_style_t *a,
+		     const cairo_stroke_style_t *b)
+{
+    if (a->line_width != b->line_width ||
+	a->line_cap != b->line_cap ||
+	a->line_join != b->line_join ||
+	a->miter_limit != b->miter_limit ||
+	a->num_dashes != b->num_dashes ||
+	a->dash_offset != b->dash_offset)
+	return FALSE;
+
+    return a->num_dashes == 0 ||
+	memcmp (a->dash, b->dash, a->num_dashes * sizeof (double)) == 0;
+}
+
+cairo_bool_t
+_cairo_gl_geometry_equal (const void *key_a, const void *key_b)
+{
+    const cairo_gl_geometry_t *a = key_a;
+    const cairo_gl_geometry_t *b = key_b;
+
+    if (a->tolerance != b->tolerance)
+	return FALSE;
+
+    if (a->style == NULL || b->style == NULL) {
+	if (a->style != b->style || a->fill_rule != b->fill_rule)
+	    return FALSE;
+    } else {
+	if (memcmp (a->ctm, b->ctm, sizeof (a->ctm)) != 0)
+	    return FALSE;
+	if (! _stroke_style_equal (a->style, b->style))
+	    return FALSE;
+    }
+
+    return _cairo_path_fixed_equal (a->path, b->path);
+}
+
+void
+_cairo_gl_geometry_destroy (void *entry)
+{
+    cairo_gl_geometry_t *geometry = entry;
+
+    if (geometry->vbo)
+	geometry->ctx->dispatch.DeleteBuffers (1, &geometry->vbo);
+
+    _cairo_path_fixed_fini (&geometry->path_embedded);
+    if (geometry->style != NULL)
+	_cairo_stroke_style_fini (&geometry->style_embedded);
+
+    free (geometry);
+}
+
+static void
+_cairo_gl_geometry_init_key (cairo_gl_geometry_t		*key,
+			     const cairo_path_fixed_t		*path,
+			     const cairo_stroke_style_t		*style,
+			     const cairo_matrix_t		*ctm,
+			     cairo_fill_rule_t			 fill_rule,
+			     double				 tolerance)
+{
+    unsigned long hash;
+
+    key->path = path;
+    key->style = style;
+    key->tolerance = tolerance;
+
+    /* A stroke does not depend upon the fill rule, nor a fill upon the
+     * ctm; and as the path is already in device space, only the linear
+     * part of the ctm shapes the pen. */
+    key->fill_rule = style ? CAIRO_FILL_RULE_WINDING : fill_rule;
+    if (style) {
+	key->ctm[0] = ctm->xx;
+	key->ctm[1] = ctm->yx;
+	key->ctm[2] = ctm->xy;
+	key->ctm[3] = ctm->yy;
+    } else {
+	key->ctm[0] = key->ctm[3] = 1.;
+	key->ctm[1] = key->ctm[2] = 0.;
+    }
+
+    hash = _cairo_path_fixed_hash (path);
+    hash = _cairo_hash_bytes (hash, &key->tolerance, sizeof (key->tolerance));
+    hash = _cairo_hash_bytes (hash, &key->fill_rule, sizeof (key->fill_rule));
+    hash = _cairo_hash_bytes (hash, key->ctm, sizeof (key->ctm));
+    if (style) {
+	hash = _cairo_hash_bytes (hash, &style->line_width, sizeof (double));
+	hash = _cairo_hash_bytes (hash, &style->line_cap,
+				  sizeof (cairo_line_cap_t));
+	hash = _cairo_hash_bytes (hash, &style->line_join,
+				  sizeof (cairo_line_join_t));
+	hash = _cairo_hash_bytes (hash, &style->miter_limit, sizeof (double));
+	hash = _cairo_hash_bytes (hash, style->dash,
+				  style->num_dashes * sizeof (double));
+	hash = _cairo_hash_bytes (hash, &style->dash_offset, sizeof (double));
+    }
+    key->base.hash = hash;
+}
+
+static cairo_status_t
+_cairo_gl_geometry_insert (cairo_gl_context_t		 *ctx,
+			   const cairo_gl_geometry_t	 *key,
+			   GLuint			  vbo,
+			   unsigned int			  num_vertices,
+			   cairo_bool_t			  uncached,
+			   cairo_gl_geometry_t		**geometry_out)
+{
+    cairo_gl_geometry_t *geometry;
+    cairo_status_t status;
+
+    geometry = malloc (sizeof (cairo_gl_geometry_t));
+    if (unlikely (geometry == NULL)) {
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto CLEANUP_VBO;
+    }
+
+    *geometry = *key;
+    geometry->ctx = ctx;
+
+    status = _cairo_path_fixed_init_copy (&geometry->path_embedded, key->path);
+    if (unlikely (status))
+	goto CLEANUP_GEOMETRY;
+    geometry->path = &geometry->path_embedded;
+
+    if (key->style != NULL) {
+	status = _cairo_stroke_style_init_copy (&geometry->style_embedded,
+						key->style);
+	if (unlikely (status)) {
+	    _cairo_path_fixed_fini (&geometry->path_embedded);
+	    goto CLEANUP_GEOMETRY;
+	}
+	geometry->style = &geometry->style_embedded;
+    }
+
+    geometry->vbo = vbo;
+    geometry->num_vertices = num_vertices;
+    geometry->uncached = uncached;
+    geometry->base.size = sizeof (cairo_gl_geometry_t) +
+			  _cairo_path_fixed_size (key->path) +
+			  num_vertices * 2 * sizeof (GLfloat);
+
+    status = _cairo_cache_insert (&ctx->geometry, &geometry->base);
+    if (unlikely (status)) {
+	_cairo_gl_geometry_destroy (geometry);
+	return status;
+    }
+
+    *geometry_out = geometry;
+    return CAIRO_STATUS_SUCCESS;
+
+CLEANUP_GEOMETRY:
+    free (geometry);
+CLEANUP_VBO:
+    if (vbo)
+	ctx->dispatch.DeleteBuffers (1, &vbo);
+    return status;
+}
+
+static cairo_status_t
+_geometry_add_triangle (void			*closure,
+			const cairo_point_t	 triangle[3])
+{
+    cairo_array_t *vertices = closure;
+    GLfloat v[6];
+    int i;
+
+    for (i = 0; i < 3; i++) {
+	v[2*i + 0] = _cairo_fixed_to_double (triangle[i].x);
+	v[2*i + 1] = _cairo_fixed_to_double (triangle[i].y);
+    }
+
+    return _cairo_array_append_multiple (vertices, v, 3);
+}
+
+static cairo_status_t
+_geometry_add_triangle_fan (void		*closure,
+			    const cairo_point_t	*midpt,
+			    const cairo_point_t	*points,
+			    int			 npoints)
+{
+    int i;
+
+    for (i = 1; i < npoints; i++) {
+	cairo_status_t status;
+	cairo_point_t triangle[3];
+
+	triangle[0] = *midpt;
+	triangle[1] = points[i - 1];
+	triangle[2] = points[i];
+
+	status = _geometry_add_triangle (closure, triangle);
+	if (unlikely (status))
+	    return status;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_geometry_add_quad (void		*closure,
+		    const cairo_point_t	 quad[4])
+{
+    cairo_point_t triangle[3];
+    cairo_status_t status;
+
+    /* The same pair of triangles as the strip emitted by
+     * _cairo_gl_composite_emit_quad_as_tristrip(). */
+    triangle[0] = quad[0];
+    triangle[1] = quad[1];
+    triangle[2] = quad[3];
+    status = _geometry_add_triangle (closure, triangle);
+    if (unlikely (status))
+	return status;
+
+    triangle[0] = quad[1];
+    triangle[1] = quad[3];
+    triangle[2] = quad[2];
+    return _geometry_add_triangle (closure, triangle);
+}
+
+static cairo_status_t
+_cairo_gl_geometry_tessellate (const cairo_gl_geometry_t	*key,
+			       const cairo_matrix_t		*ctm,
+			       const cairo_matrix_t		*ctm_inverse,
+			       cairo_array_t			*vertices)
+{
+    cairo_traps_t traps;
+    cairo_status_t status;
+    int i;
+
+    if (key->style != NULL) {
+	return _cairo_path_fixed_stroke_to_shaper ((cairo_path_fixed_t *) key->path,
+						   key->style,
+						   ctm,
+						   ctm_inverse,
+						   key->tolerance,
+						   _geometry_add_triangle,
+						   _geometry_add_triangle_fan,
+						   _geometry_add_quad,
+						   vertices);
+    }
+
+    _cairo_traps_init (&traps);
+    status = _cairo_path_fixed_fill_to_traps (key->path, key->fill_rule,
+					      key->tolerance, &traps);
+    for (i = 0; status == CAIRO_STATUS_SUCCESS && i < traps.num_traps; i++) {
+	cairo_point_t quad[4];
+
+	_quad_from_trap (&traps.traps[i], quad);
+	status = _geometry_add_quad (vertices, quad);
+    }
+    _cairo_traps_fini (&traps);
+
+    return status;
+}
+
+/* Replace the entry recording the first sighting of a path with one
+ * holding its triangles. */
+static cairo_status_t
+_cairo_gl_geometry_upload (cairo_gl_context_t		 *ctx,
+			   const cairo_gl_geometry_t	 *key,
+			   const cairo_matrix_t		 *ctm,
+			   const cairo_matrix_t		 *ctm_inverse,
+			   cairo_gl_geometry_t		**geometry)
+{
+    cairo_array_t vertices;
+    unsigned int num_vertices;
+    GLuint vbo = 0;
+    cairo_status_t status;
+
+    _cairo_array_init (&vertices, 2 * sizeof (GLfloat));
+    status = _cairo_gl_geometry_tessellate (key, ctm, ctm_inverse, &vertices);
+    if (unlikely (status))
+	goto FAIL;
+
+    /* Don't let a single path flush everything else from the cache. */
+    num_vertices = _cairo_array_num_elements (&vertices);
+    if (num_vertices > 0 &&
+	num_vertices * 2 * sizeof (GLfloat) <= CAIRO_GL_GEOMETRY_CACHE_SIZE / 8)
+    {
+	ctx->dispatch.GenBuffers (1, &vbo);
+	ctx->dispatch.BindBuffer (GL_ARRAY_BUFFER, vbo);
+	ctx->dispatch.BufferData (GL_ARRAY_BUFFER,
+				  num_vertices * 2 * sizeof (GLfloat),
+				  _cairo_array_index_const (&vertices, 0),
+				  GL_STATIC_DRAW);
+	ctx->dispatch.BindBuffer (GL_ARRAY_BUFFER, 0);
+    }
+
+    _cairo_cache_remove (&ctx->geometry, &(*geometry)->base);
+    *geometry = NULL;
+
+    status = _cairo_gl_geometry_insert (ctx, key, vbo, num_vertices,
+					vbo == 0, geometry);
+FAIL:
+    _cairo_array_fini (&vertices);
+    return status;
+}
+
+static cairo_int_status_t
+_cairo_gl_msaa_compositor_draw_geometry (cairo_composite_rectangles_t	*composite,
+					 const cairo_gl_geometry_t	*key,
+					 const cairo_matrix_t		*ctm,
+					 const cairo_matrix_t		*ctm_inverse,
+					 cairo_antialias_t		 antialias)
+{
+    cairo_gl_surface_t *dst = (cairo_gl_surface_t *) composite->surface;
+    cairo_gl_context_t *ctx, *composite_ctx = NULL;
+    cairo_gl_geometry_t *geometry;
+    cairo_gl_composite_t setup;
+    cairo_int_status_t status;
+
+    /* The cache belongs to the context, so hold it from the lookup until
+     * we have finished drawing. */
+    status = _cairo_gl_context_acquire (dst->base.device, &ctx);
+    if (unlikely (status))
+	return status;
+
+    geometry = _cairo_cache_lookup (&ctx->geometry, (cairo_cache_entry_t *) key);
+    if (geometry == NULL) {
+	status = _cairo_gl_geometry_insert (ctx, key, 0, 0, FALSE, &geometry);
+	if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	    status = CAIRO_INT_STATUS_UNSUPPORTED;
+	goto RELEASE;
+    }
+
+    if (geometry->vbo == 0 && ! geometry->uncached) {
+	status = _cairo_gl_geometry_upload (ctx, key, ctm, ctm_inverse,
+					    &geometry);
+	if (unlikely (status))
+	    goto RELEASE;
+    }
+
+    if (geometry->uncached) {
+	status = CAIRO_INT_STATUS_UNSUPPORTED;
+	goto RELEASE;
+    }
+
+    status = _cairo_gl_composite_init (&setup,
+				       composite->op,
+				       dst,
+				       FALSE /* assume_component_alpha */);
+    if (unlikely (status))
+	goto RELEASE;
+
+    status = _cairo_gl_composite_set_source (&setup,
+					     &composite->source_pattern.base,
+					     &composite->source_sample_area,
+					     &composite->bounded,
+					     TRUE);
+    if (unlikely (status))
+	goto FINISH;
+
+    _cairo_gl_msaa_compositor_set_clip (composite, &setup);
+    if (antialias != CAIRO_ANTIALIAS_NONE)
+	_cairo_gl_composite_set_multisample (&setup);
+
+    status = _cairo_gl_composite_begin (&setup, &composite_ctx);
+    if (unlikely (status))
+	goto FINISH;
+
+    if (key->style != NULL) {
+	status = _prevent_overlapping_strokes (ctx, &setup, composite,
+					       key->path, key->style, ctm);
+	if (unlikely (status))
+	    goto FINISH;
+    }
+
+    _cairo_gl_composite_draw_buffer (ctx, geometry->vbo, geometry->num_vertices);
+
+FINISH:
+    _cairo_gl_composite_fini (&setup);
+
+    if (composite_ctx)
+	status = _cairo_gl_context_release (composite_ctx, status);
+RELEASE:
+    return _cairo_gl_context_release (ctx, status);
+}
+
 static cairo_int_status_t
 _cairo_gl_msaa_compositor_stroke (const cairo_compositor_t	*compositor,
 				  cairo_composite_rectangles_t	*composite,
@@ -647,6 +1041,7 @@ _cairo_gl_msaa_compositor_stroke (const cairo_compositor_t	*compositor,
 {
     cairo_int_status_t status;
     cairo_gl_surface_t *dst = (cairo_gl_surface_t *) composite->surface;
+    cairo_gl_geometry_t key;
     struct _tristrip_composite_info info;
 
     if (! can_use_msaa_compositor (dst, antialias))
@@ -671,6 +1066,14 @@ _cairo_gl_msaa_compositor_stroke (const cairo_compositor_t	*compositor,
 	return _paint_back_unbounded_surface (compositor, composite, surface);
     }
 
+    _cairo_gl_geometry_init_key (&key, path, style, ctm,
+				 CAIRO_FILL_RULE_WINDING, tolerance);
+    status = _cairo_gl_msaa_compositor_draw_geometry (composite, &key,
+						      ctm, ctm_inverse,
+						      antialias);
+    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+	return status;
+
     status = _cairo_gl_composite_init (&info.setup,
 				       composite->op,
 				       dst,
@@ -787,6 +1190,16 @@ _cairo_gl_msaa_compositor_fill (const cairo_compositor_t	*compositor,
     draw_path_with_traps = ! _cairo_path_fixed_is_simple_quad (path);
 
     if (draw_path_with_traps) {
+	cairo_gl_geometry_t key;
+
+	_cairo_gl_geometry_init_key (&key, path, NULL, NULL,
+				     fill_rule, tolerance);
+	status = _cairo_gl_msaa_compositor_draw_geometry (composite, &key,
+							  NULL, NULL,
+							  antialias);
+	if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+	    return status;
+
 	_cairo_traps_init (&traps);
 	status = _cairo_path_fixed_fill_to_traps (path, fill_rule, tolerance, &traps);
 	if (unlikely (status))
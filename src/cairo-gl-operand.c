@@ -347,6 +347,7 @@ _cairo_gl_operand_translate (cairo_gl_operand_t *operand,
 {
     switch (operand->type) {
     case CAIRO_GL_OPERAND_TEXTURE:
+    case CAIRO_GL_OPERAND_DISTANCE_FIELD:
 	operand->texture.attributes.matrix.x0 -= tx * operand->texture.attributes.matrix.xx;
 	operand->texture.attributes.matrix.y0 -= ty * operand->texture.attributes.matrix.yy;
 	break;
@@ -474,6 +475,7 @@ _cairo_gl_operand_copy (cairo_gl_operand_t *dst,
 	_cairo_gl_gradient_reference (dst->gradient.gradient);
 	break;
     case CAIRO_GL_OPERAND_TEXTURE:
+    case CAIRO_GL_OPERAND_DISTANCE_FIELD:
 	cairo_surface_reference (&dst->texture.owns_surface->base);
 	break;
     default:
@@ -497,6 +499,7 @@ _cairo_gl_operand_destroy (cairo_gl_operand_t *operand)
 	_cairo_gl_gradient_destroy (operand->gradient.gradient);
 	break;
     case CAIRO_GL_OPERAND_TEXTURE:
+    case CAIRO_GL_OPERAND_DISTANCE_FIELD:
 	cairo_surface_destroy (&operand->texture.owns_surface->base);
 	break;
     default:
@@ -558,6 +561,7 @@ _cairo_gl_operand_get_filter (cairo_gl_operand_t *operand)
 
     switch ((int) operand->type) {
     case CAIRO_GL_OPERAND_TEXTURE:
+    case CAIRO_GL_OPERAND_DISTANCE_FIELD:
 	filter = operand->texture.attributes.filter;
 	break;
     case CAIRO_GL_OPERAND_LINEAR_GRADIENT:
@@ -591,6 +595,7 @@ _cairo_gl_operand_get_extend (cairo_gl_operand_t *operand)
 
     switch ((int) operand->type) {
     case CAIRO_GL_OPERAND_TEXTURE:
+    case CAIRO_GL_OPERAND_DISTANCE_FIELD:
 	extend = operand->texture.attributes.extend;
 	break;
     case CAIRO_GL_OPERAND_LINEAR_GRADIENT:
@@ -638,6 +643,13 @@ _cairo_gl_operand_bind_to_shader (cairo_gl_context_t *ctx,
                                     operand->constant.color[3]);
 	return;
 
+    case CAIRO_GL_OPERAND_DISTANCE_FIELD:
+	strcpy (custom_part, "_distance_scale");
+	_cairo_gl_shader_bind_float (ctx,
+				     uniform_name,
+				     operand->texture.distance_scale);
+	break;
+
     case CAIRO_GL_OPERAND_RADIAL_GRADIENT_NONE:
     case CAIRO_GL_OPERAND_RADIAL_GRADIENT_EXT:
 	strcpy (custom_part, "_a");
@@ -683,7 +695,8 @@ _cairo_gl_operand_bind_to_shader (cairo_gl_context_t *ctx,
 	break;
     }
 
-    if (operand->type == CAIRO_GL_OPERAND_TEXTURE) {
+    if (operand->type == CAIRO_GL_OPERAND_TEXTURE ||
+	operand->type == CAIRO_GL_OPERAND_DISTANCE_FIELD) {
 	    if (operand->texture.texgen)
 		    texgen = &operand->texture.attributes.matrix;
     } else {
@@ -722,6 +735,9 @@ _cairo_gl_operand_needs_setup (cairo_gl_operand_t *dest,
                dest->texture.attributes.extend != source->texture.attributes.extend ||
                dest->texture.attributes.filter != source->texture.attributes.filter ||
                dest->texture.attributes.has_component_alpha != source->texture.attributes.has_component_alpha;
+    case CAIRO_GL_OPERAND_DISTANCE_FIELD:
+        return dest->texture.surface != source->texture.surface ||
+               dest->texture.distance_scale != source->texture.distance_scale;
     case CAIRO_GL_OPERAND_LINEAR_GRADIENT:
     case CAIRO_GL_OPERAND_RADIAL_GRADIENT_A0:
     case CAIRO_GL_OPERAND_RADIAL_GRADIENT_NONE:
@@ -747,6 +763,7 @@ _cairo_gl_operand_get_vertex_size (const cairo_gl_operand_t *operand)
     case CAIRO_GL_OPERAND_CONSTANT:
         return 0;
     case CAIRO_GL_OPERAND_TEXTURE:
+    case CAIRO_GL_OPERAND_DISTANCE_FIELD:
         return operand->texture.texgen ? 0 : 2 * sizeof (GLfloat);
     case CAIRO_GL_OPERAND_LINEAR_GRADIENT:
     case CAIRO_GL_OPERAND_RADIAL_GRADIENT_A0:
@@ -784,6 +801,7 @@ _cairo_gl_operand_emit (cairo_gl_operand_t *operand,
         }
 	break;
     case CAIRO_GL_OPERAND_TEXTURE:
+    case CAIRO_GL_OPERAND_DISTANCE_FIELD:
 	if (! operand->texture.texgen) {
             cairo_surface_attributes_t *src_attributes = &operand->texture.attributes;
             double s = x;
@@ -96,6 +96,10 @@
  * (especially on embedded devices). */
 #define CAIRO_GL_VBO_SIZE (16*1024)
 
+/* Bytes of tessellated fill and stroke geometry that the MSAA compositor
+ * keeps in buffer objects for paths that are drawn repeatedly. */
+#define CAIRO_GL_GEOMETRY_CACHE_SIZE (4*1024*1024)
+
 typedef struct _cairo_gl_surface cairo_gl_surface_t;
 
 /* GL flavor */
@@ -121,6 +125,7 @@ typedef enum cairo_gl_operand_type {
     CAIRO_GL_OPERAND_RADIAL_GRADIENT_A0,
     CAIRO_GL_OPERAND_RADIAL_GRADIENT_NONE,
     CAIRO_GL_OPERAND_RADIAL_GRADIENT_EXT,
+    CAIRO_GL_OPERAND_DISTANCE_FIELD,
 
     CAIRO_GL_OPERAND_COUNT
 } cairo_gl_operand_type_t;
@@ -137,6 +142,7 @@ typedef struct cairo_gl_operand {
 	    cairo_gl_surface_t *owns_surface;
 	    cairo_surface_attributes_t attributes;
 	    int texgen;
+	    GLfloat distance_scale; /* pixels per unit of a distance field */
 	} texture;
 	struct {
 	    GLfloat color[4];
@@ -192,6 +198,15 @@ typedef struct cairo_gl_glyph_cache {
     cairo_gl_surface_t *surface;
 } cairo_gl_glyph_cache_t;
 
+/* Signed distance fields of glyph outlines. Unlike the coverage caches,
+ * the entries belong to a font face rather than to a scaled glyph and
+ * are shared by every size the face is drawn at.
+ */
+typedef struct cairo_gl_distance_field_cache {
+    cairo_gl_glyph_cache_t base;
+    cairo_hash_table_t *fields;
+} cairo_gl_distance_field_cache_t;
+
 typedef enum cairo_gl_tex {
     CAIRO_GL_TEX_SOURCE = 0,
     CAIRO_GL_TEX_MASK = 1,
@@ -251,6 +266,7 @@ typedef struct _cairo_gl_dispatch {
 			  const GLvoid* data, GLenum usage);
     GLvoid *(*MapBuffer) (GLenum target, GLenum access);
     GLboolean (*UnmapBuffer) (GLenum target);
+    void (*DeleteBuffers) (GLsizei n, const GLuint *buffers);
 
     /* Shaders */
     GLuint (*CreateShader) (GLenum type);
@@ -320,6 +336,30 @@ typedef struct _cairo_gl_dispatch {
 					     GLint level, GLsizei samples);
 } cairo_gl_dispatch_t;
 
+/* The triangles of a filled or stroked path, kept by the MSAA compositor
+ * so that a redraw of the same path is a single draw call. The key is the
+ * device space path plus whatever else the tessellation depends upon: the
+ * fill rule, or the stroke style and the linear part of the ctm. An entry
+ * without a buffer only records that the path has been seen, or, if
+ * uncached is set, that its triangles were not worth keeping. */
+typedef struct _cairo_gl_geometry {
+    cairo_cache_entry_t base;
+    cairo_gl_context_t *ctx;
+
+    const cairo_path_fixed_t *path;
+    const cairo_stroke_style_t *style; /* NULL for fills */
+    cairo_fill_rule_t fill_rule;
+    double ctm[4];
+    double tolerance;
+
+    GLuint vbo;
+    unsigned int num_vertices;
+    cairo_bool_t uncached;
+
+    cairo_path_fixed_t path_embedded;
+    cairo_stroke_style_t style_embedded;
+} cairo_gl_geometry_t;
+
 struct _cairo_gl_context {
     cairo_device_t base;
 
@@ -342,10 +382,16 @@ struct _cairo_gl_context {
     cairo_cache_t shaders;
 
     cairo_cache_t gradients;
+    cairo_cache_t geometry;
 
     cairo_gl_glyph_cache_t glyph_cache[2];
+    cairo_gl_distance_field_cache_t distance_field_cache;
+    double distance_field_threshold; /* 0 to disable */
     cairo_list_t fonts;
 
+    /* A8 rows streamed by the spans compositor for dense coverage */
+    cairo_gl_surface_t *coverage;
+
     cairo_gl_surface_t *current_target;
     cairo_operator_t current_operator;
     cairo_gl_shader_t *pre_shader; /* for component alpha */
@@ -600,6 +646,11 @@ _cairo_gl_composite_emit_triangle_as_tristrip (cairo_gl_context_t	*ctx,
 					       cairo_gl_composite_t	*setup,
 					       const cairo_point_t	 triangle[3]);
 
+cairo_private void
+_cairo_gl_composite_draw_buffer (cairo_gl_context_t *ctx,
+				 GLuint vbo,
+				 unsigned int num_vertices);
+
 cairo_private void
 _cairo_gl_context_destroy_operand (cairo_gl_context_t *ctx,
                                    cairo_gl_tex_t tex_unit);
@@ -618,6 +669,13 @@ cairo_private void
 _cairo_gl_glyph_cache_fini (cairo_gl_context_t *ctx,
 			    cairo_gl_glyph_cache_t *cache);
 
+cairo_private cairo_status_t
+_cairo_gl_distance_field_cache_init (cairo_gl_distance_field_cache_t *cache);
+
+cairo_private void
+_cairo_gl_distance_field_cache_fini (cairo_gl_context_t *ctx,
+				     cairo_gl_distance_field_cache_t *cache);
+
 cairo_private cairo_int_status_t
 _cairo_gl_surface_show_glyphs (void			*abstract_dst,
 			       cairo_operator_t		 op,
@@ -813,6 +871,12 @@ _cairo_gl_msaa_compositor_draw_clip (cairo_gl_context_t *ctx,
 				     cairo_gl_composite_t *setup,
 				     cairo_clip_t *clip);
 
+cairo_private cairo_bool_t
+_cairo_gl_geometry_equal (const void *key_a, const void *key_b);
+
+cairo_private void
+_cairo_gl_geometry_destroy (void *entry);
+
 cairo_private cairo_surface_t *
 _cairo_gl_white_source (void);
 
@@ -235,6 +235,7 @@ cairo_gl_operand_get_var_type (cairo_gl_operand_t *operand)
     case CAIRO_GL_OPERAND_RADIAL_GRADIENT_EXT:
         return operand->gradient.texgen ? CAIRO_GL_VAR_TEXGEN : CAIRO_GL_VAR_TEXCOORDS;
     case CAIRO_GL_OPERAND_TEXTURE:
+    case CAIRO_GL_OPERAND_DISTANCE_FIELD:
         return operand->texture.texgen ? CAIRO_GL_VAR_TEXGEN : CAIRO_GL_VAR_TEXCOORDS;
     }
 }
@@ -416,6 +417,22 @@ cairo_gl_shader_emit_color (cairo_output_stream_t *stream,
 		rectstr, namestr, namestr, namestr);
 	}
         break;
+    case CAIRO_GL_OPERAND_DISTANCE_FIELD:
+	/* The texel holds the signed distance to the outline, biased to
+	 * 0.5 on the outline itself; scaled to pixels, it gives the
+	 * coverage of a box filter one pixel wide. */
+	_cairo_output_stream_printf (stream,
+	    "uniform sampler2D%s %s_sampler;\n"
+	    "uniform float %s_distance_scale;\n"
+	    "varying vec2 %s_texcoords;\n"
+	    "vec4 get_%s()\n"
+	    "{\n"
+	    "    float distance = texture2D%s (%s_sampler, %s_wrap (%s_texcoords)).a - 0.5;\n"
+	    "    return vec4 (clamp (distance * %s_distance_scale + 0.5, 0.0, 1.0));\n"
+	    "}\n",
+	    rectstr, namestr, namestr, namestr, namestr,
+	    rectstr, namestr, namestr, namestr, namestr);
+	break;
     case CAIRO_GL_OPERAND_LINEAR_GRADIENT:
 	_cairo_output_stream_printf (stream,
 	    "varying vec2 %s_texcoords;\n"
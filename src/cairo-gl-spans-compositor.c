@@ -51,6 +51,16 @@
 #include "cairo-spans-compositor-private.h"
 #include "cairo-surface-backend-private.h"
 
+/* Dense antialiased geometry turns into a great many short spans, each
+ * of which costs six vertices. For such operations the coverage is
+ * instead accumulated a band of rows at a time and streamed into an A8
+ * texture, which is then used as the mask for a single rectangle per
+ * band. The first band is used to measure which is cheaper.
+ */
+#define COVERAGE_BAND_HEIGHT 32
+#define COVERAGE_TEXTURE_HEIGHT (8 * COVERAGE_BAND_HEIGHT)
+#define COVERAGE_TEXTURE_MIN_WIDTH 256
+
 typedef struct _cairo_gl_span_renderer {
     cairo_span_renderer_t base;
 
@@ -58,10 +68,19 @@ typedef struct _cairo_gl_span_renderer {
     double opacity;
 
     cairo_gl_emit_span_t emit;
+    cairo_gl_emit_rect_t emit_rect;
 
     int xmin, xmax;
     int ymin, ymax;
 
+    /* coverage of the current band, relative to (xmin, band_y) */
+    cairo_image_surface_t *band;
+    int band_y;
+    int band_x1, band_x2;
+    int band_y1, band_y2;
+    int num_spans;
+    int flush_y;
+
     cairo_gl_context_t *ctx;
 } cairo_gl_span_renderer_t;
 
@@ -240,6 +259,320 @@ _cairo_gl_finish_bounded_spans (void *abstract_renderer)
     return _cairo_gl_context_release (r->ctx, CAIRO_STATUS_SUCCESS);
 }
 
+static void
+_cairo_gl_coverage_reset_band (cairo_gl_span_renderer_t *r, int y)
+{
+    r->band_y = y - (y - r->ymin) % COVERAGE_BAND_HEIGHT;
+    r->band_x1 = r->xmax;
+    r->band_x2 = r->xmin;
+    r->band_y1 = r->band_y + COVERAGE_BAND_HEIGHT;
+    r->band_y2 = r->band_y;
+}
+
+/* Store the coverage of rows [y, y+height) within the current band */
+static void
+_cairo_gl_coverage_write_rows (cairo_gl_span_renderer_t *r,
+			       int y, int height,
+			       const cairo_half_open_span_t *spans,
+			       unsigned num_spans)
+{
+    int stride = r->band->stride;
+    uint8_t *row = r->band->data + (y - r->band_y) * stride - r->xmin;
+    int x1 = r->xmax, x2 = r->xmin;
+    int n;
+
+    if (num_spans == 0)
+	return;
+
+    do {
+	if (spans[0].coverage) {
+	    uint8_t coverage = spans[0].coverage;
+
+	    if (r->opacity != 1.)
+		coverage = r->opacity * spans[0].coverage;
+
+	    memset (row + spans[0].x, coverage, spans[1].x - spans[0].x);
+	    if (spans[0].x < x1)
+		x1 = spans[0].x;
+	    x2 = spans[1].x;
+	    r->num_spans++;
+	}
+	spans++;
+    } while (--num_spans > 1);
+
+    if (x1 >= x2)
+	return;
+
+    for (n = 1; n < height; n++)
+	memcpy (row + n * stride + x1, row + x1, x2 - x1);
+
+    if (x1 < r->band_x1)
+	r->band_x1 = x1;
+    if (x2 > r->band_x2)
+	r->band_x2 = x2;
+    if (y < r->band_y1)
+	r->band_y1 = y;
+    if (y + height > r->band_y2)
+	r->band_y2 = y + height;
+}
+
+static cairo_status_t
+_cairo_gl_coverage_flush_band (cairo_gl_span_renderer_t *r)
+{
+    cairo_gl_context_t *ctx = r->ctx;
+    int x1 = r->band_x1, x2 = r->band_x2;
+    int y1 = r->band_y1, y2 = r->band_y2;
+    cairo_status_t status;
+    uint8_t *row;
+
+    if (x1 >= x2)
+	return CAIRO_STATUS_SUCCESS;
+
+    /* Rows of the texture are reused once every COVERAGE_TEXTURE_HEIGHT;
+     * the rectangles still sampling the old contents must be drawn first.
+     */
+    if (y2 - r->flush_y > COVERAGE_TEXTURE_HEIGHT) {
+	_cairo_gl_composite_flush (ctx);
+	r->flush_y = y1;
+    }
+
+    status = _cairo_gl_surface_draw_image (ctx->coverage, r->band,
+					   x1 - r->xmin, y1 - r->band_y,
+					   x2 - x1, y2 - y1,
+					   x1 - r->xmin,
+					   (y1 - r->ymin) % COVERAGE_TEXTURE_HEIGHT,
+					   FALSE);
+    if (unlikely (status))
+	return status;
+
+    r->emit_rect (ctx, x1, y1, x2, y2);
+
+    row = r->band->data + (y1 - r->band_y) * r->band->stride + x1 - r->xmin;
+    do {
+	memset (row, 0, x2 - x1);
+	row += r->band->stride;
+    } while (++y1 < y2);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_gl_coverage_spans (void *abstract_renderer,
+			  int y, int height,
+			  const cairo_half_open_span_t *spans,
+			  unsigned num_spans)
+{
+    cairo_gl_span_renderer_t *r = abstract_renderer;
+
+    while (height) {
+	int rows;
+
+	if (y >= r->band_y + COVERAGE_BAND_HEIGHT) {
+	    cairo_status_t status;
+
+	    status = _cairo_gl_coverage_flush_band (r);
+	    if (unlikely (status))
+		return status;
+
+	    _cairo_gl_coverage_reset_band (r, y);
+	}
+
+	rows = r->band_y + COVERAGE_BAND_HEIGHT - y;
+	if (rows > height)
+	    rows = height;
+
+	_cairo_gl_coverage_write_rows (r, y, rows, spans, num_spans);
+	y += rows;
+	height -= rows;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_gl_finish_coverage_spans (void *abstract_renderer)
+{
+    cairo_gl_span_renderer_t *r = abstract_renderer;
+    cairo_status_t status;
+
+    status = _cairo_gl_coverage_flush_band (r);
+    return _cairo_gl_context_release (r->ctx, status);
+}
+
+static cairo_status_t
+_cairo_gl_coverage_begin (cairo_gl_span_renderer_t *r)
+{
+    cairo_gl_context_t *ctx = (cairo_gl_context_t *) r->setup.dst->base.device;
+    cairo_gl_operand_t *mask;
+    cairo_status_t status;
+    int width;
+
+    status = _cairo_gl_context_acquire (&ctx->base, &ctx);
+    if (unlikely (status))
+	return status;
+
+    /* The previous user of the texture may still have rectangles queued */
+    _cairo_gl_composite_flush (ctx);
+
+    width = r->xmax - r->xmin;
+    if (ctx->coverage == NULL || ctx->coverage->width < width) {
+	cairo_surface_t *surface;
+
+	if (width < COVERAGE_TEXTURE_MIN_WIDTH)
+	    width = COVERAGE_TEXTURE_MIN_WIDTH;
+	if (ctx->coverage != NULL && width < 2 * ctx->coverage->width)
+	    width = 2 * ctx->coverage->width;
+	if (width > ctx->max_texture_size)
+	    width = ctx->max_texture_size;
+
+	surface = _cairo_gl_surface_create_scratch_for_caching (ctx,
+								CAIRO_CONTENT_ALPHA,
+								width,
+								COVERAGE_TEXTURE_HEIGHT);
+	if (unlikely (surface->status))
+	    return _cairo_gl_context_release (ctx, surface->status);
+
+	_cairo_surface_release_device_reference (surface);
+
+	if (ctx->coverage != NULL)
+	    cairo_surface_destroy (&ctx->coverage->base);
+	ctx->coverage = (cairo_gl_surface_t *) surface;
+    }
+
+    /* Row y of the destination lives in row (y - ymin) modulo the
+     * height of the texture, so sample it repeated. */
+    _cairo_gl_composite_set_mask_operand (&r->setup, &ctx->coverage->operand);
+    mask = &r->setup.mask;
+    _cairo_gl_operand_translate (mask, r->xmin, r->ymin);
+    mask->texture.attributes.extend = CAIRO_EXTEND_REPEAT;
+    mask->texture.attributes.filter = CAIRO_FILTER_NEAREST;
+    mask->texture.texgen = TRUE;
+
+    status = _cairo_gl_composite_begin (&r->setup, &r->ctx);
+    status = _cairo_gl_context_release (ctx, status);
+    if (unlikely (status))
+	return status;
+
+    r->emit_rect = _cairo_gl_context_choose_emit_rect (r->ctx);
+    r->flush_y = r->band_y;
+
+    r->base.render_rows = _cairo_gl_coverage_spans;
+    r->base.finish = _cairo_gl_finish_coverage_spans;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_gl_spans_begin (cairo_gl_span_renderer_t *r)
+{
+    cairo_status_t status;
+    uint8_t *row;
+    int y;
+
+    _cairo_gl_composite_set_spans (&r->setup);
+
+    status = _cairo_gl_composite_begin (&r->setup, &r->ctx);
+    if (unlikely (status))
+	return status;
+
+    r->emit = _cairo_gl_context_choose_emit_span (r->ctx);
+    if (r->opacity == 1.)
+	r->base.render_rows = _cairo_gl_bounded_opaque_spans;
+    else
+	r->base.render_rows = _cairo_gl_bounded_spans;
+    r->base.finish = _cairo_gl_finish_bounded_spans;
+
+    /* Replay the rows sampled so far as spans, merging repeated rows */
+    row = r->band->data + (r->band_y1 - r->band_y) * r->band->stride - r->xmin;
+    for (y = r->band_y1; y < r->band_y2; ) {
+	int height = 1;
+	int x, x2;
+
+	while (y + height < r->band_y2 &&
+	       memcmp (row + r->band_x1,
+		       row + height * r->band->stride + r->band_x1,
+		       r->band_x2 - r->band_x1) == 0)
+	    height++;
+
+	for (x = r->band_x1; x < r->band_x2; x = x2) {
+	    for (x2 = x + 1; x2 < r->band_x2 && row[x2] == row[x]; x2++)
+		;
+	    if (row[x])
+		r->emit (r->ctx, x, y, x2, y + height, row[x]);
+	}
+
+	row += height * r->band->stride;
+	y += height;
+    }
+
+    cairo_surface_destroy (&r->band->base);
+    r->band = NULL;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Choose how to render the operation from the spans of its first band */
+static cairo_status_t
+_cairo_gl_spans_choose (cairo_gl_span_renderer_t *r)
+{
+    int area = (r->band_x2 - r->band_x1) * (r->band_y2 - r->band_y1);
+
+    if (r->num_spans * 6 * 3 * (int) sizeof (GLfloat) > area)
+	return _cairo_gl_coverage_begin (r);
+    else
+	return _cairo_gl_spans_begin (r);
+}
+
+static cairo_status_t
+_cairo_gl_sample_spans (void *abstract_renderer,
+			int y, int height,
+			const cairo_half_open_span_t *spans,
+			unsigned num_spans)
+{
+    cairo_gl_span_renderer_t *r = abstract_renderer;
+    int rows;
+
+    /* start sampling from the first row with any coverage */
+    if (r->band_x1 >= r->band_x2)
+	_cairo_gl_coverage_reset_band (r, y);
+
+    rows = r->band_y + COVERAGE_BAND_HEIGHT - y;
+    if (rows > height)
+	rows = height;
+    if (rows > 0) {
+	_cairo_gl_coverage_write_rows (r, y, rows, spans, num_spans);
+	y += rows;
+	height -= rows;
+    }
+
+    if (height) {
+	cairo_status_t status;
+
+	status = _cairo_gl_spans_choose (r);
+	if (unlikely (status))
+	    return status;
+
+	return r->base.render_rows (r, y, height, spans, num_spans);
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_gl_finish_sample_spans (void *abstract_renderer)
+{
+    cairo_gl_span_renderer_t *r = abstract_renderer;
+    cairo_status_t status;
+
+    if (r->band_x1 >= r->band_x2)
+	return CAIRO_STATUS_SUCCESS;
+
+    status = _cairo_gl_spans_choose (r);
+    if (unlikely (status))
+	return status;
+
+    return r->base.finish (r);
+}
+
 static void
 emit_aligned_boxes (cairo_gl_context_t *ctx,
 		    const cairo_boxes_t *boxes)
@@ -431,6 +764,8 @@ _cairo_gl_span_renderer_init (cairo_abstract_span_renderer_t	*_r,
     cairo_operator_t op = composite->op;
     cairo_int_status_t status;
 
+    r->band = NULL;
+
     if (op == CAIRO_OPERATOR_SOURCE) {
 	if (! _cairo_pattern_is_opaque (&composite->source_pattern.base,
 					&composite->source_sample_area))
@@ -479,6 +814,34 @@ _cairo_gl_span_renderer_init (cairo_abstract_span_renderer_t	*_r,
 	    goto FAIL;
     }
 
+    if (composite->is_bounded &&
+	composite->mask_pattern.base.type == CAIRO_PATTERN_TYPE_SOLID &&
+	composite->unbounded.width <= ((cairo_gl_context_t *) composite->surface->device)->max_texture_size)
+    {
+	r->band = (cairo_image_surface_t *)
+	    cairo_image_surface_create (CAIRO_FORMAT_A8,
+					composite->unbounded.width,
+					COVERAGE_BAND_HEIGHT);
+	if (unlikely (r->band->base.status)) {
+	    status = r->band->base.status;
+	    cairo_surface_destroy (&r->band->base);
+	    r->band = NULL;
+	    goto FAIL;
+	}
+
+	r->xmin = composite->unbounded.x;
+	r->xmax = composite->unbounded.x + composite->unbounded.width;
+	r->ymin = composite->unbounded.y;
+	r->ymax = composite->unbounded.y + composite->unbounded.height;
+	r->num_spans = 0;
+	r->ctx = NULL;
+	_cairo_gl_coverage_reset_band (r, r->ymin);
+
+	r->base.render_rows = _cairo_gl_sample_spans;
+	r->base.finish = _cairo_gl_finish_sample_spans;
+	return CAIRO_STATUS_SUCCESS;
+    }
+
     _cairo_gl_composite_set_spans (&r->setup);
 
     status = _cairo_gl_composite_begin (&r->setup, &r->ctx);
@@ -522,6 +885,9 @@ _cairo_gl_span_renderer_fini (cairo_abstract_span_renderer_t *_r,
     if (status == CAIRO_INT_STATUS_SUCCESS)
 	r->base.finish (r);
 
+    if (r->band != NULL)
+	cairo_surface_destroy (&r->band->base);
+
     _cairo_gl_composite_fini (&r->setup);
 }
 
@@ -92,6 +92,10 @@ cairo_public void
 cairo_gl_device_set_thread_aware (cairo_device_t	*device,
 				  cairo_bool_t		 thread_aware);
 
+cairo_public void
+cairo_gl_device_set_glyph_distance_field_threshold (cairo_device_t *device,
+						    double	    pixel_size);
+
 #if CAIRO_HAS_GLX_FUNCTIONS
 #include <GL/glx.h>
 
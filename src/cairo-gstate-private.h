@@ -275,6 +275,12 @@ _cairo_gstate_stroke_extents (cairo_gstate_t	 *gstate,
                               double *x1, double *y1,
 			      double *x2, double *y2);
 
+cairo_private void
+_cairo_gstate_approximate_stroke_extents (cairo_gstate_t     *gstate,
+					  cairo_path_fixed_t *path,
+					  double *x1, double *y1,
+					  double *x2, double *y2);
+
 cairo_private cairo_status_t
 _cairo_gstate_fill_extents (cairo_gstate_t     *gstate,
 			    cairo_path_fixed_t *path,
@@ -294,6 +300,11 @@ _cairo_gstate_in_fill (cairo_gstate_t	  *gstate,
 		       double		   x,
 		       double		   y);
 
+cairo_private cairo_hit_test_t *
+_cairo_gstate_create_hit_test (cairo_gstate_t	  *gstate,
+			       cairo_path_fixed_t *path,
+			       cairo_bool_t	   stroke);
+
 cairo_private cairo_bool_t
 _cairo_gstate_in_clip (cairo_gstate_t	  *gstate,
 		       double		   x,
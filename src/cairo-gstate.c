@@ -42,6 +42,7 @@
 #include "cairo-error-private.h"
 #include "cairo-list-inline.h"
 #include "cairo-gstate-private.h"
+#include "cairo-hit-test-private.h"
 #include "cairo-pattern-private.h"
 #include "cairo-traps-private.h"
 
@@ -1331,6 +1332,27 @@ _cairo_gstate_in_fill (cairo_gstate_t	  *gstate,
 				      x, y);
 }
 
+cairo_hit_test_t *
+_cairo_gstate_create_hit_test (cairo_gstate_t	  *gstate,
+			       cairo_path_fixed_t *path,
+			       cairo_bool_t	   stroke)
+{
+    if (stroke) {
+	return _cairo_hit_test_create_for_stroke (path,
+						  &gstate->stroke_style,
+						  &gstate->ctm,
+						  &gstate->ctm_inverse,
+						  gstate->tolerance,
+						  &gstate->target->device_transform);
+    }
+
+    return _cairo_hit_test_create_for_fill (path,
+					    gstate->fill_rule,
+					    gstate->tolerance,
+					    &gstate->ctm,
+					    &gstate->target->device_transform);
+}
+
 cairo_bool_t
 _cairo_gstate_in_clip (cairo_gstate_t	  *gstate,
 		       double		   x,
@@ -1484,6 +1506,85 @@ _cairo_gstate_stroke_extents (cairo_gstate_t	 *gstate,
     return status;
 }
 
+/* As _cairo_path_fixed_approximate_stroke_extents(), the bounds of the
+ * path grown by the furthest the stroke may reach, but kept in fixed
+ * point and rounded outwards so that the result always contains the
+ * exact extents computed above.
+ */
+void
+_cairo_gstate_approximate_stroke_extents (cairo_gstate_t     *gstate,
+					  cairo_path_fixed_t *path,
+					  double *x1, double *y1,
+					  double *x2, double *y2)
+{
+    cairo_stroke_style_t style;
+    cairo_box_t extents;
+    cairo_fixed_t fdx, fdy;
+    double dx, dy, scale = 1.;
+
+    if (gstate->stroke_style.line_width <= 0.0 ||
+	! _cairo_path_fixed_extents (path, &extents))
+    {
+	if (x1)
+	    *x1 = 0.0;
+	if (y1)
+	    *y1 = 0.0;
+	if (x2)
+	    *x2 = 0.0;
+	if (y2)
+	    *y2 = 0.0;
+	return;
+    }
+
+    /* The stroker only rounds the closing join of a sub-path if it
+     * turns sharply enough in device space for the difference to
+     * exceed the tolerance, and mitres it otherwise. Those mitres
+     * reach at most hlw / cos(a), where cos(a) = 1 - tolerance / hlw
+     * and tan(a) is stretched by up to the ratio of the axes of the
+     * pen under the ctm; lines too thin for the round join to ever be
+     * worthwhile are simply bound by the miter limit.
+     */
+    style = gstate->stroke_style;
+    if (style.line_join == CAIRO_LINE_JOIN_ROUND) {
+	double half_line_width = style.line_width / 2.;
+
+	if (half_line_width > 2 * gstate->tolerance) {
+	    double c = 1. - gstate->tolerance / half_line_width;
+	    double major, det, k;
+
+	    major = _cairo_matrix_transformed_circle_major_axis (&gstate->ctm, 1.);
+	    det = fabs (_cairo_matrix_compute_determinant (&gstate->ctm));
+	    k = major * major / det;
+
+	    scale = sqrt (1. + k * k * (1. - c * c) / (c * c));
+	} else {
+	    style.line_join = CAIRO_LINE_JOIN_MITER;
+	}
+    }
+
+    _cairo_stroke_style_max_distance_from_path (&style, path,
+						&gstate->ctm, &dx, &dy);
+    dx *= scale;
+    dy *= scale;
+
+    /* and allow for the rounding of the flattened curves */
+    if (path->has_curve_to) {
+	dx += gstate->tolerance;
+	dy += gstate->tolerance;
+    }
+
+    fdx = _cairo_fixed_from_double (dx) + 1;
+    fdy = _cairo_fixed_from_double (dy) + 1;
+
+    extents.p1.x -= fdx;
+    extents.p1.y -= fdy;
+    extents.p2.x += fdx;
+    extents.p2.y += fdy;
+
+    _cairo_gstate_extents_to_user_rectangle (gstate, &extents,
+					     x1, y1, x2, y2);
+}
+
 cairo_status_t
 _cairo_gstate_fill_extents (cairo_gstate_t     *gstate,
 			    cairo_path_fixed_t *path,
@@ -0,0 +1,113 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is Red Hat, Inc.
+ */
+
+#ifndef CAIRO_HIT_TEST_PRIVATE_H
+#define CAIRO_HIT_TEST_PRIVATE_H
+
+#include "cairo-types-private.h"
+#include "cairo-reference-count-private.h"
+#include "cairo-traps-private.h"
+
+CAIRO_BEGIN_DECLS
+
+/* A query point in device space, remembering its slot in the caller's
+ * array so that the points can be visited in order of y. */
+typedef struct _cairo_hit_point {
+    cairo_point_t point;
+    int index;
+} cairo_hit_point_t;
+
+/* An edge of the flattened path, oriented so that p1 is the top. */
+typedef struct _cairo_in_fill_edge {
+    cairo_point_t p1, p2;
+    int dir;
+} cairo_in_fill_edge_t;
+
+struct _cairo_hit_test {
+    cairo_reference_count_t ref_count;
+    cairo_status_t status;
+
+    cairo_matrix_t ctm;
+    cairo_matrix_t device_transform;
+    cairo_bool_t is_identity;
+
+    cairo_bool_t is_stroke;
+    cairo_fill_rule_t fill_rule;
+
+    /* for fills, the edges sorted by their top */
+    cairo_array_t edges;
+
+    /* for strokes, the trapezoids sorted by their top */
+    cairo_traps_t traps;
+};
+
+cairo_private cairo_hit_test_t *
+_cairo_hit_test_create_in_error (cairo_status_t status);
+
+cairo_private cairo_hit_test_t *
+_cairo_hit_test_create_for_fill (const cairo_path_fixed_t	*path,
+				 cairo_fill_rule_t		 fill_rule,
+				 double				 tolerance,
+				 const cairo_matrix_t		*ctm,
+				 const cairo_matrix_t		*device_transform);
+
+cairo_private cairo_hit_test_t *
+_cairo_hit_test_create_for_stroke (const cairo_path_fixed_t	*path,
+				   const cairo_stroke_style_t	*style,
+				   const cairo_matrix_t		*ctm,
+				   const cairo_matrix_t		*ctm_inverse,
+				   double			 tolerance,
+				   const cairo_matrix_t		*device_transform);
+
+/* cairo-path-in-fill.c */
+cairo_private cairo_status_t
+_cairo_path_fixed_in_fill_edges (const cairo_path_fixed_t	*path,
+				 double				 tolerance,
+				 cairo_array_t			*edges);
+
+cairo_private cairo_status_t
+_cairo_in_fill_edges_contain (const cairo_in_fill_edge_t	*edges,
+			      int				 num_edges,
+			      cairo_fill_rule_t			 fill_rule,
+			      const cairo_hit_point_t		*points,
+			      int				 num_points,
+			      cairo_bool_t			*inside);
+
+/* cairo-traps.c */
+cairo_private cairo_status_t
+_cairo_traps_contain_points (const cairo_traps_t	*traps,
+			     const cairo_hit_point_t	*points,
+			     int			 num_points,
+			     cairo_bool_t		*inside);
+
+CAIRO_END_DECLS
+
+#endif /* CAIRO_HIT_TEST_PRIVATE_H */
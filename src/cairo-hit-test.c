@@ -0,0 +1,353 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is Red Hat, Inc.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-array-private.h"
+#include "cairo-combsort-inline.h"
+#include "cairo-error-private.h"
+#include "cairo-hit-test-private.h"
+
+/**
+ * SECTION:cairo-hit-test
+ * @Title: Hit testing
+ * @Short_Description: Testing many points against a fill or a stroke
+ * @See_Also: cairo_in_fill(), cairo_in_stroke()
+ *
+ * cairo_in_fill() and cairo_in_stroke() flatten, or stroke, the current
+ * path again for every point that they test. A #cairo_hit_test_t does
+ * that work once, capturing the area that cairo_fill() or cairo_stroke()
+ * would cover with the current path and parameters, and can then answer
+ * for whole batches of points, visiting only those edges of the path
+ * that span each point.
+ *
+ * The hit test is a snapshot: later changes to the path or to the
+ * context do not affect it, so it may be kept for as long as the path
+ * it was created from is unchanged.
+ **/
+
+static const cairo_hit_test_t _cairo_hit_test_nil = {
+    CAIRO_REFERENCE_COUNT_INVALID,	/* ref_count */
+    CAIRO_STATUS_NO_MEMORY,		/* status */
+};
+
+cairo_hit_test_t *
+_cairo_hit_test_create_in_error (cairo_status_t status)
+{
+    cairo_hit_test_t *hit_test;
+
+    if (status == CAIRO_STATUS_NO_MEMORY)
+	return (cairo_hit_test_t *) &_cairo_hit_test_nil;
+
+    hit_test = malloc (sizeof (cairo_hit_test_t));
+    if (unlikely (hit_test == NULL))
+	return (cairo_hit_test_t *) &_cairo_hit_test_nil;
+
+    CAIRO_REFERENCE_COUNT_INIT (&hit_test->ref_count, 1);
+    hit_test->status = status;
+    hit_test->is_stroke = FALSE;
+    _cairo_array_init (&hit_test->edges, sizeof (cairo_in_fill_edge_t));
+    _cairo_traps_init (&hit_test->traps);
+
+    return hit_test;
+}
+
+static cairo_hit_test_t *
+_cairo_hit_test_create (const cairo_matrix_t *ctm,
+			const cairo_matrix_t *device_transform)
+{
+    cairo_hit_test_t *hit_test;
+
+    hit_test = malloc (sizeof (cairo_hit_test_t));
+    if (unlikely (hit_test == NULL)) {
+	_cairo_error_throw (CAIRO_STATUS_NO_MEMORY);
+	return NULL;
+    }
+
+    CAIRO_REFERENCE_COUNT_INIT (&hit_test->ref_count, 1);
+    hit_test->status = CAIRO_STATUS_SUCCESS;
+
+    hit_test->ctm = *ctm;
+    hit_test->device_transform = *device_transform;
+    hit_test->is_identity = _cairo_matrix_is_identity (ctm) &&
+			    _cairo_matrix_is_identity (device_transform);
+
+    hit_test->is_stroke = FALSE;
+    hit_test->fill_rule = CAIRO_FILL_RULE_WINDING;
+    _cairo_array_init (&hit_test->edges, sizeof (cairo_in_fill_edge_t));
+    _cairo_traps_init (&hit_test->traps);
+
+    return hit_test;
+}
+
+static void
+_cairo_hit_test_fini (cairo_hit_test_t *hit_test)
+{
+    _cairo_array_fini (&hit_test->edges);
+    _cairo_traps_fini (&hit_test->traps);
+}
+
+cairo_hit_test_t *
+_cairo_hit_test_create_for_fill (const cairo_path_fixed_t	*path,
+				 cairo_fill_rule_t		 fill_rule,
+				 double				 tolerance,
+				 const cairo_matrix_t		*ctm,
+				 const cairo_matrix_t		*device_transform)
+{
+    cairo_hit_test_t *hit_test;
+    cairo_status_t status;
+
+    hit_test = _cairo_hit_test_create (ctm, device_transform);
+    if (unlikely (hit_test == NULL))
+	return (cairo_hit_test_t *) &_cairo_hit_test_nil;
+
+    hit_test->fill_rule = fill_rule;
+
+    status = _cairo_path_fixed_in_fill_edges (path, tolerance,
+					      &hit_test->edges);
+    if (unlikely (status)) {
+	cairo_hit_test_destroy (hit_test);
+	return _cairo_hit_test_create_in_error (status);
+    }
+
+    return hit_test;
+}
+
+static inline int
+_cairo_trapezoid_compare (const cairo_trapezoid_t a,
+			  const cairo_trapezoid_t b)
+{
+    return (a.top > b.top) - (a.top < b.top);
+}
+
+CAIRO_COMBSORT_DECLARE (_cairo_trapezoids_sort,
+			cairo_trapezoid_t,
+			_cairo_trapezoid_compare)
+
+cairo_hit_test_t *
+_cairo_hit_test_create_for_stroke (const cairo_path_fixed_t	*path,
+				   const cairo_stroke_style_t	*style,
+				   const cairo_matrix_t		*ctm,
+				   const cairo_matrix_t		*ctm_inverse,
+				   double			 tolerance,
+				   const cairo_matrix_t		*device_transform)
+{
+    cairo_hit_test_t *hit_test;
+    cairo_status_t status;
+
+    hit_test = _cairo_hit_test_create (ctm, device_transform);
+    if (unlikely (hit_test == NULL))
+	return (cairo_hit_test_t *) &_cairo_hit_test_nil;
+
+    hit_test->is_stroke = TRUE;
+
+    if (style->line_width <= 0.0)
+	return hit_test;
+
+    status = _cairo_path_fixed_stroke_polygon_to_traps (path, style,
+							ctm, ctm_inverse,
+							tolerance,
+							&hit_test->traps);
+    if (unlikely (status)) {
+	cairo_hit_test_destroy (hit_test);
+	return _cairo_hit_test_create_in_error (status);
+    }
+
+    if (hit_test->traps.num_traps > 1) {
+	_cairo_trapezoids_sort (hit_test->traps.traps,
+				hit_test->traps.num_traps);
+    }
+
+    return hit_test;
+}
+
+/**
+ * cairo_hit_test_reference:
+ * @hit_test: a #cairo_hit_test_t
+ *
+ * Increases the reference count on @hit_test by one. This prevents
+ * @hit_test from being destroyed until a matching call to
+ * cairo_hit_test_destroy() is made.
+ *
+ * Return value: the referenced #cairo_hit_test_t.
+ *
+ * Since: 1.14
+ **/
+cairo_hit_test_t *
+cairo_hit_test_reference (cairo_hit_test_t *hit_test)
+{
+    if (hit_test == NULL || CAIRO_REFERENCE_COUNT_IS_INVALID (&hit_test->ref_count))
+	return hit_test;
+
+    assert (CAIRO_REFERENCE_COUNT_HAS_REFERENCE (&hit_test->ref_count));
+
+    _cairo_reference_count_inc (&hit_test->ref_count);
+    return hit_test;
+}
+
+/**
+ * cairo_hit_test_destroy:
+ * @hit_test: a #cairo_hit_test_t
+ *
+ * Destroys a #cairo_hit_test_t object created with
+ * cairo_hit_test_create_for_fill(), cairo_hit_test_create_for_stroke()
+ * or cairo_hit_test_reference().
+ *
+ * Since: 1.14
+ **/
+void
+cairo_hit_test_destroy (cairo_hit_test_t *hit_test)
+{
+    if (hit_test == NULL || CAIRO_REFERENCE_COUNT_IS_INVALID (&hit_test->ref_count))
+	return;
+
+    assert (CAIRO_REFERENCE_COUNT_HAS_REFERENCE (&hit_test->ref_count));
+
+    if (! _cairo_reference_count_dec_and_test (&hit_test->ref_count))
+	return;
+
+    _cairo_hit_test_fini (hit_test);
+    free (hit_test);
+}
+
+/**
+ * cairo_hit_test_status:
+ * @hit_test: a #cairo_hit_test_t
+ *
+ * Checks whether an error has previously occurred for this hit test
+ * object.
+ *
+ * Return value: %CAIRO_STATUS_SUCCESS, %CAIRO_STATUS_NO_MEMORY, or the
+ * error status of the #cairo_t it was created from if that context was
+ * already in an error state.
+ *
+ * Since: 1.14
+ **/
+cairo_status_t
+cairo_hit_test_status (cairo_hit_test_t *hit_test)
+{
+    return hit_test->status;
+}
+
+static inline int
+_cairo_hit_point_compare (const cairo_hit_point_t a,
+			  const cairo_hit_point_t b)
+{
+    return (a.point.y > b.point.y) - (a.point.y < b.point.y);
+}
+
+CAIRO_COMBSORT_DECLARE (_cairo_hit_points_sort,
+			cairo_hit_point_t,
+			_cairo_hit_point_compare)
+
+/**
+ * cairo_hit_test_contains_points:
+ * @hit_test: a #cairo_hit_test_t
+ * @points: an array of @num_points pairs of coordinates, x followed by y,
+ * in the user space of the context when the hit test was created
+ * @num_points: the number of points to test
+ * @inside: an array of @num_points booleans in which to store the results
+ *
+ * Tests each of the given points, setting the corresponding element of
+ * @inside to a non-zero value if the point lies within the area that
+ * the fill or stroke captured by @hit_test would cover, as cairo_in_fill()
+ * or cairo_in_stroke() would report for that point. (A point on the very
+ * edge of a stroke may be classified differently, see
+ * cairo_hit_test_create_for_stroke().)
+ *
+ * If @hit_test is in an error state, all the points are reported as
+ * being outside.
+ *
+ * Since: 1.14
+ **/
+void
+cairo_hit_test_contains_points (cairo_hit_test_t	*hit_test,
+				const double		*points,
+				int			 num_points,
+				cairo_bool_t		*inside)
+{
+    cairo_hit_point_t stack_points[CAIRO_STACK_ARRAY_LENGTH (cairo_hit_point_t)];
+    cairo_hit_point_t *hit_points;
+    cairo_status_t status;
+    int n;
+
+    if (num_points <= 0)
+	return;
+
+    for (n = 0; n < num_points; n++)
+	inside[n] = FALSE;
+
+    if (hit_test->status)
+	return;
+
+    hit_points = stack_points;
+    if (num_points > ARRAY_LENGTH (stack_points)) {
+	hit_points = _cairo_malloc_ab (num_points, sizeof (cairo_hit_point_t));
+	if (unlikely (hit_points == NULL)) {
+	    _cairo_status_set_error (&hit_test->status,
+				     _cairo_error (CAIRO_STATUS_NO_MEMORY));
+	    return;
+	}
+    }
+
+    for (n = 0; n < num_points; n++) {
+	double x = points[2*n + 0];
+	double y = points[2*n + 1];
+
+	if (! hit_test->is_identity) {
+	    cairo_matrix_transform_point (&hit_test->ctm, &x, &y);
+	    cairo_matrix_transform_point (&hit_test->device_transform, &x, &y);
+	}
+
+	hit_points[n].point.x = _cairo_fixed_from_double (x);
+	hit_points[n].point.y = _cairo_fixed_from_double (y);
+	hit_points[n].index = n;
+    }
+    if (num_points > 1)
+	_cairo_hit_points_sort (hit_points, num_points);
+
+    if (hit_test->is_stroke) {
+	status = _cairo_traps_contain_points (&hit_test->traps,
+					      hit_points, num_points,
+					      inside);
+    } else {
+	status = _cairo_in_fill_edges_contain (_cairo_array_index_const (&hit_test->edges, 0),
+					       _cairo_array_num_elements (&hit_test->edges),
+					       hit_test->fill_rule,
+					       hit_points, num_points,
+					       inside);
+    }
+    if (unlikely (status))
+	_cairo_status_set_error (&hit_test->status, status);
+
+    if (hit_points != stack_points)
+	free (hit_points);
+}
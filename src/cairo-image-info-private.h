@@ -45,6 +45,16 @@ typedef struct _cairo_image_info {
     int		 bits_per_component;
 } cairo_image_info_t;
 
+typedef struct _cairo_png_stream_info {
+    cairo_image_info_t	 info;
+    int			 color_type;
+    cairo_bool_t	 interlaced;
+    cairo_bool_t	 has_transparency;
+    const unsigned char	*palette;
+    unsigned long	 palette_length;
+    unsigned long	 idat_length;
+} cairo_png_stream_info_t;
+
 cairo_private cairo_int_status_t
 _cairo_image_info_get_jpeg_info (cairo_image_info_t	*info,
 				 const unsigned char	*data,
@@ -60,4 +70,14 @@ _cairo_image_info_get_png_info (cairo_image_info_t	*info,
 				const unsigned char     *data,
 				unsigned long            length);
 
+cairo_private cairo_int_status_t
+_cairo_image_info_get_png_stream_info (cairo_png_stream_info_t	*png,
+				       const unsigned char	*data,
+				       unsigned long		 length);
+
+cairo_private void
+_cairo_image_info_write_png_idat (cairo_output_stream_t	*stream,
+				  const unsigned char	*data,
+				  unsigned long		 length);
+
 #endif /* CAIRO_IMAGE_INFO_PRIVATE_H */
@@ -37,6 +37,7 @@
 
 #include "cairo-error-private.h"
 #include "cairo-image-info-private.h"
+#include "cairo-output-stream-private.h"
 
 static uint32_t
 _get_be32 (const unsigned char *p)
@@ -258,9 +259,55 @@ _cairo_image_info_get_jpx_info (cairo_image_info_t	*info,
  */
 
 #define PNG_IHDR 0x49484452
+#define PNG_PLTE 0x504c5445
+#define PNG_IDAT 0x49444154
+#define PNG_IEND 0x49454e44
+#define PNG_TRNS 0x74524e53
+
+#define PNG_COLOR_TYPE_GRAY		0
+#define PNG_COLOR_TYPE_RGB		2
+#define PNG_COLOR_TYPE_PALETTE		3
+#define PNG_COLOR_TYPE_GRAY_ALPHA	4
+#define PNG_COLOR_TYPE_RGB_ALPHA	6
 
 static const unsigned char _png_magic[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
 
+static int
+_png_num_components (int color_type)
+{
+    switch (color_type) {
+    case PNG_COLOR_TYPE_GRAY:
+    case PNG_COLOR_TYPE_PALETTE:
+	return 1;
+    case PNG_COLOR_TYPE_GRAY_ALPHA:
+	return 2;
+    case PNG_COLOR_TYPE_RGB:
+	return 3;
+    case PNG_COLOR_TYPE_RGB_ALPHA:
+	return 4;
+    default:
+	return 0;
+    }
+}
+
+/* Each chunk is a 4 byte length, a 4 byte type, the chunk data and a
+ * 4 byte CRC. Returns the start of the next chunk or NULL if the
+ * chunk at p does not fit between p and end. */
+static const unsigned char *
+_png_next_chunk (const unsigned char *p, const unsigned char *end)
+{
+    uint32_t length;
+
+    if (end - p < 12)
+	return NULL;
+
+    length = _get_be32 (p);
+    if (length > (unsigned long) (end - p) - 12)
+	return NULL;
+
+    return p + length + 12;
+}
+
 cairo_int_status_t
 _cairo_image_info_get_png_info (cairo_image_info_t     *info,
                                const unsigned char     *data,
@@ -287,6 +334,83 @@ _cairo_image_info_get_png_info (cairo_image_info_t     *info,
     info->width = _get_be32 (p);
     p += 4;
     info->height = _get_be32 (p);
+    p += 4;
+    info->bits_per_component = p[0];
+    info->num_components = _png_num_components (p[1]);
 
     return CAIRO_STATUS_SUCCESS;
 }
+
+/* Locate the chunks needed to embed the compressed image data
+ * directly. The image data itself is the concatenation of the
+ * payloads of all IDAT chunks, which forms a single zlib stream. */
+cairo_int_status_t
+_cairo_image_info_get_png_stream_info (cairo_png_stream_info_t	*png,
+				       const unsigned char	*data,
+				       unsigned long		 length)
+{
+    const unsigned char *p, *next;
+    const unsigned char *end = data + length;
+    cairo_int_status_t status;
+    uint32_t type;
+
+    status = _cairo_image_info_get_png_info (&png->info, data, length);
+    if (unlikely (status))
+	return status;
+
+    p = data + 8 + 8;
+    png->color_type = p[9];
+    png->interlaced = p[12] != 0;
+    if (p[10] != 0 || p[11] != 0 || png->info.num_components == 0)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    png->palette = NULL;
+    png->palette_length = 0;
+    png->has_transparency = FALSE;
+    png->idat_length = 0;
+
+    p = data + 8;
+    while ((next = _png_next_chunk (p, end)) != NULL) {
+	type = _get_be32 (p + 4);
+	if (type == PNG_IEND)
+	    break;
+
+	if (type == PNG_PLTE) {
+	    png->palette = p + 8;
+	    png->palette_length = _get_be32 (p);
+	} else if (type == PNG_TRNS) {
+	    png->has_transparency = TRUE;
+	} else if (type == PNG_IDAT) {
+	    png->idat_length += _get_be32 (p);
+	}
+
+	p = next;
+    }
+
+    /* Truncated or corrupt data */
+    if (next == NULL || png->idat_length == 0)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Write the concatenated IDAT payloads. The data must have already
+ * been validated with _cairo_image_info_get_png_stream_info(). */
+void
+_cairo_image_info_write_png_idat (cairo_output_stream_t	*stream,
+				  const unsigned char	*data,
+				  unsigned long		 length)
+{
+    const unsigned char *p, *next;
+    const unsigned char *end = data + length;
+
+    p = data + 8;
+    while ((next = _png_next_chunk (p, end)) != NULL) {
+	if (_get_be32 (p + 4) == PNG_IDAT)
+	    _cairo_output_stream_write (stream, p + 8, _get_be32 (p));
+	else if (_get_be32 (p + 4) == PNG_IEND)
+	    break;
+
+	p = next;
+    }
+}
@@ -43,6 +43,7 @@
 #include "cairo-clip-private.h"
 #include "cairo-composite-rectangles-private.h"
 #include "cairo-compositor-private.h"
+#include "cairo-damage-private.h"
 #include "cairo-default-context-private.h"
 #include "cairo-error-private.h"
 #include "cairo-image-surface-inline.h"
@@ -559,6 +560,17 @@ cairo_image_surface_get_data (cairo_surface_t *surface)
 	return NULL;
     }
 
+    /* The pixels may be written directly behind our backs */
+    if (surface->damage_is_ink) {
+	cairo_rectangle_int_t extents;
+
+	extents.x = extents.y = 0;
+	extents.width  = image_surface->width;
+	extents.height = image_surface->height;
+	surface->damage = _cairo_damage_add_rectangle (surface->damage,
+						       &extents);
+    }
+
     return image_surface->data;
 }
 slim_hidden_def (cairo_image_surface_get_data);
@@ -802,6 +814,11 @@ _cairo_image_surface_map_to_image (void *abstract_other,
     cairo_surface_t *surface;
     uint8_t *data;
 
+    /* The pixels may be written directly behind our backs */
+    if (other->base.damage_is_ink)
+	other->base.damage = _cairo_damage_add_rectangle (other->base.damage,
+							  extents);
+
     data = other->data;
     data += extents->y * other->stride;
     data += extents->x * PIXMAN_FORMAT_BPP (other->pixman_format)/ 8;
@@ -0,0 +1,527 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is Red Hat, Inc.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-error-private.h"
+#include "cairo-image-info-private.h"
+#include "cairo-image-surface-inline.h"
+#include "cairo-list-inline.h"
+
+/**
+ * SECTION:cairo-mime-surface
+ * @Title: Mime Surfaces
+ * @Short_Description: Lazily decoded compressed images
+ * @See_Also: #cairo_surface_t, cairo_surface_set_mime_data()
+ *
+ * A mime surface wraps a compressed image (JPEG, JPEG 2000 or PNG)
+ * without decoding it. The compressed data is attached to the surface
+ * as its mime data, so that backends which can embed the image
+ * directly (PDF and SVG) never need the pixels. The image is only
+ * decoded when it is used as a source by a raster backend, and the
+ * decoded pixels are kept in a process-wide cache of limited size from
+ * which they may be discarded again at any time.
+ *
+ * PNG images are decoded by cairo itself; other formats require a
+ * decoder to be supplied with cairo_mime_surface_set_decoder().
+ *
+ * Since: 1.14
+ **/
+
+/* Upper bound on the memory held by decoded images of all mime
+ * surfaces. Images in use by a rasteriser are kept alive by their own
+ * reference and do not count against this limit once evicted. */
+#define MAX_DECODED_CACHE_SIZE (64 << 20)
+
+typedef struct _cairo_mime_surface {
+    cairo_surface_t base;
+
+    const char *mime_type;
+    int width;
+    int height;
+
+    cairo_mime_surface_decode_func_t decode;
+    void *decode_closure;
+
+    /* Protected by _cairo_mime_surface_cache_mutex */
+    cairo_image_surface_t *image;
+    unsigned long image_size;
+    cairo_list_t link;
+} cairo_mime_surface_t;
+
+static const cairo_surface_backend_t _cairo_mime_surface_backend;
+
+static cairo_list_t _cairo_mime_surface_cache = {
+    &_cairo_mime_surface_cache, &_cairo_mime_surface_cache
+};
+static unsigned long _cairo_mime_surface_cache_size;
+
+static void
+_cairo_mime_surface_evict (cairo_mime_surface_t *surface)
+{
+    cairo_list_del (&surface->link);
+    _cairo_mime_surface_cache_size -= surface->image_size;
+
+    cairo_surface_destroy (&surface->image->base);
+    surface->image = NULL;
+    surface->image_size = 0;
+}
+
+static void
+_cairo_mime_surface_cache_shrink (unsigned long required)
+{
+    cairo_mime_surface_t *surface;
+
+    while (_cairo_mime_surface_cache_size + required > MAX_DECODED_CACHE_SIZE &&
+	   ! cairo_list_is_empty (&_cairo_mime_surface_cache))
+    {
+	surface = cairo_list_last_entry (&_cairo_mime_surface_cache,
+					 cairo_mime_surface_t, link);
+	_cairo_mime_surface_evict (surface);
+    }
+}
+
+void
+_cairo_mime_surface_reset_static_data (void)
+{
+    CAIRO_MUTEX_LOCK (_cairo_mime_surface_cache_mutex);
+    _cairo_mime_surface_cache_shrink (MAX_DECODED_CACHE_SIZE);
+    CAIRO_MUTEX_UNLOCK (_cairo_mime_surface_cache_mutex);
+}
+
+static cairo_status_t
+_cairo_mime_surface_finish (void *abstract_surface)
+{
+    cairo_mime_surface_t *surface = abstract_surface;
+
+    CAIRO_MUTEX_LOCK (_cairo_mime_surface_cache_mutex);
+    if (surface->image != NULL)
+	_cairo_mime_surface_evict (surface);
+    CAIRO_MUTEX_UNLOCK (_cairo_mime_surface_cache_mutex);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+#if CAIRO_HAS_PNG_FUNCTIONS
+struct png_read_closure {
+    const unsigned char *data;
+    unsigned long length;
+};
+
+static cairo_status_t
+_png_read_func (void *closure, unsigned char *data, unsigned int length)
+{
+    struct png_read_closure *png = closure;
+
+    if (length > png->length)
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    memcpy (data, png->data, length);
+    png->data += length;
+    png->length -= length;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+#endif
+
+static cairo_surface_t *
+_cairo_mime_surface_decode (cairo_mime_surface_t *surface)
+{
+    const unsigned char *data;
+    unsigned long length;
+    cairo_surface_t *image;
+
+    cairo_surface_get_mime_data (&surface->base, surface->mime_type,
+				 &data, &length);
+    if (unlikely (data == NULL))
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_READ_ERROR));
+
+    if (surface->decode != NULL) {
+	image = surface->decode (surface->decode_closure,
+				 surface->mime_type, data, length);
+	if (image == NULL)
+	    return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_READ_ERROR));
+    } else {
+#if CAIRO_HAS_PNG_FUNCTIONS
+	struct png_read_closure png;
+
+	if (strcmp (surface->mime_type, CAIRO_MIME_TYPE_PNG) != 0)
+	    return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_READ_ERROR));
+
+	png.data = data;
+	png.length = length;
+	image = cairo_image_surface_create_from_png_stream (_png_read_func, &png);
+
+	/* The compressed data already lives on the mime surface. */
+	if (image->status == CAIRO_STATUS_SUCCESS)
+	    cairo_surface_set_mime_data (image, CAIRO_MIME_TYPE_PNG, NULL, 0, NULL, NULL);
+#else
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_READ_ERROR));
+#endif
+    }
+
+    if (unlikely (image->status))
+	return image;
+
+    if (! _cairo_surface_is_image (image)) {
+	cairo_surface_destroy (image);
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_SURFACE_TYPE_MISMATCH));
+    }
+
+    return image;
+}
+
+static cairo_status_t
+_cairo_mime_surface_acquire_source_image (void                    *abstract_surface,
+					  cairo_image_surface_t  **image_out,
+					  void                   **image_extra)
+{
+    cairo_mime_surface_t *surface = abstract_surface;
+    cairo_image_surface_t *image;
+
+    CAIRO_MUTEX_LOCK (_cairo_mime_surface_cache_mutex);
+    image = surface->image;
+    if (image != NULL) {
+	cairo_list_move (&surface->link, &_cairo_mime_surface_cache);
+	cairo_surface_reference (&image->base);
+    }
+    CAIRO_MUTEX_UNLOCK (_cairo_mime_surface_cache_mutex);
+
+    if (image == NULL) {
+	cairo_surface_t *decoded;
+	unsigned long size;
+
+	/* Decode outside of the lock; should another thread beat us to
+	 * it, our copy is simply not cached. */
+	decoded = _cairo_mime_surface_decode (surface);
+	if (unlikely (decoded->status)) {
+	    cairo_status_t status = decoded->status;
+	    cairo_surface_destroy (decoded);
+	    return status;
+	}
+
+	image = (cairo_image_surface_t *) decoded;
+	size = (unsigned long) image->stride * image->height;
+
+	CAIRO_MUTEX_LOCK (_cairo_mime_surface_cache_mutex);
+	if (surface->image == NULL) {
+	    _cairo_mime_surface_cache_shrink (size);
+	    if (size <= MAX_DECODED_CACHE_SIZE) {
+		surface->image = (cairo_image_surface_t *) cairo_surface_reference (&image->base);
+		surface->image_size = size;
+		_cairo_mime_surface_cache_size += size;
+		cairo_list_add (&surface->link, &_cairo_mime_surface_cache);
+	    }
+	}
+	CAIRO_MUTEX_UNLOCK (_cairo_mime_surface_cache_mutex);
+    }
+
+    *image_out = image;
+    *image_extra = NULL;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+_cairo_mime_surface_release_source_image (void                   *abstract_surface,
+					  cairo_image_surface_t  *image,
+					  void                   *image_extra)
+{
+    cairo_surface_destroy (&image->base);
+}
+
+static cairo_surface_t *
+_cairo_mime_surface_snapshot (void *abstract_surface)
+{
+    cairo_mime_surface_t *surface = abstract_surface;
+    cairo_mime_surface_t *clone;
+    cairo_status_t status;
+
+    /* The compressed data is immutable and reference counted, so a
+     * snapshot only needs to share it. */
+    clone = malloc (sizeof (cairo_mime_surface_t));
+    if (unlikely (clone == NULL))
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_NO_MEMORY));
+
+    _cairo_surface_init (&clone->base,
+			 &_cairo_mime_surface_backend,
+			 NULL, /* device */
+			 surface->base.content);
+
+    clone->mime_type = surface->mime_type;
+    clone->width = surface->width;
+    clone->height = surface->height;
+    clone->decode = surface->decode;
+    clone->decode_closure = surface->decode_closure;
+    clone->image = NULL;
+    clone->image_size = 0;
+    cairo_list_init (&clone->link);
+
+    status = _cairo_surface_copy_mime_data (&clone->base, &surface->base);
+    if (unlikely (status)) {
+	cairo_surface_destroy (&clone->base);
+	return _cairo_surface_create_in_error (status);
+    }
+
+    return &clone->base;
+}
+
+static cairo_bool_t
+_cairo_mime_surface_get_extents (void			*abstract_surface,
+				 cairo_rectangle_int_t	*extents)
+{
+    cairo_mime_surface_t *surface = abstract_surface;
+
+    extents->x = extents->y = 0;
+    extents->width  = surface->width;
+    extents->height = surface->height;
+    return TRUE;
+}
+
+static const cairo_surface_backend_t _cairo_mime_surface_backend = {
+    CAIRO_SURFACE_TYPE_MIME,
+    _cairo_mime_surface_finish,
+
+    NULL, /* create_context */
+
+    NULL, /* create_similar */
+    NULL, /* create_similar_image */
+    NULL, /* map_to_image */
+    NULL, /* unmap_image */
+
+    _cairo_surface_default_source,
+    _cairo_mime_surface_acquire_source_image,
+    _cairo_mime_surface_release_source_image,
+    _cairo_mime_surface_snapshot,
+
+    NULL, /* copy_page */
+    NULL, /* show_page */
+
+    _cairo_mime_surface_get_extents,
+    NULL, /* get_font_options */
+
+    NULL, /* flush */
+    NULL, /* mark_dirty_rectangle */
+
+    NULL, /* paint */
+    NULL, /* mask */
+    NULL, /* stroke */
+    NULL, /* fill */
+    NULL, /* fill/stroke */
+    NULL, /* glyphs */
+};
+
+static cairo_int_status_t
+_cairo_mime_surface_get_info (const char		*mime_type,
+			      const unsigned char	*data,
+			      unsigned long		 length,
+			      cairo_image_info_t	*info,
+			      cairo_content_t		*content)
+{
+    cairo_int_status_t status;
+
+    if (strcmp (mime_type, CAIRO_MIME_TYPE_JPEG) == 0) {
+	status = _cairo_image_info_get_jpeg_info (info, data, length);
+	*content = CAIRO_CONTENT_COLOR;
+    } else if (strcmp (mime_type, CAIRO_MIME_TYPE_JP2) == 0) {
+	status = _cairo_image_info_get_jpx_info (info, data, length);
+	*content = CAIRO_CONTENT_COLOR;
+    } else if (strcmp (mime_type, CAIRO_MIME_TYPE_PNG) == 0) {
+	cairo_png_stream_info_t png;
+
+	status = _cairo_image_info_get_png_stream_info (&png, data, length);
+	if (status == CAIRO_INT_STATUS_SUCCESS) {
+	    *info = png.info;
+	    if (png.has_transparency ||
+		png.info.num_components == 2 ||
+		png.info.num_components == 4)
+	    {
+		*content = CAIRO_CONTENT_COLOR_ALPHA;
+	    }
+	    else
+	    {
+		*content = CAIRO_CONTENT_COLOR;
+	    }
+	}
+    } else {
+	status = CAIRO_INT_STATUS_UNSUPPORTED;
+    }
+
+    return status;
+}
+
+/**
+ * cairo_mime_surface_create:
+ * @mime_type: the MIME type of the compressed image data, one of
+ * %CAIRO_MIME_TYPE_JPEG, %CAIRO_MIME_TYPE_JP2 or %CAIRO_MIME_TYPE_PNG
+ * @data: the compressed image data
+ * @length: the length of the image data
+ * @destroy: a #cairo_destroy_func_t which will be called when the
+ * surface is destroyed and the data is no longer required
+ * @closure: the data to be passed to the @destroy notifier
+ *
+ * Creates a surface for a compressed image without decoding it. The
+ * size and content of the surface are read from the image header and
+ * @data is attached to the surface as mime data of type @mime_type.
+ *
+ * Vector backends that support @mime_type embed @data directly
+ * whenever the surface is used as a source. Other backends decode
+ * the image on demand, see cairo_mime_surface_set_decoder(). The
+ * decoded image is cached, but may be discarded at any time and
+ * decoded again when next required.
+ *
+ * The surface cannot be drawn upon.
+ *
+ * Return value: a pointer to the newly created surface. The caller
+ * owns the surface and should call cairo_surface_destroy() when done
+ * with it. @destroy is called even if an error occurs.
+ *
+ * This function always returns a valid pointer, but it will return a
+ * pointer to a "nil" surface if an error such as out of memory
+ * occurs, or %CAIRO_STATUS_INVALID_FORMAT if the image header cannot
+ * be parsed. You can use cairo_surface_status() to check for this.
+ *
+ * Since: 1.14
+ **/
+cairo_surface_t *
+cairo_mime_surface_create (const char		*mime_type,
+			   const unsigned char	*data,
+			   unsigned long	 length,
+			   cairo_destroy_func_t	 destroy,
+			   void			*closure)
+{
+    cairo_mime_surface_t *surface;
+    cairo_image_info_t info;
+    cairo_content_t content;
+    cairo_status_t status;
+
+    if (mime_type == NULL || data == NULL) {
+	if (destroy)
+	    destroy (closure);
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_NULL_POINTER));
+    }
+
+    status = _cairo_mime_surface_get_info (mime_type, data, length,
+					   &info, &content);
+    if (unlikely (status)) {
+	if (destroy)
+	    destroy (closure);
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_INVALID_FORMAT));
+    }
+
+    surface = malloc (sizeof (cairo_mime_surface_t));
+    if (unlikely (surface == NULL)) {
+	if (destroy)
+	    destroy (closure);
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_NO_MEMORY));
+    }
+
+    _cairo_surface_init (&surface->base,
+			 &_cairo_mime_surface_backend,
+			 NULL, /* device */
+			 content);
+
+    surface->mime_type = mime_type;
+    surface->width = info.width;
+    surface->height = info.height;
+    surface->decode = NULL;
+    surface->decode_closure = NULL;
+    surface->image = NULL;
+    surface->image_size = 0;
+    cairo_list_init (&surface->link);
+
+    status = _cairo_intern_string (&surface->mime_type, -1);
+    if (unlikely (status)) {
+	if (destroy)
+	    destroy (closure);
+	cairo_surface_destroy (&surface->base);
+	return _cairo_surface_create_in_error (status);
+    }
+
+    status = cairo_surface_set_mime_data (&surface->base, mime_type,
+					  data, length,
+					  destroy, closure);
+    if (unlikely (status)) {
+	if (destroy)
+	    destroy (closure);
+	cairo_surface_destroy (&surface->base);
+	return _cairo_surface_create_in_error (status);
+    }
+
+    return &surface->base;
+}
+
+/**
+ * cairo_mime_surface_set_decoder:
+ * @surface: a mime surface
+ * @decode: the function used to decode the compressed image data
+ * @closure: the data to be passed to @decode
+ *
+ * Sets the function used to decode the image of @surface into pixels
+ * when it is required by a raster backend. @decode must return a new
+ * image surface of the size of @surface, or %NULL on error. It may be
+ * called more than once over the life-time of @surface, from any
+ * thread using the surface.
+ *
+ * If no decoder is set, PNG images are decoded by cairo and all other
+ * formats fail to render with %CAIRO_STATUS_READ_ERROR.
+ *
+ * Since: 1.14
+ **/
+void
+cairo_mime_surface_set_decoder (cairo_surface_t			*abstract_surface,
+				cairo_mime_surface_decode_func_t decode,
+				void				*closure)
+{
+    cairo_mime_surface_t *surface = (cairo_mime_surface_t *) abstract_surface;
+
+    if (unlikely (abstract_surface->status))
+	return;
+    if (unlikely (abstract_surface->finished)) {
+	_cairo_surface_set_error (abstract_surface,
+				  _cairo_error (CAIRO_STATUS_SURFACE_FINISHED));
+	return;
+    }
+
+    if (abstract_surface->backend != &_cairo_mime_surface_backend) {
+	_cairo_surface_set_error (abstract_surface,
+				  _cairo_error (CAIRO_STATUS_SURFACE_TYPE_MISMATCH));
+	return;
+    }
+
+    surface->decode = decode;
+    surface->decode_closure = closure;
+
+    /* Any previously decoded pixels may no longer be valid. */
+    CAIRO_MUTEX_LOCK (_cairo_mime_surface_cache_mutex);
+    if (surface->image != NULL)
+	_cairo_mime_surface_evict (surface);
+    CAIRO_MUTEX_UNLOCK (_cairo_mime_surface_cache_mutex);
+}
@@ -46,9 +46,13 @@ CAIRO_MUTEX_DECLARE (_cairo_scaled_font_map_mutex)
 CAIRO_MUTEX_DECLARE (_cairo_scaled_glyph_page_cache_mutex)
 CAIRO_MUTEX_DECLARE (_cairo_scaled_font_error_mutex)
 CAIRO_MUTEX_DECLARE (_cairo_glyph_cache_mutex)
+CAIRO_MUTEX_DECLARE (_cairo_mime_surface_cache_mutex)
 
 #if CAIRO_HAS_FT_FONT
 CAIRO_MUTEX_DECLARE (_cairo_ft_unscaled_font_map_mutex)
+#if CAIRO_HAS_FC_FONT
+CAIRO_MUTEX_DECLARE (_cairo_ft_resolve_cache_mutex)
+#endif
 #endif
 
 #if CAIRO_HAS_WIN32_FONT
@@ -125,6 +125,11 @@ _cairo_output_stream_write_hex_string (cairo_output_stream_t *stream,
 				       const unsigned char *data,
 				       size_t length);
 
+/* Format a double in a locale independent way, as done by the %f
+ * and %g conversions of _cairo_output_stream_printf(). */
+cairo_private void
+_cairo_dtostr (char *buffer, size_t size, double d, cairo_bool_t limited_precision);
+
 cairo_private void
 _cairo_output_stream_vprintf (cairo_output_stream_t *stream,
 			      const char *fmt,
@@ -36,12 +36,49 @@
  */
 
 #include "cairoint.h"
+#include "cairo-box-inline.h"
 #include "cairo-boxes-private.h"
+#include "cairo-contour-inline.h"
 #include "cairo-error-private.h"
+#include "cairo-list-inline.h"
 #include "cairo-path-fixed-private.h"
 #include "cairo-region-private.h"
 #include "cairo-traps-private.h"
 
+/* Paths from GIS and scientific data often carry far more vertices than
+ * there are pixels to show them. When the caller allows the raster to
+ * be degraded for speed, see _cairo_path_fixed_fill_to_simplified_polygon(),
+ * each sub-path whose vertex count exceeds both LOD_MIN_POINTS and the
+ * perimeter of its own extents in device pixels is gathered into a
+ * contour and reduced with _cairo_contour_simplify() before tessellation.
+ * Small sub-paths are left alone even if over-detailed, as for many
+ * little islands the reduction costs more than the scan conversion it
+ * saves. Half the tolerance goes to the vertex reduction and half to the
+ * Douglas-Peucker pass, so the flattened outline never moves by more
+ * than the tolerance. Sub-paths are simplified independently with their
+ * first vertex pinned, so none are merged and only those that collapse
+ * within the tolerance are dropped. The reduction does not preserve
+ * topology, however: edges closer together than the tolerance may come
+ * to cross, which moves coverage around only within that distance of
+ * the outline.
+ */
+#define LOD_MIN_POINTS 1024
+
+static cairo_bool_t
+_cairo_path_fill_lod_contour (int num_points, const cairo_box_t *extents)
+{
+    int64_t perimeter;
+
+    if (num_points <= LOD_MIN_POINTS)
+	return FALSE;
+
+    perimeter = extents->p2.x - extents->p1.x;
+    perimeter += extents->p2.y - extents->p1.y;
+    perimeter = 2 * _cairo_fixed_integer_ceil (perimeter);
+
+    return num_points > perimeter;
+}
+
 typedef struct cairo_filler {
     cairo_polygon_t *polygon;
     double tolerance;
@@ -51,6 +88,11 @@ typedef struct cairo_filler {
 
     cairo_point_t current_point;
     cairo_point_t last_move_to;
+
+    /* Only used for over-detailed paths, see _cairo_path_fixed_fill_lod() */
+    cairo_contour_t *contour;
+    cairo_box_t contour_extents;
+    int contour_points;
 } cairo_filler_t;
 
 static cairo_status_t
@@ -60,6 +102,17 @@ _cairo_filler_line_to (void *closure,
     cairo_filler_t *filler = closure;
     cairo_status_t status;
 
+    if (filler->contour) {
+	if (point->x == filler->current_point.x &&
+	    point->y == filler->current_point.y)
+	    return CAIRO_STATUS_SUCCESS;
+
+	filler->current_point = *point;
+	_cairo_box_add_point (&filler->contour_extents, point);
+	filler->contour_points++;
+	return _cairo_contour_add_point (filler->contour, point);
+    }
+
     status = _cairo_polygon_add_external_edge (filler->polygon,
 					       &filler->current_point,
 					       point);
@@ -69,10 +122,58 @@ _cairo_filler_line_to (void *closure,
     return status;
 }
 
+static cairo_status_t
+_cairo_filler_emit_contour (cairo_filler_t *filler)
+{
+    cairo_contour_t *contour = filler->contour;
+    const cairo_contour_chain_t *chain;
+    const cairo_point_t *first, *last;
+    cairo_status_t status;
+    int i;
+
+    if (_cairo_path_fill_lod_contour (filler->contour_points,
+				      &filler->contour_extents))
+    {
+	_cairo_contour_simplify (contour, filler->tolerance / 2);
+    }
+
+    first = last = &contour->chain.points[0];
+    for (chain = &contour->chain; chain; chain = chain->next) {
+	for (i = 0; i < chain->num_points; i++) {
+	    const cairo_point_t *p = &chain->points[i];
+
+	    if (p == first)
+		continue;
+
+	    status = _cairo_polygon_add_external_edge (filler->polygon,
+						       last, p);
+	    if (unlikely (status))
+		return status;
+
+	    last = p;
+	}
+    }
+
+    return _cairo_polygon_add_external_edge (filler->polygon, last, first);
+}
+
 static cairo_status_t
 _cairo_filler_close (void *closure)
 {
     cairo_filler_t *filler = closure;
+    cairo_status_t status;
+
+    if (filler->contour) {
+	status = CAIRO_STATUS_SUCCESS;
+
+	/* a sub-path needs at least 3 vertices to enclose any area */
+	if (filler->contour->chain.num_points > 2)
+	    status = _cairo_filler_emit_contour (filler);
+
+	_cairo_contour_reset (filler->contour);
+	filler->current_point = filler->last_move_to;
+	return status;
+    }
 
     /* close the subpath */
     return _cairo_filler_line_to (closure, &filler->last_move_to);
@@ -94,6 +195,12 @@ _cairo_filler_move_to (void *closure,
     filler->current_point = *point;
     filler->last_move_to = *point;
 
+    if (filler->contour) {
+	filler->contour_extents.p1 = filler->contour_extents.p2 = *point;
+	filler->contour_points = 1;
+	return _cairo_contour_add_point (filler->contour, point);
+    }
+
     return CAIRO_STATUS_SUCCESS;
 }
 
@@ -122,17 +229,62 @@ _cairo_filler_curve_to (void		*closure,
     return _cairo_spline_decompose (&spline, filler->tolerance);
 }
 
-cairo_status_t
-_cairo_path_fixed_fill_to_polygon (const cairo_path_fixed_t *path,
-				   double tolerance,
-				   cairo_polygon_t *polygon)
+/* Gathering the sub-paths into contours is only worthwhile if at least
+ * one of them may be simplified, see _cairo_path_fill_lod_contour().
+ * No op adds more than 3 points, so it is enough to look for a run of
+ * more than LOD_MIN_POINTS / 3 ops between two move-tos. A path made of
+ * many small sub-paths is rejected without looking at its points. */
+static cairo_bool_t
+_cairo_path_fixed_fill_lod (const cairo_path_fixed_t *path)
+{
+    const cairo_path_buf_t *buf;
+    int num_ops;
+
+    num_ops = 0;
+    cairo_path_foreach_buf_start (buf, path) {
+	const cairo_path_op_t *op = buf->op;
+	const cairo_path_op_t *end = op + buf->num_ops;
+
+	while (op < end) {
+	    const cairo_path_op_t *move_to;
+
+	    move_to = memchr (op, CAIRO_PATH_OP_MOVE_TO, end - op);
+	    if (move_to == NULL) {
+		num_ops += end - op;
+		break;
+	    }
+
+	    num_ops += move_to - op;
+	    if (num_ops > LOD_MIN_POINTS / 3)
+		return TRUE;
+
+	    num_ops = 0;
+	    op = move_to + 1;
+	}
+    } cairo_path_foreach_buf_end (buf, path);
+
+    return num_ops > LOD_MIN_POINTS / 3;
+}
+
+static cairo_status_t
+_cairo_path_fixed_fill_to_polygon_internal (const cairo_path_fixed_t *path,
+					    double tolerance,
+					    cairo_bool_t simplify,
+					    cairo_polygon_t *polygon)
 {
     cairo_filler_t filler;
+    cairo_contour_t contour;
     cairo_status_t status;
 
     filler.polygon = polygon;
     filler.tolerance = tolerance;
 
+    filler.contour = NULL;
+    if (simplify) {
+	_cairo_contour_init (&contour, 1);
+	filler.contour = &contour;
+    }
+
     filler.has_limits = FALSE;
     if (polygon->num_limits) {
 	filler.has_limits = TRUE;
@@ -150,10 +302,35 @@ _cairo_path_fixed_fill_to_polygon (const cairo_path_fixed_t *path,
 					  _cairo_filler_curve_to,
 					  _cairo_filler_close,
 					  &filler);
-    if (unlikely (status))
-	return status;
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = _cairo_filler_close (&filler);
+
+    if (filler.contour)
+	_cairo_contour_fini (&contour);
+
+    return status;
+}
+
+cairo_status_t
+_cairo_path_fixed_fill_to_polygon (const cairo_path_fixed_t *path,
+				   double tolerance,
+				   cairo_polygon_t *polygon)
+{
+    return _cairo_path_fixed_fill_to_polygon_internal (path, tolerance,
+						       FALSE, polygon);
+}
 
-    return _cairo_filler_close (&filler);
+/* As _cairo_path_fixed_fill_to_polygon(), but over-detailed paths may be
+ * simplified to within the tolerance first. This is only for callers
+ * that have been asked to favour speed, by CAIRO_ANTIALIAS_FAST. */
+cairo_status_t
+_cairo_path_fixed_fill_to_simplified_polygon (const cairo_path_fixed_t *path,
+					      double tolerance,
+					      cairo_polygon_t *polygon)
+{
+    return _cairo_path_fixed_fill_to_polygon_internal (path, tolerance,
+						       _cairo_path_fixed_fill_lod (path),
+						       polygon);
 }
 
 typedef struct cairo_filler_rectilinear_aligned {
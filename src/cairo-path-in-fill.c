@@ -34,6 +34,9 @@
  */
 
 #include "cairoint.h"
+#include "cairo-array-private.h"
+#include "cairo-combsort-inline.h"
+#include "cairo-hit-test-private.h"
 #include "cairo-path-fixed-private.h"
 
 typedef struct cairo_in_fill {
@@ -41,6 +44,10 @@ typedef struct cairo_in_fill {
     cairo_bool_t on_edge;
     int winding;
 
+    /* when set, collect the edges instead of testing a single point */
+    cairo_array_t *edges;
+    cairo_status_t status;
+
     cairo_fixed_t x, y;
 
     cairo_bool_t has_current_point;
@@ -58,6 +65,9 @@ _cairo_in_fill_init (cairo_in_fill_t	*in_fill,
     in_fill->winding = 0;
     in_fill->tolerance = tolerance;
 
+    in_fill->edges = NULL;
+    in_fill->status = CAIRO_STATUS_SUCCESS;
+
     in_fill->x = _cairo_fixed_from_double (x);
     in_fill->y = _cairo_fixed_from_double (y);
 
@@ -98,6 +108,44 @@ edge_compare_for_y_against_x (const cairo_point_t *p1,
     return _cairo_int64_cmp (L, R);
 }
 
+/* Accumulate the crossings to -∞ of an edge, oriented from top to
+ * bottom, returning TRUE if the point lies upon the edge itself. */
+static cairo_bool_t
+_cairo_in_fill_edge (const cairo_point_t *p1,
+		     const cairo_point_t *p2,
+		     int dir,
+		     cairo_fixed_t x,
+		     cairo_fixed_t y,
+		     int *winding)
+{
+    /* First check whether the query is on an edge */
+    if ((p1->x == x && p1->y == y) ||
+	(p2->x == x && p2->y == y) ||
+	(! (p2->y < y || p1->y > y ||
+	   (p1->x > x && p2->x > x) ||
+	   (p1->x < x && p2->x < x)) &&
+	 edge_compare_for_y_against_x (p1, p2, y, x) == 0))
+    {
+	return TRUE;
+    }
+
+    /* edge is entirely above or below, note the shortening rule */
+    if (p2->y <= y || p1->y > y)
+	return FALSE;
+
+    /* edge lies wholly to the right */
+    if (p1->x >= x && p2->x >= x)
+	return FALSE;
+
+    if ((p1->x <= x && p2->x <= x) ||
+	edge_compare_for_y_against_x (p1, p2, y, x) < 0)
+    {
+	*winding += dir;
+    }
+
+    return FALSE;
+}
+
 static void
 _cairo_in_fill_add_edge (cairo_in_fill_t *in_fill,
 			 const cairo_point_t *p1,
@@ -121,30 +169,24 @@ _cairo_in_fill_add_edge (cairo_in_fill_t *in_fill,
 	dir = -1;
     }
 
-    /* First check whether the query is on an edge */
-    if ((p1->x == in_fill->x && p1->y == in_fill->y) ||
-	(p2->x == in_fill->x && p2->y == in_fill->y) ||
-	(! (p2->y < in_fill->y || p1->y > in_fill->y ||
-	   (p1->x > in_fill->x && p2->x > in_fill->x) ||
-	   (p1->x < in_fill->x && p2->x < in_fill->x)) &&
-	 edge_compare_for_y_against_x (p1, p2, in_fill->y, in_fill->x) == 0))
-    {
-	in_fill->on_edge = TRUE;
-	return;
-    }
+    if (in_fill->edges != NULL) {
+	cairo_in_fill_edge_t edge;
+	cairo_status_t status;
 
-    /* edge is entirely above or below, note the shortening rule */
-    if (p2->y <= in_fill->y || p1->y > in_fill->y)
-	return;
+	edge.p1 = *p1;
+	edge.p2 = *p2;
+	edge.dir = dir;
 
-    /* edge lies wholly to the right */
-    if (p1->x >= in_fill->x && p2->x >= in_fill->x)
+	status = _cairo_array_append (in_fill->edges, &edge);
+	if (unlikely (status))
+	    in_fill->status = status;
 	return;
+    }
 
-    if ((p1->x <= in_fill->x && p2->x <= in_fill->x) ||
-	edge_compare_for_y_against_x (p1, p2, in_fill->y, in_fill->x) < 0)
+    if (_cairo_in_fill_edge (p1, p2, dir, in_fill->x, in_fill->y,
+			     &in_fill->winding))
     {
-	in_fill->winding += dir;
+	in_fill->on_edge = TRUE;
     }
 }
 
@@ -193,6 +235,9 @@ _cairo_in_fill_curve_to (void *closure,
     cairo_spline_t spline;
     cairo_fixed_t top, bot, left;
 
+    if (in_fill->edges != NULL)
+	goto decompose;
+
     /* first reject based on bbox */
     bot = top = in_fill->current_point.y;
     if (b->y < top) top = b->y;
@@ -216,6 +261,7 @@ _cairo_in_fill_curve_to (void *closure,
     }
 
     /* XXX Investigate direct inspection of the inflections? */
+decompose:
     if (! _cairo_spline_init (&spline,
 			      (cairo_spline_add_point_func_t)_cairo_in_fill_line_to,
 			      in_fill,
@@ -288,3 +334,116 @@ _cairo_path_fixed_in_fill (const cairo_path_fixed_t	*path,
 
     return is_inside;
 }
+
+static inline int
+_cairo_in_fill_edge_compare (const cairo_in_fill_edge_t a,
+			     const cairo_in_fill_edge_t b)
+{
+    return (a.p1.y > b.p1.y) - (a.p1.y < b.p1.y);
+}
+
+CAIRO_COMBSORT_DECLARE (_cairo_in_fill_edges_sort,
+			cairo_in_fill_edge_t,
+			_cairo_in_fill_edge_compare)
+
+/* Flatten the path into the edges that _cairo_path_fixed_in_fill() would
+ * visit for any point, sorted by their top, so that many points can be
+ * tested against them by _cairo_in_fill_edges_contain(). */
+cairo_status_t
+_cairo_path_fixed_in_fill_edges (const cairo_path_fixed_t	*path,
+				 double				 tolerance,
+				 cairo_array_t			*edges)
+{
+    cairo_in_fill_t in_fill;
+    cairo_status_t status;
+
+    if (_cairo_path_fixed_fill_is_empty (path))
+	return CAIRO_STATUS_SUCCESS;
+
+    _cairo_in_fill_init (&in_fill, tolerance, 0, 0);
+    in_fill.edges = edges;
+
+    status = _cairo_path_fixed_interpret (path,
+					  _cairo_in_fill_move_to,
+					  _cairo_in_fill_line_to,
+					  _cairo_in_fill_curve_to,
+					  _cairo_in_fill_close_path,
+					  &in_fill);
+    assert (status == CAIRO_STATUS_SUCCESS);
+
+    _cairo_in_fill_close_path (&in_fill);
+
+    _cairo_in_fill_fini (&in_fill);
+
+    if (unlikely (in_fill.status))
+	return in_fill.status;
+
+    if (_cairo_array_num_elements (edges) > 1) {
+	_cairo_in_fill_edges_sort (_cairo_array_index (edges, 0),
+				   _cairo_array_num_elements (edges));
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Test each of the points, which must be in order of increasing y,
+ * against the sorted edges. An edge joins the active list once the scan
+ * reaches its top and leaves it once the scan has passed its bottom, so
+ * each point only visits the edges that span it. */
+cairo_status_t
+_cairo_in_fill_edges_contain (const cairo_in_fill_edge_t	*edges,
+			      int				 num_edges,
+			      cairo_fill_rule_t			 fill_rule,
+			      const cairo_hit_point_t		*points,
+			      int				 num_points,
+			      cairo_bool_t			*inside)
+{
+    const cairo_in_fill_edge_t *stack_active[CAIRO_STACK_ARRAY_LENGTH (cairo_in_fill_edge_t *)];
+    const cairo_in_fill_edge_t **active;
+    int num_active, next, i, j, n;
+
+    active = stack_active;
+    if (num_edges > ARRAY_LENGTH (stack_active)) {
+	active = _cairo_malloc_ab (num_edges, sizeof (cairo_in_fill_edge_t *));
+	if (unlikely (active == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    num_active = next = 0;
+    for (n = 0; n < num_points; n++) {
+	const cairo_point_t *pt = &points[n].point;
+	cairo_bool_t on_edge = FALSE;
+	int winding = 0;
+
+	while (next < num_edges && edges[next].p1.y <= pt->y)
+	    active[num_active++] = &edges[next++];
+
+	for (i = j = 0; i < num_active; i++) {
+	    if (active[i]->p2.y >= pt->y)
+		active[j++] = active[i];
+	}
+	num_active = j;
+
+	for (i = 0; i < num_active; i++) {
+	    if (_cairo_in_fill_edge (&active[i]->p1, &active[i]->p2,
+				     active[i]->dir, pt->x, pt->y,
+				     &winding))
+	    {
+		on_edge = TRUE;
+		break;
+	    }
+	}
+
+	if (on_edge)
+	    inside[points[n].index] = TRUE;
+	else if (fill_rule == CAIRO_FILL_RULE_EVEN_ODD)
+	    inside[points[n].index] = winding & 1;
+	else
+	    inside[points[n].index] = winding != 0;
+    }
+
+    if (active != stack_active)
+	free (active);
+
+    return CAIRO_STATUS_SUCCESS;
+}
@@ -31,6 +31,7 @@
 #include "cairoint.h"
 
 #include "cairo-array-private.h"
+#include "cairo-damage-private.h"
 #include "cairo-error-private.h"
 #include "cairo-freed-pool-private.h"
 #include "cairo-image-surface-private.h"
@@ -3475,6 +3476,21 @@ _cairo_pattern_get_extents (const cairo_pattern_t         *pattern,
 	    if (pattern->extend != CAIRO_EXTEND_NONE)
 		goto UNBOUNDED;
 
+	    /* Everything outside of the ink is transparent */
+	    if (surface->damage_is_ink) {
+		surface->damage = _cairo_damage_reduce (surface->damage);
+		if (surface->damage->status == CAIRO_STATUS_SUCCESS) {
+		    cairo_rectangle_int_t ink;
+
+		    if (surface->damage->region == NULL)
+			goto EMPTY;
+
+		    cairo_region_get_extents (surface->damage->region, &ink);
+		    if (! _cairo_rectangle_intersect (&surface_extents, &ink))
+			goto EMPTY;
+		}
+	    }
+
 	    /* The filter can effectively enlarge the extents of the
 	     * pattern, so extend as necessary.
 	     */
@@ -63,6 +63,23 @@ typedef struct _cairo_pdf_glyph {
     double x_advance;
 } cairo_pdf_glyph_t;
 
+/* The number of dash elements remembered in the line style. Longer
+ * dash arrays are always emitted.
+ */
+#define PDF_DASH_STATE_SIZE 8
+
+typedef struct _cairo_pdf_line_style {
+    cairo_bool_t         has_line_style;
+    double		 line_width;
+    cairo_line_cap_t	 line_cap;
+    cairo_line_join_t	 line_join;
+    double		 miter_limit;
+    cairo_bool_t         has_dashes;
+    int			 num_dashes; /* -1 if the dash array is not known */
+    double		 dash[PDF_DASH_STATE_SIZE];
+    double		 dash_offset;
+} cairo_pdf_line_style_t;
+
 typedef struct _cairo_pdf_operators {
     cairo_output_stream_t *stream;
     cairo_matrix_t cairo_to_pdf;
@@ -88,12 +105,12 @@ typedef struct _cairo_pdf_operators {
     cairo_pdf_glyph_t glyphs[PDF_GLYPH_BUFFER_SIZE];
 
     /* PDF line style */
-    cairo_bool_t         has_line_style;
-    double		 line_width;
-    cairo_line_cap_t	 line_cap;
-    cairo_line_join_t	 line_join;
-    double		 miter_limit;
-    cairo_bool_t         has_dashes;
+    cairo_pdf_line_style_t line_style;
+    cairo_pdf_line_style_t saved_line_style;
+
+    /* Stroke merging */
+    cairo_bool_t merge_strokes;
+    cairo_bool_t in_stroke; /* stroke path emitted but not yet painted */
 } cairo_pdf_operators_t;
 
 cairo_private void
@@ -123,12 +140,22 @@ cairo_private void
 _cairo_pdf_operators_enable_actual_text (cairo_pdf_operators_t *pdf_operators,
 					 cairo_bool_t 	  	enable);
 
+cairo_private void
+_cairo_pdf_operators_enable_stroke_merging (cairo_pdf_operators_t *pdf_operators,
+					    cairo_bool_t	   enable);
+
 cairo_private cairo_status_t
 _cairo_pdf_operators_flush (cairo_pdf_operators_t	 *pdf_operators);
 
 cairo_private void
 _cairo_pdf_operators_reset (cairo_pdf_operators_t	 *pdf_operators);
 
+cairo_private void
+_cairo_pdf_operators_save (cairo_pdf_operators_t	 *pdf_operators);
+
+cairo_private void
+_cairo_pdf_operators_restore (cairo_pdf_operators_t	 *pdf_operators);
+
 cairo_private cairo_int_status_t
 _cairo_pdf_operators_clip (cairo_pdf_operators_t	*pdf_operators,
 			   const cairo_path_fixed_t	*path,
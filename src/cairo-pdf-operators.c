@@ -52,6 +52,9 @@
 static cairo_status_t
 _cairo_pdf_operators_end_text (cairo_pdf_operators_t    *pdf_operators);
 
+static cairo_status_t
+_cairo_pdf_operators_end_stroke (cairo_pdf_operators_t  *pdf_operators);
+
 
 void
 _cairo_pdf_operators_init (cairo_pdf_operators_t	*pdf_operators,
@@ -66,8 +69,11 @@ _cairo_pdf_operators_init (cairo_pdf_operators_t	*pdf_operators,
     pdf_operators->use_font_subset_closure = NULL;
     pdf_operators->in_text_object = FALSE;
     pdf_operators->num_glyphs = 0;
-    pdf_operators->has_line_style = FALSE;
+    pdf_operators->line_style.has_line_style = FALSE;
+    pdf_operators->saved_line_style.has_line_style = FALSE;
     pdf_operators->use_actual_text = FALSE;
+    pdf_operators->merge_strokes = FALSE;
+    pdf_operators->in_stroke = FALSE;
 }
 
 cairo_status_t
@@ -94,7 +100,7 @@ _cairo_pdf_operators_set_stream (cairo_pdf_operators_t	 *pdf_operators,
 				 cairo_output_stream_t   *stream)
 {
     pdf_operators->stream = stream;
-    pdf_operators->has_line_style = FALSE;
+    pdf_operators->line_style.has_line_style = FALSE;
 }
 
 void
@@ -102,7 +108,7 @@ _cairo_pdf_operators_set_cairo_to_pdf_matrix (cairo_pdf_operators_t *pdf_operato
 					      cairo_matrix_t	    *cairo_to_pdf)
 {
     pdf_operators->cairo_to_pdf = *cairo_to_pdf;
-    pdf_operators->has_line_style = FALSE;
+    pdf_operators->line_style.has_line_style = FALSE;
 }
 
 cairo_private void
@@ -112,6 +118,20 @@ _cairo_pdf_operators_enable_actual_text (cairo_pdf_operators_t *pdf_operators,
     pdf_operators->use_actual_text = enable;
 }
 
+/* Allow a stroke to be left unpainted so that following strokes of
+ * the same style can be appended to its path and painted by a single
+ * 'S' operator. The caller must only enable this when painting the
+ * union of the strokes is identical to painting them one at a time,
+ * ie for opaque colors with the normal blend mode, and must call
+ * _cairo_pdf_operators_flush() before changing the stroke color.
+ */
+void
+_cairo_pdf_operators_enable_stroke_merging (cairo_pdf_operators_t *pdf_operators,
+					    cairo_bool_t	   enable)
+{
+    pdf_operators->merge_strokes = enable;
+}
+
 /* Finish writing out any pending commands to the stream. This
  * function must be called by the surface before emitting anything
  * into the PDF stream.
@@ -131,6 +151,9 @@ _cairo_pdf_operators_flush (cairo_pdf_operators_t	 *pdf_operators)
     if (pdf_operators->in_text_object)
 	status = _cairo_pdf_operators_end_text (pdf_operators);
 
+    if (pdf_operators->in_stroke && status == CAIRO_STATUS_SUCCESS)
+	status = _cairo_pdf_operators_end_stroke (pdf_operators);
+
     return status;
 }
 
@@ -147,242 +170,132 @@ _cairo_pdf_operators_flush (cairo_pdf_operators_t	 *pdf_operators)
 void
 _cairo_pdf_operators_reset (cairo_pdf_operators_t *pdf_operators)
 {
-    pdf_operators->has_line_style = FALSE;
+    pdf_operators->line_style.has_line_style = FALSE;
 }
 
-/* A word wrap stream can be used as a filter to do word wrapping on
- * top of an existing output stream. The word wrapping is quite
- * simple, using isspace to determine characters that separate
- * words. Any word that will cause the column count exceed the given
- * max_column will have a '\n' character emitted before it.
- *
- * The stream is careful to maintain integrity for words that cross
- * the boundary from one call to write to the next.
- *
- * Note: This stream does not guarantee that the output will never
- * exceed max_column. In particular, if a single word is larger than
- * max_column it will not be broken up.
+/* Remember the known graphics state when the surface emits the 'q'
+ * operator so that it can be reinstated by
+ * _cairo_pdf_operators_restore() after the matching 'Q' instead of
+ * being forgotten. Only one level of nesting is tracked.
  */
-
-typedef enum _cairo_word_wrap_state {
-    WRAP_STATE_DELIMITER,
-    WRAP_STATE_WORD,
-    WRAP_STATE_STRING,
-    WRAP_STATE_HEXSTRING
-} cairo_word_wrap_state_t;
-
-
-typedef struct _word_wrap_stream {
-    cairo_output_stream_t base;
-    cairo_output_stream_t *output;
-    int max_column;
-    int column;
-    cairo_word_wrap_state_t state;
-    cairo_bool_t in_escape;
-    int		 escape_digits;
-} word_wrap_stream_t;
-
-
-
-/* Emit word bytes up to the next delimiter character */
-static int
-_word_wrap_stream_count_word_up_to (word_wrap_stream_t *stream,
-				   const unsigned char *data, int length)
+void
+_cairo_pdf_operators_save (cairo_pdf_operators_t *pdf_operators)
 {
-    const unsigned char *s = data;
-    int count = 0;
-
-    while (length--) {
-	if (_cairo_isspace (*s) || *s == '<' || *s == '(') {
-	    stream->state = WRAP_STATE_DELIMITER;
-	    break;
-	}
-
-	count++;
-	stream->column++;
-	s++;
-    }
-
-    if (count)
-	_cairo_output_stream_write (stream->output, data, count);
-
-    return count;
+    pdf_operators->saved_line_style = pdf_operators->line_style;
 }
 
-
-/* Emit hexstring bytes up to either the end of the ASCII hexstring or the number
- * of columns remaining.
- */
-static int
-_word_wrap_stream_count_hexstring_up_to (word_wrap_stream_t *stream,
-					 const unsigned char *data, int length)
+void
+_cairo_pdf_operators_restore (cairo_pdf_operators_t *pdf_operators)
 {
-    const unsigned char *s = data;
-    int count = 0;
-    cairo_bool_t newline = FALSE;
-
-    while (length--) {
-	count++;
-	stream->column++;
-	if (*s == '>') {
-	    stream->state = WRAP_STATE_DELIMITER;
-	    break;
-	}
-
-	if (stream->column > stream->max_column) {
-	    newline = TRUE;
-	    break;
-	}
-	s++;
-    }
-
-    if (count)
-	_cairo_output_stream_write (stream->output, data, count);
-
-    if (newline) {
-	_cairo_output_stream_printf (stream->output, "\n");
-	stream->column = 0;
-    }
-
-    return count;
+    pdf_operators->line_style = pdf_operators->saved_line_style;
 }
 
-/* Count up to either the end of the string or the number of columns
- * remaining.
+/* Content stream operators are written directly to the output stream
+ * (which is usually a deflate stream) rather than through a filter
+ * that scans every byte for somewhere to break the line. Each token
+ * is formatted into a buffer first so that its length is known, and a
+ * line break is inserted before any token that would take the line
+ * past PDF_MAX_COLUMN. A single token longer than PDF_MAX_COLUMN is
+ * not broken up.
  */
-static int
-_word_wrap_stream_count_string_up_to (word_wrap_stream_t *stream,
-				      const unsigned char *data, int length)
-{
-    const unsigned char *s = data;
-    int count = 0;
-    cairo_bool_t newline = FALSE;
-
-    while (length--) {
-	count++;
-	stream->column++;
-	if (!stream->in_escape) {
-	    if (*s == ')') {
-		stream->state = WRAP_STATE_DELIMITER;
-		break;
-	    }
-	    if (*s == '\\') {
-		stream->in_escape = TRUE;
-		stream->escape_digits = 0;
-	    } else if (stream->column > stream->max_column) {
-		newline = TRUE;
-		break;
-	    }
-	} else {
-	    if (!_cairo_isdigit(*s) || ++stream->escape_digits == 3)
-		stream->in_escape = FALSE;
-	}
-	s++;
-    }
+#define PDF_MAX_COLUMN 72
 
-    if (count)
-	_cairo_output_stream_write (stream->output, data, count);
+/* Large enough for any number formatted by _cairo_pdf_format_number() */
+#define PDF_NUMBER_BUFFER_SIZE 32
 
-    if (newline) {
-	_cairo_output_stream_printf (stream->output, "\\\n");
-	stream->column = 0;
-    }
+/* Numbers smaller than this are formatted without the C library. */
+#define PDF_FAST_NUMBER_LIMIT 1e9
 
-    return count;
-}
-
-static cairo_status_t
-_word_wrap_stream_write (cairo_output_stream_t  *base,
-			 const unsigned char	*data,
-			 unsigned int		 length)
+/* Format @d into @buffer with at most three decimal places and
+ * trailing zeros removed, as done by the %g conversion of
+ * _cairo_output_stream_printf(), and return the length. */
+static int
+_cairo_pdf_format_number (char *buffer, double d)
 {
-    word_wrap_stream_t *stream = (word_wrap_stream_t *) base;
-    int count;
-
-    while (length) {
-	switch (stream->state) {
-	case WRAP_STATE_WORD:
-	    count = _word_wrap_stream_count_word_up_to (stream, data, length);
-	    break;
-	case WRAP_STATE_HEXSTRING:
-	    count = _word_wrap_stream_count_hexstring_up_to (stream, data, length);
-	    break;
-	case WRAP_STATE_STRING:
-	    count = _word_wrap_stream_count_string_up_to (stream, data, length);
-	    break;
-	case WRAP_STATE_DELIMITER:
-	    count = 1;
-	    stream->column++;
-	    if (*data == '\n' || stream->column >= stream->max_column) {
-		_cairo_output_stream_printf (stream->output, "\n");
-		stream->column = 0;
-	    } else if (*data == '<') {
-		stream->state = WRAP_STATE_HEXSTRING;
-	    } else if (*data == '(') {
-		stream->state = WRAP_STATE_STRING;
-	    } else if (!_cairo_isspace (*data)) {
-		stream->state = WRAP_STATE_WORD;
-	    }
-	    if (*data != '\n')
-		_cairo_output_stream_write (stream->output, data, 1);
-	    break;
+    char digits[PDF_NUMBER_BUFFER_SIZE];
+    uint64_t v, integer;
+    double t, r;
+    int frac, n, len, i;
+
+    if (! (fabs (d) < PDF_FAST_NUMBER_LIMIT)) {
+	_cairo_dtostr (buffer, PDF_NUMBER_BUFFER_SIZE, d, TRUE);
+	return strlen (buffer);
+    }
 
-	default:
-	    ASSERT_NOT_REACHED;
-	    count = length;
-	    break;
+    /* Round half to even like printf(), as coordinates converted
+     * from cairo_fixed_t often lie exactly half way. */
+    t = fabs (d) * 1000.;
+    v = (uint64_t) t;
+    r = t - v;
+    if (r > .5 || (r == .5 && (v & 1)))
+	v++;
+    integer = v / 1000;
+    frac = v % 1000;
+
+    len = 0;
+    if (d < 0 && v != 0)
+	buffer[len++] = '-';
+
+    n = 0;
+    do {
+	digits[n++] = '0' + integer % 10;
+	integer /= 10;
+    } while (integer);
+    while (n)
+	buffer[len++] = digits[--n];
+
+    if (frac) {
+	buffer[len++] = '.';
+	for (i = 100; frac; i /= 10) {
+	    buffer[len++] = '0' + frac / i;
+	    frac %= i;
 	}
-	data += count;
-	length -= count;
     }
 
-    return _cairo_output_stream_get_status (stream->output);
+    buffer[len] = '\0';
+    return len;
 }
 
+typedef struct _pdf_path_info {
+    cairo_output_stream_t   *output;
+    cairo_matrix_t	    *path_transform;
+    cairo_line_cap_t         line_cap;
+    cairo_point_t            last_move_to_point;
+    cairo_bool_t             has_sub_path;
+    int			     column;
+} pdf_path_info_t;
+
+/* Write a path construction operator preceded by its operands. */
 static cairo_status_t
-_word_wrap_stream_close (cairo_output_stream_t *base)
+_cairo_pdf_path_emit_operator (pdf_path_info_t *info,
+			       const double    *operands,
+			       int		num_operands,
+			       const char      *operator)
 {
-    word_wrap_stream_t *stream = (word_wrap_stream_t *) base;
+    char buffer[6 * (PDF_NUMBER_BUFFER_SIZE + 1) + 3];
+    int len = 0;
+    int i;
 
-    return _cairo_output_stream_get_status (stream->output);
-}
+    assert (num_operands <= 6);
 
-static cairo_output_stream_t *
-_word_wrap_stream_create (cairo_output_stream_t *output, int max_column)
-{
-    word_wrap_stream_t *stream;
-
-    if (output->status)
-	return _cairo_output_stream_create_in_error (output->status);
+    for (i = 0; i < num_operands; i++) {
+	len += _cairo_pdf_format_number (buffer + len, operands[i]);
+	buffer[len++] = ' ';
+    }
+    while (*operator)
+	buffer[len++] = *operator++;
+    buffer[len++] = ' ';
 
-    stream = malloc (sizeof (word_wrap_stream_t));
-    if (unlikely (stream == NULL)) {
-	_cairo_error_throw (CAIRO_STATUS_NO_MEMORY);
-	return (cairo_output_stream_t *) &_cairo_output_stream_nil;
+    if (info->column > 0 && info->column + len > PDF_MAX_COLUMN) {
+	_cairo_output_stream_write (info->output, "\n", 1);
+	info->column = 0;
     }
+    _cairo_output_stream_write (info->output, buffer, len);
+    info->column += len;
 
-    _cairo_output_stream_init (&stream->base,
-			       _word_wrap_stream_write,
-			       NULL,
-			       _word_wrap_stream_close);
-    stream->output = output;
-    stream->max_column = max_column;
-    stream->column = 0;
-    stream->state = WRAP_STATE_DELIMITER;
-    stream->in_escape = FALSE;
-    stream->escape_digits = 0;
-
-    return &stream->base;
+    return _cairo_output_stream_get_status (info->output);
 }
 
-typedef struct _pdf_path_info {
-    cairo_output_stream_t   *output;
-    cairo_matrix_t	    *path_transform;
-    cairo_line_cap_t         line_cap;
-    cairo_point_t            last_move_to_point;
-    cairo_bool_t             has_sub_path;
-} pdf_path_info_t;
-
 static cairo_status_t
 _cairo_pdf_path_move_to (void *closure,
 			 const cairo_point_t *point)
@@ -391,13 +304,15 @@ _cairo_pdf_path_move_to (void *closure,
     double x = _cairo_fixed_to_double (point->x);
     double y = _cairo_fixed_to_double (point->y);
 
+    double operands[2];
+
     info->last_move_to_point = *point;
     info->has_sub_path = FALSE;
     cairo_matrix_transform_point (info->path_transform, &x, &y);
-    _cairo_output_stream_printf (info->output,
-				 "%g %g m ", x, y);
+    operands[0] = x;
+    operands[1] = y;
 
-    return _cairo_output_stream_get_status (info->output);
+    return _cairo_pdf_path_emit_operator (info, operands, 2, "m");
 }
 
 static cairo_status_t
@@ -407,6 +322,7 @@ _cairo_pdf_path_line_to (void *closure,
     pdf_path_info_t *info = closure;
     double x = _cairo_fixed_to_double (point->x);
     double y = _cairo_fixed_to_double (point->y);
+    double operands[2];
 
     if (info->line_cap != CAIRO_LINE_CAP_ROUND &&
 	! info->has_sub_path &&
@@ -418,10 +334,10 @@ _cairo_pdf_path_line_to (void *closure,
 
     info->has_sub_path = TRUE;
     cairo_matrix_transform_point (info->path_transform, &x, &y);
-    _cairo_output_stream_printf (info->output,
-				 "%g %g l ", x, y);
+    operands[0] = x;
+    operands[1] = y;
 
-    return _cairo_output_stream_get_status (info->output);
+    return _cairo_pdf_path_emit_operator (info, operands, 2, "l");
 }
 
 static cairo_status_t
@@ -437,15 +353,20 @@ _cairo_pdf_path_curve_to (void          *closure,
     double cy = _cairo_fixed_to_double (c->y);
     double dx = _cairo_fixed_to_double (d->x);
     double dy = _cairo_fixed_to_double (d->y);
+    double operands[6];
 
     info->has_sub_path = TRUE;
     cairo_matrix_transform_point (info->path_transform, &bx, &by);
     cairo_matrix_transform_point (info->path_transform, &cx, &cy);
     cairo_matrix_transform_point (info->path_transform, &dx, &dy);
-    _cairo_output_stream_printf (info->output,
-				 "%g %g %g %g %g %g c ",
-				 bx, by, cx, cy, dx, dy);
-    return _cairo_output_stream_get_status (info->output);
+    operands[0] = bx;
+    operands[1] = by;
+    operands[2] = cx;
+    operands[3] = cy;
+    operands[4] = dx;
+    operands[5] = dy;
+
+    return _cairo_pdf_path_emit_operator (info, operands, 6, "c");
 }
 
 static cairo_status_t
@@ -459,8 +380,8 @@ _cairo_pdf_path_close_path (void *closure)
 	return CAIRO_STATUS_SUCCESS;
     }
 
-    _cairo_output_stream_printf (info->output,
-				 "h\n");
+    _cairo_output_stream_write (info->output, "h\n", 2);
+    info->column = 0;
 
     return _cairo_output_stream_get_status (info->output);
 }
@@ -472,14 +393,17 @@ _cairo_pdf_path_rectangle (pdf_path_info_t *info, cairo_box_t *box)
     double y1 = _cairo_fixed_to_double (box->p1.y);
     double x2 = _cairo_fixed_to_double (box->p2.x);
     double y2 = _cairo_fixed_to_double (box->p2.y);
+    double operands[4];
 
     cairo_matrix_transform_point (info->path_transform, &x1, &y1);
     cairo_matrix_transform_point (info->path_transform, &x2, &y2);
-    _cairo_output_stream_printf (info->output,
-				 "%g %g %g %g re ",
-				 x1, y1, x2 - x1, y2 - y1);
+    operands[0] = x1;
+    operands[1] = y1;
+    operands[2] = x2 - x1;
+    operands[3] = y2 - y1;
 
-    return _cairo_output_stream_get_status (info->output);
+
+    return _cairo_pdf_path_emit_operator (info, operands, 4, "re");
 }
 
 /* The line cap value is needed to workaround the fact that PostScript
@@ -497,19 +421,14 @@ _cairo_pdf_operators_emit_path (cairo_pdf_operators_t	*pdf_operators,
 				cairo_matrix_t          *path_transform,
 				cairo_line_cap_t         line_cap)
 {
-    cairo_output_stream_t *word_wrap;
-    cairo_status_t status, status2;
+    cairo_status_t status;
     pdf_path_info_t info;
     cairo_box_t box;
 
-    word_wrap = _word_wrap_stream_create (pdf_operators->stream, 72);
-    status = _cairo_output_stream_get_status (word_wrap);
-    if (unlikely (status))
-	return _cairo_output_stream_destroy (word_wrap);
-
-    info.output = word_wrap;
+    info.output = pdf_operators->stream;
     info.path_transform = path_transform;
     info.line_cap = line_cap;
+    info.column = 0;
     if (_cairo_path_fixed_is_rectangle (path, &box)) {
 	status = _cairo_pdf_path_rectangle (&info, &box);
     } else {
@@ -521,10 +440,6 @@ _cairo_pdf_operators_emit_path (cairo_pdf_operators_t	*pdf_operators,
 					      &info);
     }
 
-    status2 = _cairo_output_stream_destroy (word_wrap);
-    if (status == CAIRO_STATUS_SUCCESS)
-	status = status2;
-
     return status;
 }
 
@@ -536,11 +451,9 @@ _cairo_pdf_operators_clip (cairo_pdf_operators_t	*pdf_operators,
     const char *pdf_operator;
     cairo_status_t status;
 
-    if (pdf_operators->in_text_object) {
-	status = _cairo_pdf_operators_end_text (pdf_operators);
-	if (unlikely (status))
-	    return status;
-    }
+    status = _cairo_pdf_operators_flush (pdf_operators);
+    if (unlikely (status))
+	return status;
 
     if (! path->has_current_point) {
 	/* construct an empty path */
@@ -609,10 +522,15 @@ _cairo_pdf_operators_emit_stroke_style (cairo_pdf_operators_t		*pdf_operators,
 					const cairo_stroke_style_t	*style,
 					double				 scale)
 {
+    cairo_pdf_line_style_t *line_style = &pdf_operators->line_style;
     double *dash = style->dash;
     int num_dashes = style->num_dashes;
     double dash_offset = style->dash_offset;
     double line_width = style->line_width * scale;
+    cairo_bool_t has_line_style, emit_line_width, emit_line_cap;
+    cairo_bool_t emit_line_join, emit_miter_limit, emit_dashes;
+    cairo_status_t status;
+    int d;
 
     /* PostScript has "special needs" when it comes to zero-length
      * dash segments with butt caps. It apparently (at least
@@ -687,52 +605,89 @@ _cairo_pdf_operators_emit_stroke_style (cairo_pdf_operators_t		*pdf_operators,
 	}
     }
 
-    if (!pdf_operators->has_line_style || pdf_operators->line_width != line_width) {
+    has_line_style = line_style->has_line_style;
+    emit_line_width = !has_line_style || line_style->line_width != line_width;
+    emit_line_cap = !has_line_style || line_style->line_cap != style->line_cap;
+    emit_line_join = !has_line_style || line_style->line_join != style->line_join;
+    emit_miter_limit = !has_line_style || line_style->miter_limit != style->miter_limit;
+    if (num_dashes) {
+	emit_dashes = !has_line_style ||
+	              !line_style->has_dashes ||
+	              line_style->num_dashes != num_dashes ||
+	              line_style->dash_offset != dash_offset * scale;
+	for (d = 0; d < num_dashes && !emit_dashes; d++)
+	    emit_dashes = line_style->dash[d] != dash[d] * scale;
+    } else {
+	emit_dashes = !has_line_style || line_style->has_dashes;
+    }
+
+    /* A stroke still waiting to be painted must be painted with the
+     * style it was emitted with. */
+    if (pdf_operators->in_stroke &&
+	(emit_line_width || emit_line_cap || emit_line_join ||
+	 emit_miter_limit || emit_dashes))
+    {
+	status = _cairo_pdf_operators_end_stroke (pdf_operators);
+	if (unlikely (status))
+	    goto BAIL;
+    }
+
+    if (emit_line_width) {
 	_cairo_output_stream_printf (pdf_operators->stream,
 				     "%f w\n",
 				     line_width);
-	pdf_operators->line_width = line_width;
+	line_style->line_width = line_width;
     }
 
-    if (!pdf_operators->has_line_style || pdf_operators->line_cap != style->line_cap) {
+    if (emit_line_cap) {
 	_cairo_output_stream_printf (pdf_operators->stream,
 				     "%d J\n",
 				     _cairo_pdf_line_cap (style->line_cap));
-	pdf_operators->line_cap = style->line_cap;
+	line_style->line_cap = style->line_cap;
     }
 
-    if (!pdf_operators->has_line_style || pdf_operators->line_join != style->line_join) {
+    if (emit_line_join) {
 	_cairo_output_stream_printf (pdf_operators->stream,
 				     "%d j\n",
 				     _cairo_pdf_line_join (style->line_join));
-	pdf_operators->line_join = style->line_join;
+	line_style->line_join = style->line_join;
     }
 
-    if (num_dashes) {
-	int d;
-
+    if (emit_dashes && num_dashes) {
 	_cairo_output_stream_printf (pdf_operators->stream, "[");
 	for (d = 0; d < num_dashes; d++)
 	    _cairo_output_stream_printf (pdf_operators->stream, " %f", dash[d] * scale);
 	_cairo_output_stream_printf (pdf_operators->stream, "] %f d\n",
 				     dash_offset * scale);
-	pdf_operators->has_dashes = TRUE;
-    } else if (!pdf_operators->has_line_style || pdf_operators->has_dashes) {
+	line_style->has_dashes = TRUE;
+	if (num_dashes <= PDF_DASH_STATE_SIZE) {
+	    line_style->num_dashes = num_dashes;
+	    for (d = 0; d < num_dashes; d++)
+		line_style->dash[d] = dash[d] * scale;
+	    line_style->dash_offset = dash_offset * scale;
+	} else {
+	    line_style->num_dashes = -1;
+	}
+    } else if (emit_dashes) {
 	_cairo_output_stream_printf (pdf_operators->stream, "[] 0.0 d\n");
-	pdf_operators->has_dashes = FALSE;
+	line_style->has_dashes = FALSE;
     }
-    if (dash != style->dash)
-        free (dash);
 
-    if (!pdf_operators->has_line_style || pdf_operators->miter_limit != style->miter_limit) {
+    if (emit_miter_limit) {
 	_cairo_output_stream_printf (pdf_operators->stream,
 				     "%f M ",
 				     style->miter_limit < 1.0 ? 1.0 : style->miter_limit);
-	pdf_operators->miter_limit = style->miter_limit;
+	line_style->miter_limit = style->miter_limit;
     }
-    pdf_operators->has_line_style = TRUE;
+    line_style->has_line_style = TRUE;
 
-    return _cairo_output_stream_get_status (pdf_operators->stream);
+    status = _cairo_output_stream_get_status (pdf_operators->stream);
+
+BAIL:
+    if (dash != style->dash)
+        free (dash);
+
+    return status;
 }
 
 /* Scale the matrix so the largest absolute value of the non
@@ -761,6 +716,15 @@ _cairo_matrix_factor_out_scale (cairo_matrix_t *m, double *scale)
     cairo_matrix_scale (m, s, s);
 }
 
+static cairo_status_t
+_cairo_pdf_operators_end_stroke (cairo_pdf_operators_t *pdf_operators)
+{
+    _cairo_output_stream_printf (pdf_operators->stream, "S\n");
+    pdf_operators->in_stroke = FALSE;
+
+    return _cairo_output_stream_get_status (pdf_operators->stream);
+}
+
 static cairo_int_status_t
 _cairo_pdf_operators_emit_stroke (cairo_pdf_operators_t		*pdf_operators,
 				  const cairo_path_fixed_t	*path,
@@ -772,6 +736,7 @@ _cairo_pdf_operators_emit_stroke (cairo_pdf_operators_t		*pdf_operators,
     cairo_int_status_t status;
     cairo_matrix_t m, path_transform;
     cairo_bool_t has_ctm = TRUE;
+    cairo_bool_t merge;
     double scale = 1.0;
 
     if (pdf_operators->in_text_object) {
@@ -821,6 +786,14 @@ _cairo_pdf_operators_emit_stroke (cairo_pdf_operators_t		*pdf_operators,
 	cairo_matrix_multiply (&m, &m, &pdf_operators->cairo_to_pdf);
     }
 
+    /* Only strokes without a pen transformation can share a path. */
+    merge = pdf_operators->merge_strokes && ! has_ctm && strcmp (pdf_operator, "S") == 0;
+    if (pdf_operators->in_stroke && ! merge) {
+	status = _cairo_pdf_operators_end_stroke (pdf_operators);
+	if (unlikely (status))
+	    return status;
+    }
+
     status = _cairo_pdf_operators_emit_stroke_style (pdf_operators, style, scale);
     if (status == CAIRO_INT_STATUS_NOTHING_TO_DO)
 	return CAIRO_STATUS_SUCCESS;
@@ -834,6 +807,9 @@ _cairo_pdf_operators_emit_stroke (cairo_pdf_operators_t		*pdf_operators,
 				     m.x0, m.y0);
     } else {
 	path_transform = pdf_operators->cairo_to_pdf;
+	/* Start each merged path on a new line. */
+	if (pdf_operators->in_stroke)
+	    _cairo_output_stream_write (pdf_operators->stream, "\n", 1);
     }
 
     status = _cairo_pdf_operators_emit_path (pdf_operators,
@@ -843,6 +819,13 @@ _cairo_pdf_operators_emit_stroke (cairo_pdf_operators_t		*pdf_operators,
     if (unlikely (status))
 	return status;
 
+    if (merge) {
+	/* Leave the path unpainted in case the next stroke can be
+	 * appended to it. */
+	pdf_operators->in_stroke = TRUE;
+	return _cairo_output_stream_get_status (pdf_operators->stream);
+    }
+
     _cairo_output_stream_printf (pdf_operators->stream, "%s", pdf_operator);
     if (has_ctm)
 	_cairo_output_stream_printf (pdf_operators->stream, " Q");
@@ -875,11 +858,9 @@ _cairo_pdf_operators_fill (cairo_pdf_operators_t	*pdf_operators,
     const char *pdf_operator;
     cairo_status_t status;
 
-    if (pdf_operators->in_text_object) {
-	status = _cairo_pdf_operators_end_text (pdf_operators);
-	if (unlikely (status))
-	    return status;
-    }
+    status = _cairo_pdf_operators_flush (pdf_operators);
+    if (unlikely (status))
+	return status;
 
     status = _cairo_pdf_operators_emit_path (pdf_operators,
 					     path,
@@ -935,24 +916,55 @@ _cairo_pdf_operators_fill_stroke (cairo_pdf_operators_t		*pdf_operators,
 					     operator);
 }
 
+/* Write a token that is part of a string of glyphs, breaking the line
+ * first if the token would not fit. Hex strings ignore white space and
+ * literal strings are continued on the next line with a backslash. */
+static void
+_cairo_pdf_operators_emit_string_token (cairo_pdf_operators_t *pdf_operators,
+					const char	      *token,
+					int		       len,
+					int		      *column)
+{
+    if (*column > 0 && *column + len > PDF_MAX_COLUMN) {
+	if (pdf_operators->is_latin)
+	    _cairo_output_stream_write (pdf_operators->stream, "\\\n", 2);
+	else
+	    _cairo_output_stream_write (pdf_operators->stream, "\n", 1);
+	*column = 0;
+    }
+
+    _cairo_output_stream_write (pdf_operators->stream, token, len);
+    *column += len;
+}
+
 static void
 _cairo_pdf_operators_emit_glyph_index (cairo_pdf_operators_t *pdf_operators,
-				       cairo_output_stream_t *stream,
-				       unsigned int 	      glyph)
+				       unsigned int 	      glyph,
+				       int		     *column)
 {
+    static const char hex_digits[] = "0123456789abcdef";
+    char buffer[8];
+    int len = 0;
+    int i;
+
     if (pdf_operators->is_latin) {
-	if (glyph == '(' || glyph == ')' || glyph == '\\')
-	    _cairo_output_stream_printf (stream, "\\%c", glyph);
-	else if (glyph >= 0x20 && glyph <= 0x7e)
-	    _cairo_output_stream_printf (stream, "%c", glyph);
-	else
-	    _cairo_output_stream_printf (stream, "\\%03o", glyph);
+	if (glyph == '(' || glyph == ')' || glyph == '\\') {
+	    buffer[len++] = '\\';
+	    buffer[len++] = glyph;
+	} else if (glyph >= 0x20 && glyph <= 0x7e) {
+	    buffer[len++] = glyph;
+	} else {
+	    buffer[len++] = '\\';
+	    buffer[len++] = '0' + ((glyph >> 6) & 7);
+	    buffer[len++] = '0' + ((glyph >> 3) & 7);
+	    buffer[len++] = '0' + (glyph & 7);
+	}
     } else {
-	_cairo_output_stream_printf (stream,
-				     "%0*x",
-				     pdf_operators->hex_width,
-				     glyph);
+	for (i = pdf_operators->hex_width - 1; i >= 0; i--)
+	    buffer[len++] = hex_digits[(glyph >> (4 * i)) & 0xf];
     }
+
+    _cairo_pdf_operators_emit_string_token (pdf_operators, buffer, len, column);
 }
 
 #define GLYPH_POSITION_TOLERANCE 0.001
@@ -960,21 +972,23 @@ _cairo_pdf_operators_emit_glyph_index (cairo_pdf_operators_t *pdf_operators,
 /* Emit the string of glyphs using the 'Tj' operator. This requires
  * that the glyphs are positioned at their natural glyph advances. */
 static cairo_status_t
-_cairo_pdf_operators_emit_glyph_string (cairo_pdf_operators_t   *pdf_operators,
-					cairo_output_stream_t  	*stream)
+_cairo_pdf_operators_emit_glyph_string (cairo_pdf_operators_t   *pdf_operators)
 {
+    int column = 1;
     int i;
 
-    _cairo_output_stream_printf (stream, "%s", pdf_operators->is_latin ? "(" : "<");
+    _cairo_output_stream_write (pdf_operators->stream,
+				pdf_operators->is_latin ? "(" : "<", 1);
     for (i = 0; i < pdf_operators->num_glyphs; i++) {
 	_cairo_pdf_operators_emit_glyph_index (pdf_operators,
-					       stream,
-					       pdf_operators->glyphs[i].glyph_index);
+					       pdf_operators->glyphs[i].glyph_index,
+					       &column);
 	pdf_operators->cur_x += pdf_operators->glyphs[i].x_advance;
     }
-    _cairo_output_stream_printf (stream, "%sTj\n", pdf_operators->is_latin ? ")" : ">");
+    _cairo_output_stream_printf (pdf_operators->stream,
+				 "%sTj\n", pdf_operators->is_latin ? ")" : ">");
 
-    return _cairo_output_stream_get_status (stream);
+    return _cairo_output_stream_get_status (pdf_operators->stream);
 }
 
 /* Emit the string of glyphs using the 'TJ' operator.
@@ -987,12 +1001,14 @@ _cairo_pdf_operators_emit_glyph_string (cairo_pdf_operators_t   *pdf_operators,
  */
 static cairo_status_t
 _cairo_pdf_operators_emit_glyph_string_with_positioning (
-    cairo_pdf_operators_t   *pdf_operators,
-    cairo_output_stream_t   *stream)
+    cairo_pdf_operators_t   *pdf_operators)
 {
-    int i;
+    char buffer[32];
+    int column = 2;
+    int i, len;
 
-    _cairo_output_stream_printf (stream, "[%s", pdf_operators->is_latin ? "(" : "<");
+    _cairo_output_stream_write (pdf_operators->stream,
+				pdf_operators->is_latin ? "[(" : "[<", 2);
     for (i = 0; i < pdf_operators->num_glyphs; i++) {
 	if (pdf_operators->glyphs[i].x_position != pdf_operators->cur_x)
 	{
@@ -1011,14 +1027,20 @@ _cairo_pdf_operators_emit_glyph_string_with_positioning (
 	    if (abs(rounded_delta) < 3)
 		rounded_delta = 0;
 	    if (rounded_delta != 0) {
-		if (pdf_operators->is_latin) {
-		    _cairo_output_stream_printf (stream,
-						 ")%d(",
-						 rounded_delta);
+		/* The adjustment is outside of the strings, so the
+		 * line may always be broken before it. */
+		len = snprintf (buffer, sizeof (buffer),
+				pdf_operators->is_latin ? ")%d(" : ">%d<",
+				rounded_delta);
+		if (column + len - 1 > PDF_MAX_COLUMN) {
+		    _cairo_output_stream_write (pdf_operators->stream, buffer, 1);
+		    _cairo_output_stream_write (pdf_operators->stream, "\n", 1);
+		    _cairo_output_stream_write (pdf_operators->stream,
+						buffer + 1, len - 1);
+		    column = len - 1;
 		} else {
-		    _cairo_output_stream_printf (stream,
-						 ">%d<",
-						 rounded_delta);
+		    _cairo_output_stream_write (pdf_operators->stream, buffer, len);
+		    column += len;
 		}
 	    }
 
@@ -1030,31 +1052,26 @@ _cairo_pdf_operators_emit_glyph_string_with_positioning (
 	}
 
 	_cairo_pdf_operators_emit_glyph_index (pdf_operators,
-					       stream,
-					       pdf_operators->glyphs[i].glyph_index);
+					       pdf_operators->glyphs[i].glyph_index,
+					       &column);
 	pdf_operators->cur_x += pdf_operators->glyphs[i].x_advance;
     }
-    _cairo_output_stream_printf (stream, "%s]TJ\n", pdf_operators->is_latin ? ")" : ">");
+    _cairo_output_stream_printf (pdf_operators->stream,
+				 "%s]TJ\n", pdf_operators->is_latin ? ")" : ">");
 
-    return _cairo_output_stream_get_status (stream);
+    return _cairo_output_stream_get_status (pdf_operators->stream);
 }
 
 static cairo_status_t
 _cairo_pdf_operators_flush_glyphs (cairo_pdf_operators_t    *pdf_operators)
 {
-    cairo_output_stream_t *word_wrap_stream;
-    cairo_status_t status, status2;
+    cairo_status_t status;
     int i;
     double x;
 
     if (pdf_operators->num_glyphs == 0)
 	return CAIRO_STATUS_SUCCESS;
 
-    word_wrap_stream = _word_wrap_stream_create (pdf_operators->stream, 72);
-    status = _cairo_output_stream_get_status (word_wrap_stream);
-    if (unlikely (status))
-	return _cairo_output_stream_destroy (word_wrap_stream);
-
     /* Check if glyph advance used to position every glyph */
     x = pdf_operators->cur_x;
     for (i = 0; i < pdf_operators->num_glyphs; i++) {
@@ -1063,18 +1080,13 @@ _cairo_pdf_operators_flush_glyphs (cairo_pdf_operators_t    *pdf_operators)
 	x += pdf_operators->glyphs[i].x_advance;
     }
     if (i == pdf_operators->num_glyphs) {
-	status = _cairo_pdf_operators_emit_glyph_string (pdf_operators,
-							 word_wrap_stream);
+	status = _cairo_pdf_operators_emit_glyph_string (pdf_operators);
     } else {
-	status = _cairo_pdf_operators_emit_glyph_string_with_positioning (
-	    pdf_operators, word_wrap_stream);
+	status = _cairo_pdf_operators_emit_glyph_string_with_positioning (pdf_operators);
     }
 
     pdf_operators->num_glyphs = 0;
     pdf_operators->glyph_buf_x_pos = pdf_operators->cur_x;
-    status2 = _cairo_output_stream_destroy (word_wrap_stream);
-    if (status == CAIRO_STATUS_SUCCESS)
-	status = status2;
 
     return status;
 }
@@ -1222,6 +1234,14 @@ _cairo_pdf_operators_set_font_subset (cairo_pdf_operators_t             *pdf_ope
 static cairo_status_t
 _cairo_pdf_operators_begin_text (cairo_pdf_operators_t    *pdf_operators)
 {
+    if (pdf_operators->in_stroke) {
+	cairo_status_t status;
+
+	status = _cairo_pdf_operators_end_stroke (pdf_operators);
+	if (unlikely (status))
+	    return status;
+    }
+
     _cairo_output_stream_printf (pdf_operators->stream, "BT\n");
 
     pdf_operators->in_text_object = TRUE;
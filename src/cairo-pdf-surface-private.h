@@ -127,6 +127,37 @@ typedef struct _cairo_pdf_smask_group {
     cairo_scaled_font_t	 *scaled_font;
 } cairo_pdf_smask_group_t;
 
+/* A mask group that has been emitted, keyed by its content so that
+ * identical masking operations elsewhere in the document can reuse it
+ * with a translation. */
+typedef struct _cairo_pdf_mask_group_entry {
+    cairo_hash_entry_t base;
+    cairo_pattern_t *source; /* relative to the origin of the extents */
+    cairo_pattern_t *mask;   /* relative to the origin of the extents */
+    int width;
+    int height;
+    double x; /* top left corner of the extents in PDF coordinates */
+    double y;
+    cairo_pdf_resource_t group_res;
+    cairo_pdf_resource_t source_res;
+} cairo_pdf_mask_group_entry_t;
+
+/* The part of the PDF graphics state that is known to be in effect
+ * in the content stream being written. */
+typedef struct _cairo_pdf_gstate {
+    cairo_operator_t operator;
+    cairo_bool_t has_fill_color;
+    cairo_bool_t has_stroke_color;
+    cairo_bool_t has_alpha;
+    double fill_red;
+    double fill_green;
+    double fill_blue;
+    double stroke_red;
+    double stroke_green;
+    double stroke_blue;
+    double alpha;
+} cairo_pdf_gstate_t;
+
 typedef struct _cairo_pdf_surface cairo_pdf_surface_t;
 
 struct _cairo_pdf_surface {
@@ -148,6 +179,7 @@ struct _cairo_pdf_surface {
     cairo_array_t page_surfaces;
     cairo_hash_table_t *all_surfaces;
     cairo_array_t smask_groups;
+    cairo_hash_table_t *all_mask_groups;
     cairo_array_t knockout_group;
 
     cairo_scaled_font_subsets_t *font_subsets;
@@ -192,13 +224,8 @@ struct _cairo_pdf_surface {
 
     cairo_bool_t force_fallbacks;
 
-    cairo_operator_t current_operator;
-    cairo_bool_t current_pattern_is_solid_color;
-    cairo_bool_t current_color_is_stroke;
-    double current_color_red;
-    double current_color_green;
-    double current_color_blue;
-    double current_color_alpha;
+    cairo_pdf_gstate_t gstate;
+    cairo_pdf_gstate_t saved_gstate;
 
     cairo_surface_t *paginated_surface;
 };
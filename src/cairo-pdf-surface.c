@@ -66,6 +66,15 @@
 #include <time.h>
 #include <zlib.h>
 
+#if CAIRO_HAS_FT_FONT
+#include "cairo-ft-private.h"
+#endif
+
+#if CAIRO_PDF_USE_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 /* Issues:
  *
  * - We embed an image in the stream each time it's composited.  We
@@ -163,6 +172,7 @@ static const char *_cairo_pdf_supported_mime_types[] =
 {
     CAIRO_MIME_TYPE_JPEG,
     CAIRO_MIME_TYPE_JP2,
+    CAIRO_MIME_TYPE_PNG,
     CAIRO_MIME_TYPE_UNIQUE_ID,
     NULL
 };
@@ -239,6 +249,9 @@ _cairo_pdf_surface_emit_font_subsets (cairo_pdf_surface_t *surface);
 static cairo_bool_t
 _cairo_pdf_source_surface_equal (const void *key_a, const void *key_b);
 
+static cairo_bool_t
+_cairo_pdf_mask_group_equal (const void *key_a, const void *key_b);
+
 static const cairo_surface_backend_t cairo_pdf_surface_backend;
 static const cairo_paginated_surface_backend_t cairo_pdf_surface_paginated_backend;
 
@@ -285,6 +298,19 @@ _cairo_pdf_surface_set_size_internal (cairo_pdf_surface_t *surface,
 						  &surface->cairo_to_pdf);
 }
 
+/* Forget the graphics state set in the current content stream, eg
+ * when starting a new stream or restoring the state saved when the
+ * stream was opened. */
+static void
+_cairo_pdf_surface_reset_gstate (cairo_pdf_surface_t *surface)
+{
+    surface->gstate.operator = CAIRO_OPERATOR_OVER;
+    surface->gstate.has_fill_color = FALSE;
+    surface->gstate.has_stroke_color = FALSE;
+    surface->gstate.has_alpha = FALSE;
+    _cairo_pdf_operators_reset (&surface->pdf_operators);
+}
+
 static cairo_bool_t
 _path_covers_bbox (cairo_pdf_surface_t *surface,
 		   cairo_path_fixed_t *path)
@@ -317,8 +343,8 @@ _cairo_pdf_surface_clipper_intersect_clip_path (cairo_surface_clipper_t *clipper
     if (path == NULL) {
 	_cairo_output_stream_printf (surface->output, "Q q\n");
 
-	surface->current_pattern_is_solid_color = FALSE;
-	_cairo_pdf_operators_reset (&surface->pdf_operators);
+	/* This also restores the blend mode. */
+	_cairo_pdf_surface_reset_gstate (surface);
 
 	return CAIRO_STATUS_SUCCESS;
     }
@@ -370,12 +396,18 @@ _cairo_pdf_surface_create_for_stream_internal (cairo_output_stream_t	*output,
 	goto BAIL0;
     }
 
+    surface->all_mask_groups = _cairo_hash_table_create (_cairo_pdf_mask_group_equal);
+    if (unlikely (surface->all_mask_groups == NULL)) {
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto BAIL1;
+    }
+
     _cairo_pdf_group_resources_init (&surface->resources);
 
     surface->font_subsets = _cairo_scaled_font_subsets_create_composite ();
     if (! surface->font_subsets) {
 	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
-	goto BAIL1;
+	goto BAIL2;
     }
 
     _cairo_scaled_font_subsets_enable_latin_subset (surface->font_subsets, TRUE);
@@ -384,7 +416,7 @@ _cairo_pdf_surface_create_for_stream_internal (cairo_output_stream_t	*output,
     surface->pages_resource = _cairo_pdf_surface_new_object (surface);
     if (surface->pages_resource.id == 0) {
 	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
-        goto BAIL2;
+        goto BAIL3;
     }
 
     surface->pdf_version = CAIRO_PDF_VERSION_1_5;
@@ -399,8 +431,6 @@ _cairo_pdf_surface_create_for_stream_internal (cairo_output_stream_t	*output,
 
     surface->force_fallbacks = FALSE;
     surface->select_pattern_gstate_saved = FALSE;
-    surface->current_pattern_is_solid_color = FALSE;
-    surface->current_operator = CAIRO_OPERATOR_OVER;
     surface->header_emitted = FALSE;
 
     _cairo_surface_clipper_init (&surface->clipper,
@@ -427,8 +457,10 @@ _cairo_pdf_surface_create_for_stream_internal (cairo_output_stream_t	*output,
 	return surface->paginated_surface;
     }
 
-BAIL2:
+BAIL3:
     _cairo_scaled_font_subsets_destroy (surface->font_subsets);
+BAIL2:
+    _cairo_hash_table_destroy (surface->all_mask_groups);
 BAIL1:
     _cairo_hash_table_destroy (surface->all_surfaces);
 BAIL0:
@@ -1087,6 +1119,147 @@ _cairo_pdf_surface_add_smask_group (cairo_pdf_surface_t     *surface,
     return _cairo_array_append (&surface->smask_groups, &group);
 }
 
+static cairo_bool_t
+_cairo_pdf_mask_group_equal (const void *key_a, const void *key_b)
+{
+    const cairo_pdf_mask_group_entry_t *a = key_a;
+    const cairo_pdf_mask_group_entry_t *b = key_b;
+
+    return a->width == b->width &&
+	   a->height == b->height &&
+	   _cairo_pattern_equal (a->source, b->source) &&
+	   _cairo_pattern_equal (a->mask, b->mask);
+}
+
+static cairo_status_t
+_cairo_pdf_mask_group_init_key (cairo_pdf_mask_group_entry_t *key,
+				const cairo_pattern_t	     *source,
+				const cairo_pattern_t	     *mask,
+				const cairo_rectangle_int_t  *extents)
+{
+    cairo_matrix_t m;
+    cairo_status_t status;
+
+    status = _cairo_pattern_create_copy (&key->source, source);
+    if (unlikely (status))
+	return status;
+
+    status = _cairo_pattern_create_copy (&key->mask, mask);
+    if (unlikely (status)) {
+	cairo_pattern_destroy (key->source);
+	return status;
+    }
+
+    /* Make the patterns relative to the extents so that the same mask
+     * operation at a different position has the same key. */
+    cairo_matrix_init_translate (&m, extents->x, extents->y);
+    _cairo_pattern_transform (key->source, &m);
+    _cairo_pattern_transform (key->mask, &m);
+
+    key->width = extents->width;
+    key->height = extents->height;
+    key->base.hash = _cairo_pattern_hash (key->source);
+    key->base.hash = key->base.hash * 31 + _cairo_pattern_hash (key->mask);
+    key->base.hash = key->base.hash * 31 + key->width;
+    key->base.hash = key->base.hash * 31 + key->height;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Add a group for masking @source with @mask over @extents, or find
+ * an identical group already emitted in the document. On return
+ * @offset_x and @offset_y are the translation, in PDF coordinates,
+ * to apply before drawing the group. */
+static cairo_status_t
+_cairo_pdf_surface_add_mask_group (cairo_pdf_surface_t		*surface,
+				   const cairo_pattern_t	*source,
+				   const cairo_pattern_t	*mask,
+				   const cairo_rectangle_int_t	*extents,
+				   cairo_pdf_resource_t		*group_res,
+				   cairo_pdf_resource_t		*source_res,
+				   double			*offset_x,
+				   double			*offset_y)
+{
+    cairo_pdf_mask_group_entry_t key, *entry;
+    cairo_pdf_smask_group_t *group;
+    cairo_status_t status;
+
+    status = _cairo_pdf_mask_group_init_key (&key, source, mask, extents);
+    if (unlikely (status))
+	return status;
+
+    entry = _cairo_hash_table_lookup (surface->all_mask_groups, &key.base);
+    if (entry != NULL) {
+	cairo_pattern_destroy (key.source);
+	cairo_pattern_destroy (key.mask);
+
+	*group_res = entry->group_res;
+	*source_res = entry->source_res;
+	*offset_x = extents->x - entry->x;
+	*offset_y = (surface->height - extents->y) - entry->y;
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    group = _cairo_pdf_surface_create_smask_group (surface, extents);
+    if (unlikely (group == NULL)) {
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto BAIL;
+    }
+
+    group->operation = PDF_MASK;
+    status = _cairo_pattern_create_copy (&group->source, source);
+    if (unlikely (status)) {
+	_cairo_pdf_smask_group_destroy (group);
+	goto BAIL;
+    }
+    status = _cairo_pattern_create_copy (&group->mask, mask);
+    if (unlikely (status)) {
+	_cairo_pdf_smask_group_destroy (group);
+	goto BAIL;
+    }
+    group->source_res = _cairo_pdf_surface_new_object (surface);
+    if (group->source_res.id == 0) {
+	_cairo_pdf_smask_group_destroy (group);
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto BAIL;
+    }
+
+    status = _cairo_pdf_surface_add_smask_group (surface, group);
+    if (unlikely (status)) {
+	_cairo_pdf_smask_group_destroy (group);
+	goto BAIL;
+    }
+
+    *group_res = group->group_res;
+    *source_res = group->source_res;
+    *offset_x = 0;
+    *offset_y = 0;
+
+    entry = malloc (sizeof (cairo_pdf_mask_group_entry_t));
+    if (unlikely (entry == NULL)) {
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto BAIL;
+    }
+
+    *entry = key;
+    entry->x = extents->x;
+    entry->y = surface->height - extents->y;
+    entry->group_res = group->group_res;
+    entry->source_res = group->source_res;
+    status = _cairo_hash_table_insert (surface->all_mask_groups, &entry->base);
+    if (unlikely (status)) {
+	free (entry);
+	goto BAIL;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+
+BAIL:
+    cairo_pattern_destroy (key.source);
+    cairo_pattern_destroy (key.mask);
+    return status;
+}
+
 static cairo_bool_t
 _cairo_pdf_source_surface_equal (const void *key_a, const void *key_b)
 {
@@ -1201,6 +1374,20 @@ _get_jpeg_image_info (cairo_surface_t		 *source,
     return _cairo_image_info_get_jpeg_info (info, *mime_data, *mime_data_length);
 }
 
+static cairo_int_status_t
+_get_png_image_info (cairo_surface_t		 *source,
+		     cairo_image_info_t		 *info,
+		     const unsigned char	**mime_data,
+		     unsigned long		 *mime_data_length)
+{
+    cairo_surface_get_mime_data (source, CAIRO_MIME_TYPE_PNG,
+				 mime_data, mime_data_length);
+    if (*mime_data == NULL)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    return _cairo_image_info_get_png_info (info, *mime_data, *mime_data_length);
+}
+
 static cairo_int_status_t
 _get_source_surface_size (cairo_surface_t         *source,
 			  int                     *width,
@@ -1268,6 +1455,15 @@ _get_source_surface_size (cairo_surface_t         *source,
 	return status;
     }
 
+    status = _get_png_image_info (source, &info, &mime_data, &mime_data_length);
+    if (status != CAIRO_INT_STATUS_UNSUPPORTED) {
+	*width = info.width;
+	*height = info.height;
+	extents->width = info.width;
+	extents->height = info.height;
+	return status;
+    }
+
     if (! _cairo_surface_get_extents (source, extents))
 	return CAIRO_INT_STATUS_UNSUPPORTED;
 
@@ -1611,9 +1807,7 @@ _cairo_pdf_surface_open_stream (cairo_pdf_surface_t	*surface,
     surface->pdf_stream.self = self;
     surface->pdf_stream.length = length;
     surface->pdf_stream.compressed = compressed;
-    surface->current_pattern_is_solid_color = FALSE;
-    surface->current_operator = CAIRO_OPERATOR_OVER;
-    _cairo_pdf_operators_reset (&surface->pdf_operators);
+    _cairo_pdf_surface_reset_gstate (surface);
 
     _cairo_output_stream_printf (surface->output,
 				 "%d 0 obj\n"
@@ -1753,9 +1947,7 @@ _cairo_pdf_surface_open_group (cairo_pdf_surface_t         *surface,
     assert (surface->group_stream.active == FALSE);
 
     surface->group_stream.active = TRUE;
-    surface->current_pattern_is_solid_color = FALSE;
-    surface->current_operator = CAIRO_OPERATOR_OVER;
-    _cairo_pdf_operators_reset (&surface->pdf_operators);
+    _cairo_pdf_surface_reset_gstate (surface);
 
     surface->group_stream.mem_stream = _cairo_memory_stream_create ();
 
@@ -1936,6 +2128,19 @@ _cairo_pdf_source_surface_entry_pluck (void *entry, void *closure)
     free (surface_entry);
 }
 
+static void
+_cairo_pdf_mask_group_entry_pluck (void *entry, void *closure)
+{
+    cairo_pdf_mask_group_entry_t *group_entry = entry;
+    cairo_hash_table_t *groups = closure;
+
+    _cairo_hash_table_remove (groups, &group_entry->base);
+    cairo_pattern_destroy (group_entry->source);
+    cairo_pattern_destroy (group_entry->mask);
+
+    free (group_entry);
+}
+
 static cairo_status_t
 _cairo_pdf_surface_finish (void *abstract_surface)
 {
@@ -2021,6 +2226,10 @@ _cairo_pdf_surface_finish (void *abstract_surface)
 			       _cairo_pdf_source_surface_entry_pluck,
 			       surface->all_surfaces);
     _cairo_hash_table_destroy (surface->all_surfaces);
+    _cairo_hash_table_foreach (surface->all_mask_groups,
+			       _cairo_pdf_mask_group_entry_pluck,
+			       surface->all_mask_groups);
+    _cairo_hash_table_destroy (surface->all_mask_groups);
     _cairo_array_fini (&surface->smask_groups);
     _cairo_array_fini (&surface->fonts);
     _cairo_array_fini (&surface->knockout_group);
@@ -2626,6 +2835,137 @@ _cairo_pdf_surface_emit_jpeg_image (cairo_pdf_surface_t   *surface,
     return status;
 }
 
+/* The compressed image data of a PNG is a zlib stream of scanlines,
+ * each prefixed with the PNG filter type. This is exactly what the
+ * FlateDecode filter with a PNG predictor expects, so opaque,
+ * non-interlaced PNG images can be embedded without decompressing
+ * and recompressing the pixels. */
+static cairo_int_status_t
+_cairo_pdf_surface_emit_png_image (cairo_pdf_surface_t   *surface,
+				   cairo_surface_t	 *source,
+				   cairo_pdf_resource_t   res,
+				   cairo_bool_t           interpolate)
+{
+    cairo_status_t status;
+    const unsigned char *mime_data;
+    unsigned long mime_data_length;
+    cairo_png_stream_info_t png;
+    cairo_pdf_resource_t palette_res;
+    char colorspace[64];
+
+    cairo_surface_get_mime_data (source, CAIRO_MIME_TYPE_PNG,
+				 &mime_data, &mime_data_length);
+    if (unlikely (source->status))
+	return source->status;
+    if (mime_data == NULL)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    status = _cairo_image_info_get_png_stream_info (&png, mime_data, mime_data_length);
+    if (unlikely (status))
+	return status;
+
+    /* Interlaced images cannot be described by a predictor and any
+     * form of transparency requires the decoded pixels for the SMask. */
+    if (png.interlaced || png.has_transparency)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    if (png.info.bits_per_component == 16 &&
+	surface->pdf_version < CAIRO_PDF_VERSION_1_5)
+    {
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+    }
+
+    switch (png.color_type) {
+    case 0: /* gray */
+	strcpy (colorspace, "/DeviceGray");
+	break;
+    case 2: /* rgb */
+	if (png.info.bits_per_component < 8)
+	    return CAIRO_INT_STATUS_UNSUPPORTED;
+	strcpy (colorspace, "/DeviceRGB");
+	break;
+    case 3: /* palette */
+	if (png.palette == NULL ||
+	    png.palette_length == 0 ||
+	    png.palette_length % 3 != 0 ||
+	    png.palette_length > 256 * 3)
+	{
+	    return CAIRO_INT_STATUS_UNSUPPORTED;
+	}
+
+	palette_res = _cairo_pdf_surface_new_object (surface);
+	if (palette_res.id == 0)
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+	_cairo_output_stream_printf (surface->output,
+				     "%d 0 obj\n"
+				     "<< /Length %lu >>\n"
+				     "stream\n",
+				     palette_res.id,
+				     png.palette_length);
+	_cairo_output_stream_write (surface->output,
+				    png.palette, png.palette_length);
+	_cairo_output_stream_printf (surface->output,
+				     "\nendstream\n"
+				     "endobj\n");
+
+	snprintf (colorspace, sizeof (colorspace),
+		  "[/Indexed /DeviceRGB %lu %d 0 R]",
+		  png.palette_length / 3 - 1, palette_res.id);
+	break;
+    default:
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+    }
+
+    status = _cairo_pdf_surface_open_stream (surface,
+					     &res,
+					     FALSE,
+					     "   /Type /XObject\n"
+					     "   /Subtype /Image\n"
+					     "   /Width %d\n"
+					     "   /Height %d\n"
+					     "   /ColorSpace %s\n"
+					     "   /Interpolate %s\n"
+					     "   /BitsPerComponent %d\n"
+					     "   /Filter /FlateDecode\n"
+					     "   /DecodeParms << /Predictor 15 /Colors %d /BitsPerComponent %d /Columns %d >>\n",
+					     png.info.width,
+					     png.info.height,
+					     colorspace,
+					     interpolate ? "true" : "false",
+					     png.info.bits_per_component,
+					     png.info.num_components,
+					     png.info.bits_per_component,
+					     png.info.width);
+    if (unlikely (status))
+	return status;
+
+    _cairo_image_info_write_png_idat (surface->output, mime_data, mime_data_length);
+    status = _cairo_pdf_surface_close_stream (surface);
+
+    return status;
+}
+
+static cairo_int_status_t
+_cairo_pdf_surface_emit_mime_image (cairo_pdf_surface_t		    *surface,
+				    cairo_surface_t		    *source,
+				    cairo_pdf_source_surface_entry_t *entry)
+{
+    cairo_int_status_t status;
+
+    status = _cairo_pdf_surface_emit_jpx_image (surface, source, entry->surface_res);
+    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+	return status;
+
+    status = _cairo_pdf_surface_emit_jpeg_image (surface, source, entry->surface_res);
+    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+	return status;
+
+    return _cairo_pdf_surface_emit_png_image (surface, source,
+					      entry->surface_res,
+					      entry->interpolate);
+}
+
 static cairo_status_t
 _cairo_pdf_surface_emit_image_surface (cairo_pdf_surface_t        *surface,
 				       cairo_pdf_source_surface_t *source)
@@ -2634,6 +2974,17 @@ _cairo_pdf_surface_emit_image_surface (cairo_pdf_surface_t        *surface,
     void *image_extra;
     cairo_int_status_t status;
 
+    /* Embed any mime data before acquiring the source, so that
+     * surfaces which only hold compressed data need not be decoded. */
+    if (source->type == CAIRO_PATTERN_TYPE_SURFACE &&
+	! source->hash_entry->stencil_mask)
+    {
+	status = _cairo_pdf_surface_emit_mime_image (surface, source->surface,
+						     source->hash_entry);
+	if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+	    return status;
+    }
+
     if (source->type == CAIRO_PATTERN_TYPE_SURFACE) {
 	status = _cairo_surface_acquire_source_image (source->surface, &image, &image_extra);
     } else {
@@ -2643,12 +2994,11 @@ _cairo_pdf_surface_emit_image_surface (cairo_pdf_surface_t        *surface,
     if (unlikely (status))
 	return status;
 
-    if (!source->hash_entry->stencil_mask) {
-	status = _cairo_pdf_surface_emit_jpx_image (surface, &image->base, source->hash_entry->surface_res);
-	if (status != CAIRO_INT_STATUS_UNSUPPORTED)
-	    goto release_source;
-
-	status = _cairo_pdf_surface_emit_jpeg_image (surface, &image->base, source->hash_entry->surface_res);
+    if (source->type != CAIRO_PATTERN_TYPE_SURFACE &&
+	! source->hash_entry->stencil_mask)
+    {
+	status = _cairo_pdf_surface_emit_mime_image (surface, &image->base,
+						     source->hash_entry);
 	if (status != CAIRO_INT_STATUS_UNSUPPORTED)
 	    goto release_source;
     }
@@ -4110,13 +4460,28 @@ _can_paint_pattern (const cairo_pattern_t *pattern)
     }
 }
 
+/* Overlapping opaque strokes of the same color look the same whether
+ * painted with one operator or one after the other. */
+static cairo_bool_t
+_can_merge_strokes (cairo_operator_t	      op,
+		    const cairo_pattern_t    *source)
+{
+    const cairo_solid_pattern_t *solid;
+
+    if (op != CAIRO_OPERATOR_OVER || source->type != CAIRO_PATTERN_TYPE_SOLID)
+	return FALSE;
+
+    solid = (const cairo_solid_pattern_t *) source;
+    return solid->color.alpha >= 1.0;
+}
+
 static cairo_status_t
 _cairo_pdf_surface_select_operator (cairo_pdf_surface_t *surface,
 				    cairo_operator_t     op)
 {
     cairo_status_t status;
 
-    if (op == surface->current_operator)
+    if (op == surface->gstate.operator)
 	return CAIRO_STATUS_SUCCESS;
 
     status = _cairo_pdf_operators_flush (&surface->pdf_operators);
@@ -4125,7 +4490,7 @@ _cairo_pdf_surface_select_operator (cairo_pdf_surface_t *surface,
 
     _cairo_output_stream_printf (surface->output,
 				 "/b%d gs\n", op);
-    surface->current_operator = op;
+    surface->gstate.operator = op;
     _cairo_pdf_surface_add_operator (surface, op);
 
     return CAIRO_STATUS_SUCCESS;
@@ -4148,36 +4513,54 @@ _cairo_pdf_surface_select_pattern (cairo_pdf_surface_t *surface,
     }
 
     if (solid_color != NULL) {
-	if (surface->current_pattern_is_solid_color == FALSE ||
-	    surface->current_color_red != solid_color->red ||
-	    surface->current_color_green != solid_color->green ||
-	    surface->current_color_blue != solid_color->blue ||
-	    surface->current_color_is_stroke != is_stroke)
+	cairo_pdf_gstate_t *gstate = &surface->gstate;
+
+	/* The fill and stroke colors are separate parts of the PDF
+	 * graphics state, so each is only set when it changes. */
+	if (is_stroke &&
+	    (! gstate->has_stroke_color ||
+	     gstate->stroke_red != solid_color->red ||
+	     gstate->stroke_green != solid_color->green ||
+	     gstate->stroke_blue != solid_color->blue))
 	{
 	    status = _cairo_pdf_operators_flush (&surface->pdf_operators);
 	    if (unlikely (status))
 		return status;
 
 	    _cairo_output_stream_printf (surface->output,
-					 "%f %f %f ",
+					 "%f %f %f RG ",
 					 solid_color->red,
 					 solid_color->green,
 					 solid_color->blue);
 
-	    if (is_stroke)
-		_cairo_output_stream_printf (surface->output, "RG ");
-	    else
-		_cairo_output_stream_printf (surface->output, "rg ");
+	    gstate->has_stroke_color = TRUE;
+	    gstate->stroke_red = solid_color->red;
+	    gstate->stroke_green = solid_color->green;
+	    gstate->stroke_blue = solid_color->blue;
+	}
+	else if (! is_stroke &&
+		 (! gstate->has_fill_color ||
+		  gstate->fill_red != solid_color->red ||
+		  gstate->fill_green != solid_color->green ||
+		  gstate->fill_blue != solid_color->blue))
+	{
+	    status = _cairo_pdf_operators_flush (&surface->pdf_operators);
+	    if (unlikely (status))
+		return status;
+
+	    _cairo_output_stream_printf (surface->output,
+					 "%f %f %f rg ",
+					 solid_color->red,
+					 solid_color->green,
+					 solid_color->blue);
 
-	    surface->current_color_red = solid_color->red;
-	    surface->current_color_green = solid_color->green;
-	    surface->current_color_blue = solid_color->blue;
-	    surface->current_color_is_stroke = is_stroke;
+	    gstate->has_fill_color = TRUE;
+	    gstate->fill_red = solid_color->red;
+	    gstate->fill_green = solid_color->green;
+	    gstate->fill_blue = solid_color->blue;
 	}
 
-	if (surface->current_pattern_is_solid_color == FALSE ||
-	    surface->current_color_alpha != solid_color->alpha)
-	{
+	if (! gstate->has_alpha || gstate->alpha != solid_color->alpha) {
 	    status = _cairo_pdf_surface_add_alpha (surface, solid_color->alpha, &alpha);
 	    if (unlikely (status))
 		return status;
@@ -4189,10 +4572,9 @@ _cairo_pdf_surface_select_pattern (cairo_pdf_surface_t *surface,
 	    _cairo_output_stream_printf (surface->output,
 					 "/a%d gs\n",
 					 alpha);
-	    surface->current_color_alpha = solid_color->alpha;
+	    gstate->has_alpha = TRUE;
+	    gstate->alpha = solid_color->alpha;
 	}
-
-	surface->current_pattern_is_solid_color = TRUE;
     } else {
 	status = _cairo_pdf_surface_add_alpha (surface, 1.0, &alpha);
 	if (unlikely (status))
@@ -4208,8 +4590,11 @@ _cairo_pdf_surface_select_pattern (cairo_pdf_surface_t *surface,
 
 	/* fill-stroke calls select_pattern twice. Don't save if the
 	 * gstate is already saved. */
-	if (!surface->select_pattern_gstate_saved)
+	if (!surface->select_pattern_gstate_saved) {
 	    _cairo_output_stream_printf (surface->output, "q ");
+	    surface->saved_gstate = surface->gstate;
+	    _cairo_pdf_operators_save (&surface->pdf_operators);
+	}
 
 	if (is_stroke) {
 	    _cairo_output_stream_printf (surface->output,
@@ -4224,7 +4609,12 @@ _cairo_pdf_surface_select_pattern (cairo_pdf_surface_t *surface,
 				     "/a%d gs\n",
 				     alpha);
 	surface->select_pattern_gstate_saved = TRUE;
-	surface->current_pattern_is_solid_color = FALSE;
+	if (is_stroke)
+	    surface->gstate.has_stroke_color = FALSE;
+	else
+	    surface->gstate.has_fill_color = FALSE;
+	surface->gstate.has_alpha = TRUE;
+	surface->gstate.alpha = 1.0;
     }
 
     return _cairo_output_stream_get_status (surface->output);
@@ -4240,9 +4630,10 @@ _cairo_pdf_surface_unselect_pattern (cairo_pdf_surface_t *surface)
 	if (unlikely (status))
 	    return status;
 
+	/* Everything set since the 'q' is undone. */
 	_cairo_output_stream_printf (surface->output, "Q\n");
-	_cairo_pdf_operators_reset (&surface->pdf_operators);
-	surface->current_pattern_is_solid_color = FALSE;
+	surface->gstate = surface->saved_gstate;
+	_cairo_pdf_operators_restore (&surface->pdf_operators);
     }
     surface->select_pattern_gstate_saved = FALSE;
 
@@ -4641,7 +5032,9 @@ _cairo_pdf_surface_emit_to_unicode_stream (cairo_pdf_surface_t		*surface,
 static cairo_status_t
 _cairo_pdf_surface_emit_cff_font (cairo_pdf_surface_t		*surface,
                                   cairo_scaled_font_subset_t	*font_subset,
-                                  cairo_cff_subset_t            *subset)
+                                  cairo_cff_subset_t            *subset,
+				  const unsigned char		*data,
+				  unsigned long			 length)
 {
     cairo_pdf_resource_t stream, descriptor, cidfont_dict;
     cairo_pdf_resource_t subset_resource, to_unicode_stream;
@@ -4660,16 +5053,17 @@ _cairo_pdf_surface_emit_cff_font (cairo_pdf_surface_t		*surface,
 
     status = _cairo_pdf_surface_open_stream (surface,
 					     NULL,
-					     TRUE,
+					     FALSE,
 					     font_subset->is_latin ?
+					     "   /Filter /FlateDecode\n"
 					     "   /Subtype /Type1C\n" :
+					     "   /Filter /FlateDecode\n"
 					     "   /Subtype /CIDFontType0C\n");
     if (unlikely (status))
 	return status;
 
     stream = surface->pdf_stream.self;
-    _cairo_output_stream_write (surface->output,
-				subset->data, subset->data_length);
+    _cairo_output_stream_write (surface->output, data, length);
     status = _cairo_pdf_surface_close_stream (surface);
     if (unlikely (status))
 	return status;
@@ -4835,62 +5229,16 @@ _cairo_pdf_surface_emit_cff_font (cairo_pdf_surface_t		*surface,
     return status;
 }
 
-static cairo_status_t
-_cairo_pdf_surface_emit_cff_font_subset (cairo_pdf_surface_t	     *surface,
-                                         cairo_scaled_font_subset_t  *font_subset)
-{
-    cairo_status_t status;
-    cairo_cff_subset_t subset;
-    char name[64];
-
-    snprintf (name, sizeof name, "CairoFont-%d-%d",
-              font_subset->font_id, font_subset->subset_id);
-    status = _cairo_cff_subset_init (&subset, name, font_subset);
-    if (unlikely (status))
-        return status;
-
-    status = _cairo_pdf_surface_emit_cff_font (surface, font_subset, &subset);
-
-    _cairo_cff_subset_fini (&subset);
-
-    return status;
-}
-
-static cairo_status_t
-_cairo_pdf_surface_emit_cff_fallback_font (cairo_pdf_surface_t	       *surface,
-                                           cairo_scaled_font_subset_t  *font_subset)
-{
-    cairo_status_t status;
-    cairo_cff_subset_t subset;
-    char name[64];
-
-    /* CFF fallback subsetting does not work with 8-bit glyphs unless
-     * they are a latin subset */
-    if (!font_subset->is_composite && !font_subset->is_latin)
-	return CAIRO_INT_STATUS_UNSUPPORTED;
-
-    snprintf (name, sizeof name, "CairoFont-%d-%d",
-              font_subset->font_id, font_subset->subset_id);
-    status = _cairo_cff_fallback_init (&subset, name, font_subset);
-    if (unlikely (status))
-        return status;
-
-    status = _cairo_pdf_surface_emit_cff_font (surface, font_subset, &subset);
-
-    _cairo_cff_fallback_fini (&subset);
-
-    return status;
-}
-
 static cairo_status_t
 _cairo_pdf_surface_emit_type1_font (cairo_pdf_surface_t		*surface,
                                     cairo_scaled_font_subset_t	*font_subset,
-                                    cairo_type1_subset_t        *subset)
+                                    cairo_type1_subset_t        *subset,
+				    const unsigned char		*data,
+				    unsigned long		 length)
 {
     cairo_pdf_resource_t stream, descriptor, subset_resource, to_unicode_stream;
     cairo_pdf_font_t font;
     cairo_status_t status;
-    unsigned long length;
     unsigned int i, last_glyph;
     char tag[10];
 
@@ -4902,10 +5250,10 @@ _cairo_pdf_surface_emit_type1_font (cairo_pdf_surface_t		*surface,
     if (subset_resource.id == 0)
 	return CAIRO_STATUS_SUCCESS;
 
-    length = subset->header_length + subset->data_length + subset->trailer_length;
     status = _cairo_pdf_surface_open_stream (surface,
 					     NULL,
-					     TRUE,
+					     FALSE,
+					     "   /Filter /FlateDecode\n"
 					     "   /Length1 %lu\n"
 					     "   /Length2 %lu\n"
 					     "   /Length3 %lu\n",
@@ -4916,7 +5264,7 @@ _cairo_pdf_surface_emit_type1_font (cairo_pdf_surface_t		*surface,
 	return status;
 
     stream = surface->pdf_stream.self;
-    _cairo_output_stream_write (surface->output, subset->data, length);
+    _cairo_output_stream_write (surface->output, data, length);
     status = _cairo_pdf_surface_close_stream (surface);
     if (unlikely (status))
 	return status;
@@ -5025,62 +5373,16 @@ _cairo_pdf_surface_emit_type1_font (cairo_pdf_surface_t		*surface,
 }
 
 static cairo_status_t
-_cairo_pdf_surface_emit_type1_font_subset (cairo_pdf_surface_t		*surface,
-					   cairo_scaled_font_subset_t	*font_subset)
-{
-    cairo_status_t status;
-    cairo_type1_subset_t subset;
-    char name[64];
-
-    /* 16-bit glyphs not compatible with Type 1 fonts */
-    if (font_subset->is_composite && !font_subset->is_latin)
-	return CAIRO_INT_STATUS_UNSUPPORTED;
-
-    snprintf (name, sizeof name, "CairoFont-%d-%d",
-	      font_subset->font_id, font_subset->subset_id);
-    status = _cairo_type1_subset_init (&subset, name, font_subset, FALSE);
-    if (unlikely (status))
-	return status;
-
-    status = _cairo_pdf_surface_emit_type1_font (surface, font_subset, &subset);
-
-    _cairo_type1_subset_fini (&subset);
-    return status;
-}
-
-static cairo_status_t
-_cairo_pdf_surface_emit_type1_fallback_font (cairo_pdf_surface_t	*surface,
-                                             cairo_scaled_font_subset_t	*font_subset)
-{
-    cairo_status_t status;
-    cairo_type1_subset_t subset;
-    char name[64];
-
-    /* 16-bit glyphs not compatible with Type 1 fonts */
-    if (font_subset->is_composite && !font_subset->is_latin)
-	return CAIRO_INT_STATUS_UNSUPPORTED;
-
-    snprintf (name, sizeof name, "CairoFont-%d-%d",
-	      font_subset->font_id, font_subset->subset_id);
-    status = _cairo_type1_fallback_init_binary (&subset, name, font_subset);
-    if (unlikely (status))
-	return status;
-
-    status = _cairo_pdf_surface_emit_type1_font (surface, font_subset, &subset);
-
-    _cairo_type1_fallback_fini (&subset);
-    return status;
-}
-
-static cairo_status_t
-_cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
-					      cairo_scaled_font_subset_t	*font_subset)
+_cairo_pdf_surface_emit_truetype_font (cairo_pdf_surface_t		*surface,
+				       cairo_scaled_font_subset_t	*font_subset,
+				       cairo_truetype_subset_t		*subset,
+				       const unsigned char		*data,
+				       unsigned long			 length)
 {
     cairo_pdf_resource_t stream, descriptor, cidfont_dict;
     cairo_pdf_resource_t subset_resource, to_unicode_stream;
     cairo_status_t status;
     cairo_pdf_font_t font;
-    cairo_truetype_subset_t subset;
     unsigned int i, last_glyph;
     char tag[10];
 
@@ -5090,44 +5392,32 @@ _cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
     if (subset_resource.id == 0)
 	return CAIRO_STATUS_SUCCESS;
 
-    status = _cairo_truetype_subset_init_pdf (&subset, font_subset);
-    if (unlikely (status))
-	return status;
-
-    _create_font_subset_tag (font_subset, subset.ps_name, tag);
+    _create_font_subset_tag (font_subset, subset->ps_name, tag);
 
     status = _cairo_pdf_surface_open_stream (surface,
 					     NULL,
-					     TRUE,
+					     FALSE,
+					     "   /Filter /FlateDecode\n"
 					     "   /Length1 %lu\n",
-					     subset.data_length);
-    if (unlikely (status)) {
-	_cairo_truetype_subset_fini (&subset);
+					     subset->data_length);
+    if (unlikely (status))
 	return status;
-    }
 
     stream = surface->pdf_stream.self;
-    _cairo_output_stream_write (surface->output,
-				subset.data, subset.data_length);
+    _cairo_output_stream_write (surface->output, data, length);
     status = _cairo_pdf_surface_close_stream (surface);
-    if (unlikely (status)) {
-	_cairo_truetype_subset_fini (&subset);
+    if (unlikely (status))
 	return status;
-    }
 
     status = _cairo_pdf_surface_emit_to_unicode_stream (surface,
 	                                                font_subset,
 							&to_unicode_stream);
-    if (_cairo_status_is_error (status)) {
-	_cairo_truetype_subset_fini (&subset);
+    if (_cairo_status_is_error (status))
 	return status;
-    }
 
     descriptor = _cairo_pdf_surface_new_object (surface);
-    if (descriptor.id == 0) {
-	_cairo_truetype_subset_fini (&subset);
+    if (descriptor.id == 0)
 	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
-    }
 
     _cairo_output_stream_printf (surface->output,
 				 "%d 0 obj\n"
@@ -5135,12 +5425,12 @@ _cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
 				 "   /FontName /%s+%s\n",
 				 descriptor.id,
 				 tag,
-				 subset.ps_name);
+				 subset->ps_name);
 
-    if (subset.family_name_utf8) {
+    if (subset->family_name_utf8) {
 	char *pdf_str;
 
-	status = _utf8_to_pdf_string (subset.family_name_utf8, &pdf_str);
+	status = _utf8_to_pdf_string (subset->family_name_utf8, &pdf_str);
 	if (unlikely (status))
 	    return status;
 
@@ -5163,13 +5453,13 @@ _cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
 				 ">>\n"
 				 "endobj\n",
 				 font_subset->is_latin ? 32 : 4,
-				 (long)(subset.x_min*PDF_UNITS_PER_EM),
-				 (long)(subset.y_min*PDF_UNITS_PER_EM),
-                                 (long)(subset.x_max*PDF_UNITS_PER_EM),
-				 (long)(subset.y_max*PDF_UNITS_PER_EM),
-				 (long)(subset.ascent*PDF_UNITS_PER_EM),
-				 (long)(subset.descent*PDF_UNITS_PER_EM),
-				 (long)(subset.y_max*PDF_UNITS_PER_EM),
+				 (long)(subset->x_min*PDF_UNITS_PER_EM),
+				 (long)(subset->y_min*PDF_UNITS_PER_EM),
+                                 (long)(subset->x_max*PDF_UNITS_PER_EM),
+				 (long)(subset->y_max*PDF_UNITS_PER_EM),
+				 (long)(subset->ascent*PDF_UNITS_PER_EM),
+				 (long)(subset->descent*PDF_UNITS_PER_EM),
+				 (long)(subset->y_max*PDF_UNITS_PER_EM),
 				 stream.id);
 
     if (font_subset->is_latin) {
@@ -5192,7 +5482,7 @@ _cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
 				     "   /Widths [",
 				     subset_resource.id,
 				     tag,
-				     subset.ps_name,
+				     subset->ps_name,
 				     last_glyph,
 				     descriptor.id);
 
@@ -5201,7 +5491,7 @@ _cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
 	    if (glyph > 0) {
 		_cairo_output_stream_printf (surface->output,
 					     " %ld",
-					     (long)(subset.widths[glyph]*PDF_UNITS_PER_EM));
+					     (long)(subset->widths[glyph]*PDF_UNITS_PER_EM));
 	    } else {
 		_cairo_output_stream_printf (surface->output, " 0");
 	    }
@@ -5220,10 +5510,8 @@ _cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
 				     "endobj\n");
     } else {
 	cidfont_dict = _cairo_pdf_surface_new_object (surface);
-	if (cidfont_dict.id == 0) {
-	    _cairo_truetype_subset_fini (&subset);
+	if (cidfont_dict.id == 0)
 	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
-	}
 
 	_cairo_output_stream_printf (surface->output,
 				     "%d 0 obj\n"
@@ -5239,13 +5527,13 @@ _cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
 				     "   /W [0 [",
 				     cidfont_dict.id,
 				     tag,
-				     subset.ps_name,
+				     subset->ps_name,
 				     descriptor.id);
 
 	for (i = 0; i < font_subset->num_glyphs; i++)
 	    _cairo_output_stream_printf (surface->output,
 					 " %ld",
-					 (long)(subset.widths[i]*PDF_UNITS_PER_EM));
+					 (long)(subset->widths[i]*PDF_UNITS_PER_EM));
 
 	_cairo_output_stream_printf (surface->output,
 				     " ]]\n"
@@ -5262,7 +5550,7 @@ _cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
 				     "   /DescendantFonts [ %d 0 R]\n",
 				     subset_resource.id,
 				     tag,
-				     subset.ps_name,
+				     subset->ps_name,
 				     cidfont_dict.id);
 
 	if (to_unicode_stream.id != 0)
@@ -5280,8 +5568,6 @@ _cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
     font.subset_resource = subset_resource;
     status = _cairo_array_append (&surface->fonts, &font);
 
-    _cairo_truetype_subset_fini (&subset);
-
     return status;
 }
 
@@ -5550,35 +5836,422 @@ _cairo_pdf_surface_emit_type3_font_subset (cairo_pdf_surface_t		*surface,
     return _cairo_array_append (&surface->fonts, &font);
 }
 
-static cairo_int_status_t
-_cairo_pdf_surface_emit_unscaled_font_subset (cairo_scaled_font_subset_t *font_subset,
-                                              void			 *closure)
+/* The font programs of the unscaled subsets are generated and
+ * compressed up front, on a pool of worker threads where available,
+ * and only then written out, one subset after another in the order in
+ * which they were collected. The output therefore does not depend upon
+ * how the work was scheduled. Only fonts whose backend is known to
+ * cope with being subset from several threads at once are handed to
+ * the pool; the rest are prepared on the calling thread.
+ */
+#define PDF_MAX_FONT_THREADS 8
+
+typedef enum _cairo_pdf_font_program {
+    CAIRO_PDF_FONT_PROGRAM_NONE,
+    CAIRO_PDF_FONT_PROGRAM_CFF,
+    CAIRO_PDF_FONT_PROGRAM_TRUETYPE,
+    CAIRO_PDF_FONT_PROGRAM_TYPE1,
+    CAIRO_PDF_FONT_PROGRAM_CFF_FALLBACK,
+    CAIRO_PDF_FONT_PROGRAM_TYPE1_FALLBACK
+} cairo_pdf_font_program_t;
+
+typedef struct _cairo_pdf_font_job {
+    /* A private copy, as the subsets passed to the foreach callbacks
+     * share their glyph arrays. */
+    cairo_scaled_font_subset_t font_subset;
+
+    cairo_pdf_font_program_t program;
+    union {
+	cairo_cff_subset_t cff;
+	cairo_truetype_subset_t truetype;
+	cairo_type1_subset_t type1;
+    } subset;
+
+    /* the deflated font program */
+    unsigned char *data;
+    unsigned long length;
+
+    cairo_int_status_t status;
+} cairo_pdf_font_job_t;
+
+typedef struct _cairo_pdf_font_queue {
+    cairo_pdf_surface_t *surface;
+    cairo_array_t jobs;
+} cairo_pdf_font_queue_t;
+
+static void
+_cairo_pdf_font_job_fini (cairo_pdf_font_job_t *job)
 {
-    cairo_pdf_surface_t *surface = closure;
+    cairo_scaled_font_subset_t *font_subset = &job->font_subset;
+    unsigned int i;
+
+    switch (job->program) {
+    case CAIRO_PDF_FONT_PROGRAM_NONE:
+	break;
+    case CAIRO_PDF_FONT_PROGRAM_CFF:
+	_cairo_cff_subset_fini (&job->subset.cff);
+	break;
+    case CAIRO_PDF_FONT_PROGRAM_TRUETYPE:
+	_cairo_truetype_subset_fini (&job->subset.truetype);
+	break;
+    case CAIRO_PDF_FONT_PROGRAM_TYPE1:
+	_cairo_type1_subset_fini (&job->subset.type1);
+	break;
+    case CAIRO_PDF_FONT_PROGRAM_CFF_FALLBACK:
+	_cairo_cff_fallback_fini (&job->subset.cff);
+	break;
+    case CAIRO_PDF_FONT_PROGRAM_TYPE1_FALLBACK:
+	_cairo_type1_fallback_fini (&job->subset.type1);
+	break;
+    }
+
+    free (job->data);
+
+    if (font_subset->glyph_names != NULL) {
+	for (i = 0; i < font_subset->num_glyphs; i++)
+	    free (font_subset->glyph_names[i]);
+	free (font_subset->glyph_names);
+    }
+
+    free (font_subset->glyphs);
+    free (font_subset->utf8);
+    free (font_subset->to_latin_char);
+    free (font_subset->latin_to_subset_glyph_index);
+}
+
+static cairo_status_t
+_cairo_pdf_font_job_init (cairo_pdf_font_job_t	     *job,
+			  cairo_scaled_font_subset_t *font_subset)
+{
+    cairo_scaled_font_subset_t *copy = &job->font_subset;
+    unsigned int num_glyphs = font_subset->num_glyphs;
+
+    memset (job, 0, sizeof (cairo_pdf_font_job_t));
+    job->program = CAIRO_PDF_FONT_PROGRAM_NONE;
+    job->status = CAIRO_INT_STATUS_SUCCESS;
+
+    *copy = *font_subset;
+    copy->glyph_names = NULL;
+    copy->glyphs = _cairo_malloc_ab (num_glyphs, sizeof (unsigned long));
+    copy->utf8 = _cairo_malloc_ab (num_glyphs, sizeof (char *));
+    copy->to_latin_char = NULL;
+    copy->latin_to_subset_glyph_index = NULL;
+    if (font_subset->is_latin) {
+	copy->to_latin_char = _cairo_malloc_ab (num_glyphs, sizeof (int));
+	copy->latin_to_subset_glyph_index = _cairo_malloc_ab (256, sizeof (unsigned long));
+    }
+
+    if (unlikely (copy->glyphs == NULL ||
+		  copy->utf8 == NULL ||
+		  (font_subset->is_latin &&
+		   (copy->to_latin_char == NULL ||
+		    copy->latin_to_subset_glyph_index == NULL))))
+    {
+	_cairo_pdf_font_job_fini (job);
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    /* The strings themselves belong to the font subsets and live until
+     * they are destroyed. */
+    memcpy (copy->glyphs, font_subset->glyphs, num_glyphs * sizeof (unsigned long));
+    memcpy (copy->utf8, font_subset->utf8, num_glyphs * sizeof (char *));
+    if (font_subset->is_latin) {
+	memcpy (copy->to_latin_char, font_subset->to_latin_char,
+		num_glyphs * sizeof (int));
+	memcpy (copy->latin_to_subset_glyph_index,
+		font_subset->latin_to_subset_glyph_index,
+		256 * sizeof (unsigned long));
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Generates the font program and compresses it. This only reads from
+ * the font subset and the scaled font, but the subsetters load the font
+ * tables through the font backend, so whether it may be run on another
+ * thread depends upon the backend; see _cairo_pdf_font_job_is_threadsafe(). */
+static void
+_cairo_pdf_font_job_prepare (cairo_pdf_font_job_t *job)
+{
+    cairo_scaled_font_subset_t *font_subset = &job->font_subset;
+    cairo_output_stream_t *mem, *deflate;
+    const void *data;
+    unsigned long length;
     cairo_int_status_t status;
+    cairo_status_t status2;
+    char name[64];
 
-    status = _cairo_pdf_surface_emit_cff_font_subset (surface, font_subset);
-    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
-	return status;
+    snprintf (name, sizeof name, "CairoFont-%d-%d",
+	      font_subset->font_id, font_subset->subset_id);
 
-    status = _cairo_pdf_surface_emit_truetype_font_subset (surface, font_subset);
-    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
-	return status;
+    job->program = CAIRO_PDF_FONT_PROGRAM_CFF;
+    status = _cairo_cff_subset_init (&job->subset.cff, name, font_subset);
 
-    status = _cairo_pdf_surface_emit_type1_font_subset (surface, font_subset);
-    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
-	return status;
+    if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
+	job->program = CAIRO_PDF_FONT_PROGRAM_TRUETYPE;
+	status = _cairo_truetype_subset_init_pdf (&job->subset.truetype,
+						  font_subset);
+    }
 
-    status = _cairo_pdf_surface_emit_cff_fallback_font (surface, font_subset);
-    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
-	return status;
+    /* 16-bit glyphs not compatible with Type 1 fonts */
+    if (status == CAIRO_INT_STATUS_UNSUPPORTED &&
+	! (font_subset->is_composite && ! font_subset->is_latin))
+    {
+	job->program = CAIRO_PDF_FONT_PROGRAM_TYPE1;
+	status = _cairo_type1_subset_init (&job->subset.type1, name,
+					   font_subset, FALSE);
+    }
 
-    status = _cairo_pdf_surface_emit_type1_fallback_font (surface, font_subset);
-    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+    /* CFF fallback subsetting does not work with 8-bit glyphs unless
+     * they are a latin subset */
+    if (status == CAIRO_INT_STATUS_UNSUPPORTED &&
+	(font_subset->is_composite || font_subset->is_latin))
+    {
+	job->program = CAIRO_PDF_FONT_PROGRAM_CFF_FALLBACK;
+	status = _cairo_cff_fallback_init (&job->subset.cff, name, font_subset);
+    }
+
+    if (status == CAIRO_INT_STATUS_UNSUPPORTED &&
+	! (font_subset->is_composite && ! font_subset->is_latin))
+    {
+	job->program = CAIRO_PDF_FONT_PROGRAM_TYPE1_FALLBACK;
+	status = _cairo_type1_fallback_init_binary (&job->subset.type1, name,
+						    font_subset);
+    }
+
+    if (unlikely (status)) {
+	assert (status != CAIRO_INT_STATUS_UNSUPPORTED);
+	job->program = CAIRO_PDF_FONT_PROGRAM_NONE;
+	job->status = status;
+	return;
+    }
+
+    switch (job->program) {
+    case CAIRO_PDF_FONT_PROGRAM_CFF:
+    case CAIRO_PDF_FONT_PROGRAM_CFF_FALLBACK:
+	data = job->subset.cff.data;
+	length = job->subset.cff.data_length;
+	break;
+    case CAIRO_PDF_FONT_PROGRAM_TRUETYPE:
+	data = job->subset.truetype.data;
+	length = job->subset.truetype.data_length;
+	break;
+    case CAIRO_PDF_FONT_PROGRAM_TYPE1:
+    case CAIRO_PDF_FONT_PROGRAM_TYPE1_FALLBACK:
+	data = job->subset.type1.data;
+	length = job->subset.type1.header_length +
+		 job->subset.type1.data_length +
+		 job->subset.type1.trailer_length;
+	break;
+    case CAIRO_PDF_FONT_PROGRAM_NONE:
+    default:
+	ASSERT_NOT_REACHED;
+	return;
+    }
+
+    mem = _cairo_memory_stream_create ();
+    deflate = _cairo_deflate_stream_create (mem);
+    _cairo_output_stream_write (deflate, data, length);
+    status = _cairo_output_stream_destroy (deflate);
+
+    status2 = _cairo_memory_stream_destroy (mem, &job->data, &job->length);
+    if (status == CAIRO_INT_STATUS_SUCCESS)
+	status = status2;
+
+    job->status = status;
+}
+
+#if CAIRO_PDF_USE_THREADS
+/* The FreeType backend locks the face around every table load and
+ * glyph lookup. Others make no such promise: win32, for instance,
+ * loads the tables through a DC shared by all fonts, and user fonts
+ * call back into the application. */
+static cairo_bool_t
+_cairo_pdf_font_job_is_threadsafe (const cairo_pdf_font_job_t *job)
+{
+#if CAIRO_HAS_FT_FONT
+    return _cairo_scaled_font_is_ft (job->font_subset.scaled_font);
+#else
+    return FALSE;
+#endif
+}
+
+typedef struct _cairo_pdf_font_pool {
+    cairo_pdf_font_job_t *jobs;
+    int num_jobs;
+    int next_job;
+    cairo_mutex_t mutex;
+} cairo_pdf_font_pool_t;
+
+static void *
+_cairo_pdf_font_pool_worker (void *closure)
+{
+    cairo_pdf_font_pool_t *pool = closure;
+
+    for (;;) {
+	int i;
+
+	CAIRO_MUTEX_LOCK (pool->mutex);
+	i = pool->next_job++;
+	CAIRO_MUTEX_UNLOCK (pool->mutex);
+	if (i >= pool->num_jobs)
+	    break;
+
+	if (_cairo_pdf_font_job_is_threadsafe (&pool->jobs[i]))
+	    _cairo_pdf_font_job_prepare (&pool->jobs[i]);
+    }
+
+    return NULL;
+}
+#endif
+
+static void
+_cairo_pdf_font_jobs_prepare (cairo_pdf_font_job_t *jobs,
+			      int		    num_jobs)
+{
+    int i;
+
+#if CAIRO_PDF_USE_THREADS
+    pthread_t threads[PDF_MAX_FONT_THREADS - 1];
+    cairo_pdf_font_pool_t pool;
+    long num_threads;
+    int num_threadsafe = 0;
+
+    for (i = 0; i < num_jobs; i++) {
+	if (_cairo_pdf_font_job_is_threadsafe (&jobs[i]))
+	    num_threadsafe++;
+    }
+
+#ifdef _SC_NPROCESSORS_ONLN
+    num_threads = sysconf (_SC_NPROCESSORS_ONLN);
+#else
+    num_threads = 1;
+#endif
+    num_threads = MIN (num_threads, num_threadsafe);
+    num_threads = MIN (num_threads, PDF_MAX_FONT_THREADS) - 1;
+    if (num_threads > 0) {
+	pool.jobs = jobs;
+	pool.num_jobs = num_jobs;
+	pool.next_job = 0;
+	CAIRO_MUTEX_INIT (pool.mutex);
+
+	for (i = 0; i < num_threads; i++) {
+	    if (pthread_create (&threads[i], NULL,
+				_cairo_pdf_font_pool_worker, &pool) != 0)
+		break;
+	}
+	num_threads = i;
+
+	/* the fonts that must stay on this thread, then whatever the
+	 * other threads do not pick up */
+	for (i = 0; i < num_jobs; i++) {
+	    if (! _cairo_pdf_font_job_is_threadsafe (&jobs[i]))
+		_cairo_pdf_font_job_prepare (&jobs[i]);
+	}
+	_cairo_pdf_font_pool_worker (&pool);
+
+	for (i = 0; i < num_threads; i++)
+	    pthread_join (threads[i], NULL);
+
+	CAIRO_MUTEX_FINI (pool.mutex);
+	return;
+    }
+#endif
+
+    for (i = 0; i < num_jobs; i++)
+	_cairo_pdf_font_job_prepare (&jobs[i]);
+}
+
+static cairo_int_status_t
+_cairo_pdf_surface_queue_unscaled_font_subset (cairo_scaled_font_subset_t *font_subset,
+					       void			  *closure)
+{
+    cairo_pdf_font_queue_t *queue = closure;
+    cairo_pdf_resource_t subset_resource;
+    cairo_pdf_font_job_t job;
+    cairo_status_t status;
+
+    subset_resource = _cairo_pdf_surface_get_font_resource (queue->surface,
+							    font_subset->font_id,
+							    font_subset->subset_id);
+    if (subset_resource.id == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    status = _cairo_pdf_font_job_init (&job, font_subset);
+    if (unlikely (status))
 	return status;
 
-    ASSERT_NOT_REACHED;
-    return CAIRO_INT_STATUS_SUCCESS;
+    status = _cairo_array_append (&queue->jobs, &job);
+    if (unlikely (status))
+	_cairo_pdf_font_job_fini (&job);
+
+    return status;
+}
+
+static cairo_int_status_t
+_cairo_pdf_surface_emit_font_job (cairo_pdf_surface_t  *surface,
+				  cairo_pdf_font_job_t *job)
+{
+    if (unlikely (job->status))
+	return job->status;
+
+    switch (job->program) {
+    case CAIRO_PDF_FONT_PROGRAM_CFF:
+    case CAIRO_PDF_FONT_PROGRAM_CFF_FALLBACK:
+	return _cairo_pdf_surface_emit_cff_font (surface,
+						 &job->font_subset,
+						 &job->subset.cff,
+						 job->data, job->length);
+    case CAIRO_PDF_FONT_PROGRAM_TRUETYPE:
+	return _cairo_pdf_surface_emit_truetype_font (surface,
+						      &job->font_subset,
+						      &job->subset.truetype,
+						      job->data, job->length);
+    case CAIRO_PDF_FONT_PROGRAM_TYPE1:
+    case CAIRO_PDF_FONT_PROGRAM_TYPE1_FALLBACK:
+	return _cairo_pdf_surface_emit_type1_font (surface,
+						   &job->font_subset,
+						   &job->subset.type1,
+						   job->data, job->length);
+    case CAIRO_PDF_FONT_PROGRAM_NONE:
+    default:
+	ASSERT_NOT_REACHED;
+	return CAIRO_INT_STATUS_SUCCESS;
+    }
+}
+
+static cairo_status_t
+_cairo_pdf_surface_emit_unscaled_font_subsets (cairo_pdf_surface_t *surface)
+{
+    cairo_pdf_font_queue_t queue;
+    cairo_pdf_font_job_t *jobs;
+    cairo_status_t status;
+    int num_jobs, i;
+
+    queue.surface = surface;
+    _cairo_array_init (&queue.jobs, sizeof (cairo_pdf_font_job_t));
+
+    status = _cairo_scaled_font_subsets_foreach_unscaled (surface->font_subsets,
+							  _cairo_pdf_surface_queue_unscaled_font_subset,
+							  &queue);
+
+    jobs = _cairo_array_index (&queue.jobs, 0);
+    num_jobs = _cairo_array_num_elements (&queue.jobs);
+    if (likely (status == CAIRO_STATUS_SUCCESS)) {
+	_cairo_pdf_font_jobs_prepare (jobs, num_jobs);
+
+	for (i = 0; i < num_jobs; i++) {
+	    status = _cairo_pdf_surface_emit_font_job (surface, &jobs[i]);
+	    if (unlikely (status))
+		break;
+	}
+    }
+
+    for (i = 0; i < num_jobs; i++)
+	_cairo_pdf_font_job_fini (&jobs[i]);
+    _cairo_array_fini (&queue.jobs);
+
+    return status;
 }
 
 static cairo_int_status_t
@@ -5607,9 +6280,7 @@ _cairo_pdf_surface_emit_font_subsets (cairo_pdf_surface_t *surface)
     if (unlikely (status))
 	goto BAIL;
 
-    status = _cairo_scaled_font_subsets_foreach_unscaled (surface->font_subsets,
-                                                          _cairo_pdf_surface_emit_unscaled_font_subset,
-                                                          surface);
+    status = _cairo_pdf_surface_emit_unscaled_font_subsets (surface);
     if (unlikely (status))
 	goto BAIL;
 
@@ -6099,6 +6770,11 @@ _cairo_pdf_surface_analyze_surface_pattern_transparency (cairo_pdf_surface_t
     cairo_int_status_t      status;
     cairo_image_transparency_t transparency;
 
+    /* Avoid acquiring (and possibly decoding) surfaces that cannot
+     * contain any transparency. */
+    if (pattern->surface->content == CAIRO_CONTENT_COLOR)
+	return CAIRO_STATUS_SUCCESS;
+
     status = _cairo_surface_acquire_source_image (pattern->surface,
 						  &image,
 						  &image_extra);
@@ -6535,11 +7211,12 @@ _cairo_pdf_surface_mask (void			*abstract_surface,
 			 const cairo_clip_t	*clip)
 {
     cairo_pdf_surface_t *surface = abstract_surface;
-    cairo_pdf_smask_group_t *group;
+    cairo_pdf_resource_t group_res, source_res;
     cairo_composite_rectangles_t extents;
     cairo_int_status_t status;
     cairo_rectangle_int_t r;
     cairo_box_t box;
+    double offset_x, offset_y;
 
     status = _cairo_composite_rectangles_init_for_mask (&extents,
 							&surface->base,
@@ -6611,41 +7288,18 @@ _cairo_pdf_surface_mask (void			*abstract_surface,
     if (status != CAIRO_INT_STATUS_UNSUPPORTED)
 	goto cleanup;
 
-    group = _cairo_pdf_surface_create_smask_group (surface, &extents.bounded);
-    if (unlikely (group == NULL)) {
-	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
-	goto cleanup;
-    }
-
-    group->operation = PDF_MASK;
-    status = _cairo_pattern_create_copy (&group->source, source);
-    if (unlikely (status)) {
-	_cairo_pdf_smask_group_destroy (group);
-	goto cleanup;
-    }
-    status = _cairo_pattern_create_copy (&group->mask, mask);
-    if (unlikely (status)) {
-	_cairo_pdf_smask_group_destroy (group);
-	goto cleanup;
-    }
-    group->source_res = _cairo_pdf_surface_new_object (surface);
-    if (group->source_res.id == 0) {
-	_cairo_pdf_smask_group_destroy (group);
-	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
-	goto cleanup;
-    }
-
-    status = _cairo_pdf_surface_add_smask_group (surface, group);
-    if (unlikely (status)) {
-	_cairo_pdf_smask_group_destroy (group);
+    status = _cairo_pdf_surface_add_mask_group (surface, source, mask,
+						&extents.bounded,
+						&group_res, &source_res,
+						&offset_x, &offset_y);
+    if (unlikely (status))
 	goto cleanup;
-    }
 
-    status = _cairo_pdf_surface_add_smask (surface, group->group_res);
+    status = _cairo_pdf_surface_add_smask (surface, group_res);
     if (unlikely (status))
 	goto cleanup;
 
-    status = _cairo_pdf_surface_add_xobject (surface, group->source_res);
+    status = _cairo_pdf_surface_add_xobject (surface, source_res);
     if (unlikely (status))
 	goto cleanup;
 
@@ -6653,10 +7307,18 @@ _cairo_pdf_surface_mask (void			*abstract_surface,
     if (unlikely (status))
 	goto cleanup;
 
+    /* The soft mask is positioned by the CTM in effect at the gs
+     * operator, so a reused group is translated before both. */
+    _cairo_output_stream_printf (surface->output, "q ");
+    if (offset_x != 0 || offset_y != 0) {
+	_cairo_output_stream_printf (surface->output,
+				     "1 0 0 1 %f %f cm ",
+				     offset_x, offset_y);
+    }
     _cairo_output_stream_printf (surface->output,
-				 "q /s%d gs /x%d Do Q\n",
-				 group->group_res.id,
-				 group->source_res.id);
+				 "/s%d gs /x%d Do Q\n",
+				 group_res.id,
+				 source_res.id);
 
     _cairo_composite_rectangles_fini (&extents);
     return _cairo_output_stream_get_status (surface->output);
@@ -6784,11 +7446,14 @@ _cairo_pdf_surface_stroke (void			*abstract_surface,
 	if (unlikely (status))
 	    goto cleanup;
 
+	_cairo_pdf_operators_enable_stroke_merging (&surface->pdf_operators,
+						    _can_merge_strokes (op, source));
 	status = _cairo_pdf_operators_stroke (&surface->pdf_operators,
 					      path,
 					      style,
 					      ctm,
 					      ctm_inverse);
+	_cairo_pdf_operators_enable_stroke_merging (&surface->pdf_operators, FALSE);
 	if (unlikely (status))
 	    goto cleanup;
 
@@ -87,6 +87,7 @@
 #include "cairo-error-private.h"
 #include "cairo-image-surface-private.h"
 #include "cairo-recording-surface-inline.h"
+#include "cairo-region-private.h"
 #include "cairo-surface-wrapper-private.h"
 #include "cairo-traps-private.h"
 
@@ -2067,3 +2068,358 @@ cairo_recording_surface_get_extents (cairo_surface_t *surface,
     *extents = record->extents_pixels;
     return TRUE;
 }
+
+/* Beyond this many inserted or removed commands, the commands between
+ * the common head and tail are all taken to have changed rather than
+ * paying for the rest of the search.
+ */
+#define DIFF_MAX_EDITS 256
+
+static unsigned long
+_command_pattern_hash (unsigned long hash, const cairo_pattern_t *pattern)
+{
+    unsigned long pattern_hash = _cairo_pattern_hash (pattern);
+
+    return _cairo_hash_bytes (hash, &pattern_hash, sizeof (pattern_hash));
+}
+
+static cairo_bool_t
+_command_pattern_equal (const cairo_pattern_t *a, const cairo_pattern_t *b)
+{
+    /* The content of a raster source is unknown until it is acquired */
+    if (a->type == CAIRO_PATTERN_TYPE_RASTER_SOURCE)
+	return FALSE;
+
+    return _cairo_pattern_equal (a, b);
+}
+
+static cairo_bool_t
+_stroke_style_equal (const cairo_stroke_style_t *a,
+		     const cairo_stroke_style_t *b)
+{
+    return a->line_width == b->line_width &&
+	   a->line_cap == b->line_cap &&
+	   a->line_join == b->line_join &&
+	   a->miter_limit == b->miter_limit &&
+	   a->num_dashes == b->num_dashes &&
+	   memcmp (a->dash, b->dash, a->num_dashes * sizeof (double)) == 0 &&
+	   a->dash_offset == b->dash_offset;
+}
+
+static unsigned long
+_command_hash (const cairo_command_t *command)
+{
+    unsigned long hash = _CAIRO_HASH_INIT_VALUE;
+    unsigned long clip_hash;
+
+    hash = _cairo_hash_bytes (hash, &command->header.type,
+			      sizeof (command->header.type));
+    hash = _cairo_hash_bytes (hash, &command->header.op,
+			      sizeof (command->header.op));
+    hash = _cairo_hash_bytes (hash, &command->header.extents,
+			      sizeof (command->header.extents));
+    clip_hash = _cairo_clip_hash (command->header.clip);
+    hash = _cairo_hash_bytes (hash, &clip_hash, sizeof (clip_hash));
+
+    switch (command->header.type) {
+    case CAIRO_COMMAND_PAINT:
+	hash = _command_pattern_hash (hash, &command->paint.source.base);
+	break;
+
+    case CAIRO_COMMAND_MASK:
+	hash = _command_pattern_hash (hash, &command->mask.source.base);
+	hash = _command_pattern_hash (hash, &command->mask.mask.base);
+	break;
+
+    case CAIRO_COMMAND_STROKE:
+	hash = _command_pattern_hash (hash, &command->stroke.source.base);
+	hash ^= _cairo_path_fixed_hash (&command->stroke.path);
+	hash = _cairo_hash_bytes (hash, &command->stroke.style.line_width,
+				  sizeof (double));
+	hash = _cairo_hash_bytes (hash, command->stroke.style.dash,
+				  command->stroke.style.num_dashes * sizeof (double));
+	hash = _cairo_hash_bytes (hash, &command->stroke.ctm,
+				  sizeof (cairo_matrix_t));
+	break;
+
+    case CAIRO_COMMAND_FILL:
+	hash = _command_pattern_hash (hash, &command->fill.source.base);
+	hash ^= _cairo_path_fixed_hash (&command->fill.path);
+	hash = _cairo_hash_bytes (hash, &command->fill.fill_rule,
+				  sizeof (command->fill.fill_rule));
+	break;
+
+    case CAIRO_COMMAND_SHOW_TEXT_GLYPHS:
+	hash = _command_pattern_hash (hash, &command->show_text_glyphs.source.base);
+	hash = _cairo_hash_bytes (hash, &command->show_text_glyphs.scaled_font,
+				  sizeof (cairo_scaled_font_t *));
+	hash = _cairo_hash_bytes (hash, command->show_text_glyphs.glyphs,
+				  command->show_text_glyphs.num_glyphs * sizeof (cairo_glyph_t));
+	break;
+    }
+
+    return hash;
+}
+
+/* Whether two commands render identically given identical targets. The
+ * text and clusters of show-text-glyphs are not compared as they only
+ * annotate the glyphs.
+ */
+static cairo_bool_t
+_command_equal (const cairo_command_t *a, const cairo_command_t *b)
+{
+    if (a->header.type != b->header.type ||
+	a->header.op != b->header.op ||
+	memcmp (&a->header.extents, &b->header.extents,
+		sizeof (cairo_rectangle_int_t)) ||
+	! _cairo_clip_equal (a->header.clip, b->header.clip))
+    {
+	return FALSE;
+    }
+
+    switch (a->header.type) {
+    case CAIRO_COMMAND_PAINT:
+	return _command_pattern_equal (&a->paint.source.base,
+				       &b->paint.source.base);
+
+    case CAIRO_COMMAND_MASK:
+	return _command_pattern_equal (&a->mask.source.base,
+				       &b->mask.source.base) &&
+	       _command_pattern_equal (&a->mask.mask.base,
+				       &b->mask.mask.base);
+
+    case CAIRO_COMMAND_STROKE:
+	return a->stroke.tolerance == b->stroke.tolerance &&
+	       a->stroke.antialias == b->stroke.antialias &&
+	       memcmp (&a->stroke.ctm, &b->stroke.ctm,
+		       sizeof (cairo_matrix_t)) == 0 &&
+	       _stroke_style_equal (&a->stroke.style, &b->stroke.style) &&
+	       _command_pattern_equal (&a->stroke.source.base,
+				       &b->stroke.source.base) &&
+	       _cairo_path_fixed_equal (&a->stroke.path, &b->stroke.path);
+
+    case CAIRO_COMMAND_FILL:
+	return a->fill.fill_rule == b->fill.fill_rule &&
+	       a->fill.tolerance == b->fill.tolerance &&
+	       a->fill.antialias == b->fill.antialias &&
+	       _command_pattern_equal (&a->fill.source.base,
+				       &b->fill.source.base) &&
+	       _cairo_path_fixed_equal (&a->fill.path, &b->fill.path);
+
+    case CAIRO_COMMAND_SHOW_TEXT_GLYPHS:
+	return a->show_text_glyphs.scaled_font == b->show_text_glyphs.scaled_font &&
+	       a->show_text_glyphs.num_glyphs == b->show_text_glyphs.num_glyphs &&
+	       memcmp (a->show_text_glyphs.glyphs, b->show_text_glyphs.glyphs,
+		       a->show_text_glyphs.num_glyphs * sizeof (cairo_glyph_t)) == 0 &&
+	       _command_pattern_equal (&a->show_text_glyphs.source.base,
+				       &b->show_text_glyphs.source.base);
+    }
+
+    ASSERT_NOT_REACHED;
+    return FALSE;
+}
+
+typedef struct _cairo_recording_diff {
+    cairo_command_t **a, **b;
+    unsigned long *hash_a, *hash_b;
+    cairo_array_t damage;
+} cairo_recording_diff_t;
+
+static cairo_bool_t
+_diff_equal (const cairo_recording_diff_t *diff, int i, int j)
+{
+    return diff->hash_a[i] == diff->hash_b[j] &&
+	   _command_equal (diff->a[i], diff->b[j]);
+}
+
+static cairo_status_t
+_diff_add (cairo_recording_diff_t *diff, const cairo_command_t *command)
+{
+    return _cairo_array_append (&diff->damage, &command->header.extents);
+}
+
+/* Aligns the commands of both surfaces with the greedy shortest edit
+ * script of Myers, "An O(ND) Difference Algorithm and Its Variations",
+ * and adds the extents of every command left unpaired. A pixel outside
+ * all of those extents sees the same sequence of commands, in the same
+ * order, from both surfaces.
+ */
+static cairo_status_t
+_diff_commands (cairo_recording_diff_t *diff, int n, int m)
+{
+    int *trace, *v;
+    const int *prev;
+    int max_d, d, k, x, y;
+    cairo_status_t status;
+
+    max_d = MIN (n + m, DIFF_MAX_EDITS);
+    trace = _cairo_malloc_ab (max_d + 1, (max_d + 1) * sizeof (int));
+    if (unlikely (trace == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    /* v[k + d] holds the furthest x reached along diagonal k = x - y
+     * with d edits, and the values for each d are kept for the
+     * backtrace. */
+    for (d = 0; d <= max_d; d++) {
+	v = trace + d * d;
+	prev = trace + (d - 1) * (d - 1) + d - 1;
+
+	for (k = -d; k <= d; k += 2) {
+	    if (d == 0)
+		x = 0;
+	    else if (k == -d || (k != d && prev[k - 1] < prev[k + 1]))
+		x = prev[k + 1];
+	    else
+		x = prev[k - 1] + 1;
+	    y = x - k;
+
+	    while (x < n && y < m && _diff_equal (diff, x, y))
+		x++, y++;
+
+	    v[k + d] = x;
+	    if (x >= n && y >= m)
+		goto FOUND;
+	}
+    }
+
+    /* Too many differences: treat everything as changed */
+    status = CAIRO_STATUS_SUCCESS;
+    for (x = 0; x < n && status == CAIRO_STATUS_SUCCESS; x++)
+	status = _diff_add (diff, diff->a[x]);
+    for (y = 0; y < m && status == CAIRO_STATUS_SUCCESS; y++)
+	status = _diff_add (diff, diff->b[y]);
+    free (trace);
+    return status;
+
+FOUND:
+    status = CAIRO_STATUS_SUCCESS;
+    x = n;
+    y = m;
+    for (; d > 0 && status == CAIRO_STATUS_SUCCESS; d--) {
+	prev = trace + (d - 1) * (d - 1) + d - 1;
+	k = x - y;
+
+	if (k == -d || (k != d && prev[k - 1] < prev[k + 1])) {
+	    /* a command only in the second surface */
+	    x = prev[k + 1];
+	    y = x - (k + 1);
+	    status = _diff_add (diff, diff->b[y]);
+	} else {
+	    /* a command only in the first surface */
+	    x = prev[k - 1];
+	    y = x - (k - 1);
+	    status = _diff_add (diff, diff->a[x]);
+	}
+    }
+
+    free (trace);
+    return status;
+}
+
+/**
+ * cairo_recording_surface_diff:
+ * @surface: a #cairo_recording_surface_t
+ * @other: another #cairo_recording_surface_t
+ *
+ * Compares the operations recorded by two recording-surfaces and
+ * returns the region, in device space, outside of which replaying
+ * either of them produces the same pixels. For a retained scene that
+ * is recorded afresh for each frame, only this region of the previous
+ * frame needs to be repainted from the new recording.
+ *
+ * The operations are paired up in order, and those left over mark
+ * their extents as changed. Operations are compared by their paths,
+ * patterns, clips and other parameters rather than by rendering them,
+ * so the region may be larger than the pixels that actually differ:
+ * for example, raster-source patterns are always taken to differ, and
+ * surface patterns only match if they refer to the same snapshot of an
+ * unmodified surface.
+ *
+ * Return value: A newly allocated #cairo_region_t. Free with
+ * cairo_region_destroy(). This function always returns a valid
+ * pointer; if memory cannot be allocated, or either surface is in an
+ * error state or not a recording-surface, then a special error object
+ * is returned where all operations on the object do nothing. You can
+ * check for this with cairo_region_status(), which gives
+ * %CAIRO_STATUS_SURFACE_TYPE_MISMATCH if either surface is not a
+ * recording-surface.
+ *
+ * Since: 1.14
+ **/
+cairo_region_t *
+cairo_recording_surface_diff (cairo_surface_t *surface,
+			      cairo_surface_t *other)
+{
+    cairo_recording_surface_t *a, *b;
+    cairo_recording_diff_t diff;
+    cairo_region_t *region;
+    cairo_status_t status;
+    int n, m, head, i;
+
+    if (surface->status)
+	return _cairo_region_create_in_error (surface->status);
+    if (other->status)
+	return _cairo_region_create_in_error (other->status);
+
+    if (! _cairo_surface_is_recording (surface) ||
+	! _cairo_surface_is_recording (other))
+    {
+	return _cairo_region_create_in_error (_cairo_error (CAIRO_STATUS_SURFACE_TYPE_MISMATCH));
+    }
+
+    if (surface->finished || other->finished)
+	return _cairo_region_create_in_error (_cairo_error (CAIRO_STATUS_SURFACE_FINISHED));
+
+    a = (cairo_recording_surface_t *) surface;
+    b = (cairo_recording_surface_t *) other;
+    n = a->commands.num_elements;
+    m = b->commands.num_elements;
+
+    diff.a = _cairo_array_index (&a->commands, 0);
+    diff.b = _cairo_array_index (&b->commands, 0);
+    diff.hash_a = diff.hash_b = NULL;
+    _cairo_array_init (&diff.damage, sizeof (cairo_rectangle_int_t));
+
+    /* Successive frames mostly differ in a few places, so strip the
+     * common head and tail before the full comparison. */
+    for (head = 0; head < n && head < m; head++) {
+	if (! _command_equal (diff.a[head], diff.b[head]))
+	    break;
+    }
+    diff.a += head, n -= head;
+    diff.b += head, m -= head;
+
+    while (n > 0 && m > 0 && _command_equal (diff.a[n - 1], diff.b[m - 1]))
+	n--, m--;
+
+    status = CAIRO_STATUS_SUCCESS;
+    if (n == 0 || m == 0) {
+	for (i = 0; i < n && status == CAIRO_STATUS_SUCCESS; i++)
+	    status = _diff_add (&diff, diff.a[i]);
+	for (i = 0; i < m && status == CAIRO_STATUS_SUCCESS; i++)
+	    status = _diff_add (&diff, diff.b[i]);
+    } else {
+	diff.hash_a = _cairo_malloc_ab (n + m, sizeof (unsigned long));
+	if (unlikely (diff.hash_a == NULL)) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	} else {
+	    diff.hash_b = diff.hash_a + n;
+	    for (i = 0; i < n; i++)
+		diff.hash_a[i] = _command_hash (diff.a[i]);
+	    for (i = 0; i < m; i++)
+		diff.hash_b[i] = _command_hash (diff.b[i]);
+
+	    status = _diff_commands (&diff, n, m);
+	    free (diff.hash_a);
+	}
+    }
+
+    if (unlikely (status))
+	region = _cairo_region_create_in_error (status);
+    else
+	region = cairo_region_create_rectangles (_cairo_array_index (&diff.damage, 0),
+						 diff.damage.num_elements);
+    _cairo_array_fini (&diff.damage);
+
+    return region;
+}
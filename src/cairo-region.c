@@ -59,6 +59,11 @@ static const cairo_region_t _cairo_region_nil = {
     CAIRO_STATUS_NO_MEMORY,		/* status */
 };
 
+static const cairo_region_t _cairo_region_nil_surface_type_mismatch = {
+    CAIRO_REFERENCE_COUNT_INVALID,	/* ref_count */
+    CAIRO_STATUS_SURFACE_TYPE_MISMATCH,	/* status */
+};
+
 cairo_region_t *
 _cairo_region_create_in_error (cairo_status_t status)
 {
@@ -66,11 +71,13 @@ _cairo_region_create_in_error (cairo_status_t status)
     case CAIRO_STATUS_NO_MEMORY:
 	return (cairo_region_t *) &_cairo_region_nil;
 
+    case CAIRO_STATUS_SURFACE_TYPE_MISMATCH:
+	return (cairo_region_t *) &_cairo_region_nil_surface_type_mismatch;
+
     case CAIRO_STATUS_SUCCESS:
     case CAIRO_STATUS_LAST_STATUS:
 	ASSERT_NOT_REACHED;
 	/* fall-through */
-    case CAIRO_STATUS_SURFACE_TYPE_MISMATCH:
     case CAIRO_STATUS_INVALID_STATUS:
     case CAIRO_STATUS_INVALID_CONTENT:
     case CAIRO_STATUS_INVALID_FORMAT:
@@ -0,0 +1,768 @@
+/* cairo - a vector graphics library with display and print output
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ */
+
+/* Circles, ellipses and rounded rectangles are by far the most common
+ * curved shapes to be filled. Rather than flattening their curves into
+ * a polygon and sweeping that, we recognise the shape from the path
+ * and compute the coverage of each row directly: the interior of a
+ * row is a single solid span bounded by the chords of the shape at
+ * the top and bottom of the row, and only the pixels along the edge
+ * need their coverage evaluated. For those we take the area of the
+ * pixel behind the tangent to the shape nearest its centre, which is
+ * exact for straight edges and, for the radii we accept, well within
+ * the tolerance of the polygon we would otherwise have rasterised.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-error-private.h"
+#include "cairo-path-fixed-private.h"
+#include "cairo-spans-private.h"
+
+/* We only recognise single sub-paths of modest length... */
+#define MAX_SEGMENTS 64
+/* ...and shapes whose curves are not so tight that the tangent is a
+ * poor approximation across a pixel. */
+#define MIN_RADIUS 4.
+
+typedef struct _segment {
+    cairo_point_double_t p[4];
+    cairo_bool_t is_curve;
+} segment_t;
+
+typedef struct _shape_path {
+    segment_t segments[MAX_SEGMENTS];
+    int num_segments;
+    cairo_bool_t has_move_to;
+    cairo_bool_t closed;
+    cairo_point_double_t first, current;
+} shape_path_t;
+
+static cairo_status_t
+_shape_path_move_to (void *closure, const cairo_point_t *point)
+{
+    shape_path_t *path = closure;
+
+    if (path->has_move_to)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    path->has_move_to = TRUE;
+    path->first.x = path->current.x = _cairo_fixed_to_double (point->x);
+    path->first.y = path->current.y = _cairo_fixed_to_double (point->y);
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_shape_path_line_to (void *closure, const cairo_point_t *point)
+{
+    shape_path_t *path = closure;
+    segment_t *s;
+    double x, y;
+
+    if (path->closed)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    x = _cairo_fixed_to_double (point->x);
+    y = _cairo_fixed_to_double (point->y);
+    if (x == path->current.x && y == path->current.y)
+	return CAIRO_STATUS_SUCCESS;
+
+    if (path->num_segments == MAX_SEGMENTS)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    s = &path->segments[path->num_segments++];
+    s->is_curve = FALSE;
+    s->p[0] = path->current;
+    s->p[3].x = x;
+    s->p[3].y = y;
+
+    path->current = s->p[3];
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_shape_path_curve_to (void *closure,
+		      const cairo_point_t *b,
+		      const cairo_point_t *c,
+		      const cairo_point_t *d)
+{
+    shape_path_t *path = closure;
+    segment_t *s;
+
+    if (path->closed || path->num_segments == MAX_SEGMENTS)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    s = &path->segments[path->num_segments++];
+    s->is_curve = TRUE;
+    s->p[0] = path->current;
+    s->p[1].x = _cairo_fixed_to_double (b->x);
+    s->p[1].y = _cairo_fixed_to_double (b->y);
+    s->p[2].x = _cairo_fixed_to_double (c->x);
+    s->p[2].y = _cairo_fixed_to_double (c->y);
+    s->p[3].x = _cairo_fixed_to_double (d->x);
+    s->p[3].y = _cairo_fixed_to_double (d->y);
+
+    path->current = s->p[3];
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_shape_path_close_path (void *closure)
+{
+    shape_path_t *path = closure;
+    cairo_point_t first;
+    cairo_status_t status;
+
+    if (path->closed)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    first.x = _cairo_fixed_from_double (path->first.x);
+    first.y = _cairo_fixed_from_double (path->first.y);
+    status = _shape_path_line_to (path, &first);
+    path->closed = TRUE;
+
+    return status;
+}
+
+static void
+_segment_point (const segment_t *s, double t, double *x, double *y)
+{
+    if (s->is_curve) {
+	double t1 = 1 - t;
+	double w0 = t1 * t1 * t1;
+	double w1 = 3 * t * t1 * t1;
+	double w2 = 3 * t * t * t1;
+	double w3 = t * t * t;
+
+	*x = w0 * s->p[0].x + w1 * s->p[1].x + w2 * s->p[2].x + w3 * s->p[3].x;
+	*y = w0 * s->p[0].y + w1 * s->p[1].y + w2 * s->p[2].y + w3 * s->p[3].y;
+    } else {
+	*x = s->p[0].x + t * (s->p[3].x - s->p[0].x);
+	*y = s->p[0].y + t * (s->p[3].y - s->p[0].y);
+    }
+}
+
+/* Signed distance in device space from (x, y) to the edge of the
+ * shape, negative inside, along with the normal of the edge. */
+static double
+_shape_distance (const cairo_shape_scan_converter_t *self,
+		 double x, double y,
+		 double *nx_out, double *ny_out)
+{
+    const cairo_matrix_t *m = &self->to_shape;
+    double qx, qy, kx, ky, nx, ny, gx, gy, g, d;
+
+    qx = m->xx * x + m->xy * y + m->x0;
+    qy = m->yx * x + m->yy * y + m->y0;
+
+    kx = fabs (qx) - self->rw;
+    ky = fabs (qy) - self->rh;
+    if (kx > 0 && ky > 0) {
+	double l = sqrt (kx * kx + ky * ky);
+	d = l - 1;
+	nx = kx / l;
+	ny = ky / l;
+    } else if (kx > ky) {
+	d = kx - 1;
+	nx = 1;
+	ny = 0;
+    } else {
+	d = ky - 1;
+	nx = 0;
+	ny = 1;
+    }
+    if (qx < 0)
+	nx = -nx;
+    if (qy < 0)
+	ny = -ny;
+
+    /* the gradient of the distance in shape space, back into device space */
+    gx = m->xx * nx + m->yx * ny;
+    gy = m->xy * nx + m->yy * ny;
+    g = sqrt (gx * gx + gy * gy);
+
+    *nx_out = gx / g;
+    *ny_out = gy / g;
+    return d / g;
+}
+
+static cairo_bool_t
+_fit_rounded_rectangle (cairo_shape_scan_converter_t *self,
+			const shape_path_t *path,
+			const cairo_box_t *box)
+{
+    double x1 = _cairo_fixed_to_double (box->p1.x);
+    double y1 = _cairo_fixed_to_double (box->p1.y);
+    double x2 = _cairo_fixed_to_double (box->p2.x);
+    double y2 = _cairo_fixed_to_double (box->p2.y);
+    double lh = 0, lv = 0, rx, ry;
+    int n;
+
+    /* the straight edges of the rectangle between its corners */
+    for (n = 0; n < path->num_segments; n++) {
+	const segment_t *s = &path->segments[n];
+
+	if (s->is_curve)
+	    continue;
+
+	if (s->p[0].y == s->p[3].y) {
+	    if (s->p[0].y != y1 && s->p[0].y != y2)
+		return FALSE;
+	    lh = MAX (lh, fabs (s->p[3].x - s->p[0].x));
+	} else if (s->p[0].x == s->p[3].x) {
+	    if (s->p[0].x != x1 && s->p[0].x != x2)
+		return FALSE;
+	    lv = MAX (lv, fabs (s->p[3].y - s->p[0].y));
+	} else
+	    return FALSE;
+    }
+
+    rx = (x2 - x1 - lh) / 2;
+    ry = (y2 - y1 - lv) / 2;
+    if (rx < MIN_RADIUS || ry < MIN_RADIUS)
+	return FALSE;
+
+    cairo_matrix_init (&self->to_shape,
+		       1 / rx, 0,
+		       0, 1 / ry,
+		       -(x1 + x2) / (2 * rx), -(y1 + y2) / (2 * ry));
+    self->rw = lh / (2 * rx);
+    self->rh = lv / (2 * ry);
+    return TRUE;
+}
+
+/* Fit an ellipse, a x² + 2b xy + c y² = 1, about the centre of the
+ * extents through points along the curves. */
+static cairo_bool_t
+_fit_ellipse (cairo_shape_scan_converter_t *self,
+	      const shape_path_t *path,
+	      const cairo_box_t *box)
+{
+    double cx = _cairo_fixed_to_double (box->p1.x + box->p2.x) / 2;
+    double cy = _cairo_fixed_to_double (box->p1.y + box->p2.y) / 2;
+    double N[3][3] = { { 0 } }, v[3] = { 0 };
+    double det, a, b, c, sa, major;
+    int n, i, j;
+
+    for (n = 0; n < path->num_segments; n++) {
+	const segment_t *s = &path->segments[n];
+	double t;
+
+	if (! s->is_curve)
+	    return FALSE;
+
+	for (t = 0; t < 1; t += .5) {
+	    double x, y, r[3];
+
+	    _segment_point (s, t, &x, &y);
+	    x -= cx;
+	    y -= cy;
+
+	    r[0] = x * x;
+	    r[1] = 2 * x * y;
+	    r[2] = y * y;
+	    for (i = 0; i < 3; i++) {
+		for (j = 0; j < 3; j++)
+		    N[i][j] += r[i] * r[j];
+		v[i] += r[i];
+	    }
+	}
+    }
+
+#define DET3(m) \
+    ((m)[0][0] * ((m)[1][1] * (m)[2][2] - (m)[1][2] * (m)[2][1]) - \
+     (m)[0][1] * ((m)[1][0] * (m)[2][2] - (m)[1][2] * (m)[2][0]) + \
+     (m)[0][2] * ((m)[1][0] * (m)[2][1] - (m)[1][1] * (m)[2][0]))
+
+    det = DET3 (N);
+    if (fabs (det) < 1e-30)
+	return FALSE;
+
+    {
+	double M[3][3];
+	double s[3];
+
+	for (i = 0; i < 3; i++) {
+	    memcpy (M, N, sizeof (M));
+	    for (j = 0; j < 3; j++)
+		M[j][i] = v[j];
+	    s[i] = DET3 (M) / det;
+	}
+	a = s[0];
+	b = s[1];
+	c = s[2];
+    }
+#undef DET3
+
+    if (a <= 0 || a * c - b * b <= 0)
+	return FALSE;
+
+    /* the semi-minor axis is given by the larger eigenvalue */
+    major = (a + c) / 2 + hypot ((a - c) / 2, b);
+    if (1 / sqrt (major) < MIN_RADIUS)
+	return FALSE;
+
+    /* to_shape is the square root of the quadratic form */
+    sa = sqrt (a);
+    cairo_matrix_init (&self->to_shape,
+		       sa, 0,
+		       b / sa, sqrt (c - b * b / a),
+		       0, 0);
+    self->to_shape.x0 = -(self->to_shape.xx * cx + self->to_shape.xy * cy);
+    self->to_shape.y0 = -(self->to_shape.yx * cx + self->to_shape.yy * cy);
+    self->rw = self->rh = 0;
+    return TRUE;
+}
+
+/* Check that the path follows the edge of the shape, within tolerance,
+ * once around. */
+static cairo_bool_t
+_verify_shape (const cairo_shape_scan_converter_t *self,
+	       const shape_path_t *path,
+	       const cairo_box_t *box,
+	       double tolerance)
+{
+    double cx = _cairo_fixed_to_double (box->p1.x + box->p2.x) / 2;
+    double cy = _cairo_fixed_to_double (box->p1.y + box->p2.y) / 2;
+    double angle, total = 0, nx, ny;
+    int n;
+
+    /* allow for the rounding of the path to fixed point */
+    tolerance += 2. / CAIRO_FIXED_ONE;
+
+    angle = atan2 (path->first.y - cy, path->first.x - cx);
+    for (n = 0; n < path->num_segments; n++) {
+	const segment_t *s = &path->segments[n];
+	double t;
+
+	for (t = .25; t <= 1; t += .25) {
+	    double x, y, next, delta;
+
+	    _segment_point (s, t, &x, &y);
+	    if (fabs (_shape_distance (self, x, y, &nx, &ny)) > tolerance)
+		return FALSE;
+
+	    next = atan2 (y - cy, x - cx);
+	    delta = next - angle;
+	    if (delta > M_PI)
+		delta -= 2 * M_PI;
+	    else if (delta <= -M_PI)
+		delta += 2 * M_PI;
+
+	    /* never doubling back */
+	    if (delta * total < 0)
+		return FALSE;
+
+	    total += delta;
+	    angle = next;
+	}
+    }
+
+    return fabs (fabs (total) - 2 * M_PI) < 1e-3;
+}
+
+/* Find the points of the shape furthest in the direction (ex, ey). */
+static void
+_shape_extreme (cairo_shape_scan_converter_t *self,
+		const cairo_matrix_t *from_shape,
+		double ex, double ey,
+		double *x1, double *y1, double *x2, double *y2)
+{
+    double gx, gy, g, best;
+    int i;
+
+    gx = ex * from_shape->xx + ey * from_shape->yx;
+    gy = ex * from_shape->xy + ey * from_shape->yy;
+    g = hypot (gx, gy);
+
+    best = fabs (gx) * self->rw + fabs (gy) * self->rh;
+
+    *x1 = *y1 = HUGE_VAL;
+    *x2 = *y2 = -HUGE_VAL;
+    for (i = 0; i < 4; i++) {
+	double sx = i & 1 ? self->rw : -self->rw;
+	double sy = i & 2 ? self->rh : -self->rh;
+	double x, y;
+
+	if (gx * sx + gy * sy < best - 1e-9)
+	    continue;
+
+	x = sx + gx / g;
+	y = sy + gy / g;
+	cairo_matrix_transform_point (from_shape, &x, &y);
+
+	*x1 = MIN (*x1, x);
+	*x2 = MAX (*x2, x);
+	*y1 = MIN (*y1, y);
+	*y2 = MAX (*y2, y);
+    }
+}
+
+/* The span of the shape along the horizontal line through y. Both
+ * fits leave to_shape upper triangular, so the line stays horizontal
+ * in shape space, where the shape is the union of two rectangles and
+ * four discs about the corners. */
+static cairo_bool_t
+_shape_chord (const cairo_shape_scan_converter_t *self,
+	      double y, double *x1, double *x2)
+{
+    const cairo_matrix_t *m = &self->to_shape;
+    double qx, qy, w;
+
+    qy = fabs (m->yy * y + m->y0) - self->rh;
+    if (qy > 1)
+	return FALSE;
+
+    w = self->rw + 1;
+    if (qy > 0)
+	w = self->rw + sqrt (1 - qy * qy);
+
+    qx = m->xy * y + m->x0;
+    *x1 = (-w - qx) / m->xx;
+    *x2 = (w - qx) / m->xx;
+    return TRUE;
+}
+
+/* The area of the unit square about the origin where a·x + b·y <= t,
+ * for a >= b >= 0 and a² + b² = 1. */
+static double
+_half_plane_coverage (double t, double a, double b)
+{
+    double w = (a + b) / 2;
+
+    if (t <= -w)
+	return 0;
+    if (t >= w)
+	return 1;
+
+    if (b > 1e-6) {
+	double lo = (a - b) / 2;
+
+	if (t < -lo) {
+	    t += w;
+	    return t * t / (2 * a * b);
+	}
+	if (t > lo) {
+	    t = w - t;
+	    return 1 - t * t / (2 * a * b);
+	}
+    }
+
+    return .5 + t / a;
+}
+
+static int
+_shape_coverage (const cairo_shape_scan_converter_t *self, int x, int y)
+{
+    double nx, ny, d, a, b;
+
+    d = _shape_distance (self, x + .5, y + .5, &nx, &ny);
+
+    a = fabs (nx);
+    b = fabs (ny);
+    if (a < b) {
+	double t = a;
+	a = b;
+	b = t;
+    }
+
+    return _half_plane_coverage (-d, a, b) * 255 + .5;
+}
+
+/* Where it runs steeply down a row, the edge of the shape is near
+ * enough straight for the coverage of each pixel to be taken from the
+ * trapezoid between the chords above and below. */
+static int
+_trapezoid_coverage (double l1, double l2,
+		     double r1, double r2,
+		     int x)
+{
+    double c;
+
+    c  = _cairo_spans_ramp (l1, l2, x + 1) - _cairo_spans_ramp (l1, l2, x);
+    c -= _cairo_spans_ramp (r1, r2, x + 1) - _cairo_spans_ramp (r1, r2, x);
+    if (c <= 0)
+	return 0;
+    if (c >= 1)
+	return 255;
+    return c * 255 + .5;
+}
+
+typedef struct _chord {
+    cairo_bool_t valid;
+    double x1, x2;
+} chord_t;
+
+static int
+_shape_row (const cairo_shape_scan_converter_t *self,
+	    int y,
+	    const chord_t *upper,
+	    const chord_t *lower,
+	    cairo_half_open_span_t *spans)
+{
+    double x1, x2, l1, l2, r1, r2;
+    cairo_bool_t trapezoid;
+    int px1, px2, f1, f2, x, n, coverage;
+
+    /* the chords are extremal across the row unless it also contains
+     * one of the extreme points of the shape */
+    x1 = HUGE_VAL;
+    x2 = -HUGE_VAL;
+    if (upper->valid) {
+	x1 = MIN (x1, upper->x1);
+	x2 = MAX (x2, upper->x2);
+    }
+    if (lower->valid) {
+	x1 = MIN (x1, lower->x1);
+	x2 = MAX (x2, lower->x2);
+    }
+    trapezoid = upper->valid && lower->valid;
+#define INSIDE(v) ((v) >= y && (v) <= y + 1)
+#define EXTREME(e) \
+    if (self->e.y2 >= y && self->e.y1 <= y + 1) { \
+	x1 = MIN (x1, self->e.x1); \
+	x2 = MAX (x2, self->e.x2); \
+	if (INSIDE (self->e.y1) || INSIDE (self->e.y2)) \
+	    trapezoid = FALSE; \
+    }
+    EXTREME (left);
+    EXTREME (right);
+    EXTREME (top);
+    EXTREME (bottom);
+#undef EXTREME
+#undef INSIDE
+    if (x1 > x2)
+	return 0;
+
+    px1 = MAX (floor (x1), self->xmin);
+    px2 = MIN (ceil (x2), self->xmax);
+    if (px1 >= px2)
+	return 0;
+
+    /* only pixels with all four corners inside the shape are covered */
+    f1 = f2 = px2;
+    if (upper->valid && lower->valid) {
+	f1 = MAX (ceil (MAX (upper->x1, lower->x1)), px1);
+	f2 = MIN (floor (MIN (upper->x2, lower->x2)), px2);
+	if (f1 >= f2)
+	    f1 = f2 = px2;
+    }
+
+    l1 = MIN (upper->x1, lower->x1);
+    l2 = MAX (upper->x1, lower->x1);
+    r1 = MIN (upper->x2, lower->x2);
+    r2 = MAX (upper->x2, lower->x2);
+
+    /* but only where the edge is steep, lest it sag away from the chord */
+    if (l2 - l1 > 1 || r2 - r1 > 1)
+	trapezoid = FALSE;
+
+    n = 0;
+#define ADD_SPAN(X, C) do { \
+    int c__ = (C); \
+    if (n == 0 || spans[n-1].coverage != c__) { \
+	spans[n].x = (X); \
+	spans[n].coverage = c__; \
+	n++; \
+    } \
+} while (0)
+    for (x = px1; x < px2; x++) {
+	if (x == f1 && f2 > f1) {
+	    ADD_SPAN (x, 255);
+	    x = f2 - 1;
+	    continue;
+	}
+
+	if (trapezoid)
+	    coverage = _trapezoid_coverage (l1, l2, r1, r2, x);
+	else
+	    coverage = _shape_coverage (self, x, y);
+	ADD_SPAN (x, coverage);
+
+	/* along the straight edges every pixel is covered alike */
+	if (x >= self->flat_x1 && x < self->flat_x2 - 1) {
+	    int end = MIN (self->flat_x2, px2);
+
+	    if (f2 > f1 && x < f1)
+		end = MIN (end, f1);
+	    x = end - 1;
+	}
+    }
+#undef ADD_SPAN
+
+    spans[n].x = px2;
+    spans[n].coverage = 0;
+    return n + 1;
+}
+
+static cairo_status_t
+_cairo_shape_scan_converter_generate (void			*converter,
+				      cairo_span_renderer_t	*renderer)
+{
+    cairo_shape_scan_converter_t *self = converter;
+    cairo_half_open_span_t spans_stack[CAIRO_STACK_ARRAY_LENGTH (cairo_half_open_span_t)];
+    cairo_half_open_span_t *spans;
+    chord_t chord[2];
+    cairo_status_t status;
+    int y, y1, y2;
+
+    y1 = MAX (floor (self->top.y1), self->ymin);
+    y2 = MIN (ceil (self->bottom.y2), self->ymax);
+    if (y1 >= y2) {
+	return renderer->render_rows (renderer,
+				      self->ymin, self->ymax - self->ymin,
+				      NULL, 0);
+    }
+
+    spans = spans_stack;
+    if (self->xmax - self->xmin + 2 > ARRAY_LENGTH (spans_stack)) {
+	spans = _cairo_malloc_ab (self->xmax - self->xmin + 2,
+				  sizeof (cairo_half_open_span_t));
+	if (unlikely (spans == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    status = CAIRO_STATUS_SUCCESS;
+    if (y1 > self->ymin)
+	status = renderer->render_rows (renderer,
+					self->ymin, y1 - self->ymin,
+					NULL, 0);
+
+    chord[y1 & 1].valid = _shape_chord (self, y1,
+					&chord[y1 & 1].x1, &chord[y1 & 1].x2);
+    for (y = y1; status == CAIRO_STATUS_SUCCESS && y < y2; y++) {
+	chord_t *upper = &chord[y & 1], *lower = &chord[~y & 1];
+
+	lower->valid = _shape_chord (self, y + 1, &lower->x1, &lower->x2);
+	status = renderer->render_rows (renderer, y, 1,
+					spans,
+					_shape_row (self, y, upper, lower, spans));
+    }
+
+    if (status == CAIRO_STATUS_SUCCESS && y2 < self->ymax)
+	status = renderer->render_rows (renderer,
+					y2, self->ymax - y2,
+					NULL, 0);
+
+    if (spans != spans_stack)
+	free (spans);
+
+    return status;
+}
+
+static void
+_cairo_shape_scan_converter_destroy (void *converter)
+{
+}
+
+cairo_bool_t
+_cairo_shape_scan_converter_init (cairo_shape_scan_converter_t *self,
+				  const cairo_rectangle_int_t *extents,
+				  const cairo_path_fixed_t *path,
+				  double tolerance)
+{
+    shape_path_t shape;
+    cairo_matrix_t from_shape;
+    cairo_box_t box;
+    cairo_status_t status;
+
+    if (! path->has_curve_to || ! _cairo_path_fixed_extents (path, &box))
+	return FALSE;
+
+    shape.num_segments = 0;
+    shape.has_move_to = FALSE;
+    shape.closed = FALSE;
+    status = _cairo_path_fixed_interpret (path,
+					  _shape_path_move_to,
+					  _shape_path_line_to,
+					  _shape_path_curve_to,
+					  _shape_path_close_path,
+					  &shape);
+    if (status)
+	return FALSE;
+
+    /* filling implicitly closes the path */
+    if (! shape.closed &&
+	(shape.current.x != shape.first.x || shape.current.y != shape.first.y))
+    {
+	segment_t *s;
+
+	if (shape.num_segments == MAX_SEGMENTS)
+	    return FALSE;
+
+	s = &shape.segments[shape.num_segments++];
+	s->is_curve = FALSE;
+	s->p[0] = shape.current;
+	s->p[3] = shape.first;
+    }
+
+    if (! _fit_rounded_rectangle (self, &shape, &box) ||
+	! _verify_shape (self, &shape, &box, tolerance))
+    {
+	if (! _fit_ellipse (self, &shape, &box) ||
+	    ! _verify_shape (self, &shape, &box, tolerance))
+	{
+	    return FALSE;
+	}
+    }
+
+    from_shape = self->to_shape;
+    if (cairo_matrix_invert (&from_shape))
+	return FALSE;
+
+    _shape_extreme (self, &from_shape, -1, 0,
+		    &self->left.x1, &self->left.y1,
+		    &self->left.x2, &self->left.y2);
+    _shape_extreme (self, &from_shape, 1, 0,
+		    &self->right.x1, &self->right.y1,
+		    &self->right.x2, &self->right.y2);
+    _shape_extreme (self, &from_shape, 0, -1,
+		    &self->top.x1, &self->top.y1,
+		    &self->top.x2, &self->top.y2);
+    _shape_extreme (self, &from_shape, 0, 1,
+		    &self->bottom.x1, &self->bottom.y1,
+		    &self->bottom.x2, &self->bottom.y2);
+
+    /* the columns lying wholly along the top and bottom edges */
+    self->flat_x1 = self->flat_x2 = 0;
+    if (self->rw > 0 && self->to_shape.xy == 0 && self->to_shape.yx == 0) {
+	self->flat_x1 = ceil ((-self->rw - self->to_shape.x0) / self->to_shape.xx);
+	self->flat_x2 = floor ((self->rw - self->to_shape.x0) / self->to_shape.xx);
+    }
+
+    self->xmin = extents->x;
+    self->ymin = extents->y;
+    self->xmax = extents->x + extents->width;
+    self->ymax = extents->y + extents->height;
+
+    self->base.destroy = _cairo_shape_scan_converter_destroy;
+    self->base.generate = _cairo_shape_scan_converter_generate;
+    self->base.status = CAIRO_STATUS_SUCCESS;
+
+    return TRUE;
+}
@@ -807,6 +807,45 @@ trim_extents_to_boxes (cairo_composite_rectangles_t *extents,
     return _cairo_composite_rectangles_intersect_mask_extents (extents, &box);
 }
 
+/* Under CAIRO_ANTIALIAS_BEST, circles, ellipses and rounded rectangles
+ * have their exact coverage computed directly from the path, skipping
+ * the polygon entirely. This avoids the bias of the inscribed polygon,
+ * so the edges differ slightly from the other antialias modes. */
+static cairo_int_status_t
+composite_shape (const cairo_spans_compositor_t	*compositor,
+		 cairo_composite_rectangles_t		*extents,
+		 const cairo_path_fixed_t		*path,
+		 double					 tolerance,
+		 cairo_antialias_t			 antialias)
+{
+    cairo_abstract_span_renderer_t renderer;
+    cairo_shape_scan_converter_t converter;
+    cairo_int_status_t status;
+
+    if (extents->clip->path != NULL ||
+	! _clip_is_region (extents->clip) ||
+	extents->clip->num_boxes > 1)
+    {
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+    }
+
+    if (! _cairo_shape_scan_converter_init (&converter, &extents->unbounded,
+					    path, tolerance))
+    {
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+    }
+
+    TRACE ((stderr, "%s\n", __FUNCTION__));
+
+    status = compositor->renderer_init (&renderer, extents, antialias, FALSE);
+    if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	status = converter.base.generate (&converter.base, &renderer.base);
+    compositor->renderer_fini (&renderer, status);
+
+    converter.base.destroy (&converter.base);
+    return status;
+}
+
 static cairo_int_status_t
 trim_extents_to_polygon (cairo_composite_rectangles_t *extents,
 			 cairo_polygon_t *polygon)
@@ -1117,6 +1156,12 @@ _cairo_spans_compositor_fill (const cairo_compositor_t		*_compositor,
 	    status = clip_and_composite_boxes (compositor, extents, &boxes);
 	_cairo_boxes_fini (&boxes);
     }
+    if (status == CAIRO_INT_STATUS_UNSUPPORTED &&
+	path->has_curve_to && antialias == CAIRO_ANTIALIAS_BEST)
+    {
+	status = composite_shape (compositor, extents,
+				  path, tolerance, antialias);
+    }
     if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
 	cairo_polygon_t polygon;
 
@@ -1139,7 +1184,13 @@ _cairo_spans_compositor_fill (const cairo_compositor_t		*_compositor,
 	    _cairo_polygon_init (&polygon, NULL, 0);
 	}
 
-	status = _cairo_path_fixed_fill_to_polygon (path, tolerance, &polygon);
+	if (antialias == CAIRO_ANTIALIAS_FAST)
+	    status = _cairo_path_fixed_fill_to_simplified_polygon (path,
+								   tolerance,
+								   &polygon);
+	else
+	    status = _cairo_path_fixed_fill_to_polygon (path, tolerance,
+							&polygon);
 	TRACE_ (_cairo_debug_print_polygon (stderr, &polygon));
 	polygon.num_limits = 0;
 
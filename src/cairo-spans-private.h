@@ -168,6 +168,47 @@ _cairo_botor_scan_converter_init (cairo_botor_scan_converter_t *self,
 				  const cairo_box_t *extents,
 				  cairo_fill_rule_t fill_rule);
 
+/* The shape is the set of points within a unit distance of the
+ * rectangle [-rw, rw] x [-rh, rh] after mapping device space through
+ * to_shape, which is kept upper triangular. That covers any ellipse
+ * (rw = rh = 0) and rounded rectangles, for which the coverage is
+ * computed analytically.
+ */
+typedef struct _cairo_shape_scan_converter {
+    cairo_scan_converter_t base;
+
+    int xmin, xmax;
+    int ymin, ymax;
+
+    cairo_matrix_t to_shape;
+    double rw, rh;
+    int flat_x1, flat_x2;
+
+    /* the extreme points of the shape in each direction */
+    struct {
+	double x1, y1, x2, y2;
+    } left, right, top, bottom;
+} cairo_shape_scan_converter_t;
+
+cairo_private cairo_bool_t
+_cairo_shape_scan_converter_init (cairo_shape_scan_converter_t *self,
+				  const cairo_rectangle_int_t *extents,
+				  const cairo_path_fixed_t *path,
+				  double tolerance);
+
+/* The mean of max (u - X, 0) for X uniform over [lo, hi]: the area
+ * swept behind an edge crossing a row between lo and hi, used by the
+ * shape converter to integrate coverage across a pixel. */
+static inline double
+_cairo_spans_ramp (double lo, double hi, double u)
+{
+    if (u <= lo)
+	return 0;
+    if (u >= hi)
+	return u - (lo + hi) / 2;
+    return (u - lo) * (u - lo) / (2 * (hi - lo));
+}
+
 /* cairo-spans.c: */
 
 cairo_private cairo_scan_converter_t *
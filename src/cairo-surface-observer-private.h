@@ -180,6 +180,8 @@ struct _cairo_device_observer {
     cairo_device_t *target;
 
     cairo_observation_t log;
+
+    cairo_list_t operation_callbacks;
 };
 
 struct callback_list {
@@ -189,6 +191,13 @@ struct callback_list {
     void *data;
 };
 
+struct operation_callback_list {
+    cairo_list_t link;
+
+    cairo_device_observer_operation_callback_t func;
+    void *data;
+};
+
 struct _cairo_surface_observer {
     cairo_surface_t base;
     cairo_surface_t *target;
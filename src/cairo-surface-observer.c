@@ -326,6 +326,12 @@ static void
 _cairo_device_observer_destroy (void *_device)
 {
     cairo_device_observer_t *device = (cairo_device_observer_t *) _device;
+    struct operation_callback_list *cb, *next;
+
+    cairo_list_foreach_entry_safe (cb, next, struct operation_callback_list,
+				   &device->operation_callbacks, link)
+	free (cb);
+
     cairo_device_destroy (device->target);
     free (device);
 }
@@ -360,6 +366,7 @@ _cairo_device_create_observer_internal (cairo_device_t *target,
     }
 
     device->target = cairo_device_reference (target);
+    cairo_list_init (&device->operation_callbacks);
 
     return &device->base;
 }
@@ -422,6 +429,18 @@ do_callbacks (cairo_surface_observer_t *surface, cairo_list_t *head)
 	cb->func (&surface->base, surface->target, cb->data);
 }
 
+static void
+_do_operation_callbacks (cairo_device_observer_t *device,
+			 const char *name);
+
+static inline void
+do_operation_callbacks (cairo_device_observer_t *device,
+			const char *name)
+{
+    if (! cairo_list_is_empty (&device->operation_callbacks))
+	_do_operation_callbacks (device, name);
+}
+
 
 static cairo_status_t
 _cairo_surface_observer_finish (void *abstract_surface)
@@ -756,6 +775,7 @@ _cairo_surface_observer_paint (void *abstract_surface,
 
     add_record_paint (&surface->log, surface->target, op, source, clip, t);
     add_record_paint (&device->log, surface->target, op, source, clip, t);
+    do_operation_callbacks (device, "paint");
 
     do_callbacks (surface, &surface->paint_callbacks);
 
@@ -847,6 +867,7 @@ _cairo_surface_observer_mask (void *abstract_surface,
 		     surface->target, op, source, mask, clip,
 		     t);
 
+    do_operation_callbacks (device, "mask");
     do_callbacks (surface, &surface->mask_callbacks);
 
     return CAIRO_STATUS_SUCCESS;
@@ -957,6 +978,7 @@ _cairo_surface_observer_fill (void			*abstract_surface,
 		     fill_rule, tolerance, antialias,
 		     clip, t);
 
+    do_operation_callbacks (device, "fill");
     do_callbacks (surface, &surface->fill_callbacks);
 
     return CAIRO_STATUS_SUCCESS;
@@ -1078,6 +1100,7 @@ _cairo_surface_observer_stroke (void				*abstract_surface,
 		       tolerance, antialias,
 		       clip, t);
 
+    do_operation_callbacks (device, "stroke");
     do_callbacks (surface, &surface->stroke_callbacks);
 
     return CAIRO_STATUS_SUCCESS;
@@ -1196,6 +1219,7 @@ _cairo_surface_observer_glyphs (void			*abstract_surface,
 		       glyphs, num_glyphs, scaled_font,
 		       clip, t);
 
+    do_operation_callbacks (device, "glyphs");
     do_callbacks (surface, &surface->glyphs_callbacks);
 
     return CAIRO_STATUS_SUCCESS;
@@ -1711,7 +1735,7 @@ print_pattern (cairo_output_stream_t *stream,
 static const char *path_names[] = {
     "empty",
     "pixel-aligned",
-    "rectliinear",
+    "rectilinear",
     "straight",
     "curved",
 };
@@ -1740,6 +1764,60 @@ print_clip (cairo_output_stream_t *stream, const struct clip *c)
     _cairo_output_stream_printf (stream, "\n");
 }
 
+static void
+_append_field (char **s, char *end, const char *key, const char *value)
+{
+    char *t = *s;
+    int len;
+
+    /* Keep the operation a list of space separated fields */
+    len = snprintf (t, end - t, " %s=", key);
+    if (len >= end - t)
+	return;
+
+    t += len;
+    while (*value && t < end - 1) {
+	*t++ = *value == ' ' ? '-' : *value;
+	value++;
+    }
+    *t = '\0';
+    *s = t;
+}
+
+static void
+_do_operation_callbacks (cairo_device_observer_t *device,
+			 const char *name)
+{
+    struct operation_callback_list *cb;
+    cairo_observation_record_t *r;
+    char buf[256], *s, *end;
+    int n;
+
+    n = _cairo_array_num_elements (&device->log.timings);
+    r = _cairo_array_index (&device->log.timings, n - 1);
+
+    s = buf;
+    end = buf + sizeof (buf);
+    s += snprintf (s, end - s, "%s", name);
+    _append_field (&s, end, "op", operator_names[r->op]);
+    _append_field (&s, end, "source", pattern_names[r->source]);
+    if (r->mask != -1)
+	_append_field (&s, end, "mask", pattern_names[r->mask]);
+    if (r->path != -1)
+	_append_field (&s, end, "path", path_names[r->path]);
+    if (r->fill_rule != -1)
+	_append_field (&s, end, "fill-rule", fill_rule_names[r->fill_rule]);
+    if (r->antialias != -1)
+	_append_field (&s, end, "antialias", antialias_names[r->antialias]);
+    _append_field (&s, end, "clip", clip_names[r->clip]);
+
+    cairo_list_foreach_entry (cb, struct operation_callback_list,
+			      &device->operation_callbacks, link)
+    {
+	cb->func (&device->base, buf, _cairo_time_to_ns (r->elapsed), cb->data);
+    }
+}
+
 static void
 print_record (cairo_output_stream_t *stream,
 	      cairo_observation_record_t *r)
@@ -2025,6 +2103,52 @@ cairo_device_observer_elapsed (cairo_device_t *abstract_device)
     return _cairo_time_to_ns (_cairo_observation_total_elapsed (&device->log));
 }
 
+/**
+ * cairo_device_observer_add_operation_callback:
+ * @device: an observer device, see cairo_surface_get_device()
+ * @func: the callback
+ * @data: closure passed to @func
+ *
+ * Registers @func to be called after every drawing operation on any
+ * surface sharing the observer @device, including those created as
+ * similar surfaces and for groups. The callback receives a one-line
+ * description of the operation, the operation name followed by
+ * space separated key=value fields classifying it (operator, source
+ * and mask pattern types, path class, fill rule, antialias and clip
+ * class), and the time spent in the operation in nanoseconds.
+ *
+ * Return value: %CAIRO_STATUS_SUCCESS, or
+ * %CAIRO_STATUS_DEVICE_TYPE_MISMATCH if @device is not an observer.
+ *
+ * Since: 1.14
+ **/
+cairo_status_t
+cairo_device_observer_add_operation_callback (cairo_device_t *abstract_device,
+					      cairo_device_observer_operation_callback_t func,
+					      void *data)
+{
+    cairo_device_observer_t *device;
+    struct operation_callback_list *cb;
+
+    if (unlikely (abstract_device->status))
+	return abstract_device->status;
+
+    if (unlikely (! _cairo_device_is_observer (abstract_device)))
+	return _cairo_error (CAIRO_STATUS_DEVICE_TYPE_MISMATCH);
+
+    device = (cairo_device_observer_t *) abstract_device;
+
+    cb = malloc (sizeof (*cb));
+    if (unlikely (cb == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    cairo_list_add (&cb->link, &device->operation_callbacks);
+    cb->func = func;
+    cb->data = data;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
 double
 cairo_device_observer_paint_elapsed (cairo_device_t *abstract_device)
 {
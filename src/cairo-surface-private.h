@@ -70,6 +70,9 @@ struct _cairo_surface {
     unsigned is_clear : 1;
     unsigned has_font_options : 1;
     unsigned owns_device : 1;
+    /* The damage has been tracked since the surface was last clear, so
+     * it bounds everything drawn upon it. */
+    unsigned damage_is_ink : 1;
 
     cairo_user_data_array_t user_data;
     cairo_user_data_array_t mime_data;
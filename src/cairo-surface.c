@@ -114,6 +114,7 @@ const cairo_surface_t name = {					\
     TRUE,				/* is_clear */		\
     FALSE,				/* has_font_options */	\
     FALSE,				/* owns_device */	\
+    FALSE,				/* damage_is_ink */	\
     { 0, 0, 0, NULL, },			/* user_data */		\
     { 0, 0, 0, NULL, },			/* mime_data */         \
     { 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 },   /* device_transform */	\
@@ -417,6 +418,7 @@ _cairo_surface_init (cairo_surface_t			*surface,
     surface->is_clear = FALSE;
     surface->serial = 0;
     surface->damage = NULL;
+    surface->damage_is_ink = FALSE;
     surface->owns_device = (device != NULL);
 
     _cairo_user_data_array_init (&surface->user_data);
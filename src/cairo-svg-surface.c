@@ -126,6 +126,13 @@ struct cairo_svg_page {
     cairo_output_stream_t *xml_node;
 };
 
+/* The number of glyphs of a font subset already written out. */
+typedef struct _cairo_svg_glyph_subset {
+    unsigned int font_id;
+    unsigned int subset_id;
+    unsigned int num_glyphs;
+} cairo_svg_glyph_subset_t;
+
 struct cairo_svg_document {
     cairo_output_stream_t *output_stream;
     unsigned long refcount;
@@ -147,6 +154,14 @@ struct cairo_svg_document {
 
     cairo_bool_t alpha_filter;
 
+    /* A page is written out once the page after it is finished, so at
+     * most two pages and their definitions are held in memory. Glyphs
+     * are written alongside the first page that needs them.
+     */
+    cairo_bool_t header_emitted;
+    cairo_bool_t in_page_set;
+    cairo_array_t glyph_subsets;
+
     cairo_svg_version_t svg_version;
 
     cairo_scaled_font_subsets_t *font_subsets;
@@ -165,6 +180,10 @@ _cairo_svg_document_destroy (cairo_svg_document_t *document);
 static cairo_status_t
 _cairo_svg_document_finish (cairo_svg_document_t *document);
 
+static cairo_status_t
+_cairo_svg_document_emit_page (cairo_svg_document_t *document,
+			       cairo_svg_page_t     *page);
+
 static cairo_svg_document_t *
 _cairo_svg_document_reference (cairo_svg_document_t *document);
 
@@ -573,6 +592,22 @@ _cairo_svg_surface_create_for_stream_internal (cairo_output_stream_t	*stream,
     return surface;
 }
 
+static cairo_bool_t
+_cairo_svg_surface_is_owner (cairo_svg_surface_t *surface)
+{
+    cairo_surface_t *owner = surface->document->owner;
+
+    return owner != NULL &&
+	_cairo_paginated_surface_get_target (owner) == &surface->base;
+}
+
+/* Only the most recent page of a surface is ever referenced again, so
+ * when a new page is stored the previous one is handed to the document
+ * to be written out (if it is part of the output at all) and released.
+ * Whether a page is the last is not known until the document is
+ * finished, so the surface holds on to one completed page besides the
+ * one being drawn.
+ */
 static cairo_svg_page_t *
 _cairo_svg_surface_store_page (cairo_svg_surface_t *surface)
 {
@@ -591,7 +626,20 @@ _cairo_svg_surface_store_page (cairo_svg_surface_t *surface)
     page.clip_level = surface->clip_level;
     page.xml_node = surface->xml_node;
 
-    if (_cairo_array_append (&surface->page_set, &page)) {
+    if (surface->page_set.num_elements > 0) {
+	cairo_svg_page_t *prev = _cairo_array_index (&surface->page_set, 0);
+
+	if (_cairo_svg_surface_is_owner (surface)) {
+	    status = _cairo_svg_document_emit_page (surface->document, prev);
+	    if (unlikely (status)) {
+		status = _cairo_output_stream_destroy (stream);
+		return NULL;
+	    }
+	}
+
+	status = _cairo_output_stream_destroy (prev->xml_node);
+	*prev = page;
+    } else if (_cairo_array_append (&surface->page_set, &page)) {
 	status = _cairo_output_stream_destroy (stream);
 	return NULL;
     }
@@ -603,8 +651,7 @@ _cairo_svg_surface_store_page (cairo_svg_surface_t *surface)
 
     _cairo_surface_clipper_reset (&surface->clipper);
 
-    return _cairo_array_index (&surface->page_set,
-			       surface->page_set.num_elements - 1);
+    return _cairo_array_index (&surface->page_set, 0);
 }
 
 static cairo_int_status_t
@@ -863,10 +910,37 @@ _cairo_svg_document_emit_font_subset (cairo_scaled_font_subset_t	*font_subset,
 {
     cairo_svg_document_t *document = closure;
     cairo_int_status_t status = CAIRO_INT_STATUS_SUCCESS;
-    unsigned int i;
+    cairo_svg_glyph_subset_t *subset = NULL;
+    unsigned int i, num_subsets;
+
+    /* Glyphs are appended to a subset as they are first used, so only
+     * those past the ones written out with earlier pages are new.
+     */
+    num_subsets = _cairo_array_num_elements (&document->glyph_subsets);
+    for (i = 0; i < num_subsets; i++) {
+	subset = _cairo_array_index (&document->glyph_subsets, i);
+	if (subset->font_id == font_subset->font_id &&
+	    subset->subset_id == font_subset->subset_id)
+	    break;
+    }
+    if (i == num_subsets) {
+	cairo_svg_glyph_subset_t new_subset;
+
+	new_subset.font_id = font_subset->font_id;
+	new_subset.subset_id = font_subset->subset_id;
+	new_subset.num_glyphs = 0;
+	status = _cairo_array_append (&document->glyph_subsets, &new_subset);
+	if (unlikely (status))
+	    return status;
+
+	subset = _cairo_array_index (&document->glyph_subsets, i);
+    }
+
+    if (subset->num_glyphs == font_subset->num_glyphs)
+	return CAIRO_INT_STATUS_SUCCESS;
 
     _cairo_scaled_font_freeze_cache (font_subset->scaled_font);
-    for (i = 0; i < font_subset->num_glyphs; i++) {
+    for (i = subset->num_glyphs; i < font_subset->num_glyphs; i++) {
 	status = _cairo_svg_document_emit_glyph (document,
 					         font_subset->scaled_font,
 					         font_subset->glyphs[i],
@@ -875,10 +949,12 @@ _cairo_svg_document_emit_font_subset (cairo_scaled_font_subset_t	*font_subset,
 	    break;
     }
     _cairo_scaled_font_thaw_cache (font_subset->scaled_font);
+    subset->num_glyphs = i;
 
     return status;
 }
 
+/* Write the glyphs used since the last call into xml_node_glyphs. */
 static cairo_status_t
 _cairo_svg_document_emit_font_subsets (cairo_svg_document_t *document)
 {
@@ -888,17 +964,11 @@ _cairo_svg_document_emit_font_subsets (cairo_svg_document_t *document)
                                                         _cairo_svg_document_emit_font_subset,
                                                         document);
     if (unlikely (status))
-	goto FAIL;
-
-    status = _cairo_scaled_font_subsets_foreach_user (document->font_subsets,
-						      _cairo_svg_document_emit_font_subset,
-						      document);
-
-  FAIL:
-    _cairo_scaled_font_subsets_destroy (document->font_subsets);
-    document->font_subsets = NULL;
+	return status;
 
-    return status;
+    return _cairo_scaled_font_subsets_foreach_user (document->font_subsets,
+						    _cairo_svg_document_emit_font_subset,
+						    document);
 }
 
 static char const *
@@ -988,7 +1058,7 @@ _cairo_svg_surface_finish (void *abstract_surface)
     cairo_svg_page_t *page;
     unsigned int i;
 
-    if (_cairo_paginated_surface_get_target (document->owner) == &surface->base)
+    if (_cairo_svg_surface_is_owner (surface))
 	status = _cairo_svg_document_finish (document);
     else
 	status = CAIRO_STATUS_SUCCESS;
@@ -2680,6 +2750,11 @@ _cairo_svg_document_create (cairo_output_stream_t	 *output_stream,
 
     document->alpha_filter = FALSE;
 
+    document->header_emitted = FALSE;
+    document->in_page_set = FALSE;
+    _cairo_array_init (&document->glyph_subsets,
+		       sizeof (cairo_svg_glyph_subset_t));
+
     document->svg_version = version;
 
     *document_out = document;
@@ -2725,16 +2800,11 @@ _cairo_svg_document_destroy (cairo_svg_document_t *document)
     return status;
 }
 
-static cairo_status_t
-_cairo_svg_document_finish (cairo_svg_document_t *document)
+static void
+_cairo_svg_document_emit_header (cairo_svg_document_t *document)
 {
-    cairo_status_t status, status2;
-    cairo_output_stream_t *output = document->output_stream;
-    cairo_svg_page_t *page;
-    unsigned int i;
-
-    if (document->finished)
-	return CAIRO_STATUS_SUCCESS;
+    if (document->header_emitted)
+	return;
 
     /*
      * Should we add DOCTYPE?
@@ -2758,7 +2828,7 @@ _cairo_svg_document_finish (cairo_svg_document_t *document)
      *   a DOCTYPE declaration in SVG 1.0 and 1.1 documents.
      */
 
-    _cairo_output_stream_printf (output,
+    _cairo_output_stream_printf (document->output_stream,
 				 "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
 				 "<svg xmlns=\"http://www.w3.org/2000/svg\" "
 				 "xmlns:xlink=\"http://www.w3.org/1999/xlink\" "
@@ -2768,20 +2838,109 @@ _cairo_svg_document_finish (cairo_svg_document_t *document)
 				 document->width, document->height,
 				 _cairo_svg_internal_version_strings [document->svg_version]);
 
+    document->header_emitted = TRUE;
+}
+
+static cairo_status_t
+_cairo_svg_document_reset_node (cairo_output_stream_t **node)
+{
+    cairo_status_t status;
+
+    if (_cairo_memory_stream_length (*node) == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    status = _cairo_output_stream_destroy (*node);
+    *node = _cairo_memory_stream_create ();
+    if (unlikely (status))
+	return status;
+
+    return _cairo_output_stream_get_status (*node);
+}
+
+/* Write out the glyphs and definitions gathered so far, and start
+ * afresh. Every glyph used up to now is included, so the definitions
+ * always precede the pages that use them.
+ */
+static cairo_status_t
+_cairo_svg_document_emit_defs (cairo_svg_document_t *document)
+{
+    cairo_output_stream_t *output = document->output_stream;
+    cairo_status_t status, status2;
+
     status = _cairo_svg_document_emit_font_subsets (document);
 
-    if (_cairo_memory_stream_length (document->xml_node_glyphs) > 0 ||
-	_cairo_memory_stream_length (document->xml_node_defs) > 0) {
-	_cairo_output_stream_printf (output, "<defs>\n");
-	if (_cairo_memory_stream_length (document->xml_node_glyphs) > 0) {
-	    _cairo_output_stream_printf (output, "<g>\n");
-	    _cairo_memory_stream_copy (document->xml_node_glyphs, output);
-	    _cairo_output_stream_printf (output, "</g>\n");
-	}
-	_cairo_memory_stream_copy (document->xml_node_defs, output);
-	_cairo_output_stream_printf (output, "</defs>\n");
+    if (_cairo_memory_stream_length (document->xml_node_glyphs) == 0 &&
+	_cairo_memory_stream_length (document->xml_node_defs) == 0)
+	return status;
+
+    _cairo_output_stream_printf (output, "<defs>\n");
+    if (_cairo_memory_stream_length (document->xml_node_glyphs) > 0) {
+	_cairo_output_stream_printf (output, "<g>\n");
+	_cairo_memory_stream_copy (document->xml_node_glyphs, output);
+	_cairo_output_stream_printf (output, "</g>\n");
     }
+    _cairo_memory_stream_copy (document->xml_node_defs, output);
+    _cairo_output_stream_printf (output, "</defs>\n");
 
+    status2 = _cairo_svg_document_reset_node (&document->xml_node_glyphs);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = status2;
+
+    status2 = _cairo_svg_document_reset_node (&document->xml_node_defs);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = status2;
+
+    return status;
+}
+
+/* Called with each page of the document once the page after it is
+ * finished, and with the last page from _cairo_svg_document_finish()
+ * if any page was written before it. Documents restricted to SVG 1.1
+ * only show their final page, so for those just the definitions are
+ * written.
+ */
+static cairo_status_t
+_cairo_svg_document_emit_page (cairo_svg_document_t *document,
+			       cairo_svg_page_t     *page)
+{
+    cairo_output_stream_t *output = document->output_stream;
+    cairo_status_t status;
+
+    _cairo_svg_document_emit_header (document);
+
+    if (! _cairo_svg_version_has_page_set_support (document->svg_version))
+	return _cairo_svg_document_emit_defs (document);
+
+    if (! document->in_page_set) {
+	_cairo_output_stream_printf (output, "<pageSet>\n");
+	document->in_page_set = TRUE;
+    }
+
+    _cairo_output_stream_printf (output, "<page>\n");
+    status = _cairo_svg_document_emit_defs (document);
+    _cairo_output_stream_printf (output,
+				 "<g id=\"surface%d\">\n",
+				 page->surface_id);
+    _cairo_memory_stream_copy (page->xml_node, output);
+    _cairo_output_stream_printf (output, "</g>\n</page>\n");
+
+    return status;
+}
+
+static cairo_status_t
+_cairo_svg_document_finish (cairo_svg_document_t *document)
+{
+    cairo_status_t status, status2;
+    cairo_output_stream_t *output = document->output_stream;
+    cairo_svg_page_t *page;
+
+    if (document->finished)
+	return CAIRO_STATUS_SUCCESS;
+
+    _cairo_svg_document_emit_header (document);
+
+    status = CAIRO_STATUS_SUCCESS;
+    page = NULL;
     if (document->owner != NULL) {
 	cairo_svg_surface_t *surface;
 
@@ -2794,21 +2953,23 @@ _cairo_svg_document_finish (cairo_svg_document_t *document)
 	    }
 	}
 
-	if (surface->page_set.num_elements > 1 &&
-	    _cairo_svg_version_has_page_set_support (document->svg_version)) {
-	    _cairo_output_stream_printf (output, "<pageSet>\n");
-	    for (i = 0; i < surface->page_set.num_elements; i++) {
-		page = _cairo_array_index (&surface->page_set, i);
-		_cairo_output_stream_printf (output, "<page>\n");
-		_cairo_output_stream_printf (output,
-					     "<g id=\"surface%d\">\n",
-					     page->surface_id);
-		_cairo_memory_stream_copy (page->xml_node, output);
-		_cairo_output_stream_printf (output, "</g>\n</page>\n");
-	    }
-	    _cairo_output_stream_printf (output, "</pageSet>\n");
-	} else if (surface->page_set.num_elements > 0) {
-	    page = _cairo_array_index (&surface->page_set, surface->page_set.num_elements - 1);
+	if (surface->page_set.num_elements > 0)
+	    page = _cairo_array_index (&surface->page_set, 0);
+    }
+
+    if (document->in_page_set) {
+	if (page != NULL) {
+	    status2 = _cairo_svg_document_emit_page (document, page);
+	    if (status == CAIRO_STATUS_SUCCESS)
+		status = status2;
+	}
+	_cairo_output_stream_printf (output, "</pageSet>\n");
+    } else {
+	status2 = _cairo_svg_document_emit_defs (document);
+	if (status == CAIRO_STATUS_SUCCESS)
+	    status = status2;
+
+	if (page != NULL) {
 	    _cairo_output_stream_printf (output,
 					 "<g id=\"surface%d\">\n",
 					 page->surface_id);
@@ -2819,6 +2980,10 @@ _cairo_svg_document_finish (cairo_svg_document_t *document)
 
     _cairo_output_stream_printf (output, "</svg>\n");
 
+    _cairo_scaled_font_subsets_destroy (document->font_subsets);
+    document->font_subsets = NULL;
+    _cairo_array_fini (&document->glyph_subsets);
+
     status2 = _cairo_output_stream_destroy (document->xml_node_glyphs);
     if (status == CAIRO_STATUS_SUCCESS)
 	status = status2;
@@ -2240,7 +2240,13 @@ _cairo_traps_compositor_fill (const cairo_compositor_t *_compositor,
 	}
 #else
 	_cairo_polygon_init_with_clip (&polygon, extents->clip);
-	status = _cairo_path_fixed_fill_to_polygon (path, tolerance, &polygon);
+	if (antialias == CAIRO_ANTIALIAS_FAST)
+	    status = _cairo_path_fixed_fill_to_simplified_polygon (path,
+								   tolerance,
+								   &polygon);
+	else
+	    status = _cairo_path_fixed_fill_to_polygon (path, tolerance,
+							&polygon);
 #endif
 	if (likely (status == CAIRO_INT_STATUS_SUCCESS)) {
 	    status = clip_and_composite_polygon (compositor, extents, &polygon,
@@ -42,6 +42,7 @@
 #include "cairo-box-inline.h"
 #include "cairo-boxes-private.h"
 #include "cairo-error-private.h"
+#include "cairo-hit-test-private.h"
 #include "cairo-region-private.h"
 #include "cairo-slope-private.h"
 #include "cairo-traps-private.h"
@@ -674,6 +675,54 @@ _cairo_traps_contain (const cairo_traps_t *traps,
     return FALSE;
 }
 
+/* As _cairo_traps_contain() for many points at once. The trapezoids
+ * must be sorted by their top and the points by their y, so that each
+ * point is only tested against the trapezoids that span it. */
+cairo_status_t
+_cairo_traps_contain_points (const cairo_traps_t	*traps,
+			     const cairo_hit_point_t	*points,
+			     int			 num_points,
+			     cairo_bool_t		*inside)
+{
+    cairo_trapezoid_t *stack_active[CAIRO_STACK_ARRAY_LENGTH (cairo_trapezoid_t *)];
+    cairo_trapezoid_t **active;
+    int num_active, next, i, j, n;
+
+    active = stack_active;
+    if (traps->num_traps > ARRAY_LENGTH (stack_active)) {
+	active = _cairo_malloc_ab (traps->num_traps, sizeof (cairo_trapezoid_t *));
+	if (unlikely (active == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    num_active = next = 0;
+    for (n = 0; n < num_points; n++) {
+	cairo_point_t pt = points[n].point;
+
+	while (next < traps->num_traps && traps->traps[next].top <= pt.y)
+	    active[num_active++] = &traps->traps[next++];
+
+	for (i = j = 0; i < num_active; i++) {
+	    if (active[i]->bottom >= pt.y)
+		active[j++] = active[i];
+	}
+	num_active = j;
+
+	inside[points[n].index] = FALSE;
+	for (i = 0; i < num_active; i++) {
+	    if (_cairo_trap_contains (active[i], &pt)) {
+		inside[points[n].index] = TRUE;
+		break;
+	    }
+	}
+    }
+
+    if (active != stack_active)
+	free (active);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
 static cairo_fixed_t
 _line_compute_intersection_x_for_y (const cairo_line_t *line,
 				    cairo_fixed_t y)
@@ -56,6 +56,7 @@ typedef struct cairo_type3_glyph_surface {
     cairo_pdf_operators_t pdf_operators;
     cairo_matrix_t cairo_to_pdf;
     cairo_type3_glyph_surface_emit_image_t emit_image;
+    cairo_bool_t cacheable;
 
     cairo_surface_clipper_t clipper;
 } cairo_type3_glyph_surface_t;
@@ -45,10 +45,38 @@
 #include "cairo-default-context-private.h"
 #include "cairo-error-private.h"
 #include "cairo-image-surface-private.h"
+#include "cairo-list-inline.h"
+#include "cairo-scaled-font-private.h"
 #include "cairo-surface-clipper-private.h"
 
 static const cairo_surface_backend_t cairo_type3_glyph_surface_backend;
 
+/* The glyph procedure generated for a scaled glyph only depends upon
+ * the scaled font and the image format of the backend, unless it
+ * draws text which references the font subsets of the document. The
+ * self-contained procedures are kept alongside the scaled glyph, keyed
+ * by the backend's emit_image function, so that they can be reused by
+ * every subset and document that uses the glyph for as long as the
+ * glyph remains in the font cache.
+ */
+typedef struct _cairo_type3_glyph_proc {
+    cairo_scaled_glyph_private_t base;
+    unsigned char *data;
+    unsigned long length;
+} cairo_type3_glyph_proc_t;
+
+static void
+_cairo_type3_glyph_proc_fini (cairo_scaled_glyph_private_t *glyph_private,
+			      cairo_scaled_glyph_t *scaled_glyph,
+			      cairo_scaled_font_t  *scaled_font)
+{
+    cairo_type3_glyph_proc_t *proc = (cairo_type3_glyph_proc_t *) glyph_private;
+
+    cairo_list_del (&proc->base.link);
+    free (proc->data);
+    free (proc);
+}
+
 static cairo_status_t
 _cairo_type3_glyph_surface_clipper_intersect_clip_path (cairo_surface_clipper_t *clipper,
 							cairo_path_fixed_t *path,
@@ -94,6 +122,7 @@ _cairo_type3_glyph_surface_create (cairo_scaled_font_t			 *scaled_font,
     surface->scaled_font = scaled_font;
     surface->stream = stream;
     surface->emit_image = emit_image;
+    surface->cacheable = TRUE;
 
     /* Setup the transform from the user-font device space to Type 3
      * font space. The Type 3 font space is defined by the FontMatrix
@@ -298,6 +327,9 @@ _cairo_type3_glyph_surface_show_glyphs (void		     *abstract_surface,
     if (unlikely (status))
 	return status;
 
+    /* the glyphs are drawn using the font subsets of this document */
+    surface->cacheable = FALSE;
+
     cairo_matrix_init_scale (&invert_y_axis, 1, -1);
     cairo_matrix_multiply (&new_ctm, &invert_y_axis, &scaled_font->ctm);
     cairo_matrix_multiply (&new_ctm, &surface->cairo_to_pdf, &new_ctm);
@@ -444,6 +476,10 @@ _cairo_type3_glyph_surface_analyze_glyph (void		     *abstract_surface,
 	goto cleanup;
     }
 
+    /* a cached procedure uses no other fonts */
+    if (_cairo_scaled_glyph_find_private (scaled_glyph, surface->emit_image))
+	goto cleanup;
+
     status = _cairo_recording_surface_replay (scaled_glyph->recording_surface,
 					      &surface->base);
     if (unlikely (status))
@@ -472,6 +508,9 @@ _cairo_type3_glyph_surface_emit_glyph (void		     *abstract_surface,
 {
     cairo_type3_glyph_surface_t *surface = abstract_surface;
     cairo_scaled_glyph_t *scaled_glyph;
+    cairo_scaled_glyph_private_t *glyph_private;
+    cairo_type3_glyph_proc_t *proc;
+    cairo_output_stream_t *mem_stream;
     cairo_int_status_t status, status2;
     double x_advance, y_advance;
     cairo_matrix_t font_matrix_inverse;
@@ -525,16 +564,29 @@ _cairo_type3_glyph_surface_emit_glyph (void		     *abstract_surface,
 				 _cairo_fixed_to_double (bbox->p2.x),
 				 - _cairo_fixed_to_double (bbox->p1.y));
 
-    if (status == CAIRO_INT_STATUS_SUCCESS) {
-	cairo_output_stream_t *mem_stream;
+    glyph_private = _cairo_scaled_glyph_find_private (scaled_glyph,
+						      surface->emit_image);
+    if (glyph_private != NULL) {
+	proc = (cairo_type3_glyph_proc_t *) glyph_private;
+	_cairo_output_stream_write (stream, proc->data, proc->length);
+	status = _cairo_output_stream_get_status (stream);
+	goto FAIL;
+    }
 
-	mem_stream = _cairo_memory_stream_create ();
-	status = mem_stream->status;
-	if (unlikely (status))
-	    goto FAIL;
+    mem_stream = _cairo_memory_stream_create ();
+    if (unlikely (mem_stream->status)) {
+	status = _cairo_output_stream_destroy (mem_stream);
+	goto FAIL;
+    }
 
-	_cairo_type3_glyph_surface_set_stream (surface, mem_stream);
+    /* Each procedure starts from a clean graphics state, so that it
+     * does not depend upon the glyphs emitted before it. */
+    _cairo_type3_glyph_surface_set_stream (surface, mem_stream);
+    _cairo_surface_clipper_reset (&surface->clipper);
+    _cairo_pdf_operators_reset (&surface->pdf_operators);
+    surface->cacheable = TRUE;
 
+    if (status == CAIRO_INT_STATUS_SUCCESS) {
 	_cairo_output_stream_printf (surface->stream, "q\n");
 	status = _cairo_recording_surface_replay (scaled_glyph->recording_surface,
 						  &surface->base);
@@ -544,8 +596,39 @@ _cairo_type3_glyph_surface_emit_glyph (void		     *abstract_surface,
 	    status = status2;
 
 	_cairo_output_stream_printf (surface->stream, "Q\n");
+    }
+
+    if (status == CAIRO_INT_STATUS_IMAGE_FALLBACK) {
+	/* discard the partial procedure */
+	_cairo_output_stream_destroy (mem_stream);
+	mem_stream = _cairo_memory_stream_create ();
+	_cairo_type3_glyph_surface_set_stream (surface, mem_stream);
+	surface->cacheable = TRUE;
 
-	_cairo_type3_glyph_surface_set_stream (surface, stream);
+	status = _cairo_type3_glyph_surface_emit_fallback_image (surface, glyph_index);
+    }
+
+    _cairo_type3_glyph_surface_set_stream (surface, stream);
+
+    if (status == CAIRO_INT_STATUS_SUCCESS &&
+	surface->cacheable &&
+	_cairo_memory_stream_length (mem_stream) > 0 &&
+	(proc = malloc (sizeof (cairo_type3_glyph_proc_t))) != NULL)
+    {
+	status = _cairo_memory_stream_destroy (mem_stream,
+					       &proc->data,
+					       &proc->length);
+	if (unlikely (status)) {
+	    free (proc);
+	    goto FAIL;
+	}
+
+	_cairo_output_stream_write (stream, proc->data, proc->length);
+	_cairo_scaled_glyph_attach_private (scaled_glyph,
+					    &proc->base,
+					    surface->emit_image,
+					    _cairo_type3_glyph_proc_fini);
+    } else {
 	if (status == CAIRO_INT_STATUS_SUCCESS)
 	    _cairo_memory_stream_copy (mem_stream, stream);
 
@@ -554,9 +637,6 @@ _cairo_type3_glyph_surface_emit_glyph (void		     *abstract_surface,
 	    status = status2;
     }
 
-    if (status == CAIRO_INT_STATUS_IMAGE_FALLBACK)
-	status = _cairo_type3_glyph_surface_emit_fallback_image (surface, glyph_index);
-
   FAIL:
     _cairo_scaled_font_thaw_cache (surface->scaled_font);
 
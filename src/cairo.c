@@ -43,6 +43,7 @@
 
 #include "cairo-backend-private.h"
 #include "cairo-error-private.h"
+#include "cairo-hit-test-private.h"
 #include "cairo-path-private.h"
 #include "cairo-pattern-private.h"
 #include "cairo-surface-private.h"
@@ -2352,6 +2353,138 @@ cairo_in_fill (cairo_t *cr, double x, double y)
     return inside;
 }
 
+/**
+ * cairo_hit_test_create_for_fill:
+ * @cr: a cairo context
+ *
+ * Captures the area that would be affected by a cairo_fill() operation
+ * given the current path and filling parameters, so that many points
+ * can be tested against it with cairo_hit_test_contains_points(). The
+ * result for each point is the same as cairo_in_fill() would give.
+ *
+ * Return value: a newly created #cairo_hit_test_t. The caller owns the
+ * object and should call cairo_hit_test_destroy() when done with it.
+ *
+ * This function always returns a valid pointer; if memory cannot be
+ * allocated, or @cr is in an error state, an object in an error state
+ * is returned. You can check for this with cairo_hit_test_status().
+ *
+ * Since: 1.14
+ **/
+cairo_hit_test_t *
+cairo_hit_test_create_for_fill (cairo_t *cr)
+{
+    if (unlikely (cr->status))
+	return _cairo_hit_test_create_in_error (cr->status);
+
+    return cr->backend->create_hit_test (cr, FALSE);
+}
+
+/**
+ * cairo_hit_test_create_for_stroke:
+ * @cr: a cairo context
+ *
+ * Captures the area that would be affected by a cairo_stroke() operation
+ * given the current path and stroking parameters, so that many points
+ * can be tested against it with cairo_hit_test_contains_points(). The
+ * result for each point is the same as cairo_in_stroke() would give,
+ * except that a point lying within 1/256 of a device unit of the edge
+ * of the stroke may be classified differently. cairo_in_stroke()
+ * tessellates the stroke clipped to the immediate neighbourhood of the
+ * point, so where the pieces of the stroke overlap, as the dashes of a
+ * dashed curve do, its intersections may be rounded differently.
+ *
+ * Return value: a newly created #cairo_hit_test_t. The caller owns the
+ * object and should call cairo_hit_test_destroy() when done with it.
+ *
+ * This function always returns a valid pointer; if memory cannot be
+ * allocated, or @cr is in an error state, an object in an error state
+ * is returned. You can check for this with cairo_hit_test_status().
+ *
+ * Since: 1.14
+ **/
+cairo_hit_test_t *
+cairo_hit_test_create_for_stroke (cairo_t *cr)
+{
+    if (unlikely (cr->status))
+	return _cairo_hit_test_create_in_error (cr->status);
+
+    return cr->backend->create_hit_test (cr, TRUE);
+}
+
+static void
+_cairo_in_points (cairo_t	*cr,
+		  cairo_bool_t	 stroke,
+		  const double	*points,
+		  int		 num_points,
+		  cairo_bool_t	*inside)
+{
+    cairo_hit_test_t *hit_test;
+    cairo_status_t status;
+    int n;
+
+    if (unlikely (cr->status)) {
+	for (n = 0; n < num_points; n++)
+	    inside[n] = FALSE;
+	return;
+    }
+
+    hit_test = cr->backend->create_hit_test (cr, stroke);
+    cairo_hit_test_contains_points (hit_test, points, num_points, inside);
+
+    status = hit_test->status;
+    cairo_hit_test_destroy (hit_test);
+
+    if (unlikely (status))
+	_cairo_set_error (cr, status);
+}
+
+/**
+ * cairo_in_stroke_points:
+ * @cr: a cairo context
+ * @points: an array of @num_points pairs of user-space coordinates,
+ * x followed by y
+ * @num_points: the number of points to test
+ * @inside: an array of @num_points booleans in which to store the results
+ *
+ * Tests each of the given points as cairo_in_stroke() would, but strokes
+ * the current path only once for the whole batch. See
+ * cairo_hit_test_create_for_stroke() for how the results may differ
+ * for points lying on the edge of the stroke.
+ *
+ * Since: 1.14
+ **/
+void
+cairo_in_stroke_points (cairo_t		*cr,
+			const double	*points,
+			int		 num_points,
+			cairo_bool_t	*inside)
+{
+    _cairo_in_points (cr, TRUE, points, num_points, inside);
+}
+
+/**
+ * cairo_in_fill_points:
+ * @cr: a cairo context
+ * @points: an array of @num_points pairs of user-space coordinates,
+ * x followed by y
+ * @num_points: the number of points to test
+ * @inside: an array of @num_points booleans in which to store the results
+ *
+ * Tests each of the given points as cairo_in_fill() would, but flattens
+ * the current path only once for the whole batch.
+ *
+ * Since: 1.14
+ **/
+void
+cairo_in_fill_points (cairo_t		*cr,
+		      const double	*points,
+		      int		 num_points,
+		      cairo_bool_t	*inside)
+{
+    _cairo_in_points (cr, FALSE, points, num_points, inside);
+}
+
 /**
  * cairo_stroke_extents:
  * @cr: a cairo context
@@ -2406,6 +2539,52 @@ cairo_stroke_extents (cairo_t *cr,
 	_cairo_set_error (cr, status);
 }
 
+/**
+ * cairo_approximate_stroke_extents:
+ * @cr: a cairo context
+ * @x1: left of the resulting extents
+ * @y1: top of the resulting extents
+ * @x2: right of the resulting extents
+ * @y2: bottom of the resulting extents
+ *
+ * Computes a bounding box in user coordinates that is guaranteed to
+ * contain the extents returned by cairo_stroke_extents() for the
+ * current path and stroke parameters, but may be larger.
+ *
+ * Rather than stroking the path, the bounds of the path are simply
+ * grown by the furthest any part of the stroke may reach from the
+ * path, as determined by the line width, the line cap and, for
+ * mitered joins, the miter limit. The cost is independent of the
+ * complexity of the path and of the dash pattern, so this is the
+ * preferred way to cull or lay out shapes before drawing them, leaving
+ * cairo_stroke_extents() for when precise bounds are required.
+ *
+ * As with cairo_stroke_extents(), if the current path is empty or the
+ * line width is zero, returns an empty rectangle ((0,0), (0,0)).
+ *
+ * Since: 1.14
+ **/
+void
+cairo_approximate_stroke_extents (cairo_t *cr,
+				  double *x1, double *y1,
+				  double *x2, double *y2)
+{
+    if (unlikely (cr->status)) {
+	if (x1)
+	    *x1 = 0.0;
+	if (y1)
+	    *y1 = 0.0;
+	if (x2)
+	    *x2 = 0.0;
+	if (y2)
+	    *y2 = 0.0;
+
+	return;
+    }
+
+    cr->backend->approximate_stroke_extents (cr, x1, y1, x2, y2);
+}
+
 /**
  * cairo_fill_extents:
  * @cr: a cairo context
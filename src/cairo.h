@@ -951,6 +951,52 @@ cairo_in_fill (cairo_t *cr, double x, double y);
 cairo_public cairo_bool_t
 cairo_in_clip (cairo_t *cr, double x, double y);
 
+cairo_public void
+cairo_in_stroke_points (cairo_t		*cr,
+			const double	*points,
+			int		 num_points,
+			cairo_bool_t	*inside);
+
+cairo_public void
+cairo_in_fill_points (cairo_t		*cr,
+		      const double	*points,
+		      int		 num_points,
+		      cairo_bool_t	*inside);
+
+/**
+ * cairo_hit_test_t:
+ *
+ * A #cairo_hit_test_t holds the area that a fill or a stroke of a path
+ * would cover, prepared so that many points can be tested against it.
+ *
+ * Memory management of #cairo_hit_test_t is done with
+ * cairo_hit_test_reference() and cairo_hit_test_destroy().
+ *
+ * Since: 1.14
+ **/
+typedef struct _cairo_hit_test cairo_hit_test_t;
+
+cairo_public cairo_hit_test_t *
+cairo_hit_test_create_for_fill (cairo_t *cr);
+
+cairo_public cairo_hit_test_t *
+cairo_hit_test_create_for_stroke (cairo_t *cr);
+
+cairo_public cairo_hit_test_t *
+cairo_hit_test_reference (cairo_hit_test_t *hit_test);
+
+cairo_public void
+cairo_hit_test_destroy (cairo_hit_test_t *hit_test);
+
+cairo_public cairo_status_t
+cairo_hit_test_status (cairo_hit_test_t *hit_test);
+
+cairo_public void
+cairo_hit_test_contains_points (cairo_hit_test_t	*hit_test,
+				const double		*points,
+				int			 num_points,
+				cairo_bool_t		*inside);
+
 /* Rectangular extents */
 cairo_public void
 cairo_stroke_extents (cairo_t *cr,
@@ -962,6 +1008,11 @@ cairo_fill_extents (cairo_t *cr,
 		    double *x1, double *y1,
 		    double *x2, double *y2);
 
+cairo_public void
+cairo_approximate_stroke_extents (cairo_t *cr,
+				  double *x1, double *y1,
+				  double *x2, double *y2);
+
 /* Clipping */
 cairo_public void
 cairo_reset_clip (cairo_t *cr);
@@ -2286,6 +2337,16 @@ cairo_device_observer_stroke_elapsed (cairo_device_t *device);
 cairo_public double
 cairo_device_observer_glyphs_elapsed (cairo_device_t *device);
 
+typedef void (*cairo_device_observer_operation_callback_t) (cairo_device_t *observer,
+							    const char *operation,
+							    double elapsed,
+							    void *data);
+
+cairo_public cairo_status_t
+cairo_device_observer_add_operation_callback (cairo_device_t *device,
+					      cairo_device_observer_operation_callback_t func,
+					      void *data);
+
 cairo_public cairo_surface_t *
 cairo_surface_reference (cairo_surface_t *surface);
 
@@ -2332,6 +2393,10 @@ cairo_surface_status (cairo_surface_t *surface);
  * @CAIRO_SURFACE_TYPE_SUBSURFACE: The surface is a subsurface created with
  *   cairo_surface_create_for_rectangle(), since 1.10
  * @CAIRO_SURFACE_TYPE_COGL: This surface is of type Cogl, since 1.12
+ * @CAIRO_SURFACE_TYPE_MIME: The surface is a compressed image created
+ *   with cairo_mime_surface_create(), since 1.14
+ * @CAIRO_SURFACE_TYPE_ASYNC: The surface renders onto an image surface
+ *   from a separate thread, since 1.14
  *
  * #cairo_surface_type_t is used to describe the type of a given
  * surface. The surface types are also known as "backends" or "surface
@@ -2382,7 +2447,9 @@ typedef enum _cairo_surface_type {
     CAIRO_SURFACE_TYPE_XML,
     CAIRO_SURFACE_TYPE_SKIA,
     CAIRO_SURFACE_TYPE_SUBSURFACE,
-    CAIRO_SURFACE_TYPE_COGL
+    CAIRO_SURFACE_TYPE_COGL,
+    CAIRO_SURFACE_TYPE_MIME,
+    CAIRO_SURFACE_TYPE_ASYNC
 } cairo_surface_type_t;
 
 cairo_public cairo_surface_type_t
@@ -2438,6 +2505,39 @@ cairo_public cairo_bool_t
 cairo_surface_supports_mime_type (cairo_surface_t		*surface,
 				  const char		        *mime_type);
 
+/**
+ * cairo_mime_surface_decode_func_t:
+ * @closure: the closure passed to cairo_mime_surface_set_decoder()
+ * @mime_type: the MIME type of the compressed image data
+ * @data: the compressed image data
+ * @length: the length of the image data
+ *
+ * #cairo_mime_surface_decode_func_t is the type of function which is
+ * called when the pixels of a mime surface are required.
+ *
+ * Returns: a newly created image surface holding the decoded image,
+ * or %NULL on error.
+ *
+ * Since: 1.14
+ **/
+typedef cairo_surface_t *
+(*cairo_mime_surface_decode_func_t) (void			*closure,
+				     const char			*mime_type,
+				     const unsigned char	*data,
+				     unsigned long		 length);
+
+cairo_public cairo_surface_t *
+cairo_mime_surface_create (const char		*mime_type,
+			   const unsigned char	*data,
+			   unsigned long	 length,
+			   cairo_destroy_func_t	 destroy,
+			   void			*closure);
+
+cairo_public void
+cairo_mime_surface_set_decoder (cairo_surface_t			*surface,
+				cairo_mime_surface_decode_func_t decode,
+				void				*closure);
+
 cairo_public void
 cairo_surface_get_font_options (cairo_surface_t      *surface,
 				cairo_font_options_t *options);
@@ -3107,6 +3207,12 @@ cairo_public cairo_status_t
 cairo_region_xor_rectangle (cairo_region_t *dst,
 			    const cairo_rectangle_int_t *rectangle);
 
+/* Recording-surface comparison */
+
+cairo_public cairo_region_t *
+cairo_recording_surface_diff (cairo_surface_t *surface,
+			      cairo_surface_t *other);
+
 /* Functions to be used while debugging (not intended for use in production code) */
 cairo_public void
 cairo_debug_reset_static_data (void);
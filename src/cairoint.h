@@ -416,6 +416,9 @@ _cairo_ft_font_reset_static_data (void);
 cairo_private void
 _cairo_win32_font_reset_static_data (void);
 
+cairo_private void
+_cairo_mime_surface_reset_static_data (void);
+
 #if CAIRO_HAS_COGL_SURFACE
 void
 _cairo_cogl_context_reset_static_data (void);
@@ -1024,6 +1027,11 @@ _cairo_path_fixed_fill_to_polygon (const cairo_path_fixed_t *path,
 				   double              tolerance,
 				   cairo_polygon_t      *polygon);
 
+cairo_private cairo_status_t
+_cairo_path_fixed_fill_to_simplified_polygon (const cairo_path_fixed_t *path,
+					      double              tolerance,
+					      cairo_polygon_t      *polygon);
+
 cairo_private cairo_status_t
 _cairo_path_fixed_fill_rectilinear_to_polygon (const cairo_path_fixed_t *path,
 					       cairo_antialias_t antialias,
@@ -47,6 +47,7 @@
 #include "cairo-default-context-private.h"
 #include "cairo-freed-pool-private.h"
 #include "cairo-gstate-private.h"
+#include "cairo-hit-test-private.h"
 #include "cairo-image-surface-inline.h"
 #include "cairo-path-private.h"
 #include "cairo-pattern-private.h"
@@ -1329,6 +1330,14 @@ _cairo_skia_context_stroke_extents (void *abstract_cr,
     return CAIRO_STATUS_SUCCESS;
 }
 
+static void
+_cairo_skia_context_approximate_stroke_extents (void *abstract_cr,
+						double *x1, double *y1, double *x2, double *y2)
+{
+    /* the exact extents are always a valid approximation */
+    _cairo_skia_context_stroke_extents (abstract_cr, x1, y1, x2, y2);
+}
+
 static cairo_status_t
 _cairo_skia_context_fill_preserve (void *abstract_cr)
 {
@@ -1373,6 +1382,29 @@ _cairo_skia_context_fill_extents (void *abstract_cr,
     return CAIRO_STATUS_SUCCESS;
 }
 
+static cairo_hit_test_t *
+_cairo_skia_context_create_hit_test (void *abstract_cr,
+				     cairo_bool_t stroke)
+{
+    //cairo_skia_context_t *cr = (cairo_skia_context_t *) abstract_cr;
+    cairo_path_fixed_t path;
+    cairo_matrix_t identity;
+    cairo_hit_test_t *hit_test;
+
+    UNSUPPORTED;
+
+    /* an empty hit test, contains nothing, as per in_fill and in_stroke */
+    _cairo_path_fixed_init (&path);
+    cairo_matrix_init_identity (&identity);
+    hit_test = _cairo_hit_test_create_for_fill (&path,
+						CAIRO_FILL_RULE_WINDING,
+						CAIRO_GSTATE_TOLERANCE_DEFAULT,
+						&identity, &identity);
+    _cairo_path_fixed_fini (&path);
+
+    return hit_test;
+}
+
 static cairo_status_t
 _cairo_skia_context_clip_preserve (void *abstract_cr)
 {
@@ -1677,11 +1709,13 @@ static const cairo_backend_t _cairo_skia_context_backend = {
     _cairo_skia_context_stroke_preserve,
     _cairo_skia_context_in_stroke,
     _cairo_skia_context_stroke_extents,
+    _cairo_skia_context_approximate_stroke_extents,
 
     _cairo_skia_context_fill,
     _cairo_skia_context_fill_preserve,
     _cairo_skia_context_in_fill,
     _cairo_skia_context_fill_extents,
+    _cairo_skia_context_create_hit_test,
 
     _cairo_skia_context_set_font_face,
     _cairo_skia_context_get_font_face,
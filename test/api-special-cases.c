@@ -65,6 +65,9 @@
 
 #include "cairo-test.h"
 
+#if CAIRO_HAS_ASYNC_SURFACE
+#include <cairo-async.h>
+#endif
 #if CAIRO_HAS_GL_SURFACE
 #include <cairo-gl.h>
 #endif
@@ -427,6 +430,19 @@ test_cairo_tee_surface_index (cairo_surface_t *surface)
 
 #endif /* CAIRO_HAS_TEE_SURFACE */
 
+#if CAIRO_HAS_ASYNC_SURFACE
+
+static cairo_test_status_t
+test_cairo_async_surface_get_target (cairo_surface_t *surface)
+{
+    cairo_surface_t *target;
+
+    target = cairo_async_surface_get_target (surface);
+    return cairo_surface_status (target) ? CAIRO_TEST_SUCCESS : CAIRO_TEST_ERROR;
+}
+
+#endif /* CAIRO_HAS_ASYNC_SURFACE */
+
 #if CAIRO_HAS_GL_SURFACE
 
 static cairo_test_status_t
@@ -684,6 +700,9 @@ struct {
     TEST (cairo_tee_surface_remove, CAIRO_SURFACE_TYPE_TEE, TRUE),
     TEST (cairo_tee_surface_index, CAIRO_SURFACE_TYPE_TEE, FALSE),
 #endif
+#if CAIRO_HAS_ASYNC_SURFACE
+    TEST (cairo_async_surface_get_target, CAIRO_SURFACE_TYPE_ASYNC, FALSE),
+#endif
 #if CAIRO_HAS_GL_SURFACE
     TEST (cairo_gl_surface_set_size, CAIRO_SURFACE_TYPE_GL, TRUE),
     TEST (cairo_gl_surface_get_width, CAIRO_SURFACE_TYPE_GL, FALSE),
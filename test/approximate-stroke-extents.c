@@ -0,0 +1,157 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Check that cairo_approximate_stroke_extents() always contains the
+ * exact extents reported by cairo_stroke_extents(). */
+
+#include "cairo-test.h"
+
+static void
+make_path (cairo_t *cr, int n)
+{
+    cairo_new_path (cr);
+    switch (n) {
+    case 0: /* a sharp zig-zag to stress the miters */
+	cairo_move_to (cr, 10, 10);
+	cairo_line_to (cr, 90, 14);
+	cairo_line_to (cr, 10, 18);
+	cairo_line_to (cr, 90, 22);
+	break;
+    case 1: /* a closed curve that nearly doubles back upon itself */
+	cairo_move_to (cr, 69.65, 45.19);
+	cairo_curve_to (cr, -7.98, 7.75, -7.75, 49.01, 7.44, 36.60);
+	cairo_close_path (cr);
+	break;
+    case 2:
+	cairo_arc (cr, 50, 50, 30, 0, 2 * M_PI);
+	cairo_move_to (cr, 20, 80);
+	cairo_curve_to (cr, 120, 20, -20, 20, 80, 80);
+	break;
+    case 3: /* degenerate sub-paths */
+	cairo_move_to (cr, 30, 30);
+	cairo_close_path (cr);
+	cairo_move_to (cr, 60, 60);
+	cairo_line_to (cr, 60, 60);
+	break;
+    }
+}
+
+static cairo_bool_t
+check_extents (const cairo_test_context_t *ctx, cairo_t *cr,
+	       const char *message)
+{
+    double x1, y1, x2, y2;
+    double ex1, ey1, ex2, ey2;
+
+    cairo_stroke_extents (cr, &ex1, &ey1, &ex2, &ey2);
+    cairo_approximate_stroke_extents (cr, &x1, &y1, &x2, &y2);
+
+    if (ex1 == ex2 || ey1 == ey2)
+	return TRUE;
+
+    if (x1 <= ex1 && y1 <= ey1 && x2 >= ex2 && y2 >= ey2)
+	return TRUE;
+
+    cairo_test_log (ctx, "Error: %s; approximate stroke extents (%g, %g) x (%g, %g) should contain (%g, %g) x (%g, %g)\n",
+		    message,
+		    x1, y1, x2 - x1, y2 - y1,
+		    ex1, ey1, ex2 - ex1, ey2 - ey1);
+    return FALSE;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    static const double line_widths[] = { 0.1, 0.5, 2, 9 };
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    double x1, y1, x2, y2;
+    char message[128];
+    int path, cap, join, width, transform;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 0, 0);
+    cr = cairo_create (surface);
+    cairo_surface_destroy (surface);
+
+    for (transform = 0; transform < 3; transform++) {
+	cairo_identity_matrix (cr);
+	if (transform == 1) {
+	    cairo_scale (cr, 3, 0.5);
+	} else if (transform == 2) {
+	    cairo_translate (cr, 50, 50);
+	    cairo_rotate (cr, 0.6);
+	    cairo_scale (cr, 0.4, 2);
+	    cairo_translate (cr, -50, -50);
+	}
+
+	for (path = 0; path < 4; path++) {
+	    make_path (cr, path);
+
+	    for (cap = 0; cap < 3; cap++) {
+		cairo_set_line_cap (cr, cap);
+		for (join = 0; join < 3; join++) {
+		    cairo_set_line_join (cr, join);
+		    for (width = 0; width < ARRAY_LENGTH (line_widths); width++) {
+			cairo_set_line_width (cr, line_widths[width]);
+
+			sprintf (message,
+				 "path %d, cap %d, join %d, line-width %g, transform %d",
+				 path, cap, join, line_widths[width], transform);
+			if (! check_extents (ctx, cr, message))
+			    ret = CAIRO_TEST_FAILURE;
+		    }
+		}
+	    }
+	}
+    }
+
+    /* a zero line width inks nothing */
+    cairo_identity_matrix (cr);
+    make_path (cr, 0);
+    cairo_set_line_width (cr, 0);
+    cairo_approximate_stroke_extents (cr, &x1, &y1, &x2, &y2);
+    if (x1 != 0 || y1 != 0 || x2 != 0 || y2 != 0) {
+	cairo_test_log (ctx, "Error: Expected empty extents for a zero line width\n");
+	ret = CAIRO_TEST_FAILURE;
+    }
+
+    /* nor does an empty path */
+    cairo_new_path (cr);
+    cairo_set_line_width (cr, 2);
+    cairo_approximate_stroke_extents (cr, &x1, &y1, &x2, &y2);
+    if (x1 != 0 || y1 != 0 || x2 != 0 || y2 != 0) {
+	cairo_test_log (ctx, "Error: Expected empty extents for an empty path\n");
+	ret = CAIRO_TEST_FAILURE;
+    }
+
+    cairo_destroy (cr);
+
+    return ret;
+}
+
+CAIRO_TEST (approximate_stroke_extents,
+	    "Test that cairo_approximate_stroke_extents contains cairo_stroke_extents",
+	    "extents, stroke", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
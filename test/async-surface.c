@@ -0,0 +1,138 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+#include <cairo-async.h>
+
+/* Check that drawing through an async surface produces exactly the
+ * same pixels as drawing onto the image directly, including when a
+ * source is modified after it has been drawn and when the surface is
+ * used as a source for itself.
+ */
+
+#define SIZE 64
+#define LOOPS 200
+
+static void
+draw_scene (cairo_t *cr)
+{
+    cairo_surface_t *source;
+    cairo_t *cr2;
+    int i;
+
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    source = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 16, 16);
+    for (i = 0; i < LOOPS; i++) {
+	/* redraw the source each time it has been used */
+	cr2 = cairo_create (source);
+	cairo_set_source_rgba (cr2, i & 1, i & 2 ? 0.5 : 0, 1, 0.75);
+	cairo_paint (cr2);
+	cairo_destroy (cr2);
+
+	cairo_set_source_surface (cr, source, i % (SIZE - 16), i / 8);
+	cairo_rectangle (cr, i % (SIZE - 16), i / 8, 16, 16);
+	cairo_fill (cr);
+
+	cairo_arc (cr, i % SIZE, SIZE - i % SIZE, 4, 0, 2 * M_PI);
+	cairo_set_source_rgba (cr, 0, 0, 0, 0.25);
+	cairo_stroke (cr);
+    }
+    cairo_surface_destroy (source);
+
+    cairo_push_group (cr);
+    cairo_set_source_rgb (cr, 0, 1, 0);
+    cairo_rectangle (cr, 4, 4, SIZE / 2, SIZE / 2);
+    cairo_fill (cr);
+    cairo_pop_group_to_source (cr);
+    cairo_paint_with_alpha (cr, 0.5);
+
+    /* copy the left half onto the right half */
+    cairo_set_source_surface (cr, cairo_get_target (cr), SIZE / 2, 0);
+    cairo_rectangle (cr, SIZE / 2, 0, SIZE / 2, SIZE);
+    cairo_fill (cr);
+
+    cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+    cairo_rectangle (cr, 0, SIZE - 8, SIZE, 8);
+    cairo_fill (cr);
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_surface_t *image, *target, *async;
+    cairo_test_status_t result = CAIRO_TEST_SUCCESS;
+    cairo_status_t status;
+    cairo_t *cr;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+    cr = cairo_create (image);
+    draw_scene (cr);
+    cairo_destroy (cr);
+
+    target = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+    async = cairo_async_surface_create (target);
+    cairo_surface_destroy (target);
+
+    if (cairo_surface_get_type (async) != CAIRO_SURFACE_TYPE_ASYNC ||
+	cairo_async_surface_get_target (async) != target)
+    {
+	cairo_test_log (ctx, "Unexpected type or target of async surface\n");
+	result = CAIRO_TEST_FAILURE;
+	goto CLEANUP;
+    }
+
+    cr = cairo_create (async);
+    draw_scene (cr);
+    cairo_destroy (cr);
+
+    cairo_surface_flush (async);
+    status = cairo_surface_status (async);
+    if (status) {
+	result = cairo_test_status_from_status (ctx, status);
+	goto CLEANUP;
+    }
+
+    cairo_surface_flush (image);
+    if (memcmp (cairo_image_surface_get_data (image),
+		cairo_image_surface_get_data (target),
+		cairo_image_surface_get_stride (image) * SIZE))
+    {
+	cairo_test_log (ctx, "Async surface did not render like an image surface\n");
+	result = CAIRO_TEST_FAILURE;
+    }
+
+CLEANUP:
+    cairo_surface_destroy (async);
+    cairo_surface_destroy (image);
+
+    return result;
+}
+
+CAIRO_TEST (async_surface,
+	    "Check that the async surface renders like an image surface",
+	    "api", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
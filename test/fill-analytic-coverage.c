@@ -0,0 +1,168 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Under CAIRO_ANTIALIAS_BEST the image backend computes the coverage
+ * of circles, ellipses and rounded rectangles analytically. Check each
+ * pixel against the exact area of the shape within it. */
+
+#include "cairo-test.h"
+
+#define SIZE 48
+#define SUBROWS 256
+
+/* The largest error we accept, in 1/255ths. Flattening the curves and
+ * sampling the polygon at the default tolerance is off by up to 17 for
+ * these shapes; computing the coverage directly is not. */
+#define MAX_ERROR 10
+
+typedef struct _shape {
+    const char *name;
+    double cx, cy;
+    double w, h; /* half extents */
+    double r; /* corner radius, or 0 for an ellipse */
+} shape_t;
+
+static const shape_t shapes[] = {
+    { "circle", 24.3, 23.7, 10, 10, 0 },
+    { "ellipse", 23.6, 24.2, 20, 9.5, 0 },
+    { "rounded-rectangle", 24.2, 23.9, 19.5, 12.3, 6 },
+};
+
+/* The half width of the shape at a vertical distance of dy from its
+ * centre. */
+static double
+half_width (const shape_t *s, double dy)
+{
+    dy = fabs (dy);
+    if (dy >= s->h)
+	return 0;
+
+    if (s->r == 0)
+	return s->w * sqrt (1 - (dy / s->h) * (dy / s->h));
+
+    if (dy <= s->h - s->r)
+	return s->w;
+
+    dy -= s->h - s->r;
+    return s->w - s->r + sqrt (s->r * s->r - dy * dy);
+}
+
+static double
+exact_coverage (const shape_t *s, int x, int y)
+{
+    double sum = 0;
+    int n;
+
+    for (n = 0; n < SUBROWS; n++) {
+	double w = half_width (s, y + (n + .5) / SUBROWS - s->cy);
+	double x1 = MAX (x, s->cx - w);
+	double x2 = MIN (x + 1, s->cx + w);
+
+	if (x2 > x1)
+	    sum += x2 - x1;
+    }
+
+    return sum / SUBROWS;
+}
+
+static void
+path (cairo_t *cr, const shape_t *s)
+{
+    cairo_new_path (cr);
+    if (s->r == 0) {
+	cairo_save (cr);
+	cairo_translate (cr, s->cx, s->cy);
+	cairo_scale (cr, s->w, s->h);
+	cairo_arc (cr, 0, 0, 1, 0, 2 * M_PI);
+	cairo_restore (cr);
+    } else {
+	double x1 = s->cx - s->w, x2 = s->cx + s->w;
+	double y1 = s->cy - s->h, y2 = s->cy + s->h;
+
+	cairo_new_sub_path (cr);
+	cairo_arc (cr, x2 - s->r, y1 + s->r, s->r, -M_PI / 2, 0);
+	cairo_arc (cr, x2 - s->r, y2 - s->r, s->r, 0, M_PI / 2);
+	cairo_arc (cr, x1 + s->r, y2 - s->r, s->r, M_PI / 2, M_PI);
+	cairo_arc (cr, x1 + s->r, y1 + s->r, s->r, M_PI, 3 * M_PI / 2);
+	cairo_close_path (cr);
+    }
+}
+
+static cairo_test_status_t
+check_shape (cairo_test_context_t *ctx, const shape_t *s)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    unsigned char *data;
+    int stride, x, y;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, SIZE, SIZE);
+    cr = cairo_create (surface);
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_BEST);
+    path (cr, s);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+
+    cairo_surface_flush (surface);
+    data = cairo_image_surface_get_data (surface);
+    stride = cairo_image_surface_get_stride (surface);
+
+    for (y = 0; y < SIZE && ret == CAIRO_TEST_SUCCESS; y++) {
+	for (x = 0; x < SIZE; x++) {
+	    int expected = floor (exact_coverage (s, x, y) * 255 + .5);
+	    int actual = data[y * stride + x];
+
+	    if (abs (actual - expected) > MAX_ERROR) {
+		cairo_test_log (ctx, "Error: %s: coverage of pixel (%d, %d) is %d, expected %d\n",
+				s->name, x, y, actual, expected);
+		ret = CAIRO_TEST_FAILURE;
+		break;
+	    }
+	}
+    }
+
+    cairo_surface_destroy (surface);
+
+    return ret;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    unsigned int n;
+
+    for (n = 0; n < ARRAY_LENGTH (shapes); n++) {
+	if (check_shape (ctx, &shapes[n]))
+	    ret = CAIRO_TEST_FAILURE;
+    }
+
+    return ret;
+}
+
+CAIRO_TEST (fill_analytic_coverage,
+	    "Check the coverage of curved fills under CAIRO_ANTIALIAS_BEST",
+	    "fill", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,191 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Draws glyphs above the distance field threshold, both from a font
+ * with outlines, which are drawn from the fields, and from one without,
+ * which must fall back to bitmaps or, for glyphs too large for the
+ * glyph cache, to the fallback compositor.
+ */
+
+#include "cairo-test.h"
+#include <cairo-gl.h>
+
+#define THRESHOLD 32
+
+static cairo_status_t
+fill_glyph (cairo_scaled_font_t *scaled_font,
+	    unsigned long glyph,
+	    cairo_t *cr,
+	    cairo_text_extents_t *extents)
+{
+    cairo_rectangle (cr, .1, -.8, .6, .8);
+    cairo_fill (cr);
+
+    extents->x_advance = .8;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Painted glyphs have no outline. */
+static cairo_status_t
+paint_glyph (cairo_scaled_font_t *scaled_font,
+	     unsigned long glyph,
+	     cairo_t *cr,
+	     cairo_text_extents_t *extents)
+{
+    cairo_rectangle (cr, .1, -.8, .6, .8);
+    cairo_clip (cr);
+    cairo_paint (cr);
+
+    extents->x_advance = .8;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static uint32_t
+get_pixel (cairo_surface_t *image, int x, int y)
+{
+    uint32_t *row;
+
+    row = (uint32_t *) (cairo_image_surface_get_data (image) +
+			y * cairo_image_surface_get_stride (image));
+    return row[x];
+}
+
+static cairo_test_status_t
+check_glyphs (cairo_test_context_t *ctx,
+	      cairo_device_t *device,
+	      cairo_user_scaled_font_render_glyph_func_t render_glyph,
+	      const char *name,
+	      int size)
+{
+    cairo_font_face_t *font_face;
+    cairo_surface_t *surface, *image;
+    cairo_test_status_t result;
+    cairo_status_t status;
+    uint32_t inside, outside;
+    cairo_t *cr;
+
+    surface = cairo_gl_surface_create (device, CAIRO_CONTENT_COLOR_ALPHA,
+				       size, size);
+
+    font_face = cairo_user_font_face_create ();
+    cairo_user_font_face_set_render_glyph_func (font_face, render_glyph);
+
+    /* The glyph covers (.1, .1) to (.7, .9) of the surface. */
+    cr = cairo_create (surface);
+    cairo_set_font_face (cr, font_face);
+    cairo_set_font_size (cr, size);
+    cairo_move_to (cr, 0, .9 * size);
+    cairo_show_text (cr, "a");
+    status = cairo_status (cr);
+    cairo_destroy (cr);
+    cairo_font_face_destroy (font_face);
+
+    if (status) {
+	cairo_test_log (ctx, "Error: %s glyphs at %d: %s\n",
+			name, size, cairo_status_to_string (status));
+	cairo_surface_destroy (surface);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    image = cairo_surface_map_to_image (surface, NULL);
+    inside = get_pixel (image, .4 * size, .5 * size);
+    outside = get_pixel (image, .9 * size, .5 * size);
+    cairo_surface_unmap_image (surface, image);
+    cairo_surface_destroy (surface);
+
+    result = CAIRO_TEST_SUCCESS;
+    if (inside != 0xff000000 || outside != 0) {
+	cairo_test_log (ctx,
+			"Error: %s glyphs at %d: expected 0xff000000 and 0, "
+			"found 0x%08x and 0x%08x\n",
+			name, size, inside, outside);
+	result = CAIRO_TEST_FAILURE;
+    }
+
+    return result;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    int rgba_attribs[] = {
+	GLX_RGBA,
+	GLX_RED_SIZE, 1,
+	GLX_GREEN_SIZE, 1,
+	GLX_BLUE_SIZE, 1,
+	GLX_ALPHA_SIZE, 1,
+	GLX_DOUBLEBUFFER,
+	None
+    };
+    XVisualInfo *visinfo;
+    GLXContext glx_context;
+    cairo_device_t *device;
+    cairo_test_status_t result;
+    Display *dpy;
+
+    dpy = XOpenDisplay (NULL);
+    if (dpy == NULL)
+	return CAIRO_TEST_UNTESTED;
+
+    visinfo = glXChooseVisual (dpy, DefaultScreen (dpy), rgba_attribs);
+    if (visinfo == NULL) {
+	XCloseDisplay (dpy);
+	return CAIRO_TEST_UNTESTED;
+    }
+
+    glx_context = glXCreateContext (dpy, visinfo, NULL, True);
+    XFree (visinfo);
+    if (glx_context == NULL) {
+	XCloseDisplay (dpy);
+	return CAIRO_TEST_UNTESTED;
+    }
+
+    device = cairo_glx_device_create (dpy, glx_context);
+    cairo_gl_device_set_glyph_distance_field_threshold (device, THRESHOLD);
+
+    /* Below and above the size at which bitmaps are refused. */
+    result = check_glyphs (ctx, device, fill_glyph, "outline", 64);
+    if (result == CAIRO_TEST_SUCCESS)
+	result = check_glyphs (ctx, device, fill_glyph, "outline", 200);
+
+    /* Without outlines, the glyph cache takes the smaller glyphs, but
+     * the larger do not fit even when it is empty. */
+    if (result == CAIRO_TEST_SUCCESS)
+	result = check_glyphs (ctx, device, paint_glyph, "painted", 64);
+    if (result == CAIRO_TEST_SUCCESS)
+	result = check_glyphs (ctx, device, paint_glyph, "painted", 1400);
+
+    cairo_device_finish (device);
+    cairo_device_destroy (device);
+
+    glXDestroyContext (dpy, glx_context);
+    XCloseDisplay (dpy);
+
+    return result;
+}
+
+CAIRO_TEST (gl_glyph_distance_field,
+	    "Test drawing glyphs above the distance field threshold, with and without outlines",
+	    "gl, text", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
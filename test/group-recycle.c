@@ -0,0 +1,274 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Image groups are composited back using only the area drawn upon, and
+ * their surfaces are reused by later groups. Check that pixels written
+ * directly into a group are not lost, that a reused group starts out
+ * clear, and that a group is not reused while its pattern is alive.
+ */
+
+#include "cairo-test.h"
+
+#define SIZE 40
+
+static uint32_t
+get_pixel (cairo_surface_t *surface, int x, int y)
+{
+    unsigned char *data;
+    int stride;
+
+    cairo_surface_flush (surface);
+    data = cairo_image_surface_get_data (surface);
+    stride = cairo_image_surface_get_stride (surface);
+
+    return *(uint32_t *) (data + y * stride + 4 * x);
+}
+
+static cairo_test_status_t
+check_pixel (cairo_test_context_t *ctx,
+	     const char *name,
+	     cairo_surface_t *surface,
+	     int x, int y,
+	     uint32_t expected)
+{
+    uint32_t pixel = get_pixel (surface, x, y);
+
+    if (pixel != expected) {
+	cairo_test_log (ctx, "Error: %s: pixel (%d, %d) is %08x, expected %08x\n",
+			name, x, y, pixel, expected);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+static cairo_surface_t *
+create_target (void)
+{
+    return cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+}
+
+static void
+paint_pattern (cairo_surface_t *target, cairo_pattern_t *pattern)
+{
+    cairo_t *cr;
+
+    cr = cairo_create (target);
+    cairo_set_source (cr, pattern);
+    cairo_paint (cr);
+    cairo_destroy (cr);
+}
+
+/* Draw a little ink into a group, then write pixels elsewhere through
+ * the group target, bypassing the compositors. */
+static cairo_test_status_t
+direct_writes (cairo_test_context_t *ctx,
+	       const char *name,
+	       void (*write) (cairo_surface_t *group, int x, int y))
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    cairo_surface_t *target;
+    cairo_t *cr;
+
+    target = create_target ();
+    cr = cairo_create (target);
+
+    cairo_push_group (cr);
+    cairo_set_source_rgb (cr, 1, 0, 0);
+    cairo_rectangle (cr, 2, 2, 4, 4);
+    cairo_fill (cr);
+
+    write (cairo_get_group_target (cr), 30, 30);
+
+    cairo_pop_group_to_source (cr);
+    cairo_paint (cr);
+    cairo_destroy (cr);
+
+    if (check_pixel (ctx, name, target, 3, 3, 0xffff0000))
+	ret = CAIRO_TEST_FAILURE;
+    if (check_pixel (ctx, name, target, 30, 30, 0xff0000ff))
+	ret = CAIRO_TEST_FAILURE;
+    if (check_pixel (ctx, name, target, 20, 20, 0))
+	ret = CAIRO_TEST_FAILURE;
+
+    cairo_surface_destroy (target);
+
+    return ret;
+}
+
+static void
+write_data (cairo_surface_t *group, int x, int y)
+{
+    unsigned char *data;
+    int stride;
+
+    cairo_surface_flush (group);
+    data = cairo_image_surface_get_data (group);
+    stride = cairo_image_surface_get_stride (group);
+    *(uint32_t *) (data + y * stride + 4 * x) = 0xff0000ff;
+    cairo_surface_mark_dirty_rectangle (group, x, y, 1, 1);
+}
+
+static void
+write_mapped_subsurface (cairo_surface_t *group, int x, int y)
+{
+    cairo_surface_t *subsurface, *image;
+    unsigned char *data;
+    int stride;
+
+    subsurface = cairo_surface_create_for_rectangle (group, x - 2, y - 2, 4, 4);
+    image = cairo_surface_map_to_image (subsurface, NULL);
+    data = cairo_image_surface_get_data (image);
+    stride = cairo_image_surface_get_stride (image);
+    *(uint32_t *) (data + 2 * stride + 4 * 2) = 0xff0000ff;
+    cairo_surface_unmap_image (subsurface, image);
+    cairo_surface_destroy (subsurface);
+}
+
+/* Each group draws in a different corner, so anything left over from an
+ * earlier group shows up in the wrong place. */
+static cairo_pattern_t *
+corner_group (cairo_t *cr, int x, int y, double red, double green, double blue)
+{
+    cairo_push_group (cr);
+    cairo_set_source_rgb (cr, red, green, blue);
+    cairo_rectangle (cr, x, y, 10, 10);
+    cairo_fill (cr);
+    return cairo_pop_group (cr);
+}
+
+static cairo_test_status_t
+reuse (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    cairo_surface_t *target, *result;
+    cairo_pattern_t *first, *second, *third;
+    cairo_t *cr;
+
+    target = create_target ();
+    cr = cairo_create (target);
+
+    /* released straight away, so its surface is free for reuse */
+    first = corner_group (cr, 0, 0, 1, 0, 0);
+    cairo_set_source (cr, first);
+    cairo_paint (cr);
+    cairo_pattern_destroy (first);
+
+    /* kept alive while further groups are pushed */
+    second = corner_group (cr, 30, 0, 0, 1, 0);
+    third = corner_group (cr, 0, 30, 0, 0, 1);
+
+    cairo_destroy (cr);
+
+    result = create_target ();
+    paint_pattern (result, second);
+    if (check_pixel (ctx, "reuse-second", result, 35, 5, 0xff00ff00))
+	ret = CAIRO_TEST_FAILURE;
+    if (check_pixel (ctx, "reuse-second", result, 5, 5, 0))
+	ret = CAIRO_TEST_FAILURE;
+    if (check_pixel (ctx, "reuse-second", result, 5, 35, 0))
+	ret = CAIRO_TEST_FAILURE;
+    cairo_surface_destroy (result);
+
+    result = create_target ();
+    paint_pattern (result, third);
+    if (check_pixel (ctx, "reuse-third", result, 5, 35, 0xff0000ff))
+	ret = CAIRO_TEST_FAILURE;
+    if (check_pixel (ctx, "reuse-third", result, 5, 5, 0))
+	ret = CAIRO_TEST_FAILURE;
+    if (check_pixel (ctx, "reuse-third", result, 35, 5, 0))
+	ret = CAIRO_TEST_FAILURE;
+    cairo_surface_destroy (result);
+
+    cairo_pattern_destroy (third);
+    cairo_pattern_destroy (second);
+
+    /* the first group only touches its own corner of the target */
+    if (check_pixel (ctx, "reuse-first", target, 5, 5, 0xffff0000))
+	ret = CAIRO_TEST_FAILURE;
+    if (check_pixel (ctx, "reuse-first", target, 35, 35, 0))
+	ret = CAIRO_TEST_FAILURE;
+
+    cairo_surface_destroy (target);
+
+    return ret;
+}
+
+/* Only the ink of a group is composited back, so operators that affect
+ * the destination outside of the source must still be applied to the
+ * whole of it. */
+static cairo_test_status_t
+unbounded (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    cairo_surface_t *target;
+    cairo_pattern_t *group;
+    cairo_t *cr;
+
+    target = create_target ();
+    cr = cairo_create (target);
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    group = corner_group (cr, 10, 10, 1, 0, 0);
+    cairo_set_source (cr, group);
+    cairo_set_operator (cr, CAIRO_OPERATOR_IN);
+    cairo_paint (cr);
+    cairo_pattern_destroy (group);
+    cairo_destroy (cr);
+
+    if (check_pixel (ctx, "unbounded", target, 15, 15, 0xffff0000))
+	ret = CAIRO_TEST_FAILURE;
+    if (check_pixel (ctx, "unbounded", target, 30, 30, 0))
+	ret = CAIRO_TEST_FAILURE;
+
+    cairo_surface_destroy (target);
+
+    return ret;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+
+    if (direct_writes (ctx, "get-data", write_data))
+	ret = CAIRO_TEST_FAILURE;
+
+    if (direct_writes (ctx, "map-subsurface", write_mapped_subsurface))
+	ret = CAIRO_TEST_FAILURE;
+
+    if (reuse (ctx))
+	ret = CAIRO_TEST_FAILURE;
+
+    if (unbounded (ctx))
+	ret = CAIRO_TEST_FAILURE;
+
+    return ret;
+}
+
+CAIRO_TEST (group_recycle,
+	    "Check the reuse and bounded compositing of image groups",
+	    "group", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,178 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* A stroke covers the union of its pieces, so where a hairline crosses,
+ * joins or retraces itself it must be no darker than the outline of the
+ * stroke. Compare each hairline with the same stroke drawn at 8 times
+ * the size and scaled down. */
+
+#include "cairo-test.h"
+
+#define SIZE 32
+#define SCALE 8
+
+/* The largest error we accept, in 1/255ths, against the downscaled
+ * stroke. Summing the coverage of the pieces where they overlap is off
+ * by 64 or more. */
+#define MAX_ERROR 40
+
+static void
+single (cairo_t *cr)
+{
+    cairo_move_to (cr, 3.2, 4.7);
+    cairo_line_to (cr, 28.6, 19.1);
+}
+
+static void
+dashed (cairo_t *cr)
+{
+    static const double dash[] = { 3, 1.5 };
+
+    cairo_set_dash (cr, dash, 2, 0.7);
+    cairo_move_to (cr, 4.3, 27.2);
+    cairo_line_to (cr, 27.1, 5.6);
+}
+
+static void
+crossing (cairo_t *cr)
+{
+    cairo_move_to (cr, 4, 16);
+    cairo_line_to (cr, 28, 16);
+    cairo_move_to (cr, 16, 4);
+    cairo_line_to (cr, 16, 28);
+    cairo_move_to (cr, 4.3, 5.1);
+    cairo_line_to (cr, 27.4, 26.8);
+}
+
+static void
+joined (cairo_t *cr)
+{
+    cairo_move_to (cr, 4.5, 6.2);
+    cairo_line_to (cr, 16.3, 26.7);
+    cairo_line_to (cr, 27.2, 6.9);
+    cairo_line_to (cr, 6.1, 9.3);
+}
+
+static void
+retraced (cairo_t *cr)
+{
+    cairo_move_to (cr, 5.1, 9.4);
+    cairo_line_to (cr, 26.3, 21.9);
+    cairo_line_to (cr, 5.1, 9.4);
+}
+
+static const struct {
+    const char *name;
+    void (*path) (cairo_t *cr);
+} strokes[] = {
+    { "single", single },
+    { "dashed", dashed },
+    { "crossing", crossing },
+    { "joined", joined },
+    { "retraced", retraced },
+};
+
+static cairo_surface_t *
+draw (void (*path) (cairo_t *cr), int scale)
+{
+    cairo_surface_t *surface;
+    cairo_t *cr;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8,
+					  SIZE * scale, SIZE * scale);
+    cr = cairo_create (surface);
+    cairo_scale (cr, scale, scale);
+    cairo_set_line_width (cr, 1);
+    cairo_set_line_cap (cr, CAIRO_LINE_CAP_BUTT);
+    cairo_set_line_join (cr, CAIRO_LINE_JOIN_MITER);
+    path (cr);
+    cairo_stroke (cr);
+    cairo_destroy (cr);
+
+    cairo_surface_flush (surface);
+    return surface;
+}
+
+static cairo_test_status_t
+check_stroke (cairo_test_context_t *ctx, int n)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    cairo_surface_t *hairline, *reference;
+    unsigned char *data, *ref;
+    int stride, ref_stride, x, y;
+
+    hairline = draw (strokes[n].path, 1);
+    reference = draw (strokes[n].path, SCALE);
+
+    data = cairo_image_surface_get_data (hairline);
+    stride = cairo_image_surface_get_stride (hairline);
+    ref = cairo_image_surface_get_data (reference);
+    ref_stride = cairo_image_surface_get_stride (reference);
+
+    for (y = 0; y < SIZE && ret == CAIRO_TEST_SUCCESS; y++) {
+	for (x = 0; x < SIZE; x++) {
+	    int i, j, sum = 0, expected;
+
+	    for (j = 0; j < SCALE; j++) {
+		const unsigned char *row = ref + (y * SCALE + j) * ref_stride;
+
+		for (i = 0; i < SCALE; i++)
+		    sum += row[x * SCALE + i];
+	    }
+	    expected = (sum + SCALE * SCALE / 2) / (SCALE * SCALE);
+
+	    if (abs (data[y * stride + x] - expected) > MAX_ERROR) {
+		cairo_test_log (ctx, "Error: %s: coverage of pixel (%d, %d) is %d, expected %d\n",
+				strokes[n].name, x, y,
+				data[y * stride + x], expected);
+		ret = CAIRO_TEST_FAILURE;
+		break;
+	    }
+	}
+    }
+
+    cairo_surface_destroy (reference);
+    cairo_surface_destroy (hairline);
+
+    return ret;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    unsigned int n;
+
+    for (n = 0; n < ARRAY_LENGTH (strokes); n++) {
+	if (check_stroke (ctx, n))
+	    ret = CAIRO_TEST_FAILURE;
+    }
+
+    return ret;
+}
+
+CAIRO_TEST (hairline_overlap,
+	    "Check that crossing, joined and retraced hairlines are not overdrawn",
+	    "stroke", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,227 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Check that the batched hit tests agree with cairo_in_fill() and
+ * cairo_in_stroke() asked one point at a time. */
+
+#include "cairo-test.h"
+
+#define GRID 41
+
+static double points[2 * GRID * GRID];
+static cairo_bool_t inside[GRID * GRID];
+static cairo_bool_t prepared[GRID * GRID];
+
+static void
+make_grid (double offset)
+{
+    int i, j, n = 0;
+
+    for (i = 0; i < GRID; i++) {
+	for (j = 0; j < GRID; j++) {
+	    points[n++] = j + offset - 0.5;
+	    points[n++] = i + offset - 0.5;
+	}
+    }
+}
+
+static void
+star (cairo_t *cr)
+{
+    int i;
+
+    cairo_new_path (cr);
+    cairo_move_to (cr, 20 + 18, 20);
+    for (i = 1; i < 11; i++) {
+	double theta = i * 4 * M_PI / 5 + (i & 1) * 0.3;
+	double r = (i & 1) ? 9 : 18;
+	cairo_line_to (cr, 20 + r * cos (theta), 20 + r * sin (theta));
+    }
+    cairo_close_path (cr);
+    cairo_move_to (cr, 2, 38);
+    cairo_curve_to (cr, 40, 20, 0, 0, 38, 2);
+    cairo_arc (cr, 20, 20, 6, 0, 2 * M_PI);
+}
+
+static cairo_test_status_t
+check_fill (cairo_test_context_t *ctx, cairo_t *cr, const char *name)
+{
+    cairo_hit_test_t *hit_test;
+    cairo_path_t *path;
+    int n;
+
+    make_grid (0.25);
+
+    cairo_in_fill_points (cr, points, GRID * GRID, inside);
+    for (n = 0; n < GRID * GRID; n++) {
+	if (cairo_in_fill (cr, points[2*n], points[2*n+1]) != inside[n]) {
+	    cairo_test_log (ctx, "Error: %s: cairo_in_fill_points disagrees with cairo_in_fill at (%g, %g)\n",
+			    name, points[2*n], points[2*n+1]);
+	    return CAIRO_TEST_FAILURE;
+	}
+    }
+
+    /* the prepared hit test must not depend upon the current path */
+    hit_test = cairo_hit_test_create_for_fill (cr);
+    path = cairo_copy_path (cr);
+    cairo_new_path (cr);
+    cairo_hit_test_contains_points (hit_test, points, GRID * GRID, prepared);
+    cairo_append_path (cr, path);
+    cairo_path_destroy (path);
+    cairo_hit_test_destroy (hit_test);
+
+    for (n = 0; n < GRID * GRID; n++) {
+	if (prepared[n] != inside[n]) {
+	    cairo_test_log (ctx, "Error: %s: cairo_hit_test_contains_points disagrees with cairo_in_fill at (%g, %g)\n",
+			    name, points[2*n], points[2*n+1]);
+	    return CAIRO_TEST_FAILURE;
+	}
+    }
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+static cairo_test_status_t
+check_stroke (cairo_test_context_t *ctx, cairo_t *cr, const char *name,
+	      double offset)
+{
+    cairo_hit_test_t *hit_test;
+    cairo_path_t *path;
+    int n;
+
+    make_grid (offset);
+
+    cairo_in_stroke_points (cr, points, GRID * GRID, inside);
+    for (n = 0; n < GRID * GRID; n++) {
+	if (cairo_in_stroke (cr, points[2*n], points[2*n+1]) != inside[n]) {
+	    cairo_test_log (ctx, "Error: %s: cairo_in_stroke_points disagrees with cairo_in_stroke at (%g, %g)\n",
+			    name, points[2*n], points[2*n+1]);
+	    return CAIRO_TEST_FAILURE;
+	}
+    }
+
+    /* the prepared hit test must not depend upon the current path */
+    hit_test = cairo_hit_test_create_for_stroke (cr);
+    path = cairo_copy_path (cr);
+    cairo_new_path (cr);
+    cairo_hit_test_contains_points (hit_test, points, GRID * GRID, prepared);
+    cairo_append_path (cr, path);
+    cairo_path_destroy (path);
+    cairo_hit_test_destroy (hit_test);
+
+    for (n = 0; n < GRID * GRID; n++) {
+	if (prepared[n] != inside[n]) {
+	    cairo_test_log (ctx, "Error: %s: cairo_hit_test_contains_points disagrees with cairo_in_stroke at (%g, %g)\n",
+			    name, points[2*n], points[2*n+1]);
+	    return CAIRO_TEST_FAILURE;
+	}
+    }
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    cairo_surface_t *surface;
+    cairo_hit_test_t *hit_test;
+    cairo_t *cr;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 0, 0);
+    cr = cairo_create (surface);
+    cairo_surface_destroy (surface);
+
+    star (cr);
+    cairo_set_fill_rule (cr, CAIRO_FILL_RULE_WINDING);
+    if (check_fill (ctx, cr, "winding"))
+	ret = CAIRO_TEST_FAILURE;
+    cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+    if (check_fill (ctx, cr, "even-odd"))
+	ret = CAIRO_TEST_FAILURE;
+
+    cairo_translate (cr, 40, 0);
+    cairo_rotate (cr, M_PI / 2);
+    cairo_scale (cr, 0.75, 1.25);
+    star (cr);
+    if (check_fill (ctx, cr, "transformed"))
+	ret = CAIRO_TEST_FAILURE;
+
+    cairo_identity_matrix (cr);
+    cairo_new_path (cr);
+    cairo_move_to (cr, 4, 4);
+    cairo_line_to (cr, 36, 4);
+    cairo_line_to (cr, 36, 36);
+    cairo_line_to (cr, 20, 36);
+    cairo_line_to (cr, 20, 12);
+    cairo_line_to (cr, 4, 12);
+    cairo_set_line_width (cr, 4);
+    cairo_set_line_join (cr, CAIRO_LINE_JOIN_MITER);
+    cairo_set_line_cap (cr, CAIRO_LINE_CAP_SQUARE);
+    /* keep clear of the edges of the axis-aligned stroke */
+    if (check_stroke (ctx, cr, "stroke", 0.5))
+	ret = CAIRO_TEST_FAILURE;
+
+    /* a dashed curve whose dashes overlap at the joins */
+    {
+	static const double dash[] = { 4.5, 2.5 };
+
+	cairo_curve_to (cr, 4, 20, 30, 30, 10, 38);
+	cairo_set_dash (cr, dash, 2, 1);
+	if (check_stroke (ctx, cr, "dashed", 0.25))
+	    ret = CAIRO_TEST_FAILURE;
+	cairo_set_dash (cr, NULL, 0, 0);
+    }
+
+    cairo_set_line_width (cr, 0);
+    cairo_in_stroke_points (cr, points, GRID * GRID, inside);
+    if (inside[GRID * 4 + 4]) {
+	cairo_test_log (ctx, "Error: Found point inside a stroke of zero width\n");
+	ret = CAIRO_TEST_FAILURE;
+    }
+
+    /* an empty path contains nothing */
+    cairo_new_path (cr);
+    hit_test = cairo_hit_test_create_for_fill (cr);
+    if (cairo_hit_test_status (hit_test)) {
+	cairo_test_log (ctx, "Error: Failed to create a hit test for an empty path\n");
+	ret = CAIRO_TEST_FAILURE;
+    }
+    inside[0] = TRUE;
+    cairo_hit_test_contains_points (hit_test, points, 1, inside);
+    if (inside[0]) {
+	cairo_test_log (ctx, "Error: Found point inside an empty path\n");
+	ret = CAIRO_TEST_FAILURE;
+    }
+    cairo_hit_test_destroy (hit_test);
+
+    cairo_destroy (cr);
+
+    return ret;
+}
+
+CAIRO_TEST (in_fill_points,
+	    "Test cairo_in_fill_points and cairo_in_stroke_points",
+	    "in, trap", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,237 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+#include <stdio.h>
+#include <errno.h>
+
+#if CAIRO_HAS_PDF_SURFACE
+#include <cairo-pdf.h>
+#endif
+
+/* Check that a mime surface is only decoded when its pixels are
+ * required and that it then renders identically to the decoded image.
+ */
+
+#define IMAGE_FILE "romedalen.png"
+
+typedef struct _png_data {
+    const unsigned char *data;
+    unsigned long length;
+    int decode_count;
+} png_data_t;
+
+static cairo_status_t
+read_png (void *closure, unsigned char *data, unsigned int length)
+{
+    png_data_t *png = closure;
+
+    if (length > png->length)
+	return CAIRO_STATUS_READ_ERROR;
+
+    memcpy (data, png->data, length);
+    png->data += length;
+    png->length -= length;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_surface_t *
+decode (void *closure,
+	const char *mime_type,
+	const unsigned char *data,
+	unsigned long length)
+{
+    png_data_t *count = closure;
+    png_data_t png;
+
+    count->decode_count++;
+
+    png.data = data;
+    png.length = length;
+    return cairo_image_surface_create_from_png_stream (read_png, &png);
+}
+
+static cairo_status_t
+read_file (const cairo_test_context_t *ctx,
+	   const char *filename,
+	   unsigned char **data_out,
+	   unsigned long *length_out)
+{
+    FILE *file;
+    unsigned char *buf;
+    unsigned long len;
+
+    file = fopen (filename, "rb");
+    if (file == NULL) {
+	char path[4096];
+
+	/* try again with srcdir */
+	snprintf (path, sizeof (path),
+		  "%s/%s", ctx->srcdir, filename);
+	file = fopen (path, "rb");
+    }
+    if (file == NULL)
+	return errno == ENOMEM ? CAIRO_STATUS_NO_MEMORY : CAIRO_STATUS_FILE_NOT_FOUND;
+
+    fseek (file, 0, SEEK_END);
+    len = ftell (file);
+    fseek (file, 0, SEEK_SET);
+
+    buf = xmalloc (len);
+    *length_out = fread (buf, 1, len, file);
+    fclose (file);
+    if (*length_out != len) {
+	free (buf);
+	return CAIRO_STATUS_READ_ERROR;
+    }
+
+    *data_out = buf;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_surface_t *
+render (cairo_surface_t *source, int width, int height)
+{
+    cairo_surface_t *image;
+    cairo_t *cr;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_RGB24, width, height);
+    cr = cairo_create (image);
+    cairo_set_source_surface (cr, source, 0, 0);
+    cairo_paint (cr);
+    cairo_destroy (cr);
+
+    return image;
+}
+
+static cairo_bool_t
+images_equal (cairo_surface_t *a, cairo_surface_t *b)
+{
+    int height = cairo_image_surface_get_height (a);
+    int stride = cairo_image_surface_get_stride (a);
+
+    cairo_surface_flush (a);
+    cairo_surface_flush (b);
+    return memcmp (cairo_image_surface_get_data (a),
+		   cairo_image_surface_get_data (b),
+		   stride * height) == 0;
+}
+
+#if CAIRO_HAS_PDF_SURFACE
+static cairo_status_t
+null_write (void *closure, const unsigned char *data, unsigned int length)
+{
+    return CAIRO_STATUS_SUCCESS;
+}
+#endif
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_surface_t *surface, *image, *a, *b;
+    unsigned char *data;
+    unsigned long length;
+    png_data_t count = { NULL, 0, 0 };
+    cairo_test_status_t result = CAIRO_TEST_SUCCESS;
+    cairo_status_t status;
+    int width, height;
+
+    status = read_file (ctx, IMAGE_FILE, &data, &length);
+    if (status)
+	return cairo_test_status_from_status (ctx, status);
+
+    surface = cairo_mime_surface_create (CAIRO_MIME_TYPE_PNG,
+					 data, length,
+					 free, data);
+    status = cairo_surface_status (surface);
+    if (status) {
+	cairo_surface_destroy (surface);
+	return cairo_test_status_from_status (ctx, status);
+    }
+    cairo_mime_surface_set_decoder (surface, decode, &count);
+
+    if (cairo_surface_get_type (surface) != CAIRO_SURFACE_TYPE_MIME ||
+	cairo_surface_get_content (surface) != CAIRO_CONTENT_COLOR)
+    {
+	cairo_test_log (ctx, "Unexpected type or content of mime surface\n");
+	cairo_surface_destroy (surface);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    image = cairo_test_create_surface_from_png (ctx, IMAGE_FILE);
+    width = cairo_image_surface_get_width (image);
+    height = cairo_image_surface_get_height (image);
+
+#if CAIRO_HAS_PDF_SURFACE
+    if (cairo_test_is_target_enabled (ctx, "pdf")) {
+	cairo_surface_t *pdf;
+	cairo_t *cr;
+
+	pdf = cairo_pdf_surface_create_for_stream (null_write, NULL,
+						   width, height);
+	cr = cairo_create (pdf);
+	cairo_set_source_surface (cr, surface, 0, 0);
+	cairo_paint (cr);
+	cairo_destroy (cr);
+	cairo_surface_finish (pdf);
+	status = cairo_surface_status (pdf);
+	cairo_surface_destroy (pdf);
+
+	if (status) {
+	    cairo_test_log (ctx, "Failed to write pdf: %s\n",
+			    cairo_status_to_string (status));
+	    result = CAIRO_TEST_FAILURE;
+	    goto CLEANUP;
+	}
+
+	if (count.decode_count != 0) {
+	    cairo_test_log (ctx, "Mime surface was decoded for PDF output\n");
+	    result = CAIRO_TEST_FAILURE;
+	    goto CLEANUP;
+	}
+    }
+#endif
+
+    a = render (surface, width, height);
+    b = render (image, width, height);
+    if (count.decode_count != 1 || ! images_equal (a, b)) {
+	cairo_test_log (ctx, "Mime surface did not render like its decoded image\n");
+	result = CAIRO_TEST_FAILURE;
+    }
+    cairo_surface_destroy (a);
+    cairo_surface_destroy (b);
+
+CLEANUP:
+    cairo_surface_destroy (image);
+    cairo_surface_destroy (surface);
+
+    return result;
+}
+
+CAIRO_TEST (mime_surface,
+	    "Check that mime surfaces are decoded lazily",
+	    "api, mime-data", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,178 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <cairo.h>
+#include <cairo-pdf.h>
+
+/* This test checks that the compressed image data of an opaque PNG
+ * attached as mime data is copied unchanged into the PDF output.
+ */
+
+#define IMAGE_FILE "romedalen.png"
+
+typedef struct _buffer {
+    unsigned char *data;
+    unsigned int length;
+    unsigned int size;
+} buffer_t;
+
+static cairo_status_t
+write_buffer (void *closure, const unsigned char *data, unsigned int length)
+{
+    buffer_t *buffer = closure;
+
+    if (buffer->length + length > buffer->size) {
+	while (buffer->length + length > buffer->size)
+	    buffer->size = buffer->size ? 2 * buffer->size : 4096;
+	buffer->data = xrealloc (buffer->data, buffer->size);
+    }
+
+    memcpy (buffer->data + buffer->length, data, length);
+    buffer->length += length;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static uint32_t
+get_be32 (const unsigned char *p)
+{
+    return p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+/* Concatenate the payload of all IDAT chunks. */
+static void
+extract_idat (const unsigned char *png, unsigned long png_length,
+	      buffer_t *idat)
+{
+    const unsigned char *p = png + 8;
+    const unsigned char *end = png + png_length;
+
+    while (end - p >= 12) {
+	uint32_t length = get_be32 (p);
+
+	if (memcmp (p + 4, "IDAT", 4) == 0)
+	    write_buffer (idat, p + 8, length);
+
+	p += length + 12;
+    }
+}
+
+static cairo_bool_t
+buffer_contains (const buffer_t *haystack,
+		 const unsigned char *needle, unsigned int length)
+{
+    unsigned int i;
+
+    if (length > haystack->length)
+	return FALSE;
+
+    for (i = 0; i <= haystack->length - length; i++) {
+	if (memcmp (haystack->data + i, needle, length) == 0)
+	    return TRUE;
+    }
+
+    return FALSE;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_surface_t *image;
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    cairo_status_t status;
+    const unsigned char *png;
+    unsigned long png_length;
+    buffer_t pdf = { NULL, 0, 0 };
+    buffer_t idat = { NULL, 0, 0 };
+    const char predictor[] = "/Predictor 15";
+    cairo_test_status_t result = CAIRO_TEST_SUCCESS;
+
+    if (! cairo_test_is_target_enabled (ctx, "pdf"))
+	return CAIRO_TEST_UNTESTED;
+
+    image = cairo_image_surface_create_from_png (IMAGE_FILE);
+    status = cairo_surface_status (image);
+    if (status) {
+	cairo_test_log (ctx, "Could not read input png file %s\n", IMAGE_FILE);
+	cairo_surface_destroy (image);
+	return cairo_test_status_from_status (ctx, status);
+    }
+
+    cairo_surface_get_mime_data (image, CAIRO_MIME_TYPE_PNG, &png, &png_length);
+    if (png == NULL) {
+	cairo_test_log (ctx, "No png mime data attached to %s\n", IMAGE_FILE);
+	cairo_surface_destroy (image);
+	return CAIRO_TEST_FAILURE;
+    }
+    extract_idat (png, png_length, &idat);
+
+    surface = cairo_pdf_surface_create_for_stream (write_buffer, &pdf,
+						   cairo_image_surface_get_width (image),
+						   cairo_image_surface_get_height (image));
+    cr = cairo_create (surface);
+    cairo_set_source_surface (cr, image, 0, 0);
+    cairo_paint (cr);
+    status = cairo_status (cr);
+    cairo_destroy (cr);
+    cairo_surface_finish (surface);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = cairo_surface_status (surface);
+    cairo_surface_destroy (surface);
+    cairo_surface_destroy (image);
+
+    if (status) {
+	cairo_test_log (ctx, "Failed to create pdf surface: %s\n",
+			cairo_status_to_string (status));
+	result = CAIRO_TEST_FAILURE;
+	goto CLEANUP;
+    }
+
+    if (! buffer_contains (&pdf, (unsigned char *) predictor, strlen (predictor))) {
+	cairo_test_log (ctx, "image was not embedded with a PNG predictor\n");
+	result = CAIRO_TEST_FAILURE;
+	goto CLEANUP;
+    }
+
+    if (idat.length == 0 || ! buffer_contains (&pdf, idat.data, idat.length)) {
+	cairo_test_log (ctx, "output image data does not match source IDAT data\n");
+	result = CAIRO_TEST_FAILURE;
+	goto CLEANUP;
+    }
+
+CLEANUP:
+    free (pdf.data);
+    free (idat.data);
+
+    return result;
+}
+
+CAIRO_TEST (pdf_mime_data_png,
+	    "Check PNG mime data is embedded without recompression by PDF surface",
+	    "pdf, mime-data", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,173 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Check that cairo_recording_surface_diff() reports the extents of the
+ * operations that differ between two recordings, and nothing else. */
+
+#include "cairo-test.h"
+
+#define NUM_BOXES 20
+
+/* A column of boxes, with box @changed drawn in another colour, box
+ * @missing left out and an extra box drawn after box @extra. */
+static cairo_surface_t *
+record (int changed, int missing, int extra)
+{
+    cairo_rectangle_t extents = { 0, 0, 100, 10 * NUM_BOXES };
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    int i;
+
+    surface = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA,
+					      &extents);
+    cr = cairo_create (surface);
+
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    for (i = 0; i < NUM_BOXES; i++) {
+	if (i != missing) {
+	    if (i == changed)
+		cairo_set_source_rgb (cr, 1, 0, 0);
+	    else
+		cairo_set_source_rgb (cr, 0, 0, 1);
+	    cairo_rectangle (cr, 10, 10 * i + 2, 40, 6);
+	    cairo_fill (cr);
+	}
+
+	if (i == extra) {
+	    cairo_set_source_rgb (cr, 0, 1, 0);
+	    cairo_rectangle (cr, 60, 10 * i + 2, 30, 6);
+	    cairo_fill (cr);
+	}
+    }
+
+    cairo_destroy (cr);
+
+    return surface;
+}
+
+static cairo_bool_t
+check_diff (const cairo_test_context_t *ctx,
+	    cairo_surface_t *a, cairo_surface_t *b,
+	    const cairo_rectangle_int_t *expected, int num_expected,
+	    const char *message)
+{
+    cairo_region_t *region, *expected_region;
+    cairo_bool_t ret;
+
+    region = cairo_recording_surface_diff (a, b);
+    expected_region = cairo_region_create_rectangles (expected, num_expected);
+
+    ret = cairo_region_status (region) == CAIRO_STATUS_SUCCESS &&
+	  cairo_region_equal (region, expected_region);
+    if (! ret) {
+	cairo_rectangle_int_t extents;
+
+	cairo_region_get_extents (region, &extents);
+	cairo_test_log (ctx, "Error: %s; found %d rectangles within (%d, %d) x (%d, %d), status %d\n",
+			message,
+			cairo_region_num_rectangles (region),
+			extents.x, extents.y, extents.width, extents.height,
+			cairo_region_status (region));
+    }
+
+    cairo_region_destroy (expected_region);
+    cairo_region_destroy (region);
+
+    return ret;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    static const cairo_rectangle_int_t box3 = { 10, 32, 40, 6 };
+    static const cairo_rectangle_int_t boxes3_15[] = {
+	{ 10, 32, 40, 6 },
+	{ 10, 152, 40, 6 },
+    };
+    static const cairo_rectangle_int_t extra7 = { 60, 72, 30, 6 };
+    static const cairo_rectangle_int_t missing_and_extra[] = {
+	{ 10, 42, 40, 6 },
+	{ 60, 162, 30, 6 },
+    };
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    cairo_surface_t *base, *other, *image;
+    cairo_region_t *region;
+
+    base = record (-1, -1, -1);
+
+    other = record (-1, -1, -1);
+    if (! check_diff (ctx, base, other, NULL, 0, "identical recordings"))
+	ret = CAIRO_TEST_FAILURE;
+    cairo_surface_destroy (other);
+
+    other = record (3, -1, -1);
+    if (! check_diff (ctx, base, other, &box3, 1, "one changed colour"))
+	ret = CAIRO_TEST_FAILURE;
+    cairo_surface_destroy (other);
+
+    other = record (-1, 3, -1);
+    if (! check_diff (ctx, base, other, &box3, 1, "one removed box"))
+	ret = CAIRO_TEST_FAILURE;
+    if (! check_diff (ctx, other, base, &box3, 1, "one added box"))
+	ret = CAIRO_TEST_FAILURE;
+    cairo_surface_destroy (other);
+
+    other = record (3, 15, -1);
+    if (! check_diff (ctx, base, other, boxes3_15, 2, "two separate changes"))
+	ret = CAIRO_TEST_FAILURE;
+    cairo_surface_destroy (other);
+
+    other = record (-1, -1, 7);
+    if (! check_diff (ctx, base, other, &extra7, 1, "an inserted box"))
+	ret = CAIRO_TEST_FAILURE;
+    cairo_surface_destroy (other);
+
+    other = record (-1, 4, 16);
+    if (! check_diff (ctx, base, other, missing_and_extra, 2,
+		      "a removed and an inserted box"))
+	ret = CAIRO_TEST_FAILURE;
+    cairo_surface_destroy (other);
+
+    /* only recording-surfaces can be compared */
+    image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 10, 10);
+    region = cairo_recording_surface_diff (base, image);
+    if (cairo_region_status (region) != CAIRO_STATUS_SURFACE_TYPE_MISMATCH) {
+	cairo_test_log (ctx, "Error: Expected a surface type mismatch comparing with an image, found %s\n",
+			cairo_status_to_string (cairo_region_status (region)));
+	ret = CAIRO_TEST_FAILURE;
+    }
+    cairo_region_destroy (region);
+    cairo_surface_destroy (image);
+
+    cairo_surface_destroy (base);
+
+    return ret;
+}
+
+CAIRO_TEST (recording_surface_diff,
+	    "Test cairo_recording_surface_diff",
+	    "recording, api", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
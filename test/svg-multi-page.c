@@ -0,0 +1,193 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* The SVG surface writes each page out once the next one is finished.
+ * Check that every gradient, clip and glyph a page refers to is defined
+ * ahead of it, and that nothing follows the pageSet of an SVG 1.2
+ * document.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <cairo-svg.h>
+#include "cairo-test.h"
+
+#define SIZE 100
+#define NUM_PAGES 3
+
+typedef struct _buffer {
+    char *data;
+    size_t length;
+} buffer_t;
+
+static cairo_status_t
+write_buffer (void *closure, const unsigned char *data, unsigned int length)
+{
+    buffer_t *buffer = closure;
+    char *new_data;
+
+    new_data = realloc (buffer->data, buffer->length + length + 1);
+    if (new_data == NULL)
+	return CAIRO_STATUS_WRITE_ERROR;
+
+    memcpy (new_data + buffer->length, data, length);
+    buffer->data = new_data;
+    buffer->length += length;
+    buffer->data[buffer->length] = '\0';
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+draw_page (cairo_t *cr, int page)
+{
+    cairo_pattern_t *gradient;
+    char text[32];
+
+    gradient = cairo_pattern_create_linear (0, 0, SIZE, 0);
+    cairo_pattern_add_color_stop_rgb (gradient, 0, 1, 0, 0);
+    cairo_pattern_add_color_stop_rgb (gradient, 1, 0, 0, 1);
+    cairo_set_source (cr, gradient);
+    cairo_pattern_destroy (gradient);
+    cairo_rectangle (cr, 10 + page, 10, 50, 20);
+    cairo_fill (cr);
+
+    cairo_save (cr);
+    cairo_arc (cr, SIZE / 2, SIZE / 2, 20, 0, 2 * M_PI);
+    cairo_clip (cr);
+    cairo_set_source_rgb (cr, 0, .5, 0);
+    cairo_paint_with_alpha (cr, .5);
+    cairo_restore (cr);
+
+    /* each page introduces glyphs that earlier pages did not use */
+    cairo_select_font_face (cr, CAIRO_TEST_FONT_FAMILY " Sans",
+			    CAIRO_FONT_SLANT_NORMAL,
+			    CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size (cr, 12);
+    cairo_set_source_rgb (cr, 0, 0, 0);
+    cairo_move_to (cr, 10, 80);
+    sprintf (text, "Page %c%d", 'a' + page, page);
+    cairo_show_text (cr, text);
+
+    cairo_show_page (cr);
+}
+
+static cairo_test_status_t
+check_document (cairo_test_context_t *ctx,
+		const char	     *version,
+		const char	     *data)
+{
+    const char *href, *end;
+
+    for (href = strstr (data, "href=\"#");
+	 href != NULL;
+	 href = strstr (href + 1, "href=\"#"))
+    {
+	char id[64];
+	const char *def;
+	int length;
+
+	length = strcspn (href + 7, "\"");
+	if (length >= (int) sizeof (id) - 6)
+	    length = sizeof (id) - 6;
+	sprintf (id, " id=\"%.*s\"", length, href + 7);
+
+	def = strstr (data, id);
+	if (def == NULL || def > href) {
+	    cairo_test_log (ctx, "Error: %s: %s is used before it is defined\n",
+			    version, id + 1);
+	    return CAIRO_TEST_FAILURE;
+	}
+    }
+
+    end = strstr (data, "</pageSet>");
+    if (end != NULL && strcmp (end, "</pageSet>\n</svg>\n") != 0) {
+	cairo_test_log (ctx, "Error: %s: content follows the pageSet\n",
+			version);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+static cairo_test_status_t
+check_version (cairo_test_context_t *ctx, cairo_svg_version_t version)
+{
+    const char *name = cairo_svg_version_to_string (version);
+    cairo_test_status_t ret;
+    cairo_surface_t *surface;
+    buffer_t buffer = { NULL, 0 };
+    cairo_t *cr;
+    int page;
+
+    surface = cairo_svg_surface_create_for_stream (write_buffer, &buffer,
+						   SIZE, SIZE);
+    cairo_svg_surface_restrict_to_version (surface, version);
+
+    cr = cairo_create (surface);
+    for (page = 0; page < NUM_PAGES; page++)
+	draw_page (cr, page);
+    cairo_destroy (cr);
+
+    cairo_surface_finish (surface);
+    if (cairo_surface_status (surface)) {
+	cairo_test_log (ctx, "Error: %s: %s\n", name,
+			cairo_status_to_string (cairo_surface_status (surface)));
+	cairo_surface_destroy (surface);
+	free (buffer.data);
+	return CAIRO_TEST_FAILURE;
+    }
+    cairo_surface_destroy (surface);
+
+    ret = check_document (ctx, name, buffer.data);
+    free (buffer.data);
+
+    return ret;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+
+    if (! cairo_test_is_target_enabled (ctx, "svg11") &&
+	! cairo_test_is_target_enabled (ctx, "svg12"))
+    {
+	return CAIRO_TEST_UNTESTED;
+    }
+
+    if (check_version (ctx, CAIRO_SVG_VERSION_1_1))
+	ret = CAIRO_TEST_FAILURE;
+
+    if (check_version (ctx, CAIRO_SVG_VERSION_1_2))
+	ret = CAIRO_TEST_FAILURE;
+
+    return ret;
+}
+
+CAIRO_TEST (svg_multi_page,
+	    "Check that multi-page SVG documents define everything before use",
+	    "svg", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
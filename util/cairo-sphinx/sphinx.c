@@ -15,6 +15,7 @@
 #include <errno.h>
 #include <assert.h>
 #include <pthread.h>
+#include <time.h>
 
 #include <cairo.h>
 #include <cairo-script.h>
@@ -1489,6 +1490,596 @@ do_wait (int fd)
     return ret != 0;
 }
 
+/* The render daemon: a long-lived process that replays scripts sent to
+ * it by any number of concurrent clients and hands back the resulting
+ * images through shared memory.  All jobs are rendered inside the one
+ * process by a pool of worker threads, so font loading and the global
+ * font and glyph caches are paid for once and then shared by every job.
+ *
+ * Protocol, one connection per client:
+ *   server -> client: "<shm-path>\n" (or "busy\n" if no slot is free)
+ *   client -> server: "render <length>\n" followed by <length> bytes of script
+ *   server -> client: "<offset> <format> <width> <height> <stride>\n"
+ *		       or "error <reason>\n"
+ *   client -> server: "stats\n"
+ *   server -> client: a single line of statistics
+ *
+ * Each client owns a fixed slot of the shared memory segment, so its
+ * result remains valid until it sends its next request.
+ */
+
+#define RENDER_SOCKET "/tmp/cairo-sphinx-render"
+#define RENDER_SHM_PATH SHM_PATH_XXX "-render"
+#define RENDER_LATENCY_HISTORY 1024
+
+struct render_job {
+    struct render_job *next;
+    int sk;
+
+    uint8_t *data;
+    unsigned long offset, size;
+
+    char *script;
+    int length;
+
+    double queued;
+    cairo_surface_t *surface;
+};
+
+struct render_server {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    struct render_job *head, **tail;
+    int wakeup[2];
+
+    uint8_t *base;
+    unsigned long slot_size;
+    int num_slots;
+
+    struct render_stats {
+	unsigned long jobs, errors;
+	double start, last;
+	double total_queue, total_render;
+	double latency[RENDER_LATENCY_HISTORY];
+    } stats;
+};
+
+static double
+render_now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static cairo_surface_t *
+_render_surface_create (void *closure,
+			cairo_content_t content,
+			double width, double height,
+			long uid)
+{
+    struct render_job *job = closure;
+    cairo_format_t format = format_for_content (content);
+    cairo_surface_t *surface;
+    int w = ceil (width), h = ceil (height);
+    int stride;
+
+    if (job->surface != NULL)
+	return cairo_image_surface_create (format, w, h);
+
+    /* The first surface created by the script is its output, render
+     * straight into the client's slot.
+     */
+    stride = cairo_format_stride_for_width (format, w);
+    if (stride > 0 && (unsigned long) stride * h <= job->size) {
+	memset (job->data, 0, (unsigned long) stride * h);
+	surface = cairo_image_surface_create_for_data (job->data,
+						       format, w, h, stride);
+    } else {
+	surface = cairo_image_surface_create (format, w, h);
+    }
+
+    job->surface = cairo_surface_reference (surface);
+    return surface;
+}
+
+static int
+render_job_run (struct render_job *job)
+{
+    const cairo_script_interpreter_hooks_t hooks = {
+	.closure = job,
+	.surface_create = _render_surface_create,
+    };
+    cairo_script_interpreter_t *csi;
+    cairo_status_t status;
+    char buf[1024];
+    int len;
+
+    job->surface = NULL;
+
+    csi = cairo_script_interpreter_create ();
+    cairo_script_interpreter_install_hooks (csi, &hooks);
+    cairo_script_interpreter_feed_string (csi, job->script, job->length);
+    cairo_script_interpreter_finish (csi);
+    status = cairo_script_interpreter_destroy (csi);
+
+    if (job->surface == NULL) {
+	len = sprintf (buf, "error no surface\n");
+    } else {
+	cairo_surface_flush (job->surface);
+	if (status == CAIRO_STATUS_SUCCESS)
+	    status = cairo_surface_status (job->surface);
+
+	if (status) {
+	    len = sprintf (buf, "error %s\n", cairo_status_to_string (status));
+	} else if (cairo_image_surface_get_data (job->surface) != job->data) {
+	    len = sprintf (buf, "error image too large\n");
+	} else {
+	    len = sprintf (buf, "%lu %d %d %d %d\n",
+			   job->offset,
+			   cairo_image_surface_get_format (job->surface),
+			   cairo_image_surface_get_width (job->surface),
+			   cairo_image_surface_get_height (job->surface),
+			   cairo_image_surface_get_stride (job->surface));
+	}
+	cairo_surface_destroy (job->surface);
+    }
+
+    writen (job->sk, buf, len);
+    return buf[0] != 'e';
+}
+
+static void
+render_stats_add (struct render_stats *stats,
+		  double queued, double started, double finished,
+		  int success)
+{
+    if (stats->jobs == 0)
+	stats->start = queued;
+    stats->last = finished;
+
+    stats->latency[stats->jobs % RENDER_LATENCY_HISTORY] = finished - queued;
+    stats->total_queue += started - queued;
+    stats->total_render += finished - started;
+    stats->jobs++;
+    if (! success)
+	stats->errors++;
+}
+
+static int
+double_cmp (const void *A, const void *B)
+{
+    const double *a = A, *b = B;
+    return *a < *b ? -1 : *a > *b ? 1 : 0;
+}
+
+static int
+render_stats_print (struct render_stats *stats, char *buf)
+{
+    double latency[RENDER_LATENCY_HISTORY];
+    double elapsed;
+    int count;
+
+    if (stats->jobs == 0)
+	return sprintf (buf, "jobs=0\n");
+
+    count = stats->jobs;
+    if (count > RENDER_LATENCY_HISTORY)
+	count = RENDER_LATENCY_HISTORY;
+    memcpy (latency, stats->latency, count * sizeof (double));
+    qsort (latency, count, sizeof (double), double_cmp);
+
+    elapsed = stats->last - stats->start;
+    return sprintf (buf,
+		    "jobs=%lu errors=%lu throughput=%.1f/s "
+		    "latency(ms) min=%.3f median=%.3f p95=%.3f max=%.3f "
+		    "mean-queue=%.3f mean-render=%.3f\n",
+		    stats->jobs, stats->errors,
+		    elapsed > 0 ? stats->jobs / elapsed : 0.,
+		    latency[0] * 1e3,
+		    latency[count / 2] * 1e3,
+		    latency[count * 95 / 100] * 1e3,
+		    latency[count - 1] * 1e3,
+		    stats->total_queue / stats->jobs * 1e3,
+		    stats->total_render / stats->jobs * 1e3);
+}
+
+static void *
+render_worker (void *arg)
+{
+    struct render_server *server = arg;
+
+    do {
+	struct render_job *job;
+	double started, finished;
+	int success;
+
+	pthread_mutex_lock (&server->mutex);
+	while (server->head == NULL)
+	    pthread_cond_wait (&server->cond, &server->mutex);
+	job = server->head;
+	server->head = job->next;
+	if (server->head == NULL)
+	    server->tail = &server->head;
+	pthread_mutex_unlock (&server->mutex);
+
+	started = render_now ();
+	success = render_job_run (job);
+	finished = render_now ();
+
+	pthread_mutex_lock (&server->mutex);
+	render_stats_add (&server->stats,
+			  job->queued, started, finished, success);
+	pthread_mutex_unlock (&server->mutex);
+
+	/* hand the client back to the poll loop */
+	writen (server->wakeup[1], &job->sk, sizeof (job->sk));
+
+	free (job->script);
+	free (job);
+    } while (1);
+
+    return NULL;
+}
+
+static void
+render_server_queue (struct render_server *server, struct render_job *job)
+{
+    job->next = NULL;
+    job->queued = render_now ();
+
+    pthread_mutex_lock (&server->mutex);
+    *server->tail = job;
+    server->tail = &job->next;
+    pthread_cond_signal (&server->cond);
+    pthread_mutex_unlock (&server->mutex);
+}
+
+struct render_client {
+    int sk;
+    int slot;
+    int busy;
+};
+
+/* Read one request from a client; returns 0 if the client should be
+ * dropped.
+ */
+static int
+render_client_request (struct render_server *server,
+		       struct render_client *c)
+{
+    char line[4096];
+    int len;
+
+    len = readline (c->sk, line, sizeof (line));
+    if (len < 0)
+	return 0;
+
+    if (strncmp (line, "render ", 7) == 0) {
+	struct render_job *job;
+
+	job = xmalloc (sizeof (*job));
+	job->sk = c->sk;
+	job->offset = c->slot * server->slot_size;
+	job->data = server->base + job->offset;
+	job->size = server->slot_size;
+
+	job->length = atoi (line + 7);
+	if (job->length <= 0) {
+	    free (job);
+	    return 0;
+	}
+
+	job->script = xmalloc (job->length + 1);
+	if (! readn (c->sk, job->script, job->length)) {
+	    free (job->script);
+	    free (job);
+	    return 0;
+	}
+	job->script[job->length] = '\0';
+
+	c->busy = TRUE;
+	render_server_queue (server, job);
+    } else if (strcmp (line, "stats") == 0) {
+	pthread_mutex_lock (&server->mutex);
+	len = render_stats_print (&server->stats, line);
+	pthread_mutex_unlock (&server->mutex);
+
+	if (! writen (c->sk, line, len))
+	    return 0;
+    } else {
+	return 0;
+    }
+
+    return 1;
+}
+
+static int
+do_render_server (const char *path, int num_threads, int slot_kb)
+{
+    struct render_server server;
+    struct render_client *clients;
+    uint8_t *slots;
+    struct pollfd *pfd;
+    int num_clients, size_clients;
+    int sk, n, cnt, len;
+    char buf[1024];
+
+    signal (SIGPIPE, SIG_IGN);
+
+    if (num_threads <= 0)
+	num_threads = sysconf (_SC_NPROCESSORS_ONLN);
+    if (num_threads <= 0)
+	num_threads = 1;
+    if (slot_kb <= 0)
+	slot_kb = 4096;
+
+    memset (&server, 0, sizeof (server));
+    pthread_mutex_init (&server.mutex, NULL);
+    pthread_cond_init (&server.cond, NULL);
+    server.tail = &server.head;
+
+    server.slot_size = (unsigned long) slot_kb << 10;
+    server.num_slots = DATA_SIZE / server.slot_size;
+    if (server.num_slots == 0) {
+	fprintf (stderr, "Slot size is larger than the shared memory segment\n");
+	return 1;
+    }
+
+    server.base = clients_shm (RENDER_SHM_PATH);
+    if (server.base == MAP_FAILED) {
+	fprintf (stderr, "Failed to create shared memory segment\n");
+	return 1;
+    }
+    slots = xmalloc (server.num_slots);
+    memset (slots, 0, server.num_slots);
+
+    if (pipe (server.wakeup) < 0) {
+	fprintf (stderr, "Failed to create wakeup pipe\n");
+	return 1;
+    }
+
+    sk = server_socket (path);
+    if (sk < 0) {
+	fprintf (stderr, "Failed to create server socket\n");
+	return 1;
+    }
+
+    if (daemonize () < 0)
+	return 1;
+
+    for (n = 0; n < num_threads; n++) {
+	pthread_t thread;
+
+	if (pthread_create (&thread, NULL, render_worker, &server) < 0) {
+	    fprintf (stderr, "Failed to spawn render thread\n");
+	    return 1;
+	}
+	pthread_detach (thread);
+    }
+
+    size_clients = 4;
+    clients = xmalloc (sizeof (*clients) * size_clients);
+    pfd = xmalloc (sizeof (*pfd) * (size_clients + 2));
+    num_clients = 0;
+
+    do {
+	pfd[0].fd = sk;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = server.wakeup[0];
+	pfd[1].events = POLLIN;
+	for (n = 0; n < num_clients; n++) {
+	    /* busy clients are waiting on their reply, leave them be */
+	    pfd[n+2].fd = clients[n].busy ? -1 : clients[n].sk;
+	    pfd[n+2].events = POLLIN;
+	    pfd[n+2].revents = 0;
+	}
+
+	cnt = poll (pfd, num_clients + 2, -1);
+	if (cnt < 0) {
+	    if (errno == EINTR)
+		continue;
+	    break;
+	}
+
+	if (pfd[1].revents) {
+	    int done;
+
+	    if (read (server.wakeup[0], &done, sizeof (done)) != sizeof (done))
+		break;
+
+	    for (n = 0; n < num_clients; n++) {
+		if (clients[n].sk == done) {
+		    clients[n].busy = FALSE;
+		    break;
+		}
+	    }
+	}
+
+	for (n = 0; n < num_clients; n++) {
+	    if (pfd[n+2].fd == -1 || ! pfd[n+2].revents)
+		continue;
+
+	    if (! render_client_request (&server, &clients[n])) {
+		close (clients[n].sk);
+		slots[clients[n].slot] = FALSE;
+		clients[n].sk = -1;
+	    }
+	}
+
+	for (n = cnt = 0; n < num_clients; n++) {
+	    if (clients[n].sk != -1) {
+		if (cnt != n)
+		    clients[cnt] = clients[n];
+		cnt++;
+	    }
+	}
+	num_clients = cnt;
+
+	if (pfd[0].revents) {
+	    int slot;
+
+	    while ((n = accept (sk, NULL, NULL)) != -1) {
+		for (slot = 0; slot < server.num_slots; slot++)
+		    if (! slots[slot])
+			break;
+
+		if (slot == server.num_slots) {
+		    writen (n, "busy\n", 5);
+		    close (n);
+		    continue;
+		}
+
+		len = sprintf (buf, "%s\n", RENDER_SHM_PATH);
+		if (! writen (n, buf, len)) {
+		    close (n);
+		    continue;
+		}
+
+		if (num_clients == size_clients) {
+		    size_clients *= 2;
+		    clients = xrealloc (clients,
+					sizeof (*clients) * size_clients);
+		    pfd = xrealloc (pfd, sizeof (*pfd) * (size_clients + 2));
+		}
+
+		slots[slot] = TRUE;
+		clients[num_clients].sk = n;
+		clients[num_clients].slot = slot;
+		clients[num_clients].busy = FALSE;
+		num_clients++;
+	    }
+	}
+    } while (1);
+
+    shm_unlink (RENDER_SHM_PATH);
+    return 1;
+}
+
+static char *
+render_read_file (const char *filename, int *length)
+{
+    FILE *file;
+    char *data;
+    int size, len;
+
+    file = fopen (filename, "rb");
+    if (file == NULL)
+	return NULL;
+
+    size = 65536;
+    data = xmalloc (size);
+    *length = 0;
+    while ((len = fread (data + *length, 1, size - *length, file)) > 0) {
+	*length += len;
+	if (*length == size) {
+	    size *= 2;
+	    data = xrealloc (data, size);
+	}
+    }
+    fclose (file);
+
+    return data;
+}
+
+static int
+do_render (const char *path, char **files)
+{
+    char buf[4096];
+    uint8_t *base;
+    int sk, len, ret = 0;
+
+    sk = client_socket (path);
+    if (sk < 0) {
+	fprintf (stderr, "Failed to connect to render server\n");
+	return 1;
+    }
+
+    if (readline (sk, buf, sizeof (buf)) < 0 || strcmp (buf, "busy") == 0) {
+	fprintf (stderr, "Render server is busy\n");
+	return 1;
+    }
+
+    base = client_shm (buf);
+    if (base == MAP_FAILED) {
+	fprintf (stderr, "Failed to map shared memory segment '%s'.\n", buf);
+	return 1;
+    }
+
+    for (; *files != NULL; files++) {
+	unsigned long offset;
+	int format, width, height, stride;
+	cairo_surface_t *image;
+	char *script, *dot;
+	int length;
+
+	script = render_read_file (*files, &length);
+	if (script == NULL) {
+	    fprintf (stderr, "Failed to read '%s'\n", *files);
+	    ret = 1;
+	    continue;
+	}
+
+	len = sprintf (buf, "render %d\n", length);
+	if (! writen (sk, buf, len) || ! writen (sk, script, length)) {
+	    free (script);
+	    return 1;
+	}
+	free (script);
+
+	if (readline (sk, buf, sizeof (buf)) < 0)
+	    return 1;
+
+	if (sscanf (buf, "%lu %d %d %d %d",
+		    &offset, &format, &width, &height, &stride) != 5)
+	{
+	    fprintf (stderr, "Failed to render '%s': %s\n", *files, buf);
+	    ret = 1;
+	    continue;
+	}
+
+	snprintf (buf, sizeof (buf) - 4, "%s", *files);
+	dot = strrchr (buf, '.');
+	if (dot == NULL || strchr (dot, '/') != NULL)
+	    dot = buf + strlen (buf);
+	strcpy (dot, ".png");
+
+	image = cairo_image_surface_create_for_data (base + offset, format,
+						     width, height, stride);
+	if (cairo_surface_write_to_png (image, buf))
+	    ret = 1;
+	cairo_surface_destroy (image);
+    }
+
+    munmap (base, DATA_SIZE);
+    close (sk);
+
+    return ret;
+}
+
+static int
+do_render_stats (const char *path)
+{
+    char buf[4096];
+    int sk;
+
+    sk = client_socket (path);
+    if (sk < 0)
+	return 1;
+
+    if (readline (sk, buf, sizeof (buf)) < 0 || strcmp (buf, "busy") == 0)
+	return 1;
+
+    if (! writen (sk, "stats\n", 6) || readline (sk, buf, sizeof (buf)) < 0)
+	return 1;
+
+    printf ("%s\n", buf);
+    close (sk);
+
+    return 0;
+}
+
 int
 main (int argc, char **argv)
 {
@@ -1499,6 +2090,18 @@ main (int argc, char **argv)
     if (argc == 1)
 	return do_server ("/tmp/cairo-sphinx");
 
+    if (strcmp (argv[1], "render-server") == 0) {
+	return do_render_server (RENDER_SOCKET,
+				 argc > 2 ? atoi (argv[2]) : 0,
+				 argc > 3 ? atoi (argv[3]) : 0);
+    }
+
+    if (strcmp (argv[1], "render") == 0)
+	return do_render (RENDER_SOCKET, argv + 2);
+
+    if (strcmp (argv[1], "render-stats") == 0)
+	return do_render_stats (RENDER_SOCKET);
+
     fd = client_socket ("/tmp/cairo-sphinx");
     if (fd < 0)
 	return 1;